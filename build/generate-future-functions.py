@@ -87,6 +87,7 @@ typedef_list = [
 
     # Const libmongoc.
     typedef("const_mongoc_find_and_modify_opts_ptr", "const mongoc_find_and_modify_opts_t *"),
+    typedef("const_mongoc_prepared_count_ptr", "const mongoc_prepared_count_t *"),
     typedef("const_mongoc_read_prefs_ptr", "const mongoc_read_prefs_t *"),
     typedef("const_mongoc_write_concern_ptr", "const mongoc_write_concern_t *"),
 ]
@@ -285,6 +286,10 @@ future_functions = [
                     [param("mongoc_gridfs_file_ptr", "file"),
                      param("bson_error_ptr", "error")]),
 
+    future_function("bool",
+                    "mongoc_gridfs_file_save",
+                    [param("mongoc_gridfs_file_ptr", "file")]),
+
     future_function("int",
                     "mongoc_gridfs_file_seek",
                     [param("mongoc_gridfs_file_ptr", "file"),
@@ -298,6 +303,14 @@ future_functions = [
                      param("size_t", "iovcnt"),
                      param("uint32_t", "timeout_msec")]),
 
+    future_function("int64_t",
+                    "mongoc_prepared_count_execute",
+                    [param("const_mongoc_prepared_count_ptr", "prepared"),
+                     param("const_bson_ptr", "query"),
+                     param("int64_t", "skip"),
+                     param("int64_t", "limit"),
+                     param("bson_error_ptr", "error")]),
+
     future_function("mongoc_server_description_ptr",
                     "mongoc_topology_select",
                     [param("mongoc_topology_ptr", "topology"),
@@ -19,14 +19,40 @@
 #include <bson.h>
 #include <mongoc.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
 
 /*
- * This is an example that reads BSON documents from STDIN and prints them
- * to standard output as JSON if they match {'hello': 'world'}.
+ * This is an example that reads BSON documents from a file, such as a
+ * mongodump .bson file, or from STDIN, and prints those that match a query.
+ *
+ *   filter-bsondump [--bson] [--threads N] [QUERY [FILE]]
+ *
+ * The query defaults to {'hello': 'world'}. Matches are printed as JSON, or
+ * as BSON with --bson. A FILE is matched in parallel by N threads, one per
+ * core by default, and matches are printed in file order.
  */
 
 
+static bool
+print_match (const bson_t *bson, void *ctx)
+{
+   bool as_bson = *(bool *) ctx;
+   char *str;
+
+   if (as_bson) {
+      return fwrite (bson_get_data (bson), 1, bson->len, stdout) == bson->len;
+   }
+
+   str = bson_as_extended_json (bson, NULL);
+   printf ("%s\n", str);
+   bson_free (str);
+
+   return true;
+}
+
+
 int
 main (int argc, char *argv[])
 {
@@ -34,32 +60,81 @@ main (int argc, char *argv[])
    bson_reader_t *reader;
    const bson_t *bson;
    bson_t *spec;
-   char *str;
+   bson_error_t error;
+   const char *query = "{\"hello\": \"world\"}";
+   const char *path = NULL;
+   uint32_t n_threads = 0;
+   bool as_bson = false;
+   int ret = EXIT_SUCCESS;
    int fd;
+   int i;
+
+   for (i = 1; i < argc; i++) {
+      if (!strcmp (argv[i], "--bson")) {
+         as_bson = true;
+      } else if (!strcmp (argv[i], "--threads") && i + 1 < argc) {
+         n_threads = (uint32_t) atoi (argv[++i]);
+      } else if (argv[i][0] == '-') {
+         fprintf (stderr,
+                  "usage: %s [--bson] [--threads N] [QUERY [FILE]]\n",
+                  argv[0]);
+         return EXIT_FAILURE;
+      } else {
+         break;
+      }
+   }
+
+   if (i < argc) {
+      query = argv[i++];
+   }
+
+   if (i < argc) {
+      path = argv[i++];
+   }
 
    mongoc_init ();
 
+   spec = bson_new_from_json ((const uint8_t *) query, -1, &error);
+   if (!spec) {
+      fprintf (stderr, "Invalid query: %s\n", error.message);
+      return EXIT_FAILURE;
+   }
+
+   matcher = mongoc_matcher_new (spec, &error);
+   if (!matcher) {
+      fprintf (stderr, "Invalid query: %s\n", error.message);
+      bson_destroy (spec);
+      return EXIT_FAILURE;
+   }
+
+   if (path) {
+      if (!mongoc_matcher_match_file (
+             matcher, path, n_threads, print_match, &as_bson, &error)) {
+         fprintf (stderr, "%s\n", error.message);
+         ret = EXIT_FAILURE;
+      }
+   } else {
 #ifdef _WIN32
-   fd = fileno (stdin);
+      fd = fileno (stdin);
 #else
-   fd = STDIN_FILENO;
+      fd = STDIN_FILENO;
 #endif
 
-   reader = bson_reader_new_from_fd (fd, false);
+      reader = bson_reader_new_from_fd (fd, false);
 
-   spec = BCON_NEW ("hello", "world");
-   matcher = mongoc_matcher_new (spec, NULL);
-
-   while ((bson = bson_reader_read (reader, NULL))) {
-      if (mongoc_matcher_match (matcher, bson)) {
-         str = bson_as_extended_json (bson, NULL);
-         printf ("%s\n", str);
-         bson_free (str);
+      while ((bson = bson_reader_read (reader, NULL))) {
+         if (mongoc_matcher_match (matcher, bson)) {
+            print_match (bson, &as_bson);
+         }
       }
+
+      bson_reader_destroy (reader);
    }
 
-   bson_reader_destroy (reader);
+   mongoc_matcher_destroy (matcher);
    bson_destroy (spec);
 
-   return 0;
+   mongoc_cleanup ();
+
+   return ret;
 }
@@ -23,6 +23,7 @@
 
 #include "mongoc-array-private.h"
 #include "mongoc-client.h"
+#include "mongoc-client-pool.h"
 #include "mongoc-write-command-private.h"
 
 
@@ -32,6 +33,9 @@ struct _mongoc_bulk_operation_t {
    char *database;
    char *collection;
    mongoc_client_t *client;
+   /* if set, unordered writes are split across all mongos in the latency
+    * window, using one client from the pool per mongos */
+   mongoc_client_pool_t *pool;
    mongoc_write_concern_t *write_concern;
    mongoc_bulk_write_flags_t flags;
    uint32_t server_id;
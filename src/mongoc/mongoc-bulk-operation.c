@@ -18,6 +18,8 @@
 #include "mongoc-bulk-operation.h"
 #include "mongoc-bulk-operation-private.h"
 #include "mongoc-client-private.h"
+#include "mongoc-thread-private.h"
+#include "mongoc-topology-private.h"
 #include "mongoc-trace-private.h"
 #include "mongoc-write-concern-private.h"
 #include "mongoc-util-private.h"
@@ -333,20 +335,51 @@ mongoc_bulk_operation_delete_one (mongoc_bulk_operation_t *bulk,
 void
 mongoc_bulk_operation_insert (mongoc_bulk_operation_t *bulk,
                               const bson_t *document)
+{
+   ENTRY;
+
+   BSON_ASSERT (bulk);
+   BSON_ASSERT (document);
+
+   BULK_EXIT_IF_PRIOR_ERROR;
+
+   if (!mongoc_bulk_operation_insert_with_opts (
+          bulk, document, NULL, &bulk->result.error)) {
+      MONGOC_WARNING ("%s", bulk->result.error.message);
+   }
+
+   EXIT;
+}
+
+bool
+mongoc_bulk_operation_insert_with_opts (mongoc_bulk_operation_t *bulk,
+                                        const bson_t *document,
+                                        const bson_t *opts,
+                                        bson_error_t *error) /* OUT */
 {
    mongoc_write_command_t command = {0};
    mongoc_write_command_t *last;
+   bson_iter_t iter;
+   bool validate = true;
 
    ENTRY;
 
    BSON_ASSERT (bulk);
    BSON_ASSERT (document);
 
-   BULK_EXIT_IF_PRIOR_ERROR;
+   BULK_RETURN_IF_PRIOR_ERROR;
 
-   if (!_mongoc_validate_new_document (document, &bulk->result.error)) {
-      MONGOC_WARNING ("%s", bulk->result.error.message);
-      EXIT;
+   if (opts && bson_iter_init_find (&iter, opts, "validate")) {
+      if (!BSON_ITER_HOLDS_BOOL (&iter)) {
+         bson_set_error (error,
+                         MONGOC_ERROR_COMMAND,
+                         MONGOC_ERROR_COMMAND_INVALID_ARG,
+                         "%s expects the 'validate' option to be a boolean",
+                         BSON_FUNC);
+         RETURN (false);
+      }
+
+      validate = bson_iter_bool (&iter);
    }
 
    if (bulk->commands.len) {
@@ -354,21 +387,27 @@ mongoc_bulk_operation_insert (mongoc_bulk_operation_t *bulk,
          &bulk->commands, mongoc_write_command_t, bulk->commands.len - 1);
 
       if (SHOULD_APPEND (last, MONGOC_WRITE_COMMAND_INSERT)) {
-         _mongoc_write_command_insert_append (last, document);
-         EXIT;
+         RETURN (_mongoc_write_command_insert_append_validated (
+            last, document, validate, error));
       }
    }
 
    _mongoc_write_command_init_insert (
       &command,
-      document,
+      NULL,
       bulk->flags,
       bulk->operation_id,
       !mongoc_write_concern_is_acknowledged (bulk->write_concern));
 
+   if (!_mongoc_write_command_insert_append_validated (
+          &command, document, validate, error)) {
+      _mongoc_write_command_destroy (&command);
+      RETURN (false);
+   }
+
    _mongoc_array_append_val (&bulk->commands, command);
 
-   EXIT;
+   RETURN (true);
 }
 
 bool
@@ -652,6 +691,225 @@ mongoc_bulk_operation_update_one (mongoc_bulk_operation_t *bulk,
    EXIT;
 }
 
+/* the share of an unordered bulk operation sent to one mongos */
+typedef struct {
+   mongoc_bulk_operation_t *bulk;
+   mongoc_client_t *client;
+   uint32_t server_id;
+   mongoc_array_t commands; /* slices, of mongoc_write_command_t */
+   mongoc_array_t offsets;  /* each slice's offset, of uint32_t */
+   mongoc_write_result_t result;
+   mongoc_thread_t thread;
+   bool started;
+} mongoc_bulk_part_t;
+
+
+static void *
+_mongoc_bulk_part_run (void *data)
+{
+   mongoc_bulk_part_t *part = (mongoc_bulk_part_t *) data;
+   mongoc_bulk_operation_t *bulk = part->bulk;
+   mongoc_server_stream_t *server_stream;
+   size_t i;
+
+   server_stream = mongoc_cluster_stream_for_server (&part->client->cluster,
+                                                     part->server_id,
+                                                     true /* reconnect_ok */,
+                                                     &part->result.error);
+
+   if (!server_stream) {
+      part->result.failed = true;
+      return NULL;
+   }
+
+   for (i = 0; i < part->commands.len; i++) {
+      _mongoc_write_command_execute (
+         &_mongoc_array_index (&part->commands, mongoc_write_command_t, i),
+         part->client,
+         server_stream,
+         bulk->database,
+         bulk->collection,
+         bulk->write_concern,
+         _mongoc_array_index (&part->offsets, uint32_t, i),
+         &part->result);
+
+      if (part->result.must_stop) {
+         break;
+      }
+   }
+
+   mongoc_server_stream_cleanup (server_stream);
+
+   return NULL;
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_bulk_operation_execute_parallel --
+ *
+ *       If @bulk is unordered, has a client pool, and the pool's topology
+ *       is a sharded cluster with more than one mongos in the latency
+ *       window, split each write command into one contiguous slice per
+ *       mongos and run the slices in parallel: the first on bulk->client,
+ *       the others each on a client from the pool. The pool is never
+ *       blocked on, only clients it has idle are used. Every part's result
+ *       is merged into bulk->result.
+ *
+ * Returns:
+ *       true if the bulk operation was executed, false if it is not
+ *       eligible or no client could be taken from the pool, and must be
+ *       executed serially on bulk->client.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+static bool
+_mongoc_bulk_operation_execute_parallel (mongoc_bulk_operation_t *bulk)
+{
+   mongoc_topology_t *topology;
+   mongoc_client_t *client;
+   mongoc_server_stream_t *server_stream;
+   mongoc_array_t server_ids;
+   mongoc_bulk_part_t *parts;
+   mongoc_bulk_part_t *part;
+   mongoc_write_command_t *command;
+   mongoc_write_command_t slice;
+   bson_error_t error;
+   uint32_t offset = 0;
+   uint32_t slice_offset;
+   uint32_t chunk;
+   uint32_t n_parts;
+   uint32_t i;
+   int j;
+
+   ENTRY;
+
+   if (!bulk->pool || bulk->flags.ordered || bulk->server_id) {
+      RETURN (false);
+   }
+
+   /* the first part runs on bulk->client, which may be the pool's only
+    * client: wait for its topology to discover a writable server */
+   client = bulk->client;
+   server_stream = mongoc_cluster_stream_for_writes (&client->cluster, &error);
+   if (!server_stream) {
+      RETURN (false);
+   }
+
+   mongoc_server_stream_cleanup (server_stream);
+
+   topology = client->topology;
+   _mongoc_array_init (&server_ids, sizeof (uint32_t));
+   if (_mongoc_topology_get_type (topology) == MONGOC_TOPOLOGY_SHARDED) {
+      _mongoc_topology_suitable_server_ids (
+         topology, MONGOC_SS_WRITE, &server_ids);
+   }
+
+   if (server_ids.len < 2) {
+      _mongoc_array_destroy (&server_ids);
+      RETURN (false);
+   }
+
+   parts = (mongoc_bulk_part_t *) bson_malloc0 (server_ids.len * sizeof *parts);
+
+   /* don't block on the pool: use as many mongos as we get clients for.
+    * server ids are only meaningful within bulk->client's topology */
+   parts[0].client = client;
+   for (n_parts = 1; n_parts < server_ids.len; n_parts++) {
+      parts[n_parts].client = mongoc_client_pool_try_pop (bulk->pool);
+      if (!parts[n_parts].client) {
+         break;
+      }
+
+      if (parts[n_parts].client->topology != topology) {
+         mongoc_client_pool_push (bulk->pool, parts[n_parts].client);
+         break;
+      }
+   }
+
+   if (n_parts < 2) {
+      bson_free (parts);
+      _mongoc_array_destroy (&server_ids);
+      RETURN (false);
+   }
+
+   for (i = 0; i < n_parts; i++) {
+      part = &parts[i];
+      part->bulk = bulk;
+      part->server_id = _mongoc_array_index (&server_ids, uint32_t, i);
+      _mongoc_array_init (&part->commands, sizeof (mongoc_write_command_t));
+      _mongoc_array_init (&part->offsets, sizeof (uint32_t));
+      _mongoc_write_result_init (&part->result);
+   }
+
+   /* give each part a contiguous range of each command's documents */
+   for (j = 0; j < bulk->commands.len; j++) {
+      command =
+         &_mongoc_array_index (&bulk->commands, mongoc_write_command_t, j);
+      chunk = (command->n_documents + n_parts - 1) / n_parts;
+
+      for (i = 0; i < n_parts && i * chunk < command->n_documents; i++) {
+         _mongoc_write_command_init_slice (
+            &slice,
+            command,
+            i * chunk,
+            BSON_MIN (chunk, command->n_documents - i * chunk));
+         slice_offset = offset + i * chunk;
+         _mongoc_array_append_val (&parts[i].commands, slice);
+         _mongoc_array_append_val (&parts[i].offsets, slice_offset);
+      }
+
+      offset += command->n_documents;
+   }
+
+   for (i = 1; i < n_parts; i++) {
+      parts[i].started = parts[i].commands.len &&
+                         0 == mongoc_thread_create (&parts[i].thread,
+                                                    _mongoc_bulk_part_run,
+                                                    &parts[i]);
+   }
+
+   /* run the first part on this thread, and any that failed to start */
+   for (i = 0; i < n_parts; i++) {
+      if (!parts[i].started && parts[i].commands.len) {
+         _mongoc_bulk_part_run (&parts[i]);
+      }
+   }
+
+   for (i = 0; i < n_parts; i++) {
+      part = &parts[i];
+
+      if (part->started) {
+         mongoc_thread_join (part->thread);
+      }
+
+      _mongoc_write_result_merge_result (&bulk->result, &part->result);
+      _mongoc_write_result_destroy (&part->result);
+
+      for (j = 0; j < (int) part->commands.len; j++) {
+         _mongoc_write_command_destroy (&_mongoc_array_index (
+            &part->commands, mongoc_write_command_t, j));
+      }
+
+      _mongoc_array_destroy (&part->commands);
+      _mongoc_array_destroy (&part->offsets);
+
+      if (i > 0) {
+         mongoc_client_pool_push (bulk->pool, part->client);
+      }
+   }
+
+   bulk->server_id = parts[0].server_id;
+
+   bson_free (parts);
+   _mongoc_array_destroy (&server_ids);
+
+   RETURN (true);
+}
+
+
 uint32_t
 mongoc_bulk_operation_execute (mongoc_bulk_operation_t *bulk, /* IN */
                                bson_t *reply,                 /* OUT */
@@ -721,6 +979,17 @@ mongoc_bulk_operation_execute (mongoc_bulk_operation_t *bulk, /* IN */
       RETURN (false);
    }
 
+   if (_mongoc_bulk_operation_execute_parallel (bulk)) {
+      ret = _mongoc_write_result_complete (&bulk->result,
+                                           bulk->client->error_api_version,
+                                           bulk->write_concern,
+                                           MONGOC_ERROR_COMMAND,
+                                           reply,
+                                           error);
+
+      RETURN (ret ? bulk->server_id : 0);
+   }
+
    if (bulk->server_id) {
       server_stream = mongoc_cluster_stream_for_server (
          cluster, bulk->server_id, true /* reconnect_ok */, error);
@@ -836,6 +1105,16 @@ mongoc_bulk_operation_set_client (mongoc_bulk_operation_t *bulk, void *client)
 }
 
 
+void
+mongoc_bulk_operation_set_client_pool (mongoc_bulk_operation_t *bulk,
+                                       void *pool)
+{
+   BSON_ASSERT (bulk);
+
+   bulk->pool = (mongoc_client_pool_t *) pool;
+}
+
+
 uint32_t
 mongoc_bulk_operation_get_hint (const mongoc_bulk_operation_t *bulk)
 {
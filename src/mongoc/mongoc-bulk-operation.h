@@ -52,6 +52,11 @@ mongoc_bulk_operation_delete_one (mongoc_bulk_operation_t *bulk,
 BSON_EXPORT (void)
 mongoc_bulk_operation_insert (mongoc_bulk_operation_t *bulk,
                               const bson_t *document);
+BSON_EXPORT (bool)
+mongoc_bulk_operation_insert_with_opts (mongoc_bulk_operation_t *bulk,
+                                        const bson_t *document,
+                                        const bson_t *opts,
+                                        bson_error_t *error); /* OUT */
 BSON_EXPORT (void)
 mongoc_bulk_operation_remove (mongoc_bulk_operation_t *bulk,
                               const bson_t *selector);
@@ -124,6 +129,9 @@ mongoc_bulk_operation_set_collection (mongoc_bulk_operation_t *bulk,
                                       const char *collection);
 BSON_EXPORT (void)
 mongoc_bulk_operation_set_client (mongoc_bulk_operation_t *bulk, void *client);
+BSON_EXPORT (void)
+mongoc_bulk_operation_set_client_pool (mongoc_bulk_operation_t *bulk,
+                                       void *pool);
 /* These names include the term "hint" for backward compatibility, should be
  * mongoc_bulk_operation_get_server_id, mongoc_bulk_operation_set_server_id. */
 BSON_EXPORT (void)
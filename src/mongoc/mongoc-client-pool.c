@@ -21,6 +21,7 @@
 #include "mongoc-client-pool-private.h"
 #include "mongoc-client-pool.h"
 #include "mongoc-client-private.h"
+#include "mongoc-query-cache-private.h"
 #include "mongoc-queue-private.h"
 #include "mongoc-thread-private.h"
 #include "mongoc-topology-private.h"
@@ -48,6 +49,7 @@ struct _mongoc_client_pool_t {
    void *apm_context;
    int32_t error_api_version;
    bool error_api_set;
+   mongoc_query_cache_t *query_cache;
 };
 
 
@@ -111,6 +113,7 @@ mongoc_client_pool_new (const mongoc_uri_t *uri)
    topology = mongoc_topology_new (uri, false);
    pool->topology = topology;
    pool->error_api_version = MONGOC_ERROR_API_VERSION_LEGACY;
+   pool->query_cache = _mongoc_query_cache_new ();
 
    b = mongoc_uri_get_options (pool->uri);
 
@@ -154,6 +157,7 @@ mongoc_client_pool_destroy (mongoc_client_pool_t *pool)
    }
 
    mongoc_topology_destroy (pool->topology);
+   _mongoc_query_cache_destroy (pool->query_cache);
 
    mongoc_uri_destroy (pool->uri);
    mongoc_mutex_destroy (&pool->mutex);
@@ -209,6 +213,7 @@ again:
             pool->topology->scanner->initiator_context);
 
          client->error_api_version = pool->error_api_version;
+         client->query_cache = pool->query_cache;
          _mongoc_client_set_apm_callbacks_private (
             client, &pool->apm_callbacks, pool->apm_context);
 #ifdef MONGOC_ENABLE_SSL
@@ -244,6 +249,7 @@ mongoc_client_pool_try_pop (mongoc_client_pool_t *pool)
    if (!(client = (mongoc_client_t *) _mongoc_queue_pop_head (&pool->queue))) {
       if (pool->size < pool->max_pool_size) {
          client = _mongoc_client_new_from_uri (pool->uri, pool->topology);
+         client->query_cache = pool->query_cache;
 #ifdef MONGOC_ENABLE_SSL
          if (pool->ssl_opts_set) {
             mongoc_client_set_ssl_opts (client, &pool->ssl_opts);
@@ -425,3 +431,22 @@ mongoc_client_pool_set_appname (mongoc_client_pool_t *pool, const char *appname)
 
    return ret;
 }
+
+void
+mongoc_client_pool_set_query_cache (mongoc_client_pool_t *pool,
+                                    int64_t ttl_msec,
+                                    size_t max_bytes)
+{
+   BSON_ASSERT (pool);
+
+   _mongoc_query_cache_configure (pool->query_cache, ttl_msec, max_bytes);
+}
+
+void
+mongoc_client_pool_invalidate_query_cache (mongoc_client_pool_t *pool,
+                                           const char *ns)
+{
+   BSON_ASSERT (pool);
+
+   _mongoc_query_cache_invalidate (pool->query_cache, ns);
+}
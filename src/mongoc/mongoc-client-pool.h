@@ -68,6 +68,13 @@ mongoc_client_pool_set_error_api (mongoc_client_pool_t *pool, int32_t version);
 BSON_EXPORT (bool)
 mongoc_client_pool_set_appname (mongoc_client_pool_t *pool,
                                 const char *appname);
+BSON_EXPORT (void)
+mongoc_client_pool_set_query_cache (mongoc_client_pool_t *pool,
+                                    int64_t ttl_msec,
+                                    size_t max_bytes);
+BSON_EXPORT (void)
+mongoc_client_pool_invalidate_query_cache (mongoc_client_pool_t *pool,
+                                           const char *ns);
 BSON_END_DECLS
 
 
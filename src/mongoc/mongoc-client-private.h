@@ -32,6 +32,7 @@
 #include "mongoc-read-prefs.h"
 #include "mongoc-rpc-private.h"
 #include "mongoc-opcode.h"
+#include "mongoc-query-cache-private.h"
 #ifdef MONGOC_ENABLE_SSL
 #include "mongoc-ssl.h"
 #endif
@@ -66,6 +67,19 @@ BSON_BEGIN_DECLS
 #define WIRE_VERSION_CMD_WRITE_CONCERN 5
 /* first version to support collation */
 #define WIRE_VERSION_COLLATION 5
+/* first version to accept OP_MSG, including fire-and-forget "moreToCome" */
+#define WIRE_VERSION_OP_MSG 6
+
+
+/* a killCursors deferred by mongoc_cursor_destroy, see
+ * mongoc_client_set_defer_kill_cursors */
+typedef struct _mongoc_deferred_kill_t {
+   uint32_t server_id;
+   int64_t cursor_id;
+   int64_t operation_id;
+   char ns[MONGOC_NAMESPACE_MAX];
+   uint32_t dblen;
+} mongoc_deferred_kill_t;
 
 
 struct _mongoc_client_t {
@@ -92,6 +106,11 @@ struct _mongoc_client_t {
 
    int32_t error_api_version;
    bool error_api_set;
+
+   bool defer_kill_cursors;
+   mongoc_array_t deferred_kills; /* of mongoc_deferred_kill_t */
+
+   mongoc_query_cache_t *query_cache; /* the pool's, or NULL */
 };
 
 
@@ -148,6 +167,16 @@ _mongoc_client_kill_cursor (mongoc_client_t *client,
                             int64_t operation_id,
                             const char *db,
                             const char *collection);
+void
+_mongoc_client_defer_kill_cursor (mongoc_client_t *client,
+                                  uint32_t server_id,
+                                  int64_t cursor_id,
+                                  int64_t operation_id,
+                                  const char *db,
+                                  const char *collection);
+void
+_mongoc_client_flush_kill_cursors (mongoc_client_t *client,
+                                   uint32_t server_id);
 bool
 _mongoc_client_command_with_opts (mongoc_client_t *client,
                                   const char *db_name,
@@ -161,6 +190,15 @@ _mongoc_client_command_with_opts (mongoc_client_t *client,
                                   bson_t *reply,
                                   bson_error_t *error);
 bool
+_mongoc_client_command_with_stream (mongoc_client_t *client,
+                                    const char *db_name,
+                                    const bson_t *command,
+                                    mongoc_server_stream_t *server_stream,
+                                    const mongoc_query_flags_t flags,
+                                    const mongoc_read_prefs_t *read_prefs,
+                                    bson_t *reply,
+                                    bson_error_t *error);
+bool
 _mongoc_client_command_append_iterator_opts_to_command (bson_iter_t *iter,
                                                         int max_wire_version,
                                                         bson_t *command,
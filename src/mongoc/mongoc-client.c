@@ -56,7 +56,8 @@
 static void
 _mongoc_client_op_killcursors (mongoc_cluster_t *cluster,
                                mongoc_server_stream_t *server_stream,
-                               int64_t cursor_id,
+                               const int64_t *cursor_ids,
+                               uint32_t n_cursors,
                                int64_t operation_id,
                                const char *db,
                                const char *collection);
@@ -64,7 +65,8 @@ _mongoc_client_op_killcursors (mongoc_cluster_t *cluster,
 static void
 _mongoc_client_killcursors_command (mongoc_cluster_t *cluster,
                                     mongoc_server_stream_t *server_stream,
-                                    int64_t cursor_id,
+                                    const int64_t *cursor_ids,
+                                    uint32_t n_cursors,
                                     const char *db,
                                     const char *collection);
 
@@ -736,6 +738,9 @@ _mongoc_client_new_from_uri (const mongoc_uri_t *uri,
    client->topology = topology;
    client->error_api_version = MONGOC_ERROR_API_VERSION_LEGACY;
    client->error_api_set = false;
+   client->defer_kill_cursors = false;
+   _mongoc_array_init (&client->deferred_kills,
+                       sizeof (mongoc_deferred_kill_t));
 
    write_concern = mongoc_uri_get_write_concern (client->uri);
    client->write_concern = mongoc_write_concern_copy (write_concern);
@@ -802,6 +807,10 @@ void
 mongoc_client_destroy (mongoc_client_t *client)
 {
    if (client) {
+      /* send any deferred killCursors while the topology is still alive */
+      _mongoc_client_flush_kill_cursors (client, 0);
+      _mongoc_array_destroy (&client->deferred_kills);
+
       if (client->topology->single_threaded) {
          mongoc_topology_destroy (client->topology);
       }
@@ -1211,7 +1220,7 @@ mongoc_client_command (mongoc_client_t *client,
 }
 
 
-static bool
+bool
 _mongoc_client_command_with_stream (mongoc_client_t *client,
                                     const char *db_name,
                                     const bson_t *command,
@@ -1646,7 +1655,24 @@ mongoc_client_command_simple_with_server_id (
 
 
 static void
-_mongoc_client_prepare_killcursors_command (int64_t cursor_id,
+_mongoc_client_append_cursor_ids (bson_t *array,
+                                  const int64_t *cursor_ids,
+                                  uint32_t n_cursors)
+{
+   const char *key;
+   char buf[16];
+   uint32_t i;
+
+   for (i = 0; i < n_cursors; i++) {
+      bson_uint32_to_string (i, &key, buf, sizeof buf);
+      bson_append_int64 (array, key, -1, cursor_ids[i]);
+   }
+}
+
+
+static void
+_mongoc_client_prepare_killcursors_command (const int64_t *cursor_ids,
+                                            uint32_t n_cursors,
                                             const char *collection,
                                             bson_t *command)
 {
@@ -1654,7 +1680,7 @@ _mongoc_client_prepare_killcursors_command (int64_t cursor_id,
 
    bson_append_utf8 (command, "killCursors", 11, collection, -1);
    bson_append_array_begin (command, "cursors", 7, &child);
-   bson_append_int64 (&child, "0", 1, cursor_id);
+   _mongoc_client_append_cursor_ids (&child, cursor_ids, n_cursors);
    bson_append_array_end (command, &child);
 }
 
@@ -1685,11 +1711,12 @@ _mongoc_client_kill_cursor (mongoc_client_t *client,
    if (db && collection &&
        server_stream->sd->max_wire_version >= WIRE_VERSION_KILLCURSORS_CMD) {
       _mongoc_client_killcursors_command (
-         &client->cluster, server_stream, cursor_id, db, collection);
+         &client->cluster, server_stream, &cursor_id, 1, db, collection);
    } else {
       _mongoc_client_op_killcursors (&client->cluster,
                                      server_stream,
-                                     cursor_id,
+                                     &cursor_id,
+                                     1,
                                      operation_id,
                                      db,
                                      collection);
@@ -1701,10 +1728,174 @@ _mongoc_client_kill_cursor (mongoc_client_t *client,
 }
 
 
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_client_defer_kill_cursor --
+ *
+ *       Queue @cursor_id to be killed by the next call to
+ *       _mongoc_client_flush_kill_cursors.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+void
+_mongoc_client_defer_kill_cursor (mongoc_client_t *client,
+                                  uint32_t server_id,
+                                  int64_t cursor_id,
+                                  int64_t operation_id,
+                                  const char *db,
+                                  const char *collection)
+{
+   mongoc_deferred_kill_t kill;
+
+   ENTRY;
+
+   BSON_ASSERT (client);
+   BSON_ASSERT (cursor_id);
+   BSON_ASSERT (db);
+   BSON_ASSERT (collection);
+
+   kill.server_id = server_id;
+   kill.cursor_id = cursor_id;
+   kill.operation_id = operation_id;
+   kill.dblen = (uint32_t) strlen (db);
+   bson_snprintf (kill.ns, sizeof kill.ns, "%s.%s", db, collection);
+
+   _mongoc_array_append_val (&client->deferred_kills, kill);
+   mongoc_counter_cursors_kill_queued_inc ();
+
+   EXIT;
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_client_flush_kill_cursors --
+ *
+ *       Send the deferred killCursors for @server_id, or for all servers
+ *       if @server_id is 0. Cursor ids on the same server and namespace
+ *       are killed with a single killCursors command, or a single
+ *       OP_KILL_CURSORS message on older servers.
+ *
+ * Side effects:
+ *       Errors are ignored; if the server is unavailable the cursors are
+ *       left to time out on the server.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+void
+_mongoc_client_flush_kill_cursors (mongoc_client_t *client, uint32_t server_id)
+{
+   mongoc_array_t kills;
+   mongoc_array_t cursor_ids;
+   mongoc_deferred_kill_t *kill;
+   mongoc_deferred_kill_t *first;
+   mongoc_server_stream_t *server_stream;
+   char db[MONGOC_NAMESPACE_MAX];
+   size_t i;
+   size_t j;
+   size_t n_kept;
+
+   ENTRY;
+
+   BSON_ASSERT (client);
+
+   /* the connection is busy streaming an exhaust cursor */
+   if (!client->deferred_kills.len || client->in_exhaust) {
+      EXIT;
+   }
+
+   /* move the matching ids out of the queue first: fetching a stream below
+    * calls back into this function */
+   _mongoc_array_init (&kills, sizeof (mongoc_deferred_kill_t));
+   n_kept = 0;
+   for (i = 0; i < client->deferred_kills.len; i++) {
+      kill = &_mongoc_array_index (
+         &client->deferred_kills, mongoc_deferred_kill_t, i);
+
+      if (!server_id || kill->server_id == server_id) {
+         _mongoc_array_append_val (&kills, *kill);
+      } else {
+         _mongoc_array_index (
+            &client->deferred_kills, mongoc_deferred_kill_t, n_kept++) =
+            *kill;
+      }
+   }
+
+   client->deferred_kills.len = n_kept;
+
+   _mongoc_array_init (&cursor_ids, sizeof (int64_t));
+
+   for (i = 0; i < kills.len; i++) {
+      first = &_mongoc_array_index (&kills, mongoc_deferred_kill_t, i);
+      if (!first->cursor_id) {
+         /* already sent with an earlier group */
+         continue;
+      }
+
+      cursor_ids.len = 0;
+      for (j = i; j < kills.len; j++) {
+         kill = &_mongoc_array_index (&kills, mongoc_deferred_kill_t, j);
+         if (kill->cursor_id && kill->server_id == first->server_id &&
+             !strcmp (kill->ns, first->ns)) {
+            _mongoc_array_append_val (&cursor_ids, kill->cursor_id);
+            if (j > i) {
+               kill->cursor_id = 0;
+            }
+         }
+      }
+
+      /* don't attempt reconnect if server unavailable, and ignore errors */
+      server_stream = mongoc_cluster_stream_for_server (
+         &client->cluster, first->server_id, false, NULL);
+
+      first->cursor_id = 0;
+
+      if (!server_stream) {
+         continue;
+      }
+
+      bson_strncpy (db, first->ns, first->dblen + 1);
+
+      if (server_stream->sd->max_wire_version >=
+          WIRE_VERSION_KILLCURSORS_CMD) {
+         _mongoc_client_killcursors_command (
+            &client->cluster,
+            server_stream,
+            &_mongoc_array_index (&cursor_ids, int64_t, 0),
+            (uint32_t) cursor_ids.len,
+            db,
+            first->ns + first->dblen + 1);
+      } else {
+         _mongoc_client_op_killcursors (
+            &client->cluster,
+            server_stream,
+            &_mongoc_array_index (&cursor_ids, int64_t, 0),
+            (uint32_t) cursor_ids.len,
+            first->operation_id,
+            db,
+            first->ns + first->dblen + 1);
+      }
+
+      mongoc_counter_cursors_killed_add ((int64_t) cursor_ids.len);
+      mongoc_server_stream_cleanup (server_stream);
+   }
+
+   _mongoc_array_destroy (&cursor_ids);
+   _mongoc_array_destroy (&kills);
+
+   EXIT;
+}
+
+
 static void
 _mongoc_client_monitor_op_killcursors (mongoc_cluster_t *cluster,
                                        mongoc_server_stream_t *server_stream,
-                                       int64_t cursor_id,
+                                       const int64_t *cursor_ids,
+                                       uint32_t n_cursors,
                                        int64_t operation_id,
                                        const char *db,
                                        const char *collection)
@@ -1722,7 +1913,8 @@ _mongoc_client_monitor_op_killcursors (mongoc_cluster_t *cluster,
    }
 
    bson_init (&doc);
-   _mongoc_client_prepare_killcursors_command (cursor_id, collection, &doc);
+   _mongoc_client_prepare_killcursors_command (
+      cursor_ids, n_cursors, collection, &doc);
    mongoc_apm_command_started_init (&event,
                                     &doc,
                                     db,
@@ -1746,7 +1938,8 @@ _mongoc_client_monitor_op_killcursors_succeeded (
    mongoc_cluster_t *cluster,
    int64_t duration,
    mongoc_server_stream_t *server_stream,
-   int64_t cursor_id,
+   const int64_t *cursor_ids,
+   uint32_t n_cursors,
    int64_t operation_id)
 {
    mongoc_client_t *client;
@@ -1766,7 +1959,7 @@ _mongoc_client_monitor_op_killcursors_succeeded (
    bson_init (&doc);
    bson_append_int32 (&doc, "ok", 2, 1);
    bson_append_array_begin (&doc, "cursorsUnknown", 14, &cursors_unknown);
-   bson_append_int64 (&cursors_unknown, "0", 1, cursor_id);
+   _mongoc_client_append_cursor_ids (&cursors_unknown, cursor_ids, n_cursors);
    bson_append_array_end (&doc, &cursors_unknown);
 
    mongoc_apm_command_succeeded_init (&event,
@@ -1824,7 +2017,8 @@ _mongoc_client_monitor_op_killcursors_failed (
 static void
 _mongoc_client_op_killcursors (mongoc_cluster_t *cluster,
                                mongoc_server_stream_t *server_stream,
-                               int64_t cursor_id,
+                               const int64_t *cursor_ids,
+                               uint32_t n_cursors,
                                int64_t operation_id,
                                const char *db,
                                const char *collection)
@@ -1846,12 +2040,17 @@ _mongoc_client_op_killcursors (mongoc_cluster_t *cluster,
    rpc.kill_cursors.response_to = 0;
    rpc.kill_cursors.opcode = MONGOC_OPCODE_KILL_CURSORS;
    rpc.kill_cursors.zero = 0;
-   rpc.kill_cursors.cursors = &cursor_id;
-   rpc.kill_cursors.n_cursors = 1;
+   rpc.kill_cursors.cursors = (int64_t *) cursor_ids;
+   rpc.kill_cursors.n_cursors = (int32_t) n_cursors;
 
    if (has_ns) {
-      _mongoc_client_monitor_op_killcursors (
-         cluster, server_stream, cursor_id, operation_id, db, collection);
+      _mongoc_client_monitor_op_killcursors (cluster,
+                                             server_stream,
+                                             cursor_ids,
+                                             n_cursors,
+                                             operation_id,
+                                             db,
+                                             collection);
    }
 
    r = mongoc_cluster_sendv_to_server (
@@ -1863,7 +2062,8 @@ _mongoc_client_op_killcursors (mongoc_cluster_t *cluster,
             cluster,
             bson_get_monotonic_time () - started,
             server_stream,
-            cursor_id,
+            cursor_ids,
+            n_cursors,
             operation_id);
       } else {
          _mongoc_client_monitor_op_killcursors_failed (
@@ -1880,7 +2080,8 @@ _mongoc_client_op_killcursors (mongoc_cluster_t *cluster,
 static void
 _mongoc_client_killcursors_command (mongoc_cluster_t *cluster,
                                     mongoc_server_stream_t *server_stream,
-                                    int64_t cursor_id,
+                                    const int64_t *cursor_ids,
+                                    uint32_t n_cursors,
                                     const char *db,
                                     const char *collection)
 {
@@ -1889,7 +2090,8 @@ _mongoc_client_killcursors_command (mongoc_cluster_t *cluster,
    ENTRY;
 
    ++cluster->operation_id;
-   _mongoc_client_prepare_killcursors_command (cursor_id, collection, &command);
+   _mongoc_client_prepare_killcursors_command (
+      cursor_ids, n_cursors, collection, &command);
 
    /* Find, getMore And killCursors Commands Spec: "The result from the
     * killCursors command MAY be safely ignored."
@@ -2190,6 +2392,8 @@ mongoc_client_select_server (mongoc_client_t *client,
       return NULL;
    }
 
+   mongoc_cluster_read_pending_reply (&client->cluster);
+
    return mongoc_topology_select (client->topology,
                                   for_writes ? MONGOC_SS_WRITE : MONGOC_SS_READ,
                                   prefs,
@@ -2232,3 +2436,31 @@ mongoc_client_set_appname (mongoc_client_t *client, const char *appname)
 
    return _mongoc_topology_set_appname (client->topology, appname);
 }
+
+void
+mongoc_client_set_defer_kill_cursors (mongoc_client_t *client, bool defer)
+{
+   BSON_ASSERT (client);
+
+   client->defer_kill_cursors = defer;
+
+   if (!defer) {
+      _mongoc_client_flush_kill_cursors (client, 0);
+   }
+}
+
+bool
+mongoc_client_get_defer_kill_cursors (const mongoc_client_t *client)
+{
+   BSON_ASSERT (client);
+
+   return client->defer_kill_cursors;
+}
+
+void
+mongoc_client_flush_kill_cursors (mongoc_client_t *client)
+{
+   BSON_ASSERT (client);
+
+   _mongoc_client_flush_kill_cursors (client, 0);
+}
@@ -231,6 +231,12 @@ BSON_EXPORT (bool)
 mongoc_client_set_error_api (mongoc_client_t *client, int32_t version);
 BSON_EXPORT (bool)
 mongoc_client_set_appname (mongoc_client_t *client, const char *appname);
+BSON_EXPORT (void)
+mongoc_client_set_defer_kill_cursors (mongoc_client_t *client, bool defer);
+BSON_EXPORT (bool)
+mongoc_client_get_defer_kill_cursors (const mongoc_client_t *client);
+BSON_EXPORT (void)
+mongoc_client_flush_kill_cursors (mongoc_client_t *client);
 BSON_END_DECLS
 
 
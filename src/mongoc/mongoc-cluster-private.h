@@ -55,6 +55,10 @@ typedef struct _mongoc_cluster_node_t {
    int64_t timestamp;
 } mongoc_cluster_node_t;
 
+/* reads a reply that was requested ahead of time, see mongoc_cluster_t */
+typedef void (*mongoc_cluster_pending_reply_t) (void *ctx);
+
+
 typedef struct _mongoc_cluster_t {
    int64_t operation_id;
    uint32_t request_id;
@@ -67,6 +71,11 @@ typedef struct _mongoc_cluster_t {
 
    mongoc_set_t *nodes;
    mongoc_array_t iov;
+
+   /* a prefetching cursor's reply still unread on one of our streams. it is
+    * read before any stream is selected for another operation */
+   mongoc_cluster_pending_reply_t pending_reply;
+   void *pending_reply_ctx;
 } mongoc_cluster_t;
 
 void
@@ -80,6 +89,9 @@ mongoc_cluster_destroy (mongoc_cluster_t *cluster);
 void
 mongoc_cluster_disconnect_node (mongoc_cluster_t *cluster, uint32_t id);
 
+void
+mongoc_cluster_read_pending_reply (mongoc_cluster_t *cluster);
+
 int32_t
 mongoc_cluster_get_max_bson_obj_size (mongoc_cluster_t *cluster);
 
@@ -130,6 +142,15 @@ mongoc_cluster_run_command_monitored (mongoc_cluster_t *cluster,
                                       bson_t *reply,
                                       bson_error_t *error);
 
+bool
+mongoc_cluster_run_command_unacknowledged (
+   mongoc_cluster_t *cluster,
+   mongoc_server_stream_t *server_stream,
+   const char *db_name,
+   const bson_t *command,
+   int64_t operation_id,
+   bson_error_t *error);
+
 bool
 mongoc_cluster_run_command (mongoc_cluster_t *cluster,
                             mongoc_stream_t *stream,
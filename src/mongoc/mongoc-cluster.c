@@ -441,6 +441,223 @@ mongoc_cluster_run_command (mongoc_cluster_t *cluster,
                                                error);
 }
 
+static BSON_INLINE uint8_t *
+_mongoc_cluster_put_int32_le (uint8_t *pos, int32_t v)
+{
+   v = BSON_UINT32_TO_LE (v);
+   memcpy (pos, &v, sizeof v);
+
+   return pos + sizeof v;
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * mongoc_cluster_run_command_unacknowledged --
+ *
+ *       Send a command as an OP_MSG with the "moreToCome" flag set, so
+ *       the server does not reply and we do not wait for it. Used for
+ *       unacknowledged writes to servers whose maxWireVersion is at
+ *       least WIRE_VERSION_OP_MSG.
+ *
+ *       The body section is @command with a "$db" field appended; the
+ *       field is spliced in through the iovec list, so @command is not
+ *       copied and must not already contain "$db".
+ *
+ * Returns:
+ *       true if the message was written to the socket; otherwise false
+ *       and @error is set.
+ *
+ * Side effects:
+ *       If the client's APM callbacks are set, they are executed. As for
+ *       legacy unacknowledged writes, command-succeeded reports {ok: 1}.
+ *       On a network error the cluster disconnects from the server.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+bool
+mongoc_cluster_run_command_unacknowledged (
+   mongoc_cluster_t *cluster,
+   mongoc_server_stream_t *server_stream,
+   const char *db_name,
+   const bson_t *command,
+   int64_t operation_id,
+   bson_error_t *error)
+{
+   int64_t started;
+   const char *command_name;
+   mongoc_apm_callbacks_t *callbacks;
+   /* message header, flagBits, section kind, and body length */
+   uint8_t prefix[25];
+   /* "$db" element type, key, and string length */
+   uint8_t db_element[9];
+   uint8_t eoo = 0;
+   uint8_t *pos;
+   mongoc_iovec_t iov[5];
+   size_t db_len;
+   int32_t body_len;
+   int32_t msg_len;
+   int32_t max_msg_size;
+   uint32_t request_id;
+   uint32_t server_id;
+   bson_t ok = BSON_INITIALIZER;
+   mongoc_apm_command_started_t started_event;
+   mongoc_apm_command_succeeded_t succeeded_event;
+   mongoc_apm_command_failed_t failed_event;
+   bson_error_t err_local;
+   bool ret = false;
+
+   ENTRY;
+
+   BSON_ASSERT (cluster);
+   BSON_ASSERT (server_stream);
+   BSON_ASSERT (db_name);
+   BSON_ASSERT (command);
+
+   if (!error) {
+      error = &err_local;
+   }
+
+   command_name = _mongoc_get_command_name (command);
+   if (!command_name) {
+      bson_set_error (error,
+                      MONGOC_ERROR_COMMAND,
+                      MONGOC_ERROR_COMMAND_INVALID_ARG,
+                      "Empty command document");
+      RETURN (false);
+   }
+
+   if (cluster->client->in_exhaust) {
+      bson_set_error (error,
+                      MONGOC_ERROR_CLIENT,
+                      MONGOC_ERROR_CLIENT_IN_EXHAUST,
+                      "A cursor derived from this client is in exhaust.");
+      RETURN (false);
+   }
+
+   db_len = strlen (db_name);
+   body_len = (int32_t) (command->len + sizeof db_element + db_len + 1);
+   msg_len = (int32_t) (sizeof prefix - 4) + body_len;
+   max_msg_size = mongoc_server_stream_max_msg_size (server_stream);
+
+   if (msg_len > max_msg_size) {
+      bson_set_error (error,
+                      MONGOC_ERROR_CLIENT,
+                      MONGOC_ERROR_CLIENT_TOO_BIG,
+                      "Attempted to send an RPC larger than the "
+                      "max allowed message size. Was %u, allowed %u.",
+                      msg_len,
+                      max_msg_size);
+      RETURN (false);
+   }
+
+   server_id = server_stream->sd->id;
+   callbacks = &cluster->client->apm_callbacks;
+   started = bson_get_monotonic_time ();
+   request_id = ++cluster->request_id;
+
+   pos = _mongoc_cluster_put_int32_le (prefix, msg_len);
+   pos = _mongoc_cluster_put_int32_le (pos, (int32_t) request_id);
+   pos = _mongoc_cluster_put_int32_le (pos, 0);
+   pos = _mongoc_cluster_put_int32_le (pos, MONGOC_OPCODE_MSG);
+   pos = _mongoc_cluster_put_int32_le (
+      pos, (int32_t) MONGOC_OP_MSG_FLAG_MORE_TO_COME);
+   *pos++ = MONGOC_OP_MSG_SECTION_BODY;
+   _mongoc_cluster_put_int32_le (pos, body_len);
+
+   db_element[0] = BSON_TYPE_UTF8;
+   memcpy (&db_element[1], "$db", 4);
+   _mongoc_cluster_put_int32_le (&db_element[5], (int32_t) db_len + 1);
+
+   /* the body is @command without its length prefix and trailing NUL,
+    * followed by "$db": db_name and a new trailing NUL */
+   iov[0].iov_base = (void *) prefix;
+   iov[0].iov_len = sizeof prefix;
+   iov[1].iov_base = (void *) (bson_get_data (command) + 4);
+   iov[1].iov_len = command->len - 5;
+   iov[2].iov_base = (void *) db_element;
+   iov[2].iov_len = sizeof db_element;
+   iov[3].iov_base = (void *) db_name;
+   iov[3].iov_len = db_len + 1;
+   iov[4].iov_base = (void *) &eoo;
+   iov[4].iov_len = 1;
+
+   if (callbacks->started) {
+      mongoc_apm_command_started_init (&started_event,
+                                       command,
+                                       db_name,
+                                       command_name,
+                                       request_id,
+                                       operation_id,
+                                       &server_stream->sd->host,
+                                       server_id,
+                                       cluster->client->apm_context);
+
+      callbacks->started (&started_event);
+      mongoc_apm_command_started_cleanup (&started_event);
+   }
+
+   mongoc_counter_op_egress_total_inc ();
+   mongoc_counter_op_egress_msg_inc ();
+
+   if (!_mongoc_stream_writev_full (server_stream->stream,
+                                    iov,
+                                    sizeof iov / sizeof iov[0],
+                                    cluster->sockettimeoutms,
+                                    error)) {
+      mongoc_cluster_disconnect_node (cluster, server_id);
+
+      _bson_error_message_printf (
+         error,
+         "Failed to send \"%s\" command with database \"%s\": %s",
+         command_name,
+         db_name,
+         error->message);
+
+      if (callbacks->failed) {
+         mongoc_apm_command_failed_init (&failed_event,
+                                         bson_get_monotonic_time () - started,
+                                         command_name,
+                                         error,
+                                         request_id,
+                                         operation_id,
+                                         &server_stream->sd->host,
+                                         server_id,
+                                         cluster->client->apm_context);
+
+         callbacks->failed (&failed_event);
+         mongoc_apm_command_failed_cleanup (&failed_event);
+      }
+
+      GOTO (done);
+   }
+
+   ret = true;
+
+   if (callbacks->succeeded) {
+      BSON_APPEND_INT32 (&ok, "ok", 1);
+      mongoc_apm_command_succeeded_init (&succeeded_event,
+                                         bson_get_monotonic_time () - started,
+                                         &ok,
+                                         command_name,
+                                         request_id,
+                                         operation_id,
+                                         &server_stream->sd->host,
+                                         server_id,
+                                         cluster->client->apm_context);
+
+      callbacks->succeeded (&succeeded_event);
+      mongoc_apm_command_succeeded_cleanup (&succeeded_event);
+   }
+
+done:
+   bson_destroy (&ok);
+
+   RETURN (ret);
+}
+
 /*
  *--------------------------------------------------------------------------
  *
@@ -1178,6 +1395,35 @@ mongoc_cluster_disconnect_node (mongoc_cluster_t *cluster, uint32_t server_id)
    EXIT;
 }
 
+/*
+ *--------------------------------------------------------------------------
+ *
+ * mongoc_cluster_read_pending_reply --
+ *
+ *       If a cursor sent a request ahead of time and has not read the
+ *       reply, have it read the reply now, so the stream can be used for
+ *       another request.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+void
+mongoc_cluster_read_pending_reply (mongoc_cluster_t *cluster)
+{
+   mongoc_cluster_pending_reply_t pending_reply;
+   void *ctx;
+
+   pending_reply = cluster->pending_reply;
+   ctx = cluster->pending_reply_ctx;
+
+   if (pending_reply) {
+      cluster->pending_reply = NULL;
+      cluster->pending_reply_ctx = NULL;
+      pending_reply (ctx);
+   }
+}
+
+
 static void
 _mongoc_cluster_node_destroy (mongoc_cluster_node_t *node)
 {
@@ -1380,6 +1626,11 @@ _mongoc_cluster_stream_for_server (mongoc_cluster_t *cluster,
 
    topology = cluster->client->topology;
 
+   mongoc_cluster_read_pending_reply (cluster);
+
+   /* send deferred killCursors ahead of the next message to this server */
+   _mongoc_client_flush_kill_cursors (cluster->client, server_id);
+
    /* in the single-threaded use case we share topology's streams */
    if (topology->single_threaded) {
       server_stream = mongoc_cluster_fetch_stream_single (
@@ -1734,6 +1985,9 @@ _mongoc_cluster_stream_for_optype (mongoc_cluster_t *cluster,
 
    BSON_ASSERT (cluster);
 
+   /* server selection may check a stream with "isMaster" */
+   mongoc_cluster_read_pending_reply (cluster);
+
    server_id =
       mongoc_topology_select_server_id (topology, optype, read_prefs, error);
 
@@ -31,6 +31,7 @@
 #include "mongoc-error.h"
 #include "mongoc-index.h"
 #include "mongoc-log.h"
+#include "mongoc-query-cache-private.h"
 #include "mongoc-trace-private.h"
 #include "mongoc-read-concern-private.h"
 #include "mongoc-write-concern-private.h"
@@ -597,6 +598,8 @@ mongoc_collection_find_with_opts (mongoc_collection_t *collection,
                                   const bson_t *opts,
                                   const mongoc_read_prefs_t *read_prefs)
 {
+   mongoc_cursor_t *cursor;
+
    BSON_ASSERT (collection);
    BSON_ASSERT (filter);
 
@@ -606,7 +609,7 @@ mongoc_collection_find_with_opts (mongoc_collection_t *collection,
       read_prefs = collection->read_prefs;
    }
 
-   return _mongoc_cursor_new_with_opts (
+   cursor = _mongoc_cursor_new_with_opts (
       collection->client,
       collection->ns,
       false /* is_command */,
@@ -614,6 +617,14 @@ mongoc_collection_find_with_opts (mongoc_collection_t *collection,
       opts,
       COALESCE (read_prefs, collection->read_prefs),
       collection->read_concern);
+
+   /* set by mongoc_client_pool_pop */
+   if (collection->client->query_cache) {
+      cursor =
+         _mongoc_query_cache_find (collection->client->query_cache, cursor);
+   }
+
+   return cursor;
 }
 
 
@@ -1563,18 +1574,6 @@ mongoc_collection_insert_bulk (mongoc_collection_t *collection,
       write_concern = collection->write_concern;
    }
 
-   if (!(flags & MONGOC_INSERT_NO_VALIDATE)) {
-      for (i = 0; i < n_documents; i++) {
-         if (!_mongoc_validate_new_document (documents[i], error)) {
-            RETURN (false);
-         }
-      }
-   }
-
-   bson_clear (&collection->gle);
-
-   _mongoc_write_result_init (&result);
-
    write_flags.ordered = !(flags & MONGOC_INSERT_CONTINUE_ON_ERROR);
 
    _mongoc_write_command_init_insert (
@@ -1584,10 +1583,23 @@ mongoc_collection_insert_bulk (mongoc_collection_t *collection,
       ++collection->client->cluster.operation_id,
       true);
 
+   /* validate each document, and find its "_id" in the same walk, just
+    * before copying it */
    for (i = 0; i < n_documents; i++) {
-      _mongoc_write_command_insert_append (&command, documents[i]);
+      if (!_mongoc_write_command_insert_append_validated (
+             &command,
+             documents[i],
+             !(flags & MONGOC_INSERT_NO_VALIDATE),
+             error)) {
+         _mongoc_write_command_destroy (&command);
+         RETURN (false);
+      }
    }
 
+   bson_clear (&collection->gle);
+
+   _mongoc_write_result_init (&result);
+
    _mongoc_collection_write_command_execute (
       &command, collection, write_concern, &result);
 
@@ -1658,19 +1670,21 @@ mongoc_collection_insert (mongoc_collection_t *collection,
       write_concern = collection->write_concern;
    }
 
-   if (!(flags & MONGOC_INSERT_NO_VALIDATE) &&
-       !_mongoc_validate_new_document (document, error)) {
-      RETURN (false);
-   }
-
-   _mongoc_write_result_init (&result);
    _mongoc_write_command_init_insert (
       &command,
-      document,
+      NULL,
       write_flags,
       ++collection->client->cluster.operation_id,
       false);
 
+   if (!_mongoc_write_command_insert_append_validated (
+          &command, document, !(flags & MONGOC_INSERT_NO_VALIDATE), error)) {
+      _mongoc_write_command_destroy (&command);
+      RETURN (false);
+   }
+
+   _mongoc_write_result_init (&result);
+
    _mongoc_collection_write_command_execute (
       &command, collection, write_concern, &result);
 
@@ -0,0 +1,638 @@
+/*
+ * Copyright 2017 MongoDB, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <string.h>
+
+#include "mongoc-columnar.h"
+#include "mongoc-error.h"
+#include "mongoc-trace-private.h"
+
+
+#undef MONGOC_LOG_DOMAIN
+#define MONGOC_LOG_DOMAIN "columnar"
+
+
+typedef struct {
+   char *path;
+   bson_type_t type;
+   void *values;         /* n_alloc values of the column's C type */
+   uint32_t *lengths;    /* string lengths, for BSON_TYPE_UTF8 only */
+   uint8_t *null_bitmap; /* bit set if the row's value is null or missing */
+} mongoc_columnar_column_t;
+
+
+/* one path component; a node may be both a column and a parent, as when
+ * decoding both "a" and "a.b" */
+typedef struct _mongoc_columnar_node_t {
+   char *key;
+   int32_t column; /* -1 if only a parent */
+   struct _mongoc_columnar_node_t *children;
+   uint32_t n_children;
+} mongoc_columnar_node_t;
+
+
+struct _mongoc_columnar_t {
+   mongoc_columnar_column_t *columns;
+   uint32_t n_columns;
+   mongoc_columnar_node_t root;
+   uint32_t n_rows;
+   uint32_t n_alloc;
+};
+
+
+static size_t
+_mongoc_columnar_value_size (bson_type_t type)
+{
+   switch (type) {
+   case BSON_TYPE_INT32:
+      return sizeof (int32_t);
+   case BSON_TYPE_INT64:
+   case BSON_TYPE_DATE_TIME:
+      return sizeof (int64_t);
+   case BSON_TYPE_DOUBLE:
+      return sizeof (double);
+   case BSON_TYPE_BOOL:
+      return sizeof (bool);
+   case BSON_TYPE_OID:
+      return sizeof (bson_oid_t);
+   case BSON_TYPE_UTF8:
+      return sizeof (const char *);
+   default:
+      return 0;
+   }
+}
+
+
+static void
+_mongoc_columnar_node_destroy (mongoc_columnar_node_t *node)
+{
+   uint32_t i;
+
+   for (i = 0; i < node->n_children; i++) {
+      _mongoc_columnar_node_destroy (&node->children[i]);
+   }
+
+   bson_free (node->children);
+   bson_free (node->key);
+}
+
+
+mongoc_columnar_t *
+mongoc_columnar_new (void)
+{
+   mongoc_columnar_t *columns;
+
+   columns = (mongoc_columnar_t *) bson_malloc0 (sizeof *columns);
+   columns->root.column = -1;
+
+   return columns;
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * mongoc_columnar_add_column --
+ *
+ *       Add a column that decodes the value at the dotted @path, which
+ *       must be of @type. BSON_TYPE_INT64 columns also accept int32
+ *       values, and BSON_TYPE_DOUBLE columns accept any number. Other
+ *       values are decoded as null.
+ *
+ *       Columns are numbered in the order they are added.
+ *
+ * Returns:
+ *       True on success, false if @path or @type is invalid and @error
+ *       is set.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+bool
+mongoc_columnar_add_column (mongoc_columnar_t *columns,
+                            const char *path,
+                            bson_type_t type,
+                            bson_error_t *error)
+{
+   mongoc_columnar_column_t *column;
+   mongoc_columnar_node_t *node;
+   mongoc_columnar_node_t *child;
+   const char *key;
+   const char *dot;
+   size_t key_len;
+   uint32_t i;
+
+   ENTRY;
+
+   BSON_ASSERT (columns);
+   BSON_ASSERT (path);
+
+   if (!_mongoc_columnar_value_size (type)) {
+      bson_set_error (error,
+                      MONGOC_ERROR_COMMAND,
+                      MONGOC_ERROR_COMMAND_INVALID_ARG,
+                      "Cannot decode BSON type 0x%02x into a column",
+                      (int) type);
+      RETURN (false);
+   }
+
+   if (!*path || path[strlen (path) - 1] == '.' || strstr (path, "..") ||
+       *path == '.') {
+      bson_set_error (error,
+                      MONGOC_ERROR_COMMAND,
+                      MONGOC_ERROR_COMMAND_INVALID_ARG,
+                      "Invalid column path: \"%s\"",
+                      path);
+      RETURN (false);
+   }
+
+   /* find or create the path's node, one component at a time */
+   node = &columns->root;
+   key = path;
+   for (;;) {
+      dot = strchr (key, '.');
+      key_len = dot ? (size_t) (dot - key) : strlen (key);
+
+      child = NULL;
+      for (i = 0; i < node->n_children; i++) {
+         if (strlen (node->children[i].key) == key_len &&
+             !memcmp (node->children[i].key, key, key_len)) {
+            child = &node->children[i];
+            break;
+         }
+      }
+
+      if (!child) {
+         node->children = (mongoc_columnar_node_t *) bson_realloc (
+            node->children, (node->n_children + 1) * sizeof *child);
+         child = &node->children[node->n_children++];
+         memset (child, 0, sizeof *child);
+         child->key = bson_strndup (key, key_len);
+         child->column = -1;
+      }
+
+      node = child;
+      if (!dot) {
+         break;
+      }
+
+      key = dot + 1;
+   }
+
+   if (node->column >= 0) {
+      bson_set_error (error,
+                      MONGOC_ERROR_COMMAND,
+                      MONGOC_ERROR_COMMAND_INVALID_ARG,
+                      "Duplicate column path: \"%s\"",
+                      path);
+      RETURN (false);
+   }
+
+   node->column = (int32_t) columns->n_columns;
+
+   columns->columns = (mongoc_columnar_column_t *) bson_realloc (
+      columns->columns, (columns->n_columns + 1) * sizeof *column);
+   column = &columns->columns[columns->n_columns++];
+   memset (column, 0, sizeof *column);
+   column->path = bson_strdup (path);
+   column->type = type;
+
+   /* storage is allocated for the next batch */
+   columns->n_rows = 0;
+   columns->n_alloc = 0;
+
+   RETURN (true);
+}
+
+
+uint32_t
+mongoc_columnar_get_n_columns (const mongoc_columnar_t *columns)
+{
+   BSON_ASSERT (columns);
+
+   return columns->n_columns;
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_columnar_reserve --
+ *
+ *       Make room for @n_rows rows in each column, set every row null,
+ *       and zero the values.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+static void
+_mongoc_columnar_reserve (mongoc_columnar_t *columns, uint32_t n_rows)
+{
+   mongoc_columnar_column_t *column;
+   size_t value_size;
+   uint32_t i;
+
+   for (i = 0; i < columns->n_columns; i++) {
+      column = &columns->columns[i];
+      value_size = _mongoc_columnar_value_size (column->type);
+
+      if (n_rows > columns->n_alloc || !column->values) {
+         column->values =
+            bson_realloc (column->values, BSON_MAX (n_rows, 1) * value_size);
+         column->null_bitmap = (uint8_t *) bson_realloc (
+            column->null_bitmap, BSON_MAX (n_rows, 1) / 8 + 1);
+         if (column->type == BSON_TYPE_UTF8) {
+            column->lengths = (uint32_t *) bson_realloc (
+               column->lengths, BSON_MAX (n_rows, 1) * sizeof (uint32_t));
+         }
+      }
+
+      memset (column->values, 0, n_rows * value_size);
+      memset (column->null_bitmap, 0xff, n_rows / 8 + 1);
+      if (column->lengths) {
+         memset (column->lengths, 0, n_rows * sizeof (uint32_t));
+      }
+   }
+
+   columns->n_alloc = BSON_MAX (columns->n_alloc, n_rows);
+   columns->n_rows = n_rows;
+}
+
+
+static void
+_mongoc_columnar_set (mongoc_columnar_column_t *column,
+                      const bson_iter_t *iter,
+                      uint32_t row)
+{
+   uint8_t mask = (uint8_t) (1 << (row % 8));
+
+   if (!(column->null_bitmap[row / 8] & mask)) {
+      /* duplicate key, the first one wins */
+      return;
+   }
+
+   switch (column->type) {
+   case BSON_TYPE_INT32:
+      if (!BSON_ITER_HOLDS_INT32 (iter)) {
+         return;
+      }
+
+      ((int32_t *) column->values)[row] = bson_iter_int32 (iter);
+      break;
+   case BSON_TYPE_INT64:
+      if (!BSON_ITER_HOLDS_INT32 (iter) && !BSON_ITER_HOLDS_INT64 (iter)) {
+         return;
+      }
+
+      ((int64_t *) column->values)[row] = bson_iter_as_int64 (iter);
+      break;
+   case BSON_TYPE_DATE_TIME:
+      if (!BSON_ITER_HOLDS_DATE_TIME (iter)) {
+         return;
+      }
+
+      ((int64_t *) column->values)[row] = bson_iter_date_time (iter);
+      break;
+   case BSON_TYPE_DOUBLE:
+      if (BSON_ITER_HOLDS_DOUBLE (iter)) {
+         ((double *) column->values)[row] = bson_iter_double (iter);
+      } else if (BSON_ITER_HOLDS_INT32 (iter) || BSON_ITER_HOLDS_INT64 (iter)) {
+         ((double *) column->values)[row] = (double) bson_iter_as_int64 (iter);
+      } else {
+         return;
+      }
+
+      break;
+   case BSON_TYPE_BOOL:
+      if (!BSON_ITER_HOLDS_BOOL (iter)) {
+         return;
+      }
+
+      ((bool *) column->values)[row] = bson_iter_bool (iter);
+      break;
+   case BSON_TYPE_OID:
+      if (!BSON_ITER_HOLDS_OID (iter)) {
+         return;
+      }
+
+      bson_oid_copy (bson_iter_oid (iter),
+                     &((bson_oid_t *) column->values)[row]);
+      break;
+   case BSON_TYPE_UTF8:
+      if (!BSON_ITER_HOLDS_UTF8 (iter)) {
+         return;
+      }
+
+      /* points into the cursor's buffer */
+      ((const char **) column->values)[row] =
+         bson_iter_utf8 (iter, &column->lengths[row]);
+      break;
+   default:
+      BSON_ASSERT (false);
+      return;
+   }
+
+   column->null_bitmap[row / 8] &= (uint8_t) ~mask;
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_columnar_walk --
+ *
+ *       Decode one level of a document: each key is compared only with the
+ *       path components at this level, and the walk stops once all of
+ *       them are found.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+static void
+_mongoc_columnar_walk (mongoc_columnar_t *columns,
+                       const mongoc_columnar_node_t *node,
+                       bson_iter_t *iter,
+                       uint32_t row)
+{
+   const mongoc_columnar_node_t *child;
+   bson_iter_t child_iter;
+   const char *key;
+   uint32_t n_found = 0;
+   uint32_t i;
+
+   while (n_found < node->n_children && bson_iter_next (iter)) {
+      key = bson_iter_key (iter);
+      child = NULL;
+
+      for (i = 0; i < node->n_children; i++) {
+         if (!strcmp (key, node->children[i].key)) {
+            child = &node->children[i];
+            break;
+         }
+      }
+
+      if (!child) {
+         continue;
+      }
+
+      n_found++;
+
+      if (child->column >= 0) {
+         _mongoc_columnar_set (&columns->columns[child->column], iter, row);
+      }
+
+      if (child->n_children &&
+          (BSON_ITER_HOLDS_DOCUMENT (iter) || BSON_ITER_HOLDS_ARRAY (iter)) &&
+          bson_iter_recurse (iter, &child_iter)) {
+         _mongoc_columnar_walk (columns, child, &child_iter, row);
+      }
+   }
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * mongoc_cursor_next_columnar --
+ *
+ *       Get the cursor's next batch with mongoc_cursor_next_batch, and
+ *       decode the batch into @columns, one row per document.
+ *
+ *       Strings are not copied: they point into the cursor's buffer and
+ *       are valid until the cursor is advanced or destroyed.
+ *
+ * Returns:
+ *       True if at least one document was decoded. False if there was an
+ *       error or the cursor was exhausted, see mongoc_cursor_error().
+ *
+ *--------------------------------------------------------------------------
+ */
+
+bool
+mongoc_cursor_next_columnar (mongoc_cursor_t *cursor,
+                             mongoc_columnar_t *columns)
+{
+   const uint8_t *data;
+   size_t data_len;
+   const uint32_t *offsets;
+   uint32_t n_docs;
+   uint32_t doc_len;
+   uint32_t i;
+   bson_t doc;
+   bson_iter_t iter;
+
+   ENTRY;
+
+   BSON_ASSERT (cursor);
+   BSON_ASSERT (columns);
+
+   columns->n_rows = 0;
+
+   if (!mongoc_cursor_next_batch (
+          cursor, &data, &data_len, &offsets, &n_docs)) {
+      RETURN (false);
+   }
+
+   _mongoc_columnar_reserve (columns, n_docs);
+
+   for (i = 0; i < n_docs; i++) {
+      memcpy (&doc_len, data + offsets[i], sizeof doc_len);
+      doc_len = BSON_UINT32_FROM_LE (doc_len);
+
+      if (!bson_init_static (&doc, data + offsets[i], doc_len) ||
+          !bson_iter_init (&iter, &doc)) {
+         /* leave the row null */
+         continue;
+      }
+
+      _mongoc_columnar_walk (columns, &columns->root, &iter, i);
+   }
+
+   RETURN (true);
+}
+
+
+uint32_t
+mongoc_columnar_get_n_rows (const mongoc_columnar_t *columns)
+{
+   BSON_ASSERT (columns);
+
+   return columns->n_rows;
+}
+
+
+static const mongoc_columnar_column_t *
+_mongoc_columnar_get (const mongoc_columnar_t *columns,
+                      uint32_t column,
+                      bson_type_t type)
+{
+   BSON_ASSERT (columns);
+
+   if (column >= columns->n_columns || !columns->n_rows) {
+      return NULL;
+   }
+
+   if (type != BSON_TYPE_EOD && columns->columns[column].type != type) {
+      return NULL;
+   }
+
+   return &columns->columns[column];
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * mongoc_columnar_get_null_bitmap --
+ *
+ *       Get a bitmap with one bit per row, least significant bit first.
+ *       A set bit means the row's value was missing, null, or of another
+ *       type, and its value in the column is zero.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+const uint8_t *
+mongoc_columnar_get_null_bitmap (const mongoc_columnar_t *columns,
+                                 uint32_t column)
+{
+   const mongoc_columnar_column_t *c;
+
+   c = _mongoc_columnar_get (columns, column, BSON_TYPE_EOD);
+
+   return c ? c->null_bitmap : NULL;
+}
+
+
+bool
+mongoc_columnar_is_null (const mongoc_columnar_t *columns,
+                         uint32_t column,
+                         uint32_t row)
+{
+   const mongoc_columnar_column_t *c;
+
+   c = _mongoc_columnar_get (columns, column, BSON_TYPE_EOD);
+   if (!c || row >= columns->n_rows) {
+      return true;
+   }
+
+   return (c->null_bitmap[row / 8] & (1 << (row % 8))) != 0;
+}
+
+
+const int32_t *
+mongoc_columnar_get_int32 (const mongoc_columnar_t *columns, uint32_t column)
+{
+   const mongoc_columnar_column_t *c;
+
+   c = _mongoc_columnar_get (columns, column, BSON_TYPE_INT32);
+
+   return c ? (const int32_t *) c->values : NULL;
+}
+
+
+const int64_t *
+mongoc_columnar_get_int64 (const mongoc_columnar_t *columns, uint32_t column)
+{
+   const mongoc_columnar_column_t *c;
+
+   c = _mongoc_columnar_get (columns, column, BSON_TYPE_INT64);
+   if (!c) {
+      c = _mongoc_columnar_get (columns, column, BSON_TYPE_DATE_TIME);
+   }
+
+   return c ? (const int64_t *) c->values : NULL;
+}
+
+
+const double *
+mongoc_columnar_get_double (const mongoc_columnar_t *columns, uint32_t column)
+{
+   const mongoc_columnar_column_t *c;
+
+   c = _mongoc_columnar_get (columns, column, BSON_TYPE_DOUBLE);
+
+   return c ? (const double *) c->values : NULL;
+}
+
+
+const bool *
+mongoc_columnar_get_bool (const mongoc_columnar_t *columns, uint32_t column)
+{
+   const mongoc_columnar_column_t *c;
+
+   c = _mongoc_columnar_get (columns, column, BSON_TYPE_BOOL);
+
+   return c ? (const bool *) c->values : NULL;
+}
+
+
+const bson_oid_t *
+mongoc_columnar_get_oid (const mongoc_columnar_t *columns, uint32_t column)
+{
+   const mongoc_columnar_column_t *c;
+
+   c = _mongoc_columnar_get (columns, column, BSON_TYPE_OID);
+
+   return c ? (const bson_oid_t *) c->values : NULL;
+}
+
+
+const char *const *
+mongoc_columnar_get_utf8 (const mongoc_columnar_t *columns,
+                          uint32_t column,
+                          const uint32_t **lengths)
+{
+   const mongoc_columnar_column_t *c;
+
+   c = _mongoc_columnar_get (columns, column, BSON_TYPE_UTF8);
+   if (!c) {
+      if (lengths) {
+         *lengths = NULL;
+      }
+
+      return NULL;
+   }
+
+   if (lengths) {
+      *lengths = c->lengths;
+   }
+
+   return (const char *const *) c->values;
+}
+
+
+void
+mongoc_columnar_destroy (mongoc_columnar_t *columns)
+{
+   uint32_t i;
+
+   if (!columns) {
+      return;
+   }
+
+   for (i = 0; i < columns->n_columns; i++) {
+      bson_free (columns->columns[i].path);
+      bson_free (columns->columns[i].values);
+      bson_free (columns->columns[i].lengths);
+      bson_free (columns->columns[i].null_bitmap);
+   }
+
+   _mongoc_columnar_node_destroy (&columns->root);
+   bson_free (columns->columns);
+   bson_free (columns);
+}
@@ -0,0 +1,86 @@
+/*
+ * Copyright 2017 MongoDB, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MONGOC_COLUMNAR_H
+#define MONGOC_COLUMNAR_H
+
+#if !defined(MONGOC_INSIDE) && !defined(MONGOC_COMPILATION)
+#error "Only <mongoc.h> can be included directly."
+#endif
+
+#include <bson.h>
+
+#include "mongoc-cursor.h"
+
+BSON_BEGIN_DECLS
+
+typedef struct _mongoc_columnar_t mongoc_columnar_t;
+
+BSON_EXPORT (mongoc_columnar_t *)
+mongoc_columnar_new (void);
+
+BSON_EXPORT (bool)
+mongoc_columnar_add_column (mongoc_columnar_t *columns,
+                            const char *path,
+                            bson_type_t type,
+                            bson_error_t *error);
+
+BSON_EXPORT (uint32_t)
+mongoc_columnar_get_n_columns (const mongoc_columnar_t *columns);
+
+BSON_EXPORT (bool)
+mongoc_cursor_next_columnar (mongoc_cursor_t *cursor,
+                             mongoc_columnar_t *columns);
+
+BSON_EXPORT (uint32_t)
+mongoc_columnar_get_n_rows (const mongoc_columnar_t *columns);
+
+BSON_EXPORT (const uint8_t *)
+mongoc_columnar_get_null_bitmap (const mongoc_columnar_t *columns,
+                                 uint32_t column);
+
+BSON_EXPORT (bool)
+mongoc_columnar_is_null (const mongoc_columnar_t *columns,
+                         uint32_t column,
+                         uint32_t row);
+
+BSON_EXPORT (const int32_t *)
+mongoc_columnar_get_int32 (const mongoc_columnar_t *columns, uint32_t column);
+
+BSON_EXPORT (const int64_t *)
+mongoc_columnar_get_int64 (const mongoc_columnar_t *columns, uint32_t column);
+
+BSON_EXPORT (const double *)
+mongoc_columnar_get_double (const mongoc_columnar_t *columns, uint32_t column);
+
+BSON_EXPORT (const bool *)
+mongoc_columnar_get_bool (const mongoc_columnar_t *columns, uint32_t column);
+
+BSON_EXPORT (const bson_oid_t *)
+mongoc_columnar_get_oid (const mongoc_columnar_t *columns, uint32_t column);
+
+BSON_EXPORT (const char *const *)
+mongoc_columnar_get_utf8 (const mongoc_columnar_t *columns,
+                          uint32_t column,
+                          const uint32_t **lengths);
+
+BSON_EXPORT (void)
+mongoc_columnar_destroy (mongoc_columnar_t *columns);
+
+BSON_END_DECLS
+
+
+#endif /* MONGOC_COLUMNAR_H */
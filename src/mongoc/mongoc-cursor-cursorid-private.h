@@ -45,6 +45,10 @@ _mongoc_cursor_cursorid_prime (mongoc_cursor_t *cursor);
 bool
 _mongoc_cursor_cursorid_next (mongoc_cursor_t *cursor, const bson_t **bson);
 void
+_mongoc_cursor_cursorid_next_batch (mongoc_cursor_t *cursor,
+                                    const bson_t *first,
+                                    uint32_t max_docs);
+void
 _mongoc_cursor_cursorid_init (mongoc_cursor_t *cursor, const bson_t *command);
 bool
 _mongoc_cursor_prepare_getmore_command (mongoc_cursor_t *cursor,
@@ -18,11 +18,13 @@
 #include "mongoc-cursor.h"
 #include "mongoc-cursor-private.h"
 #include "mongoc-cursor-cursorid-private.h"
+#include "mongoc-apm-private.h"
 #include "mongoc-log.h"
 #include "mongoc-trace-private.h"
 #include "mongoc-error.h"
 #include "mongoc-util-private.h"
 #include "mongoc-client-private.h"
+#include "mongoc-read-prefs-private.h"
 
 
 #undef MONGOC_LOG_DOMAIN
@@ -76,6 +78,9 @@ _mongoc_cursor_cursorid_start_batch (mongoc_cursor_t *cursor)
    bson_iter_t child;
    const char *ns;
    uint32_t nslen;
+   const uint8_t *data;
+   uint32_t data_len;
+   bson_t batch;
 
    cid = (mongoc_cursor_cursorid_t *) cursor->iface_data;
 
@@ -94,6 +99,13 @@ _mongoc_cursor_cursorid_start_batch (mongoc_cursor_t *cursor)
             if (BSON_ITER_HOLDS_ARRAY (&child) &&
                 bson_iter_recurse (&child, &cid->batch_iter)) {
                cid->in_batch = true;
+
+               if (cursor->adaptive.max_bytes) {
+                  bson_iter_array (&child, &data_len, &data);
+                  BSON_ASSERT (bson_init_static (&batch, data, data_len));
+                  _mongoc_cursor_adaptive_reply (
+                     cursor, data_len, bson_count_keys (&batch));
+               }
             }
          }
       }
@@ -103,6 +115,393 @@ _mongoc_cursor_cursorid_start_batch (mongoc_cursor_t *cursor)
 }
 
 
+/* if prefetch is enabled, request the batch after the one in cid->array */
+static void
+_mongoc_cursor_cursorid_prefetch (mongoc_cursor_t *cursor)
+{
+   mongoc_cursor_cursorid_t *cid;
+   mongoc_server_stream_t *server_stream;
+   bson_iter_t iter;
+   bson_error_t error;
+   int64_t ahead = 0;
+
+   ENTRY;
+
+   cid = (mongoc_cursor_cursorid_t *) cursor->iface_data;
+
+   /* a streaming cursor has its getMores in flight already */
+   if (!cursor->prefetch.enabled || cursor->stream.depth ||
+       !mongoc_cursor_get_id (cursor)) {
+      EXIT;
+   }
+
+   server_stream = mongoc_cluster_stream_for_server (
+      &cursor->client->cluster, cursor->server_id, false, &error);
+
+   if (!server_stream) {
+      /* the getMore will report the error */
+      EXIT;
+   }
+
+   memcpy (&iter, &cid->batch_iter, sizeof iter);
+   while (bson_iter_next (&iter)) {
+      ahead++;
+   }
+
+   _mongoc_cursor_prefetch_send (cursor,
+                                 server_stream,
+                                 ahead,
+                                 _use_getmore_command (cursor, server_stream));
+
+   mongoc_server_stream_cleanup (server_stream);
+
+   EXIT;
+}
+
+
+/* the cursor id in a getMore reply, or 0 if the cursor is closed */
+static int64_t
+_mongoc_cursor_cursorid_reply_id (const bson_t *reply)
+{
+   bson_iter_t iter;
+
+   if (bson_iter_init_find (&iter, reply, "cursor") &&
+       BSON_ITER_HOLDS_DOCUMENT (&iter) && bson_iter_recurse (&iter, &iter) &&
+       bson_iter_find (&iter, "id")) {
+      return bson_iter_as_int64 (&iter);
+   }
+
+   return 0;
+}
+
+
+/* send one more getMore command on cursor->stream.server_stream */
+static bool
+_mongoc_cursor_cursorid_stream_send (mongoc_cursor_t *cursor)
+{
+   mongoc_cursor_stream_t *stream;
+   mongoc_client_t *client;
+   mongoc_cluster_t *cluster;
+   mongoc_server_stream_t *server_stream;
+   mongoc_cursor_stream_request_t request;
+   mongoc_query_flags_t flags;
+   mongoc_apply_read_prefs_result_t result = READ_PREFS_RESULT_INIT;
+   mongoc_apm_command_started_t event;
+   mongoc_rpc_t rpc;
+   bson_t command;
+   char db[MONGOC_NAMESPACE_MAX];
+   char cmd_ns[MONGOC_NAMESPACE_MAX];
+   bool ret = false;
+
+   ENTRY;
+
+   stream = &cursor->stream;
+   client = cursor->client;
+   cluster = &client->cluster;
+   server_stream = stream->server_stream;
+
+   if (!_mongoc_cursor_flags (cursor, server_stream, &flags)) {
+      RETURN (false);
+   }
+
+   bson_strncpy (db, cursor->ns, cursor->dblen + 1);
+   bson_snprintf (cmd_ns, sizeof cmd_ns, "%s.$cmd", db);
+
+   _mongoc_cursor_prepare_getmore_command (cursor, &command);
+   apply_read_preferences (
+      cursor->read_prefs, server_stream, &command, flags, &result);
+   _mongoc_rpc_prep_command (
+      &rpc, cmd_ns, result.query_with_read_prefs, result.flags);
+
+   request.request_id = ++cluster->request_id;
+   rpc.query.request_id = request.request_id;
+
+   if (client->apm_callbacks.started) {
+      mongoc_apm_command_started_init (&event,
+                                       result.query_with_read_prefs,
+                                       db,
+                                       "getMore",
+                                       request.request_id,
+                                       cursor->operation_id,
+                                       &server_stream->sd->host,
+                                       server_stream->sd->id,
+                                       client->apm_context);
+
+      client->apm_callbacks.started (&event);
+      mongoc_apm_command_started_cleanup (&event);
+   }
+
+   request.started = bson_get_monotonic_time ();
+
+   if (mongoc_cluster_sendv_to_server (
+          cluster, &rpc, 1, server_stream, NULL, &stream->error)) {
+      _mongoc_array_append_val (&stream->requests, request);
+      ret = true;
+   } else {
+      /* the cluster closed the connection, earlier replies are lost */
+      stream->requests.len = 0;
+      stream->closed = true;
+      stream->failed = true;
+   }
+
+   apply_read_prefs_result_cleanup (&result);
+   bson_destroy (&command);
+
+   RETURN (ret);
+}
+
+
+/* read the reply to the oldest getMore in flight, and queue it unless the
+ * cursor has already ended */
+static void
+_mongoc_cursor_cursorid_stream_recv (mongoc_cursor_t *cursor)
+{
+   mongoc_cursor_stream_t *stream;
+   mongoc_client_t *client;
+   mongoc_cluster_t *cluster;
+   mongoc_cursor_stream_request_t request;
+   mongoc_apm_command_succeeded_t succeeded_event;
+   mongoc_apm_command_failed_t failed_event;
+   mongoc_cursor_stream_reply_t queued;
+   bson_error_t error;
+   bson_t reply;
+   bool ok;
+
+   ENTRY;
+
+   stream = &cursor->stream;
+   client = cursor->client;
+   cluster = &client->cluster;
+
+   BSON_ASSERT (stream->requests.len);
+
+   request = _mongoc_array_index (
+      &stream->requests, mongoc_cursor_stream_request_t, 0);
+
+   if (stream->buffer.data) {
+      _mongoc_buffer_clear (&stream->buffer, false);
+   } else {
+      _mongoc_buffer_init (&stream->buffer, NULL, 0, NULL, NULL);
+   }
+
+   if (!_mongoc_client_recv (client,
+                             &stream->rpc,
+                             &stream->buffer,
+                             stream->server_stream,
+                             &error)) {
+      GOTO (failed);
+   }
+
+   if (stream->rpc.header.opcode != MONGOC_OPCODE_REPLY ||
+       stream->rpc.header.response_to != (int32_t) request.request_id ||
+       !_mongoc_rpc_reply_get_first (&stream->rpc.reply, &reply)) {
+      bson_set_error (&error,
+                      MONGOC_ERROR_PROTOCOL,
+                      MONGOC_ERROR_PROTOCOL_INVALID_REPLY,
+                      "Invalid reply to getMore command.");
+
+      /* later replies can't be matched to their requests */
+      mongoc_cluster_disconnect_node (cluster, cursor->server_id);
+      GOTO (failed);
+   }
+
+   stream->requests.len--;
+   memmove (stream->requests.data,
+            (char *) stream->requests.data + sizeof request,
+            stream->requests.len * sizeof request);
+
+   ok = !_mongoc_populate_cmd_error (&reply, client->error_api_version, &error);
+
+   if (ok && client->apm_callbacks.succeeded) {
+      mongoc_apm_command_succeeded_init (&succeeded_event,
+                                         bson_get_monotonic_time () -
+                                            request.started,
+                                         &reply,
+                                         "getMore",
+                                         request.request_id,
+                                         cursor->operation_id,
+                                         &stream->server_stream->sd->host,
+                                         stream->server_stream->sd->id,
+                                         client->apm_context);
+
+      client->apm_callbacks.succeeded (&succeeded_event);
+      mongoc_apm_command_succeeded_cleanup (&succeeded_event);
+   } else if (!ok && client->apm_callbacks.failed) {
+      mongoc_apm_command_failed_init (&failed_event,
+                                      bson_get_monotonic_time () -
+                                         request.started,
+                                      "getMore",
+                                      &error,
+                                      request.request_id,
+                                      cursor->operation_id,
+                                      &stream->server_stream->sd->host,
+                                      stream->server_stream->sd->id,
+                                      client->apm_context);
+
+      client->apm_callbacks.failed (&failed_event);
+      mongoc_apm_command_failed_cleanup (&failed_event);
+   }
+
+   /* getMores sent past the last batch fail with CursorNotFound, drop
+    * their replies */
+   if (!stream->closed) {
+      if (!ok || !_mongoc_cursor_cursorid_reply_id (&reply)) {
+         stream->closed = true;
+      }
+
+      /* queue the receive buffer itself, the next reply gets another */
+      memcpy (&queued.buffer, &stream->buffer, sizeof queued.buffer);
+      queued.data = bson_get_data (&reply);
+      queued.len = reply.len;
+      _mongoc_array_append_val (&stream->replies, queued);
+      memset (&stream->buffer, 0, sizeof stream->buffer);
+   }
+
+   GOTO (done);
+
+failed:
+   if (client->apm_callbacks.failed) {
+      mongoc_apm_command_failed_init (&failed_event,
+                                      bson_get_monotonic_time () -
+                                         request.started,
+                                      "getMore",
+                                      &error,
+                                      request.request_id,
+                                      cursor->operation_id,
+                                      &stream->server_stream->sd->host,
+                                      stream->server_stream->sd->id,
+                                      client->apm_context);
+
+      client->apm_callbacks.failed (&failed_event);
+      mongoc_apm_command_failed_cleanup (&failed_event);
+   }
+
+   /* the connection is closed, the other replies are lost */
+   stream->requests.len = 0;
+   stream->closed = true;
+
+   if (!stream->failed) {
+      stream->failed = true;
+      memcpy (&stream->error, &error, sizeof error);
+   }
+
+done:
+   if (!stream->requests.len && cluster->pending_reply_ctx == cursor) {
+      cluster->pending_reply = NULL;
+      cluster->pending_reply_ctx = NULL;
+   }
+
+   EXIT;
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_cursor_cursorid_stream_fill --
+ *
+ *       If streaming is enabled, send getMore commands until
+ *       cursor->stream.depth batches are in flight or queued. The server
+ *       processes them in order, so the batches arrive back to back
+ *       instead of one round trip apart.
+ *
+ *       The replies are read when the application reaches them, or
+ *       before any other operation selects a stream from the client,
+ *       see mongoc_cluster_read_pending_reply.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+static void
+_mongoc_cursor_cursorid_stream_fill (mongoc_cursor_t *cursor)
+{
+   mongoc_cursor_stream_t *stream;
+   mongoc_cluster_t *cluster;
+   bson_error_t error;
+
+   ENTRY;
+
+   stream = &cursor->stream;
+   cluster = &cursor->client->cluster;
+
+   /* a limit would need the getMores to count documents, and a tailable
+    * cursor's getMore may wait for new data */
+   if (!stream->depth || stream->closed || !mongoc_cursor_get_id (cursor) ||
+       mongoc_cursor_get_limit (cursor) || cursor->decoded.tailable) {
+      EXIT;
+   }
+
+   if (!stream->requests.len) {
+      /* nothing is in flight on the stream we held, it may be stale */
+      mongoc_server_stream_cleanup (stream->server_stream);
+      stream->server_stream = mongoc_cluster_stream_for_server (
+         cluster, cursor->server_id, false, &error);
+
+      if (!stream->server_stream) {
+         /* the getMore will report the error */
+         EXIT;
+      }
+
+      if (!_use_getmore_command (cursor, stream->server_stream)) {
+         mongoc_server_stream_cleanup (stream->server_stream);
+         stream->server_stream = NULL;
+         EXIT;
+      }
+   }
+
+   while (!stream->closed &&
+          stream->requests.len + stream->replies.len < stream->depth) {
+      if (!_mongoc_cursor_cursorid_stream_send (cursor)) {
+         break;
+      }
+   }
+
+   if (stream->requests.len) {
+      cluster->pending_reply = _mongoc_cursor_stream_drain;
+      cluster->pending_reply_ctx = cursor;
+   }
+
+   EXIT;
+}
+
+
+/* read all streamed replies, also the cluster's pending_reply callback */
+void
+_mongoc_cursor_stream_drain (void *ctx)
+{
+   mongoc_cursor_t *cursor;
+
+   cursor = (mongoc_cursor_t *) ctx;
+
+   while (cursor->stream.requests.len) {
+      _mongoc_cursor_cursorid_stream_recv (cursor);
+   }
+}
+
+
+void
+_mongoc_cursor_stream_destroy (mongoc_cursor_t *cursor)
+{
+   mongoc_cursor_stream_t *stream;
+   size_t i;
+
+   stream = &cursor->stream;
+
+   BSON_ASSERT (!stream->requests.len);
+
+   for (i = 0; i < stream->replies.len; i++) {
+      _mongoc_buffer_destroy (&_mongoc_array_index (
+         &stream->replies, mongoc_cursor_stream_reply_t, i).buffer);
+   }
+
+   _mongoc_array_destroy (&stream->requests);
+   _mongoc_array_destroy (&stream->replies);
+   _mongoc_buffer_destroy (&stream->buffer);
+   mongoc_server_stream_cleanup (stream->server_stream);
+   stream->server_stream = NULL;
+}
+
+
 static bool
 _mongoc_cursor_cursorid_refresh_from_command (mongoc_cursor_t *cursor,
                                               const bson_t *command)
@@ -120,6 +519,8 @@ _mongoc_cursor_cursorid_refresh_from_command (mongoc_cursor_t *cursor,
     * to getMore command with {cursor: {id: N, nextBatch: []}}. */
    if (_mongoc_cursor_run_command (cursor, command, &cid->array) &&
        _mongoc_cursor_cursorid_start_batch (cursor)) {
+      _mongoc_cursor_cursorid_prefetch (cursor);
+      _mongoc_cursor_cursorid_stream_fill (cursor);
       RETURN (true);
    } else {
       if (!cursor->error.domain) {
@@ -135,6 +536,176 @@ _mongoc_cursor_cursorid_refresh_from_command (mongoc_cursor_t *cursor,
 }
 
 
+/* like refresh_from_command, but the getMore was sent by
+ * _mongoc_cursor_prefetch_send and its reply is in the prefetch buffer */
+static bool
+_mongoc_cursor_cursorid_refresh_from_prefetch (mongoc_cursor_t *cursor)
+{
+   mongoc_cursor_cursorid_t *cid;
+   mongoc_cursor_prefetch_t *prefetch;
+   mongoc_client_t *client;
+   mongoc_apm_command_succeeded_t succeeded_event;
+   mongoc_apm_command_failed_t failed_event;
+   bson_t reply;
+   bool ret = false;
+
+   ENTRY;
+
+   cid = (mongoc_cursor_cursorid_t *) cursor->iface_data;
+   BSON_ASSERT (cid);
+
+   prefetch = &cursor->prefetch;
+   client = cursor->client;
+
+   _mongoc_cursor_prefetch_recv (cursor);
+
+   bson_destroy (&cid->array);
+   bson_init (&cid->array);
+
+   if (prefetch->state == MONGOC_CURSOR_PREFETCH_FAILED) {
+      memcpy (&cursor->error, &prefetch->error, sizeof (bson_error_t));
+      GOTO (done);
+   }
+
+   if (prefetch->rpc.header.opcode != MONGOC_OPCODE_REPLY ||
+       prefetch->rpc.header.response_to != prefetch->request_id ||
+       !_mongoc_rpc_reply_get_first (&prefetch->rpc.reply, &reply)) {
+      bson_set_error (&cursor->error,
+                      MONGOC_ERROR_PROTOCOL,
+                      MONGOC_ERROR_PROTOCOL_INVALID_REPLY,
+                      "Invalid reply to getMore command.");
+      GOTO (done);
+   }
+
+   /* iterate the batch where it was received. the previous batch's buffer
+    * receives the next prefetched reply */
+   _mongoc_cursor_swap_buffer (cursor, &prefetch->buffer);
+   bson_destroy (&cid->array);
+   bson_init_static (&cid->array, bson_get_data (&reply), reply.len);
+
+   if (_mongoc_populate_cmd_error (
+          &cid->array, client->error_api_version, &cursor->error)) {
+      GOTO (done);
+   }
+
+   if (!_mongoc_cursor_cursorid_start_batch (cursor)) {
+      bson_set_error (&cursor->error,
+                      MONGOC_ERROR_PROTOCOL,
+                      MONGOC_ERROR_PROTOCOL_INVALID_REPLY,
+                      "Invalid reply to getMore command.");
+      GOTO (done);
+   }
+
+   ret = true;
+
+   if (client->apm_callbacks.succeeded) {
+      mongoc_apm_command_succeeded_init (&succeeded_event,
+                                         prefetch->finished - prefetch->started,
+                                         &cid->array,
+                                         "getMore",
+                                         prefetch->request_id,
+                                         cursor->operation_id,
+                                         &prefetch->server_stream->sd->host,
+                                         prefetch->server_stream->sd->id,
+                                         client->apm_context);
+
+      client->apm_callbacks.succeeded (&succeeded_event);
+      mongoc_apm_command_succeeded_cleanup (&succeeded_event);
+   }
+
+done:
+   if (!ret && client->apm_callbacks.failed) {
+      mongoc_apm_command_failed_init (&failed_event,
+                                      prefetch->finished - prefetch->started,
+                                      "getMore",
+                                      &cursor->error,
+                                      prefetch->request_id,
+                                      cursor->operation_id,
+                                      &prefetch->server_stream->sd->host,
+                                      prefetch->server_stream->sd->id,
+                                      client->apm_context);
+
+      client->apm_callbacks.failed (&failed_event);
+      mongoc_apm_command_failed_cleanup (&failed_event);
+   }
+
+   _mongoc_cursor_prefetch_reset (cursor);
+
+   if (ret) {
+      _mongoc_cursor_cursorid_prefetch (cursor);
+   }
+
+   RETURN (ret);
+}
+
+
+/* like refresh_from_command, but the getMore was sent by
+ * _mongoc_cursor_cursorid_stream_fill and its reply may be queued already */
+static bool
+_mongoc_cursor_cursorid_refresh_from_stream (mongoc_cursor_t *cursor)
+{
+   mongoc_cursor_cursorid_t *cid;
+   mongoc_cursor_stream_t *stream;
+   mongoc_cursor_stream_reply_t reply;
+
+   ENTRY;
+
+   cid = (mongoc_cursor_cursorid_t *) cursor->iface_data;
+   BSON_ASSERT (cid);
+
+   stream = &cursor->stream;
+
+   if (!stream->replies.len && stream->requests.len) {
+      _mongoc_cursor_cursorid_stream_recv (cursor);
+   }
+
+   bson_destroy (&cid->array);
+
+   if (!stream->replies.len) {
+      /* a network error after the last queued batch */
+      BSON_ASSERT (stream->failed);
+      bson_init (&cid->array);
+      memcpy (&cursor->error, &stream->error, sizeof (bson_error_t));
+      RETURN (false);
+   }
+
+   reply = _mongoc_array_index (
+      &stream->replies, mongoc_cursor_stream_reply_t, 0);
+   stream->replies.len--;
+   memmove (stream->replies.data,
+            (char *) stream->replies.data + sizeof reply,
+            stream->replies.len * sizeof reply);
+
+   /* iterate the batch where it was received, and keep the previous batch's
+    * buffer for the next reply if there's no spare one */
+   _mongoc_cursor_swap_buffer (cursor, &reply.buffer);
+   if (!stream->buffer.data) {
+      memcpy (&stream->buffer, &reply.buffer, sizeof reply.buffer);
+   } else {
+      _mongoc_buffer_destroy (&reply.buffer);
+   }
+
+   bson_init_static (&cid->array, reply.data, reply.len);
+
+   if (_mongoc_populate_cmd_error (
+          &cid->array, cursor->client->error_api_version, &cursor->error)) {
+      RETURN (false);
+   }
+
+   if (!_mongoc_cursor_cursorid_start_batch (cursor)) {
+      bson_set_error (&cursor->error,
+                      MONGOC_ERROR_PROTOCOL,
+                      MONGOC_ERROR_PROTOCOL_INVALID_REPLY,
+                      "Invalid reply to getMore command.");
+      RETURN (false);
+   }
+
+   _mongoc_cursor_cursorid_stream_fill (cursor);
+
+   RETURN (true);
+}
+
+
 static void
 _mongoc_cursor_cursorid_read_from_batch (mongoc_cursor_t *cursor,
                                          const bson_t **bson)
@@ -187,7 +758,7 @@ _mongoc_cursor_prepare_getmore_command (mongoc_cursor_t *cursor,
    bson_append_int64 (command, "getMore", 7, mongoc_cursor_get_id (cursor));
    bson_append_utf8 (command, "collection", 10, collection, collection_len);
 
-   batch_size = mongoc_cursor_get_batch_size (cursor);
+   batch_size = _mongoc_cursor_batch_size (cursor);
 
    /* See find, getMore, and killCursors Spec for batchSize rules */
    if (batch_size) {
@@ -204,8 +775,7 @@ _mongoc_cursor_prepare_getmore_command (mongoc_cursor_t *cursor,
       option maxAwaitTimeMS. If no maxAwaitTimeMS is specified, the driver
       SHOULD not set maxTimeMS on the getMore command."
     */
-   await_data = _mongoc_cursor_get_opt_bool (cursor, MONGOC_CURSOR_TAILABLE) &&
-                _mongoc_cursor_get_opt_bool (cursor, MONGOC_CURSOR_AWAIT_DATA);
+   await_data = cursor->decoded.tailable && cursor->decoded.await_data;
 
 
    if (await_data) {
@@ -236,6 +806,16 @@ _mongoc_cursor_cursorid_get_more (mongoc_cursor_t *cursor)
    cid = (mongoc_cursor_cursorid_t *) cursor->iface_data;
    BSON_ASSERT (cid);
 
+   if (cursor->prefetch.state != MONGOC_CURSOR_PREFETCH_NONE &&
+       cursor->prefetch.is_command) {
+      RETURN (_mongoc_cursor_cursorid_refresh_from_prefetch (cursor));
+   }
+
+   if (cursor->stream.requests.len || cursor->stream.replies.len ||
+       cursor->stream.failed) {
+      RETURN (_mongoc_cursor_cursorid_refresh_from_stream (cursor));
+   }
+
    server_stream = _mongoc_cursor_fetch_stream (cursor);
 
    if (!server_stream) {
@@ -243,6 +823,7 @@ _mongoc_cursor_cursorid_get_more (mongoc_cursor_t *cursor)
    }
 
    if (_use_getmore_command (cursor, server_stream)) {
+      _mongoc_cursor_adaptive_request (cursor);
       if (!_mongoc_cursor_prepare_getmore_command (cursor, &command)) {
          mongoc_server_stream_cleanup (server_stream);
          RETURN (false);
@@ -322,6 +903,44 @@ done:
 }
 
 
+/* mongoc_cursor_next_batch: _mongoc_cursor_cursorid_next returned @first,
+ * add the documents after it in the same batch */
+void
+_mongoc_cursor_cursorid_next_batch (mongoc_cursor_t *cursor,
+                                    const bson_t *first,
+                                    uint32_t max_docs)
+{
+   mongoc_cursor_cursorid_t *cid;
+   const uint8_t *data;
+   uint32_t data_len;
+
+   ENTRY;
+
+   cid = (mongoc_cursor_cursorid_t *) cursor->iface_data;
+   BSON_ASSERT (cid);
+
+   if (cid->in_reader) {
+      _mongoc_cursor_batch_from_reader (cursor, first, max_docs);
+      EXIT;
+   }
+
+   /* documents in the "firstBatch" or "nextBatch" array are separated by
+    * element headers, so the batch is the array's data and offsets skip the
+    * headers */
+   cursor->batch.data = bson_get_data (first);
+   _mongoc_cursor_batch_add (cursor, bson_get_data (first));
+
+   while (cursor->batch.n_docs < max_docs &&
+          bson_iter_next (&cid->batch_iter) &&
+          BSON_ITER_HOLDS_DOCUMENT (&cid->batch_iter)) {
+      bson_iter_document (&cid->batch_iter, &data_len, &data);
+      _mongoc_cursor_batch_add (cursor, data);
+   }
+
+   EXIT;
+}
+
+
 static mongoc_cursor_t *
 _mongoc_cursor_cursorid_clone (const mongoc_cursor_t *cursor)
 {
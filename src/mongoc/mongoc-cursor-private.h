@@ -24,7 +24,10 @@
 #include <bson.h>
 
 #include "mongoc-client.h"
+#include "mongoc-array-private.h"
 #include "mongoc-buffer-private.h"
+#include "mongoc-prepared.h"
+#include "mongoc-query-cache-private.h"
 #include "mongoc-rpc-private.h"
 #include "mongoc-server-stream-private.h"
 
@@ -102,6 +105,104 @@ struct _mongoc_cursor_interface_t {
 #define MONGOC_CURSOR_TAILABLE "tailable"
 #define MONGOC_CURSOR_TAILABLE_LEN 8
 
+/* options read for every document or getMore, decoded from cursor->opts when
+ * it changes. cursor->opts is still used to build the "find" command or
+ * OP_QUERY */
+typedef struct _mongoc_cursor_decoded_opts_t {
+   int64_t limit; /* positive, see single_batch */
+   int64_t batch_size;
+   int64_t max_await_time_ms;
+   bool single_batch;
+   bool tailable;
+   bool await_data;
+   bool exhaust;
+   mongoc_query_flags_t flags;
+   bool flags_valid; /* if false, _mongoc_cursor_flags reports the error */
+} mongoc_cursor_decoded_opts_t;
+
+
+typedef enum {
+   MONGOC_CURSOR_PREFETCH_NONE,
+   MONGOC_CURSOR_PREFETCH_IN_FLIGHT,
+   MONGOC_CURSOR_PREFETCH_RECEIVED,
+   MONGOC_CURSOR_PREFETCH_FAILED,
+} mongoc_cursor_prefetch_state_t;
+
+
+/* the next batch, requested as soon as the current one arrives. the reply is
+ * read into a second buffer, so the current batch stays valid until the
+ * application has iterated it */
+typedef struct _mongoc_cursor_prefetch_t {
+   bool enabled;
+   mongoc_cursor_prefetch_state_t state;
+   bool is_command; /* a getMore command, otherwise OP_GET_MORE */
+   uint32_t request_id;
+   int64_t started;
+   int64_t finished;
+   mongoc_server_stream_t *server_stream;
+   mongoc_rpc_t rpc;
+   mongoc_buffer_t buffer;
+   bson_error_t error;
+} mongoc_cursor_prefetch_t;
+
+
+/* opt-in adaptive getMore batch sizes: start small and grow while round
+ * trips, not the application, limit throughput, up to max_bytes a batch */
+typedef struct _mongoc_cursor_adaptive_t {
+   uint32_t max_bytes; /* 0 if disabled */
+   int64_t batch_size; /* for the next getMore */
+   int64_t doc_size;   /* moving average of document sizes, in bytes */
+   int64_t rtt;        /* last getMore round trip, in microseconds */
+   int64_t sent;       /* when the last getMore was sent */
+   int64_t received;   /* when the current batch arrived */
+} mongoc_cursor_adaptive_t;
+
+
+/* a getMore command sent by a streaming cursor, not yet replied to */
+typedef struct _mongoc_cursor_stream_request_t {
+   uint32_t request_id;
+   int64_t started;
+} mongoc_cursor_stream_request_t;
+
+
+/* a streamed getMore reply, in the buffer it was received in. the batch is
+ * iterated there once the buffer becomes the cursor's buffer */
+typedef struct _mongoc_cursor_stream_reply_t {
+   mongoc_buffer_t buffer;
+   const uint8_t *data; /* the reply document, within "buffer" */
+   uint32_t len;
+} mongoc_cursor_stream_reply_t;
+
+
+/* opt-in streaming for command cursors: up to "depth" getMore commands are
+ * sent ahead of the application on one connection. replies arrive in order
+ * and are matched to "requests" by responseTo, then queued in "replies"
+ * until the application reaches them */
+typedef struct _mongoc_cursor_stream_t {
+   uint32_t depth; /* 0 if disabled */
+   mongoc_server_stream_t *server_stream;
+   mongoc_array_t requests; /* of mongoc_cursor_stream_request_t */
+   mongoc_array_t replies;  /* of mongoc_cursor_stream_reply_t, oldest first */
+   mongoc_rpc_t rpc;
+   mongoc_buffer_t buffer; /* the next reply is read here, may be unallocated */
+   bool closed; /* the server ended the cursor, or the stream failed */
+   bool failed; /* "error" is reported after the queued replies */
+   bson_error_t error;
+} mongoc_cursor_stream_t;
+
+
+/* the documents last returned by mongoc_cursor_next_batch, each at an offset
+ * into "data", which points into the cursor's reply */
+typedef struct _mongoc_cursor_batch_t {
+   const uint8_t *data;
+   size_t data_len;
+   uint32_t *offsets;
+   uint32_t n_docs;
+   uint32_t n_alloc;
+   bson_t first; /* cursor->current after a batch read from cursor->reader */
+} mongoc_cursor_batch_t;
+
+
 struct _mongoc_cursor_t {
    mongoc_client_t *client;
 
@@ -118,6 +219,7 @@ struct _mongoc_cursor_t {
 
    bson_t filter;
    bson_t opts;
+   mongoc_cursor_decoded_opts_t decoded;
 
    mongoc_read_concern_t *read_concern;
    mongoc_read_prefs_t *read_prefs;
@@ -142,15 +244,32 @@ struct _mongoc_cursor_t {
    void *iface_data;
 
    int64_t operation_id;
+
+   mongoc_cursor_prefetch_t prefetch;
+   mongoc_cursor_batch_t batch;
+   mongoc_cursor_adaptive_t adaptive;
+   mongoc_cursor_stream_t stream;
+
+   /* the documents returned so far, if a query cache lookup missed */
+   mongoc_query_cache_fill_t *cache_fill;
+
+   /* set by mongoc_prepared_find_execute, must outlive the cursor */
+   const mongoc_prepared_find_t *prepared;
 };
 
 
 int32_t
 _mongoc_n_return (mongoc_cursor_t *cursor);
+int64_t
+_mongoc_cursor_batch_size (const mongoc_cursor_t *cursor);
+void
+_mongoc_cursor_adaptive_request (mongoc_cursor_t *cursor);
+void
+_mongoc_cursor_adaptive_reply (mongoc_cursor_t *cursor,
+                              size_t batch_len,
+                              uint32_t n_docs);
 void
 _mongoc_set_cursor_ns (mongoc_cursor_t *cursor, const char *ns, uint32_t nslen);
-bool
-_mongoc_cursor_get_opt_bool (const mongoc_cursor_t *cursor, const char *option);
 mongoc_cursor_t *
 _mongoc_cursor_new_with_opts (mongoc_client_t *client,
                               const char *db_and_collection,
@@ -160,6 +279,11 @@ _mongoc_cursor_new_with_opts (mongoc_client_t *client,
                               const mongoc_read_prefs_t *read_prefs,
                               const mongoc_read_concern_t *read_concern);
 mongoc_cursor_t *
+_mongoc_cursor_new_prepared (const mongoc_prepared_find_t *prepared,
+                             const bson_t *filter);
+bool
+_mongoc_cursor_validate_opts (const bson_t *opts, bson_error_t *error);
+mongoc_cursor_t *
 _mongoc_cursor_new (mongoc_client_t *client,
                     const char *db_and_collection,
                     mongoc_query_flags_t flags,
@@ -177,6 +301,12 @@ void
 _mongoc_cursor_destroy (mongoc_cursor_t *cursor);
 bool
 _mongoc_read_from_buffer (mongoc_cursor_t *cursor, const bson_t **bson);
+void
+_mongoc_cursor_batch_add (mongoc_cursor_t *cursor, const uint8_t *doc);
+void
+_mongoc_cursor_batch_from_reader (mongoc_cursor_t *cursor,
+                                  const bson_t *first,
+                                  uint32_t max_docs);
 bool
 _use_find_command (const mongoc_cursor_t *cursor,
                    const mongoc_server_stream_t *server_stream);
@@ -198,6 +328,28 @@ _mongoc_cursor_run_command (mongoc_cursor_t *cursor,
                             bson_t *reply);
 bool
 _mongoc_cursor_more (mongoc_cursor_t *cursor);
+void
+_mongoc_cursor_prefetch_recv (void *cursor);
+void
+_mongoc_cursor_prefetch_send (mongoc_cursor_t *cursor,
+                              mongoc_server_stream_t *server_stream,
+                              int64_t ahead,
+                              bool is_command);
+void
+_mongoc_cursor_prefetch_reset (mongoc_cursor_t *cursor);
+void
+_mongoc_cursor_swap_buffer (mongoc_cursor_t *cursor, mongoc_buffer_t *buffer);
+void
+_mongoc_cursor_stream_drain (void *cursor);
+void
+_mongoc_cursor_stream_destroy (mongoc_cursor_t *cursor);
+bool
+_mongoc_cursor_flags (mongoc_cursor_t *cursor,
+                      mongoc_server_stream_t *stream,
+                      mongoc_query_flags_t *flags /* OUT */);
+bool
+_mongoc_cursor_streams_exhaust (const mongoc_cursor_t *cursor,
+                                const mongoc_server_stream_t *server_stream);
 bool
 _mongoc_cursor_next (mongoc_cursor_t *cursor, const bson_t **bson);
 bool
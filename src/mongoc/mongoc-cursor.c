@@ -17,10 +17,12 @@
 
 #include "mongoc-cursor.h"
 #include "mongoc-cursor-private.h"
+#include "mongoc-apm-private.h"
 #include "mongoc-client-private.h"
 #include "mongoc-counters-private.h"
 #include "mongoc-error.h"
 #include "mongoc-log.h"
+#include "mongoc-prepared-private.h"
 #include "mongoc-trace-private.h"
 #include "mongoc-cursor-cursorid-private.h"
 #include "mongoc-read-concern-private.h"
@@ -34,6 +36,11 @@
 
 #define CURSOR_FAILED(cursor_) ((cursor_)->error.domain != 0)
 
+/* adaptive batch sizes, see _mongoc_cursor_adaptive_request */
+#define MONGOC_CURSOR_ADAPTIVE_INITIAL_BATCH_SIZE 16
+#define MONGOC_CURSOR_ADAPTIVE_GROW_RATIO 4
+#define MONGOC_CURSOR_ADAPTIVE_SHRINK_RATIO 64
+
 static bool
 _translate_query_opt (const char *query_field,
                       const char **cmd_field,
@@ -53,38 +60,97 @@ _mongoc_cursor_find_command (mongoc_cursor_t *cursor,
                              mongoc_server_stream_t *server_stream);
 
 
-static bool
-_mongoc_cursor_set_opt_int64 (mongoc_cursor_t *cursor,
-                              const char *option,
-                              int64_t value)
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_cursor_decode_opts --
+ *
+ *       Decode the options that are read for each document or getMore
+ *       into cursor->decoded, so they are not looked up in cursor->opts
+ *       each time. Call whenever cursor->opts changes.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+static void
+_mongoc_cursor_decode_opts (mongoc_cursor_t *cursor)
 {
+   mongoc_cursor_decoded_opts_t *decoded;
+   mongoc_query_flags_t flag;
    bson_iter_t iter;
+   const char *key;
 
-   if (bson_iter_init_find (&iter, &cursor->opts, option)) {
-      if (!BSON_ITER_HOLDS_INT64 (&iter)) {
-         return false;
-      }
+   decoded = &cursor->decoded;
+   memset (decoded, 0, sizeof *decoded);
 
-      bson_iter_overwrite_int64 (&iter, value);
-      return true;
+   if (!bson_iter_init (&iter, &cursor->opts)) {
+      return;
    }
 
-   return BSON_APPEND_INT64 (&cursor->opts, option, value);
+   decoded->flags_valid = true;
+
+   while (bson_iter_next (&iter)) {
+      key = bson_iter_key (&iter);
+      flag = MONGOC_QUERY_NONE;
+
+      if (!strcmp (key, MONGOC_CURSOR_LIMIT)) {
+         decoded->limit = bson_iter_as_int64 (&iter);
+      } else if (!strcmp (key, MONGOC_CURSOR_BATCH_SIZE)) {
+         decoded->batch_size = bson_iter_as_int64 (&iter);
+      } else if (!strcmp (key, MONGOC_CURSOR_MAX_AWAIT_TIME_MS)) {
+         decoded->max_await_time_ms = bson_iter_as_int64 (&iter);
+      } else if (!strcmp (key, MONGOC_CURSOR_SINGLE_BATCH)) {
+         decoded->single_batch = bson_iter_as_bool (&iter);
+      } else if (!strcmp (key, MONGOC_CURSOR_TAILABLE)) {
+         decoded->tailable = bson_iter_as_bool (&iter);
+         flag = MONGOC_QUERY_TAILABLE_CURSOR;
+      } else if (!strcmp (key, MONGOC_CURSOR_AWAIT_DATA)) {
+         decoded->await_data = bson_iter_as_bool (&iter);
+         flag = MONGOC_QUERY_AWAIT_DATA;
+      } else if (!strcmp (key, MONGOC_CURSOR_EXHAUST)) {
+         decoded->exhaust = bson_iter_as_bool (&iter);
+         flag = MONGOC_QUERY_EXHAUST;
+      } else if (!strcmp (key, MONGOC_CURSOR_ALLOW_PARTIAL_RESULTS)) {
+         flag = MONGOC_QUERY_PARTIAL;
+      } else if (!strcmp (key, MONGOC_CURSOR_NO_CURSOR_TIMEOUT)) {
+         flag = MONGOC_QUERY_NO_CURSOR_TIMEOUT;
+      } else if (!strcmp (key, MONGOC_CURSOR_OPLOG_REPLAY)) {
+         flag = MONGOC_QUERY_OPLOG_REPLAY;
+      }
+
+      if (flag != MONGOC_QUERY_NONE) {
+         if (!BSON_ITER_HOLDS_BOOL (&iter)) {
+            decoded->flags_valid = false;
+         } else if (bson_iter_as_bool (&iter)) {
+            decoded->flags |= flag;
+         }
+      }
+   }
 }
 
 
-static int64_t
-_mongoc_cursor_get_opt_int64 (const mongoc_cursor_t *cursor,
+static bool
+_mongoc_cursor_set_opt_int64 (mongoc_cursor_t *cursor,
                               const char *option,
-                              int64_t default_value)
+                              int64_t value)
 {
    bson_iter_t iter;
+   bool r;
 
    if (bson_iter_init_find (&iter, &cursor->opts, option)) {
-      return bson_iter_as_int64 (&iter);
+      if (!BSON_ITER_HOLDS_INT64 (&iter)) {
+         return false;
+      }
+
+      bson_iter_overwrite_int64 (&iter, value);
+      r = true;
+   } else {
+      r = BSON_APPEND_INT64 (&cursor->opts, option, value);
    }
 
-   return default_value;
+   _mongoc_cursor_decode_opts (cursor);
+
+   return r;
 }
 
 
@@ -94,6 +160,7 @@ _mongoc_cursor_set_opt_bool (mongoc_cursor_t *cursor,
                              bool value)
 {
    bson_iter_t iter;
+   bool r;
 
    if (bson_iter_init_find (&iter, &cursor->opts, option)) {
       if (!BSON_ITER_HOLDS_BOOL (&iter)) {
@@ -101,23 +168,14 @@ _mongoc_cursor_set_opt_bool (mongoc_cursor_t *cursor,
       }
 
       bson_iter_overwrite_bool (&iter, value);
-      return true;
+      r = true;
+   } else {
+      r = BSON_APPEND_BOOL (&cursor->opts, option, value);
    }
 
-   return BSON_APPEND_BOOL (&cursor->opts, option, value);
-}
-
-
-bool
-_mongoc_cursor_get_opt_bool (const mongoc_cursor_t *cursor, const char *option)
-{
-   bson_iter_t iter;
-
-   if (bson_iter_init_find (&iter, &cursor->opts, option)) {
-      return bson_iter_as_bool (&iter);
-   }
+   _mongoc_cursor_decode_opts (cursor);
 
-   return false;
+   return r;
 }
 
 
@@ -134,7 +192,7 @@ _mongoc_n_return (mongoc_cursor_t *cursor)
    }
 
    limit = mongoc_cursor_get_limit (cursor);
-   batch_size = mongoc_cursor_get_batch_size (cursor);
+   batch_size = _mongoc_cursor_batch_size (cursor);
 
    if (limit < 0) {
       n_return = limit;
@@ -162,6 +220,93 @@ _mongoc_n_return (mongoc_cursor_t *cursor)
 }
 
 
+/* the batch size for the next query or getMore */
+int64_t
+_mongoc_cursor_batch_size (const mongoc_cursor_t *cursor)
+{
+   if (cursor->adaptive.max_bytes) {
+      return cursor->adaptive.batch_size;
+   }
+
+   return cursor->decoded.batch_size;
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_cursor_adaptive_request --
+ *
+ *       In adaptive mode, choose the batch size for the getMore about to be
+ *       sent. Double it while a round trip takes more than a quarter of
+ *       the time the application spent on the last batch, halve it if the
+ *       application is much slower than the round trip, and never ask for
+ *       more than max_bytes of documents of the average size seen.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+void
+_mongoc_cursor_adaptive_request (mongoc_cursor_t *cursor)
+{
+   mongoc_cursor_adaptive_t *adaptive = &cursor->adaptive;
+   int64_t now;
+   int64_t consumed;
+   int64_t max_docs;
+
+   if (!adaptive->max_bytes) {
+      return;
+   }
+
+   now = bson_get_monotonic_time ();
+   consumed = adaptive->received ? now - adaptive->received : 0;
+
+   if (!adaptive->rtt ||
+       consumed < adaptive->rtt * MONGOC_CURSOR_ADAPTIVE_GROW_RATIO) {
+      adaptive->batch_size *= 2;
+   } else if (consumed > adaptive->rtt * MONGOC_CURSOR_ADAPTIVE_SHRINK_RATIO) {
+      adaptive->batch_size /= 2;
+   }
+
+   if (adaptive->doc_size) {
+      max_docs = BSON_MAX (adaptive->max_bytes / adaptive->doc_size, 1);
+      adaptive->batch_size = BSON_MIN (adaptive->batch_size, max_docs);
+   }
+
+   adaptive->batch_size = BSON_MAX (adaptive->batch_size, 1);
+   adaptive->batch_size = BSON_MIN (adaptive->batch_size, INT32_MAX);
+   adaptive->sent = now;
+}
+
+
+/* in adaptive mode, record a batch's round trip and document sizes */
+void
+_mongoc_cursor_adaptive_reply (mongoc_cursor_t *cursor,
+                              size_t batch_len,
+                              uint32_t n_docs)
+{
+   mongoc_cursor_adaptive_t *adaptive = &cursor->adaptive;
+   int64_t doc_size;
+
+   if (!adaptive->max_bytes) {
+      return;
+   }
+
+   adaptive->received = bson_get_monotonic_time ();
+   if (adaptive->sent) {
+      adaptive->rtt = adaptive->received - adaptive->sent;
+      adaptive->sent = 0;
+   }
+
+   if (n_docs) {
+      doc_size = BSON_MAX ((int64_t) (batch_len / n_docs), 1);
+      adaptive->doc_size = adaptive->doc_size
+                              ? (adaptive->doc_size + doc_size) / 2
+                              : doc_size;
+   }
+}
+
+
 void
 _mongoc_set_cursor_ns (mongoc_cursor_t *cursor, const char *ns, uint32_t nslen)
 {
@@ -200,6 +345,43 @@ _has_dollar_fields (const bson_t *bson)
 }
 
 
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_cursor_validate_opts --
+ *
+ *       Check @opts the same way for every cursor constructor: no empty
+ *       keys and no $-modifiers.
+ *
+ * Returns:
+ *       true if @opts may be used, otherwise false and @error is set.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+bool
+_mongoc_cursor_validate_opts (const bson_t *opts, bson_error_t *error)
+{
+   if (!bson_validate (opts, BSON_VALIDATE_EMPTY_KEYS, NULL)) {
+      bson_set_error (error,
+                      MONGOC_ERROR_CURSOR,
+                      MONGOC_ERROR_CURSOR_INVALID_CURSOR,
+                      "Cannot use empty keys in 'opts'.");
+      return false;
+   }
+
+   if (_has_dollar_fields (opts)) {
+      bson_set_error (error,
+                      MONGOC_ERROR_CURSOR,
+                      MONGOC_ERROR_CURSOR_INVALID_CURSOR,
+                      "Cannot use $-modifiers in 'opts'.");
+      return false;
+   }
+
+   return true;
+}
+
+
 #define MARK_FAILED(c)          \
    do {                         \
       (c)->done = true;         \
@@ -247,21 +429,8 @@ _mongoc_cursor_new_with_opts (mongoc_client_t *client,
    }
 
    if (opts) {
-      if (!bson_validate (opts, BSON_VALIDATE_EMPTY_KEYS, NULL)) {
-         MARK_FAILED (cursor);
-         bson_set_error (&cursor->error,
-                         MONGOC_ERROR_CURSOR,
-                         MONGOC_ERROR_CURSOR_INVALID_CURSOR,
-                         "Cannot use empty keys in 'opts'.");
-         GOTO (finish);
-      }
-
-      if (_has_dollar_fields (opts)) {
+      if (!_mongoc_cursor_validate_opts (opts, &cursor->error)) {
          MARK_FAILED (cursor);
-         bson_set_error (&cursor->error,
-                         MONGOC_ERROR_CURSOR,
-                         MONGOC_ERROR_CURSOR_INVALID_CURSOR,
-                         "Cannot use $-modifiers in 'opts'.");
          GOTO (finish);
       }
 
@@ -282,6 +451,8 @@ _mongoc_cursor_new_with_opts (mongoc_client_t *client,
       }
    }
 
+   _mongoc_cursor_decode_opts (cursor);
+
    cursor->read_prefs = read_prefs
                            ? mongoc_read_prefs_copy (read_prefs)
                            : mongoc_read_prefs_new (MONGOC_READ_PRIMARY);
@@ -294,8 +465,8 @@ _mongoc_cursor_new_with_opts (mongoc_client_t *client,
          cursor, db_and_collection, (uint32_t) strlen (db_and_collection));
    }
 
-   if (_mongoc_cursor_get_opt_bool (cursor, MONGOC_CURSOR_EXHAUST)) {
-      if (_mongoc_cursor_get_opt_int64 (cursor, MONGOC_CURSOR_LIMIT, 0)) {
+   if (cursor->decoded.exhaust) {
+      if (cursor->decoded.limit) {
          bson_set_error (&cursor->error,
                          MONGOC_ERROR_CURSOR,
                          MONGOC_ERROR_CURSOR_INVALID_CURSOR,
@@ -326,6 +497,83 @@ finish:
 }
 
 
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_cursor_new_prepared --
+ *
+ *       Create a find cursor from a mongoc_prepared_find_t. The opts were
+ *       validated when @prepared was created, so only @filter is checked
+ *       here. The cursor borrows @prepared's pre-built command fields.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+mongoc_cursor_t *
+_mongoc_cursor_new_prepared (const mongoc_prepared_find_t *prepared,
+                             const bson_t *filter)
+{
+   mongoc_cursor_t *cursor;
+   mongoc_topology_description_type_t td_type;
+
+   ENTRY;
+
+   BSON_ASSERT (prepared);
+
+   cursor = (mongoc_cursor_t *) bson_malloc0 (sizeof *cursor);
+   cursor->client = prepared->client;
+   cursor->prepared = prepared;
+
+   bson_init (&cursor->filter);
+   bson_copy_to (&prepared->opts, &cursor->opts);
+   _mongoc_cursor_decode_opts (cursor);
+
+   cursor->read_prefs = mongoc_read_prefs_copy (prepared->read_prefs);
+   cursor->read_concern = mongoc_read_concern_copy (prepared->read_concern);
+
+   _mongoc_set_cursor_ns (
+      cursor, prepared->ns, (uint32_t) strlen (prepared->ns));
+
+   if (filter) {
+      if (!bson_validate (filter, BSON_VALIDATE_EMPTY_KEYS, NULL)) {
+         MARK_FAILED (cursor);
+         bson_set_error (&cursor->error,
+                         MONGOC_ERROR_CURSOR,
+                         MONGOC_ERROR_CURSOR_INVALID_CURSOR,
+                         "Empty keys are not allowed in 'filter'.");
+         GOTO (finish);
+      }
+
+      bson_destroy (&cursor->filter);
+      bson_copy_to (filter, &cursor->filter);
+   }
+
+   if (prepared->server_id) {
+      mongoc_cursor_set_hint (cursor, prepared->server_id);
+   }
+
+   if (prepared->exhaust) {
+      td_type = _mongoc_topology_get_type (cursor->client->topology);
+
+      if (td_type == MONGOC_TOPOLOGY_SHARDED) {
+         bson_set_error (&cursor->error,
+                         MONGOC_ERROR_CURSOR,
+                         MONGOC_ERROR_CURSOR_INVALID_CURSOR,
+                         "Cannot use exhaust cursor with sharded cluster.");
+         MARK_FAILED (cursor);
+         GOTO (finish);
+      }
+   }
+
+   _mongoc_buffer_init (&cursor->buffer, NULL, 0, NULL, NULL);
+
+finish:
+   mongoc_counter_cursors_active_inc ();
+
+   RETURN (cursor);
+}
+
+
 mongoc_cursor_t *
 _mongoc_cursor_new (mongoc_client_t *client,
                     const char *db_and_collection,
@@ -505,6 +753,25 @@ mongoc_cursor_destroy (mongoc_cursor_t *cursor)
    EXIT;
 }
 
+/* true if a received prefetch reply says the server closed the cursor */
+static bool
+_mongoc_cursor_prefetch_exhausted (mongoc_cursor_t *cursor)
+{
+   bson_t reply;
+   bson_iter_t iter;
+
+   if (!cursor->prefetch.is_command) {
+      return cursor->prefetch.rpc.reply.cursor_id == 0;
+   }
+
+   return _mongoc_rpc_reply_get_first (&cursor->prefetch.rpc.reply, &reply) &&
+          bson_iter_init_find (&iter, &reply, "cursor") &&
+          BSON_ITER_HOLDS_DOCUMENT (&iter) &&
+          bson_iter_recurse (&iter, &iter) && bson_iter_find (&iter, "id") &&
+          bson_iter_as_int64 (&iter) == 0;
+}
+
+
 void
 _mongoc_cursor_destroy (mongoc_cursor_t *cursor)
 {
@@ -513,6 +780,28 @@ _mongoc_cursor_destroy (mongoc_cursor_t *cursor)
 
    BSON_ASSERT (cursor);
 
+   if (cursor->prefetch.state != MONGOC_CURSOR_PREFETCH_NONE) {
+      /* read the reply to leave the stream usable, and skip killCursors if
+       * the prefetched batch was the last */
+      _mongoc_cursor_prefetch_recv (cursor);
+      if (cursor->prefetch.state == MONGOC_CURSOR_PREFETCH_RECEIVED &&
+          _mongoc_cursor_prefetch_exhausted (cursor)) {
+         cursor->rpc.reply.cursor_id = 0;
+      }
+
+      _mongoc_cursor_prefetch_reset (cursor);
+   }
+
+   if (cursor->stream.requests.len) {
+      /* read the streamed replies to leave the stream usable */
+      _mongoc_cursor_stream_drain (cursor);
+   }
+
+   if (cursor->stream.closed && !cursor->stream.failed) {
+      /* the server ended the cursor in a streamed batch */
+      cursor->rpc.reply.cursor_id = 0;
+   }
+
    if (cursor->in_exhaust) {
       cursor->client->in_exhaust = false;
       if (!cursor->done) {
@@ -523,12 +812,22 @@ _mongoc_cursor_destroy (mongoc_cursor_t *cursor)
    } else if (cursor->rpc.reply.cursor_id) {
       bson_strncpy (db, cursor->ns, cursor->dblen + 1);
 
-      _mongoc_client_kill_cursor (cursor->client,
-                                  cursor->server_id,
-                                  cursor->rpc.reply.cursor_id,
-                                  cursor->operation_id,
-                                  db,
-                                  cursor->ns + cursor->dblen + 1);
+      if (cursor->client->defer_kill_cursors) {
+         /* sent in a batch on the next use of the server */
+         _mongoc_client_defer_kill_cursor (cursor->client,
+                                           cursor->server_id,
+                                           cursor->rpc.reply.cursor_id,
+                                           cursor->operation_id,
+                                           db,
+                                           cursor->ns + cursor->dblen + 1);
+      } else {
+         _mongoc_client_kill_cursor (cursor->client,
+                                     cursor->server_id,
+                                     cursor->rpc.reply.cursor_id,
+                                     cursor->operation_id,
+                                     db,
+                                     cursor->ns + cursor->dblen + 1);
+      }
    }
 
    if (cursor->reader) {
@@ -537,6 +836,10 @@ _mongoc_cursor_destroy (mongoc_cursor_t *cursor)
    }
 
    _mongoc_buffer_destroy (&cursor->buffer);
+   _mongoc_buffer_destroy (&cursor->prefetch.buffer);
+   _mongoc_cursor_stream_destroy (cursor);
+   _mongoc_query_cache_fill_destroy (cursor->cache_fill);
+   bson_free (cursor->batch.offsets);
    mongoc_read_prefs_destroy (cursor->read_prefs);
    mongoc_read_concern_destroy (cursor->read_concern);
    mongoc_write_concern_destroy (cursor->write_concern);
@@ -587,8 +890,9 @@ _use_find_command (const mongoc_cursor_t *cursor,
     * exhaust flag."
     */
    return server_stream->sd->max_wire_version >= WIRE_VERSION_FIND_CMD &&
-          !cursor->is_command &&
-          !_mongoc_cursor_get_opt_bool (cursor, MONGOC_CURSOR_EXHAUST);
+          !cursor->is_command && (!cursor->decoded.exhaust ||
+                                  _mongoc_cursor_streams_exhaust (
+                                     cursor, server_stream));
 }
 
 
@@ -597,7 +901,21 @@ _use_getmore_command (const mongoc_cursor_t *cursor,
                       const mongoc_server_stream_t *server_stream)
 {
    return server_stream->sd->max_wire_version >= WIRE_VERSION_FIND_CMD &&
-          !_mongoc_cursor_get_opt_bool (cursor, MONGOC_CURSOR_EXHAUST);
+          (!cursor->decoded.exhaust ||
+           _mongoc_cursor_streams_exhaust (cursor, server_stream));
+}
+
+
+/* instead of an OP_QUERY exhaust cursor, which ties up the client, use the
+ * find command and stream getMore commands, see
+ * mongoc_cursor_set_stream_depth */
+bool
+_mongoc_cursor_streams_exhaust (const mongoc_cursor_t *cursor,
+                                const mongoc_server_stream_t *server_stream)
+{
+   return cursor->decoded.exhaust && cursor->stream.depth &&
+          !cursor->is_command && !cursor->prepared &&
+          server_stream->sd->max_wire_version >= WIRE_VERSION_FIND_CMD;
 }
 
 
@@ -905,7 +1223,7 @@ _mongoc_cursor_monitor_failed (mongoc_cursor_t *cursor,
       }                                                            \
    } while (false);
 
-static bool
+bool
 _mongoc_cursor_flags (mongoc_cursor_t *cursor,
                       mongoc_server_stream_t *stream,
                       mongoc_query_flags_t *flags /* OUT */)
@@ -915,32 +1233,41 @@ _mongoc_cursor_flags (mongoc_cursor_t *cursor,
 
    *flags = MONGOC_QUERY_NONE;
 
-   if (!bson_iter_init (&iter, &cursor->opts)) {
-      bson_set_error (&cursor->error,
-                      MONGOC_ERROR_BSON,
-                      MONGOC_ERROR_BSON_INVALID,
-                      "Invalid 'opts' parameter.");
-      return false;
-   }
-
-   while (bson_iter_next (&iter)) {
-      key = bson_iter_key (&iter);
+   if (cursor->decoded.flags_valid) {
+      *flags = cursor->decoded.flags;
+   } else {
+      /* decoding found an invalid option, report it */
+      if (!bson_iter_init (&iter, &cursor->opts)) {
+         bson_set_error (&cursor->error,
+                         MONGOC_ERROR_BSON,
+                         MONGOC_ERROR_BSON_INVALID,
+                         "Invalid 'opts' parameter.");
+         return false;
+      }
 
-      if (!strcmp (key, MONGOC_CURSOR_ALLOW_PARTIAL_RESULTS)) {
-         ADD_FLAG (flags, MONGOC_QUERY_PARTIAL);
-      } else if (!strcmp (key, MONGOC_CURSOR_AWAIT_DATA)) {
-         ADD_FLAG (flags, MONGOC_QUERY_AWAIT_DATA);
-      } else if (!strcmp (key, MONGOC_CURSOR_EXHAUST)) {
-         ADD_FLAG (flags, MONGOC_QUERY_EXHAUST);
-      } else if (!strcmp (key, MONGOC_CURSOR_NO_CURSOR_TIMEOUT)) {
-         ADD_FLAG (flags, MONGOC_QUERY_NO_CURSOR_TIMEOUT);
-      } else if (!strcmp (key, MONGOC_CURSOR_OPLOG_REPLAY)) {
-         ADD_FLAG (flags, MONGOC_QUERY_OPLOG_REPLAY);
-      } else if (!strcmp (key, MONGOC_CURSOR_TAILABLE)) {
-         ADD_FLAG (flags, MONGOC_QUERY_TAILABLE_CURSOR);
+      while (bson_iter_next (&iter)) {
+         key = bson_iter_key (&iter);
+
+         if (!strcmp (key, MONGOC_CURSOR_ALLOW_PARTIAL_RESULTS)) {
+            ADD_FLAG (flags, MONGOC_QUERY_PARTIAL);
+         } else if (!strcmp (key, MONGOC_CURSOR_AWAIT_DATA)) {
+            ADD_FLAG (flags, MONGOC_QUERY_AWAIT_DATA);
+         } else if (!strcmp (key, MONGOC_CURSOR_EXHAUST)) {
+            ADD_FLAG (flags, MONGOC_QUERY_EXHAUST);
+         } else if (!strcmp (key, MONGOC_CURSOR_NO_CURSOR_TIMEOUT)) {
+            ADD_FLAG (flags, MONGOC_QUERY_NO_CURSOR_TIMEOUT);
+         } else if (!strcmp (key, MONGOC_CURSOR_OPLOG_REPLAY)) {
+            ADD_FLAG (flags, MONGOC_QUERY_OPLOG_REPLAY);
+         } else if (!strcmp (key, MONGOC_CURSOR_TAILABLE)) {
+            ADD_FLAG (flags, MONGOC_QUERY_TAILABLE_CURSOR);
+         }
       }
    }
 
+   if (_mongoc_cursor_streams_exhaust (cursor, stream)) {
+      *flags &= ~MONGOC_QUERY_EXHAUST;
+   }
+
    if (cursor->slave_ok) {
       *flags |= MONGOC_QUERY_SLAVE_OK;
    } else if (cursor->server_id_set &&
@@ -1215,8 +1542,11 @@ _mongoc_cursor_op_query (mongoc_cursor_t *cursor,
 
    cursor->reader = bson_reader_new_from_data (
       cursor->rpc.reply.documents, (size_t) cursor->rpc.reply.documents_len);
+   _mongoc_cursor_adaptive_reply (cursor,
+                                  (size_t) cursor->rpc.reply.documents_len,
+                                  (uint32_t) cursor->rpc.reply.n_returned);
 
-   if (_mongoc_cursor_get_opt_bool (cursor, MONGOC_CURSOR_EXHAUST)) {
+   if (cursor->decoded.exhaust) {
       cursor->in_exhaust = true;
       cursor->client->in_exhaust = true;
    }
@@ -1231,6 +1561,11 @@ _mongoc_cursor_op_query (mongoc_cursor_t *cursor,
    cursor->end_of_event = false;
    succeeded = true;
 
+   if (!cursor->is_command) {
+      _mongoc_cursor_prefetch_send (
+         cursor, server_stream, cursor->rpc.reply.n_returned, false);
+   }
+
    _mongoc_read_from_buffer (cursor, &ret);
 
 done:
@@ -1385,23 +1720,76 @@ _mongoc_cursor_collection (const mongoc_cursor_t *cursor,
 }
 
 
+/* append the fields pre-built by mongoc_prepared_find_new, then the opts a
+ * cursor setter may have changed since */
 static bool
-_mongoc_cursor_prepare_find_command (mongoc_cursor_t *cursor,
+_mongoc_cursor_append_prepared_find (mongoc_cursor_t *cursor,
                                      bson_t *command,
                                      mongoc_server_stream_t *server_stream)
 {
-   const char *collection;
-   int collection_len;
+   static const char *mutable_opts[] = {MONGOC_CURSOR_LIMIT,
+                                        MONGOC_CURSOR_BATCH_SIZE,
+                                        MONGOC_CURSOR_SINGLE_BATCH};
+   const mongoc_prepared_find_t *prepared = cursor->prepared;
    bson_iter_t iter;
+   size_t i;
 
-   _mongoc_cursor_collection (cursor, &collection, &collection_len);
-   bson_append_utf8 (command,
-                     MONGOC_CURSOR_FIND,
-                     MONGOC_CURSOR_FIND_LEN,
-                     collection,
-                     collection_len);
-   bson_append_document (
+   if (prepared->has_collation &&
+       server_stream->sd->max_wire_version < WIRE_VERSION_COLLATION) {
+      bson_set_error (&cursor->error,
+                      MONGOC_ERROR_CURSOR,
+                      MONGOC_ERROR_PROTOCOL_BAD_WIRE_VERSION,
+                      "Collation is not supported by this server");
+      MARK_FAILED (cursor);
+      return false;
+   }
+
+   if (!bson_concat (command, &prepared->find_tail)) {
+      goto too_large;
+   }
+
+   for (i = 0; i < sizeof mutable_opts / sizeof mutable_opts[0]; i++) {
+      if (bson_iter_init_find (&iter, &cursor->opts, mutable_opts[i]) &&
+          !bson_append_iter (command, mutable_opts[i], -1, &iter)) {
+         goto too_large;
+      }
+   }
+
+   return true;
+
+too_large:
+   bson_set_error (&cursor->error,
+                   MONGOC_ERROR_BSON,
+                   MONGOC_ERROR_BSON_INVALID,
+                   "Cursor opts too large");
+   MARK_FAILED (cursor);
+   return false;
+}
+
+
+static bool
+_mongoc_cursor_prepare_find_command (mongoc_cursor_t *cursor,
+                                     bson_t *command,
+                                     mongoc_server_stream_t *server_stream)
+{
+   const char *collection;
+   int collection_len;
+   bson_iter_t iter;
+
+   _mongoc_cursor_collection (cursor, &collection, &collection_len);
+   bson_append_utf8 (command,
+                     MONGOC_CURSOR_FIND,
+                     MONGOC_CURSOR_FIND_LEN,
+                     collection,
+                     collection_len);
+   bson_append_document (
       command, MONGOC_CURSOR_FILTER, MONGOC_CURSOR_FILTER_LEN, &cursor->filter);
+
+   if (cursor->prepared) {
+      return _mongoc_cursor_append_prepared_find (
+         cursor, command, server_stream);
+   }
+
    bson_iter_init (&iter, &cursor->opts);
 
    while (bson_iter_next (&iter)) {
@@ -1414,6 +1802,10 @@ _mongoc_cursor_prepare_find_command (mongoc_cursor_t *cursor,
                          "Collation is not supported by this server");
          MARK_FAILED (cursor);
          return false;
+      } else if (!strcmp (bson_iter_key (&iter), MONGOC_CURSOR_EXHAUST) &&
+                 _mongoc_cursor_streams_exhaust (cursor, server_stream)) {
+         /* the find command has no exhaust option, the getMores stream */
+         continue;
       } else if (strcmp (bson_iter_key (&iter),
                          MONGOC_CURSOR_MAX_AWAIT_TIME_MS)) {
          if (!bson_append_iter (command, bson_iter_key (&iter), -1, &iter)) {
@@ -1550,6 +1942,55 @@ _mongoc_cursor_monitor_legacy_get_more (mongoc_cursor_t *cursor,
 }
 
 
+static void
+_mongoc_cursor_prepare_op_getmore (mongoc_cursor_t *cursor,
+                                   mongoc_query_flags_t flags,
+                                   uint32_t request_id,
+                                   mongoc_rpc_t *rpc)
+{
+   rpc->get_more.cursor_id = cursor->rpc.reply.cursor_id;
+   rpc->get_more.msg_len = 0;
+   rpc->get_more.request_id = request_id;
+   rpc->get_more.response_to = 0;
+   rpc->get_more.opcode = MONGOC_OPCODE_GET_MORE;
+   rpc->get_more.zero = 0;
+   rpc->get_more.collection = cursor->ns;
+
+   if (flags & MONGOC_QUERY_TAILABLE_CURSOR) {
+      rpc->get_more.n_return = 0;
+   } else {
+      rpc->get_more.n_return = _mongoc_n_return (cursor);
+   }
+}
+
+
+/* make @buffer the cursor's buffer, and give the cursor's previous buffer to
+ * the caller for reuse. documents in @buffer stay where they were received */
+void
+_mongoc_cursor_swap_buffer (mongoc_cursor_t *cursor, mongoc_buffer_t *buffer)
+{
+   mongoc_buffer_t tmp;
+
+   memcpy (&tmp, &cursor->buffer, sizeof tmp);
+   memcpy (&cursor->buffer, buffer, sizeof tmp);
+   memcpy (buffer, &tmp, sizeof tmp);
+}
+
+
+/* take the prefetched reply: its buffer becomes the cursor's buffer, and the
+ * previous batch's buffer is reused for the next prefetch */
+static void
+_mongoc_cursor_prefetch_install (mongoc_cursor_t *cursor)
+{
+   BSON_ASSERT (cursor->prefetch.state == MONGOC_CURSOR_PREFETCH_RECEIVED);
+
+   _mongoc_cursor_swap_buffer (cursor, &cursor->prefetch.buffer);
+   memcpy (&cursor->rpc, &cursor->prefetch.rpc, sizeof cursor->rpc);
+
+   _mongoc_cursor_prefetch_reset (cursor);
+}
+
+
 bool
 _mongoc_cursor_op_getmore (mongoc_cursor_t *cursor,
                            mongoc_server_stream_t *server_stream)
@@ -1565,47 +2006,54 @@ _mongoc_cursor_op_getmore (mongoc_cursor_t *cursor,
    started = bson_get_monotonic_time ();
    cluster = &cursor->client->cluster;
 
-   if (!_mongoc_cursor_flags (cursor, server_stream, &flags)) {
-      GOTO (fail);
-   }
+   if (cursor->prefetch.state != MONGOC_CURSOR_PREFETCH_NONE) {
+      BSON_ASSERT (!cursor->prefetch.is_command);
 
-   if (cursor->in_exhaust) {
-      request_id = (uint32_t) cursor->rpc.header.request_id;
-   } else {
-      request_id = ++cluster->request_id;
-
-      rpc.get_more.cursor_id = cursor->rpc.reply.cursor_id;
-      rpc.get_more.msg_len = 0;
-      rpc.get_more.request_id = request_id;
-      rpc.get_more.response_to = 0;
-      rpc.get_more.opcode = MONGOC_OPCODE_GET_MORE;
-      rpc.get_more.zero = 0;
-      rpc.get_more.collection = cursor->ns;
-
-      if (flags & MONGOC_QUERY_TAILABLE_CURSOR) {
-         rpc.get_more.n_return = 0;
-      } else {
-         rpc.get_more.n_return = _mongoc_n_return (cursor);
-      }
+      /* the getMore was sent when the previous batch arrived, and the
+       * "started" event was published then */
+      _mongoc_cursor_prefetch_recv (cursor);
+      request_id = cursor->prefetch.request_id;
+      started -= cursor->prefetch.finished - cursor->prefetch.started;
 
-      if (!_mongoc_cursor_monitor_legacy_get_more (cursor, server_stream)) {
+      if (cursor->prefetch.state == MONGOC_CURSOR_PREFETCH_FAILED) {
+         memcpy (&cursor->error, &cursor->prefetch.error, sizeof (bson_error_t));
+         _mongoc_cursor_prefetch_reset (cursor);
          GOTO (fail);
       }
 
-      if (!mongoc_cluster_sendv_to_server (
-             cluster, &rpc, 1, server_stream, NULL, &cursor->error)) {
+      _mongoc_cursor_prefetch_install (cursor);
+   } else {
+      if (!_mongoc_cursor_flags (cursor, server_stream, &flags)) {
          GOTO (fail);
       }
-   }
 
-   _mongoc_buffer_clear (&cursor->buffer, false);
+      if (cursor->in_exhaust) {
+         request_id = (uint32_t) cursor->rpc.header.request_id;
+      } else {
+         request_id = ++cluster->request_id;
 
-   if (!_mongoc_client_recv (cursor->client,
-                             &cursor->rpc,
-                             &cursor->buffer,
-                             server_stream,
-                             &cursor->error)) {
-      GOTO (fail);
+         _mongoc_cursor_adaptive_request (cursor);
+         _mongoc_cursor_prepare_op_getmore (cursor, flags, request_id, &rpc);
+
+         if (!_mongoc_cursor_monitor_legacy_get_more (cursor, server_stream)) {
+            GOTO (fail);
+         }
+
+         if (!mongoc_cluster_sendv_to_server (
+                cluster, &rpc, 1, server_stream, NULL, &cursor->error)) {
+            GOTO (fail);
+         }
+      }
+
+      _mongoc_buffer_clear (&cursor->buffer, false);
+
+      if (!_mongoc_client_recv (cursor->client,
+                                &cursor->rpc,
+                                &cursor->buffer,
+                                server_stream,
+                                &cursor->error)) {
+         GOTO (fail);
+      }
    }
 
    if (cursor->rpc.header.opcode != MONGOC_OPCODE_REPLY) {
@@ -1639,6 +2087,9 @@ _mongoc_cursor_op_getmore (mongoc_cursor_t *cursor,
 
    cursor->reader = bson_reader_new_from_data (
       cursor->rpc.reply.documents, (size_t) cursor->rpc.reply.documents_len);
+   _mongoc_cursor_adaptive_reply (cursor,
+                                  (size_t) cursor->rpc.reply.documents_len,
+                                  (uint32_t) cursor->rpc.reply.n_returned);
 
    _mongoc_cursor_monitor_succeeded (cursor,
                                      bson_get_monotonic_time () - started,
@@ -1646,6 +2097,9 @@ _mongoc_cursor_op_getmore (mongoc_cursor_t *cursor,
                                      server_stream,
                                      "getMore");
 
+   _mongoc_cursor_prefetch_send (
+      cursor, server_stream, cursor->rpc.reply.n_returned, false);
+
    RETURN (true);
 
 fail:
@@ -1655,6 +2109,195 @@ fail:
 }
 
 
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_cursor_prefetch_send --
+ *
+ *       If prefetch is enabled, request the batch after the one the
+ *       cursor just received. @ahead is the number of documents in the
+ *       current batch, not yet returned to the application.
+ *
+ *       The reply is not read here: it is read when the application has
+ *       iterated the current batch, or before any other operation selects
+ *       a stream from the client, see mongoc_cluster_read_pending_reply.
+ *
+ *       Errors are recorded in the prefetch and reported when the cursor
+ *       would have sent the getMore itself.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+void
+_mongoc_cursor_prefetch_send (mongoc_cursor_t *cursor,
+                              mongoc_server_stream_t *server_stream,
+                              int64_t ahead,
+                              bool is_command)
+{
+   mongoc_cursor_prefetch_t *prefetch;
+   mongoc_client_t *client;
+   mongoc_cluster_t *cluster;
+   mongoc_query_flags_t flags;
+   mongoc_apply_read_prefs_result_t result = READ_PREFS_RESULT_INIT;
+   mongoc_apm_command_started_t event;
+   mongoc_rpc_t rpc;
+   bson_t command;
+   char db[MONGOC_NAMESPACE_MAX];
+   char cmd_ns[MONGOC_NAMESPACE_MAX];
+   int64_t limit;
+
+   ENTRY;
+
+   prefetch = &cursor->prefetch;
+   client = cursor->client;
+   cluster = &client->cluster;
+   limit = mongoc_cursor_get_limit (cursor);
+
+   /* a tailable cursor's getMore may wait for new data, and the server
+    * streams an exhaust cursor's batches without getMores */
+   if (!prefetch->enabled || prefetch->state != MONGOC_CURSOR_PREFETCH_NONE ||
+       cursor->in_exhaust || client->in_exhaust ||
+       !mongoc_cursor_get_id (cursor) || limit < 0 ||
+       (limit > 0 && cursor->count + ahead >= limit) ||
+       cursor->decoded.tailable) {
+      EXIT;
+   }
+
+   if (!_mongoc_cursor_flags (cursor, server_stream, &flags)) {
+      EXIT;
+   }
+
+   /* build the request as if the application had iterated the batch */
+   cursor->count += (uint32_t) ahead;
+   prefetch->request_id = ++cluster->request_id;
+   _mongoc_cursor_adaptive_request (cursor);
+   bson_strncpy (db, cursor->ns, cursor->dblen + 1);
+
+   if (is_command) {
+      _mongoc_cursor_prepare_getmore_command (cursor, &command);
+      apply_read_preferences (
+         cursor->read_prefs, server_stream, &command, flags, &result);
+
+      bson_snprintf (cmd_ns, sizeof cmd_ns, "%s.$cmd", db);
+      _mongoc_rpc_prep_command (
+         &rpc, cmd_ns, result.query_with_read_prefs, result.flags);
+      rpc.query.request_id = prefetch->request_id;
+
+      if (client->apm_callbacks.started) {
+         mongoc_apm_command_started_init (&event,
+                                          result.query_with_read_prefs,
+                                          db,
+                                          "getMore",
+                                          prefetch->request_id,
+                                          cursor->operation_id,
+                                          &server_stream->sd->host,
+                                          server_stream->sd->id,
+                                          client->apm_context);
+
+         client->apm_callbacks.started (&event);
+         mongoc_apm_command_started_cleanup (&event);
+      }
+   } else {
+      bson_init (&command);
+      _mongoc_cursor_prepare_op_getmore (
+         cursor, flags, prefetch->request_id, &rpc);
+      _mongoc_cursor_monitor_legacy_get_more (cursor, server_stream);
+   }
+
+   cursor->count -= (uint32_t) ahead;
+
+   prefetch->is_command = is_command;
+   prefetch->server_stream = mongoc_server_stream_new (
+      server_stream->topology_type,
+      mongoc_server_description_new_copy (server_stream->sd),
+      server_stream->stream);
+
+   prefetch->started = bson_get_monotonic_time ();
+
+   if (mongoc_cluster_sendv_to_server (
+          cluster, &rpc, 1, server_stream, NULL, &prefetch->error)) {
+      prefetch->state = MONGOC_CURSOR_PREFETCH_IN_FLIGHT;
+      cluster->pending_reply = _mongoc_cursor_prefetch_recv;
+      cluster->pending_reply_ctx = cursor;
+   } else {
+      prefetch->state = MONGOC_CURSOR_PREFETCH_FAILED;
+      prefetch->finished = bson_get_monotonic_time ();
+   }
+
+   apply_read_prefs_result_cleanup (&result);
+   bson_destroy (&command);
+
+   EXIT;
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_cursor_prefetch_recv --
+ *
+ *       Read the reply to a prefetched getMore into the prefetch buffer,
+ *       if it has not been read yet. Also the cluster's pending_reply
+ *       callback, so @ctx is the cursor.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+void
+_mongoc_cursor_prefetch_recv (void *ctx)
+{
+   mongoc_cursor_t *cursor;
+   mongoc_cursor_prefetch_t *prefetch;
+   mongoc_cluster_t *cluster;
+
+   ENTRY;
+
+   cursor = (mongoc_cursor_t *) ctx;
+   prefetch = &cursor->prefetch;
+   cluster = &cursor->client->cluster;
+
+   if (prefetch->state != MONGOC_CURSOR_PREFETCH_IN_FLIGHT) {
+      EXIT;
+   }
+
+   if (cluster->pending_reply_ctx == cursor) {
+      cluster->pending_reply = NULL;
+      cluster->pending_reply_ctx = NULL;
+   }
+
+   _mongoc_buffer_clear (&prefetch->buffer, false);
+
+   if (_mongoc_client_recv (cursor->client,
+                            &prefetch->rpc,
+                            &prefetch->buffer,
+                            prefetch->server_stream,
+                            &prefetch->error)) {
+      prefetch->state = MONGOC_CURSOR_PREFETCH_RECEIVED;
+   } else {
+      prefetch->state = MONGOC_CURSOR_PREFETCH_FAILED;
+   }
+
+   prefetch->finished = bson_get_monotonic_time ();
+
+   EXIT;
+}
+
+
+void
+_mongoc_cursor_prefetch_reset (mongoc_cursor_t *cursor)
+{
+   mongoc_cursor_prefetch_t *prefetch;
+
+   prefetch = &cursor->prefetch;
+
+   BSON_ASSERT (prefetch->state != MONGOC_CURSOR_PREFETCH_IN_FLIGHT);
+
+   mongoc_server_stream_cleanup (prefetch->server_stream);
+   prefetch->server_stream = NULL;
+   prefetch->state = MONGOC_CURSOR_PREFETCH_NONE;
+}
+
+
 bool
 mongoc_cursor_error (mongoc_cursor_t *cursor, bson_error_t *error)
 {
@@ -1743,10 +2386,186 @@ mongoc_cursor_next (mongoc_cursor_t *cursor, const bson_t **bson)
 
    cursor->count++;
 
+   if (cursor->cache_fill) {
+      if (ret) {
+         _mongoc_query_cache_fill_add (cursor->cache_fill, *bson);
+      } else {
+         _mongoc_query_cache_fill_finish (cursor);
+      }
+   }
+
    RETURN (ret);
 }
 
 
+/*
+ *--------------------------------------------------------------------------
+ *
+ * mongoc_cursor_next_batch --
+ *
+ *       Like mongoc_cursor_next, but returns all documents remaining in the
+ *       current batch, up to the cursor's limit. A new batch is fetched if
+ *       the current one is exhausted.
+ *
+ *       The documents are not copied: @data points into the cursor's
+ *       reply, and document i is at @data + @offsets[i]. Each document
+ *       starts with its length, as usual for BSON.
+ *
+ * Returns:
+ *       true if at least one document was returned, false when the cursor
+ *       is exhausted or on error, see mongoc_cursor_error.
+ *
+ * Side effects:
+ *       @data, @data_len, @offsets and @n_docs are valid until the next
+ *       call to mongoc_cursor_next, mongoc_cursor_next_batch or
+ *       mongoc_cursor_destroy.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+bool
+mongoc_cursor_next_batch (mongoc_cursor_t *cursor,
+                          const uint8_t **data,
+                          size_t *data_len,
+                          const uint32_t **offsets,
+                          uint32_t *n_docs)
+{
+   const bson_t *first;
+   const uint8_t *pos;
+   int32_t len;
+   bson_t doc;
+   int64_t limit;
+   uint32_t max_docs = UINT32_MAX;
+   uint32_t i;
+
+   ENTRY;
+
+   BSON_ASSERT (cursor);
+   BSON_ASSERT (data);
+   BSON_ASSERT (data_len);
+   BSON_ASSERT (offsets);
+   BSON_ASSERT (n_docs);
+
+   cursor->batch.data = NULL;
+   cursor->batch.data_len = 0;
+   cursor->batch.n_docs = 0;
+
+   *data = NULL;
+   *data_len = 0;
+   *offsets = NULL;
+   *n_docs = 0;
+
+   /* fetch a batch if needed, and check limit, errors, exhaust etc. once */
+   if (!mongoc_cursor_next (cursor, &first)) {
+      RETURN (false);
+   }
+
+   limit = mongoc_cursor_get_limit (cursor);
+   if (limit) {
+      /* cursor->count includes "first" */
+      max_docs = (uint32_t) (llabs (limit) - cursor->count + 1);
+   }
+
+   if (!cursor->iface.next) {
+      _mongoc_cursor_batch_from_reader (cursor, first, max_docs);
+   } else if (cursor->iface.next == _mongoc_cursor_cursorid_next) {
+      _mongoc_cursor_cursorid_next_batch (cursor, first, max_docs);
+   } else {
+      /* cursors with other interfaces return one document at a time */
+      cursor->batch.data = bson_get_data (first);
+      _mongoc_cursor_batch_add (cursor, bson_get_data (first));
+   }
+
+   cursor->count += cursor->batch.n_docs - 1;
+
+   if (cursor->cache_fill) {
+      /* mongoc_cursor_next recorded "first" */
+      for (i = 1; i < cursor->batch.n_docs; i++) {
+         pos = cursor->batch.data + cursor->batch.offsets[i];
+         memcpy (&len, pos, sizeof len);
+         BSON_ASSERT (
+            bson_init_static (&doc, pos, (size_t) BSON_UINT32_FROM_LE (len)));
+         _mongoc_query_cache_fill_add (cursor->cache_fill, &doc);
+      }
+   }
+
+   *data = cursor->batch.data;
+   *data_len = cursor->batch.data_len;
+   *offsets = cursor->batch.offsets;
+   *n_docs = cursor->batch.n_docs;
+
+   RETURN (true);
+}
+
+
+/* add a document to the batch returned by mongoc_cursor_next_batch */
+void
+_mongoc_cursor_batch_add (mongoc_cursor_t *cursor, const uint8_t *doc)
+{
+   mongoc_cursor_batch_t *batch;
+   uint32_t offset;
+   int32_t len;
+
+   batch = &cursor->batch;
+
+   BSON_ASSERT (doc >= batch->data);
+
+   if (batch->n_docs == batch->n_alloc) {
+      batch->n_alloc = batch->n_alloc ? batch->n_alloc * 2 : 64;
+      batch->offsets = (uint32_t *) bson_realloc (
+         batch->offsets, batch->n_alloc * sizeof (uint32_t));
+   }
+
+   offset = (uint32_t) (doc - batch->data);
+   memcpy (&len, doc, sizeof len);
+   len = BSON_UINT32_FROM_LE (len);
+
+   batch->offsets[batch->n_docs++] = offset;
+   batch->data_len = (size_t) offset + (size_t) len;
+}
+
+
+/* mongoc_cursor_next_batch: "first" was read from cursor->reader, add the
+ * documents after it in the OP_REPLY, and advance the reader past them */
+void
+_mongoc_cursor_batch_from_reader (mongoc_cursor_t *cursor,
+                                  const bson_t *first,
+                                  uint32_t max_docs)
+{
+   const uint8_t *pos;
+   const uint8_t *end;
+   int32_t len;
+
+   pos = bson_get_data (first);
+   end = cursor->rpc.reply.documents + cursor->rpc.reply.documents_len;
+
+   cursor->batch.data = pos;
+   _mongoc_cursor_batch_add (cursor, pos);
+   pos += first->len;
+
+   while (cursor->batch.n_docs < max_docs && end - pos >= 5) {
+      memcpy (&len, pos, sizeof len);
+      len = BSON_UINT32_FROM_LE (len);
+      if (len < 5 || len > end - pos) {
+         /* let the reader report the invalid document */
+         break;
+      }
+
+      _mongoc_cursor_batch_add (cursor, pos);
+      pos += len;
+   }
+
+   /* "first" is inline in the reader, point cursor->current at its copy in
+    * the reply instead */
+   BSON_ASSERT (bson_init_static (
+      &cursor->batch.first, cursor->batch.data, (size_t) first->len));
+   cursor->current = &cursor->batch.first;
+
+   bson_reader_destroy (cursor->reader);
+   cursor->reader = bson_reader_new_from_data (pos, (size_t) (end - pos));
+}
+
+
 bool
 _mongoc_read_from_buffer (mongoc_cursor_t *cursor, const bson_t **bson)
 {
@@ -1809,7 +2628,7 @@ _mongoc_cursor_next (mongoc_cursor_t *cursor, const bson_t **bson)
    }
 
 complete:
-   tailable = _mongoc_cursor_get_opt_bool (cursor, "tailable");
+   tailable = cursor->decoded.tailable;
    cursor->done = (cursor->end_of_event &&
                    ((cursor->in_exhaust && !cursor->rpc.reply.cursor_id) ||
                     (!b && !tailable)));
@@ -1931,6 +2750,7 @@ _mongoc_cursor_clone (const mongoc_cursor_t *cursor)
    _clone->nslen = cursor->nslen;
    _clone->dblen = cursor->dblen;
    _clone->has_fields = cursor->has_fields;
+   _clone->prepared = cursor->prepared;
 
    if (cursor->read_prefs) {
       _clone->read_prefs = mongoc_read_prefs_copy (cursor->read_prefs);
@@ -1943,10 +2763,14 @@ _mongoc_cursor_clone (const mongoc_cursor_t *cursor)
 
    bson_copy_to (&cursor->filter, &_clone->filter);
    bson_copy_to (&cursor->opts, &_clone->opts);
+   memcpy (&_clone->decoded, &cursor->decoded, sizeof _clone->decoded);
 
    bson_strncpy (_clone->ns, cursor->ns, sizeof _clone->ns);
 
    _mongoc_buffer_init (&_clone->buffer, NULL, 0, NULL, NULL);
+   mongoc_cursor_set_prefetch (_clone, cursor->prefetch.enabled);
+   mongoc_cursor_set_stream_depth (_clone, cursor->stream.depth);
+   mongoc_cursor_set_adaptive_batch_size (_clone, cursor->adaptive.max_bytes);
 
    mongoc_counter_cursors_active_inc ();
 
@@ -2004,8 +2828,7 @@ mongoc_cursor_get_batch_size (const mongoc_cursor_t *cursor)
 {
    BSON_ASSERT (cursor);
 
-   return (uint32_t) _mongoc_cursor_get_opt_int64 (
-      cursor, MONGOC_CURSOR_BATCH_SIZE, 0);
+   return (uint32_t) cursor->decoded.batch_size;
 }
 
 bool
@@ -2032,15 +2855,12 @@ int64_t
 mongoc_cursor_get_limit (const mongoc_cursor_t *cursor)
 {
    int64_t limit;
-   bool single_batch;
 
    BSON_ASSERT (cursor);
 
-   limit = _mongoc_cursor_get_opt_int64 (cursor, MONGOC_CURSOR_LIMIT, 0);
-   single_batch =
-      _mongoc_cursor_get_opt_bool (cursor, MONGOC_CURSOR_SINGLE_BATCH);
+   limit = cursor->decoded.limit;
 
-   if (limit > 0 && single_batch) {
+   if (limit > 0 && cursor->decoded.single_batch) {
       limit = -limit;
    }
 
@@ -2099,16 +2919,83 @@ mongoc_cursor_set_max_await_time_ms (mongoc_cursor_t *cursor,
 uint32_t
 mongoc_cursor_get_max_await_time_ms (const mongoc_cursor_t *cursor)
 {
-   bson_iter_t iter;
+   BSON_ASSERT (cursor);
+
+   return (uint32_t) cursor->decoded.max_await_time_ms;
+}
+
+void
+mongoc_cursor_set_prefetch (mongoc_cursor_t *cursor, bool prefetch)
+{
+   BSON_ASSERT (cursor);
+
+   if (prefetch && !cursor->prefetch.buffer.data) {
+      _mongoc_buffer_init (&cursor->prefetch.buffer, NULL, 0, NULL, NULL);
+   }
+
+   cursor->prefetch.enabled = prefetch;
+}
+
+bool
+mongoc_cursor_get_prefetch (const mongoc_cursor_t *cursor)
+{
+   BSON_ASSERT (cursor);
 
+   return cursor->prefetch.enabled;
+}
+
+void
+mongoc_cursor_set_adaptive_batch_size (mongoc_cursor_t *cursor,
+                                       uint32_t max_batch_bytes)
+{
    BSON_ASSERT (cursor);
 
-   if (bson_iter_init_find (
-          &iter, &cursor->opts, MONGOC_CURSOR_MAX_AWAIT_TIME_MS)) {
-      return (uint32_t) bson_iter_as_int64 (&iter);
+   if (max_batch_bytes && !cursor->adaptive.max_bytes) {
+      /* start small, unless the application chose the first batch size */
+      if (!cursor->sent && !cursor->decoded.batch_size) {
+         _mongoc_cursor_set_opt_int64 (
+            cursor,
+            MONGOC_CURSOR_BATCH_SIZE,
+            (int64_t) MONGOC_CURSOR_ADAPTIVE_INITIAL_BATCH_SIZE);
+      }
+
+      cursor->adaptive.batch_size =
+         cursor->decoded.batch_size ? cursor->decoded.batch_size
+                                    : MONGOC_CURSOR_ADAPTIVE_INITIAL_BATCH_SIZE;
    }
 
-   return 0;
+   cursor->adaptive.max_bytes = max_batch_bytes;
+}
+
+uint32_t
+mongoc_cursor_get_adaptive_batch_size (const mongoc_cursor_t *cursor)
+{
+   BSON_ASSERT (cursor);
+
+   return cursor->adaptive.max_bytes;
+}
+
+void
+mongoc_cursor_set_stream_depth (mongoc_cursor_t *cursor, uint32_t depth)
+{
+   BSON_ASSERT (cursor);
+
+   if (depth && !cursor->stream.requests.element_size) {
+      _mongoc_array_init (&cursor->stream.requests,
+                          sizeof (mongoc_cursor_stream_request_t));
+      _mongoc_array_init (&cursor->stream.replies,
+                          sizeof (mongoc_cursor_stream_reply_t));
+   }
+
+   cursor->stream.depth = depth;
+}
+
+uint32_t
+mongoc_cursor_get_stream_depth (const mongoc_cursor_t *cursor)
+{
+   BSON_ASSERT (cursor);
+
+   return cursor->stream.depth;
 }
 
 
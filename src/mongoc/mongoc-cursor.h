@@ -44,6 +44,12 @@ mongoc_cursor_more (mongoc_cursor_t *cursor);
 BSON_EXPORT (bool)
 mongoc_cursor_next (mongoc_cursor_t *cursor, const bson_t **bson);
 BSON_EXPORT (bool)
+mongoc_cursor_next_batch (mongoc_cursor_t *cursor,
+                          const uint8_t **data,
+                          size_t *data_len,
+                          const uint32_t **offsets,
+                          uint32_t *n_docs);
+BSON_EXPORT (bool)
 mongoc_cursor_error (mongoc_cursor_t *cursor, bson_error_t *error);
 BSON_EXPORT (void)
 mongoc_cursor_get_host (mongoc_cursor_t *cursor, mongoc_host_list_t *host);
@@ -72,6 +78,19 @@ mongoc_cursor_set_max_await_time_ms (mongoc_cursor_t *cursor,
                                      uint32_t max_await_time_ms);
 BSON_EXPORT (uint32_t)
 mongoc_cursor_get_max_await_time_ms (const mongoc_cursor_t *cursor);
+BSON_EXPORT (void)
+mongoc_cursor_set_prefetch (mongoc_cursor_t *cursor, bool prefetch);
+BSON_EXPORT (bool)
+mongoc_cursor_get_prefetch (const mongoc_cursor_t *cursor);
+BSON_EXPORT (void)
+mongoc_cursor_set_adaptive_batch_size (mongoc_cursor_t *cursor,
+                                       uint32_t max_batch_bytes);
+BSON_EXPORT (uint32_t)
+mongoc_cursor_get_adaptive_batch_size (const mongoc_cursor_t *cursor);
+BSON_EXPORT (void)
+mongoc_cursor_set_stream_depth (mongoc_cursor_t *cursor, uint32_t depth);
+BSON_EXPORT (uint32_t)
+mongoc_cursor_get_stream_depth (const mongoc_cursor_t *cursor);
 BSON_EXPORT (mongoc_cursor_t *)
 mongoc_cursor_new_from_command_reply (struct _mongoc_client_t *client,
                                       bson_t *reply,
@@ -0,0 +1,84 @@
+/*
+ * Copyright 2017 MongoDB, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MONGOC_GRIDFS_FILE_CACHE_PRIVATE_H
+#define MONGOC_GRIDFS_FILE_CACHE_PRIVATE_H
+
+#if !defined(MONGOC_COMPILATION)
+#error "Only <mongoc.h> can be included directly."
+#endif
+
+#include <bson.h>
+
+#include "mongoc-set-private.h"
+
+
+BSON_BEGIN_DECLS
+
+
+typedef struct _mongoc_gridfs_file_cache_chunk_t {
+   uint32_t n;
+   uint8_t *data;
+   uint32_t len;
+   struct _mongoc_gridfs_file_cache_chunk_t *prev;
+   struct _mongoc_gridfs_file_cache_chunk_t *next;
+} mongoc_gridfs_file_cache_chunk_t;
+
+
+/* a file's chunks by number, evicting the least recently used past
+ * max_size bytes of data */
+typedef struct _mongoc_gridfs_file_cache_t {
+   mongoc_set_t *chunks;
+   mongoc_gridfs_file_cache_chunk_t *lru; /* most recently used first */
+   size_t size;
+   size_t max_size;
+} mongoc_gridfs_file_cache_t;
+
+
+mongoc_gridfs_file_cache_t *
+_mongoc_gridfs_file_cache_new (size_t max_size);
+
+void
+_mongoc_gridfs_file_cache_set_max_size (mongoc_gridfs_file_cache_t *cache,
+                                        size_t max_size);
+
+bool
+_mongoc_gridfs_file_cache_contains (mongoc_gridfs_file_cache_t *cache,
+                                    uint32_t n);
+
+const uint8_t *
+_mongoc_gridfs_file_cache_get (mongoc_gridfs_file_cache_t *cache,
+                               uint32_t n,
+                               uint32_t *len);
+
+void
+_mongoc_gridfs_file_cache_put (mongoc_gridfs_file_cache_t *cache,
+                               uint32_t n,
+                               const uint8_t *data,
+                               uint32_t len);
+
+void
+_mongoc_gridfs_file_cache_remove (mongoc_gridfs_file_cache_t *cache,
+                                  uint32_t n);
+
+void
+_mongoc_gridfs_file_cache_destroy (mongoc_gridfs_file_cache_t *cache);
+
+
+BSON_END_DECLS
+
+
+#endif /* MONGOC_GRIDFS_FILE_CACHE_PRIVATE_H */
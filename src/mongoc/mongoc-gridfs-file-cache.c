@@ -0,0 +1,185 @@
+/*
+ * Copyright 2017 MongoDB, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#undef MONGOC_LOG_DOMAIN
+#define MONGOC_LOG_DOMAIN "gridfs_file_cache"
+
+#include "mongoc-gridfs-file-cache-private.h"
+#include "mongoc-trace-private.h"
+#include "utlist.h"
+
+
+static void
+_mongoc_gridfs_file_cache_chunk_dtor (void *item, void *ctx)
+{
+   mongoc_gridfs_file_cache_chunk_t *chunk =
+      (mongoc_gridfs_file_cache_chunk_t *) item;
+
+   bson_free (chunk->data);
+   bson_free (chunk);
+}
+
+
+mongoc_gridfs_file_cache_t *
+_mongoc_gridfs_file_cache_new (size_t max_size)
+{
+   mongoc_gridfs_file_cache_t *cache;
+
+   cache = (mongoc_gridfs_file_cache_t *) bson_malloc0 (sizeof *cache);
+   cache->chunks =
+      mongoc_set_new (8, _mongoc_gridfs_file_cache_chunk_dtor, NULL);
+   cache->max_size = max_size;
+
+   return cache;
+}
+
+
+static void
+_mongoc_gridfs_file_cache_unlink (mongoc_gridfs_file_cache_t *cache,
+                                  mongoc_gridfs_file_cache_chunk_t *chunk)
+{
+   DL_DELETE (cache->lru, chunk);
+   cache->size -= chunk->len;
+   mongoc_set_rm (cache->chunks, chunk->n);
+}
+
+
+/* evict the least recently used chunks, but never the most recent one:
+ * it is about to be read, even if it alone is over max_size */
+static void
+_mongoc_gridfs_file_cache_evict (mongoc_gridfs_file_cache_t *cache)
+{
+   while (cache->size > cache->max_size && cache->lru &&
+          cache->lru->prev != cache->lru) {
+      _mongoc_gridfs_file_cache_unlink (cache, cache->lru->prev);
+   }
+}
+
+
+void
+_mongoc_gridfs_file_cache_set_max_size (mongoc_gridfs_file_cache_t *cache,
+                                        size_t max_size)
+{
+   BSON_ASSERT (cache);
+
+   cache->max_size = max_size;
+   _mongoc_gridfs_file_cache_evict (cache);
+}
+
+
+bool
+_mongoc_gridfs_file_cache_contains (mongoc_gridfs_file_cache_t *cache,
+                                    uint32_t n)
+{
+   BSON_ASSERT (cache);
+
+   return mongoc_set_get (cache->chunks, n) != NULL;
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_gridfs_file_cache_get --
+ *
+ *       Look up chunk @n and mark it the most recently used.
+ *
+ * Returns:
+ *       The chunk's data, valid until the next put or remove, or NULL if
+ *       the chunk is not cached.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+const uint8_t *
+_mongoc_gridfs_file_cache_get (mongoc_gridfs_file_cache_t *cache,
+                               uint32_t n,
+                               uint32_t *len)
+{
+   mongoc_gridfs_file_cache_chunk_t *chunk;
+
+   BSON_ASSERT (cache);
+   BSON_ASSERT (len);
+
+   chunk = (mongoc_gridfs_file_cache_chunk_t *) mongoc_set_get (cache->chunks,
+                                                                n);
+   if (!chunk) {
+      return NULL;
+   }
+
+   if (chunk != cache->lru) {
+      DL_DELETE (cache->lru, chunk);
+      DL_PREPEND (cache->lru, chunk);
+   }
+
+   *len = chunk->len;
+
+   return chunk->data;
+}
+
+
+void
+_mongoc_gridfs_file_cache_put (mongoc_gridfs_file_cache_t *cache,
+                               uint32_t n,
+                               const uint8_t *data,
+                               uint32_t len)
+{
+   mongoc_gridfs_file_cache_chunk_t *chunk;
+
+   BSON_ASSERT (cache);
+   BSON_ASSERT (data || !len);
+
+   _mongoc_gridfs_file_cache_remove (cache, n);
+
+   chunk = (mongoc_gridfs_file_cache_chunk_t *) bson_malloc0 (sizeof *chunk);
+   chunk->n = n;
+   chunk->data = (uint8_t *) bson_malloc (len ? len : 1);
+   chunk->len = len;
+   memcpy (chunk->data, data, len);
+
+   mongoc_set_add (cache->chunks, n, chunk);
+   DL_PREPEND (cache->lru, chunk);
+   cache->size += len;
+
+   _mongoc_gridfs_file_cache_evict (cache);
+}
+
+
+void
+_mongoc_gridfs_file_cache_remove (mongoc_gridfs_file_cache_t *cache,
+                                  uint32_t n)
+{
+   mongoc_gridfs_file_cache_chunk_t *chunk;
+
+   BSON_ASSERT (cache);
+
+   chunk = (mongoc_gridfs_file_cache_chunk_t *) mongoc_set_get (cache->chunks,
+                                                                n);
+   if (chunk) {
+      _mongoc_gridfs_file_cache_unlink (cache, chunk);
+   }
+}
+
+
+void
+_mongoc_gridfs_file_cache_destroy (mongoc_gridfs_file_cache_t *cache)
+{
+   if (cache) {
+      mongoc_set_destroy (cache->chunks);
+      bson_free (cache);
+   }
+}
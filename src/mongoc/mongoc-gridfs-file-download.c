@@ -0,0 +1,376 @@
+/*
+ * Copyright 2017 MongoDB, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#undef MONGOC_LOG_DOMAIN
+#define MONGOC_LOG_DOMAIN "gridfs_file"
+
+#include <bson.h>
+
+#include "mongoc-client-pool.h"
+#include "mongoc-collection.h"
+#include "mongoc-collection-private.h"
+#include "mongoc-cursor.h"
+#include "mongoc-error.h"
+#include "mongoc-gridfs-file-download.h"
+#include "mongoc-gridfs-file-private.h"
+#include "mongoc-gridfs-private.h"
+#include "mongoc-thread-private.h"
+#include "mongoc-trace-private.h"
+
+
+/* clients used when the caller passes 0 */
+#define MONGOC_GRIDFS_FILE_DOWNLOAD_CLIENTS 4
+
+
+typedef struct {
+   const mongoc_read_prefs_t *read_prefs; /* the gridfs chunks collection's */
+   const bson_value_t *files_id;
+   int64_t length;
+   int32_t chunk_size;
+   int64_t begin; /* bytes to download */
+   int64_t end;
+   mongoc_gridfs_file_download_func_t func;
+   void *ctx;
+   bool failed;
+   bson_error_t error; /* the first error */
+   mongoc_mutex_t mutex;
+} mongoc_gridfs_file_download_t;
+
+
+typedef struct {
+   mongoc_gridfs_file_download_t *download;
+   mongoc_client_t *client; /* from the pool, or NULL for the gridfs client */
+   mongoc_collection_t *chunks;
+   int32_t n_start; /* chunks [n_start, n_end) */
+   int32_t n_end;
+   mongoc_thread_t thread;
+   bool started;
+} mongoc_gridfs_file_download_range_t;
+
+
+static bool
+_mongoc_gridfs_file_download_failed (mongoc_gridfs_file_download_t *download)
+{
+   bool failed;
+
+   mongoc_mutex_lock (&download->mutex);
+   failed = download->failed;
+   mongoc_mutex_unlock (&download->mutex);
+
+   return failed;
+}
+
+
+static void
+_mongoc_gridfs_file_download_fail (mongoc_gridfs_file_download_t *download,
+                                   const bson_error_t *error)
+{
+   mongoc_mutex_lock (&download->mutex);
+   if (!download->failed) {
+      download->failed = true;
+      memcpy (&download->error, error, sizeof (bson_error_t));
+   }
+   mongoc_mutex_unlock (&download->mutex);
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_gridfs_file_download_thread --
+ *
+ *       Query the chunks of one range with the range's client, and pass
+ *       the bytes of each that fall in the download to the callback.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+static void *
+_mongoc_gridfs_file_download_thread (void *data)
+{
+   mongoc_gridfs_file_download_range_t *range =
+      (mongoc_gridfs_file_download_range_t *) data;
+   mongoc_gridfs_file_download_t *download = range->download;
+   mongoc_cursor_t *cursor;
+   const bson_t *chunk;
+   const uint8_t *chunk_data = NULL;
+   bson_iter_t iter;
+   bson_error_t error;
+   uint32_t chunk_len;
+   int64_t chunk_offset;
+   int64_t lo;
+   int64_t hi;
+   int32_t n = range->n_start;
+   bson_t query;
+   bson_t opts;
+   bson_t child;
+   bool ok = true;
+
+   bson_init (&query);
+   BSON_APPEND_VALUE (&query, "files_id", download->files_id);
+   BSON_APPEND_DOCUMENT_BEGIN (&query, "n", &child);
+   BSON_APPEND_INT32 (&child, "$gte", range->n_start);
+   BSON_APPEND_INT32 (&child, "$lt", range->n_end);
+   bson_append_document_end (&query, &child);
+
+   bson_init (&opts);
+   BSON_APPEND_DOCUMENT_BEGIN (&opts, "sort", &child);
+   BSON_APPEND_INT32 (&child, "n", 1);
+   bson_append_document_end (&opts, &child);
+
+   BSON_APPEND_DOCUMENT_BEGIN (&opts, "projection", &child);
+   BSON_APPEND_INT32 (&child, "n", 1);
+   BSON_APPEND_INT32 (&child, "data", 1);
+   BSON_APPEND_INT32 (&child, "_id", 0);
+   bson_append_document_end (&opts, &child);
+
+   cursor = mongoc_collection_find_with_opts (
+      range->chunks, &query, &opts, download->read_prefs);
+
+   while (n < range->n_end && mongoc_cursor_next (cursor, &chunk)) {
+      if (_mongoc_gridfs_file_download_failed (download)) {
+         ok = false;
+         break;
+      }
+
+      if (!bson_iter_init_find (&iter, chunk, "n") ||
+          bson_iter_as_int64 (&iter) != n) {
+         bson_set_error (&error,
+                         MONGOC_ERROR_GRIDFS,
+                         MONGOC_ERROR_GRIDFS_CHUNK_MISSING,
+                         "missing chunk number %" PRId32,
+                         n);
+         _mongoc_gridfs_file_download_fail (download, &error);
+         ok = false;
+         break;
+      }
+
+      chunk_offset = (int64_t) n * download->chunk_size;
+
+      if (!bson_iter_init_find (&iter, chunk, "data") ||
+          !BSON_ITER_HOLDS_BINARY (&iter)) {
+         chunk_len = 0;
+      } else {
+         bson_iter_binary (&iter, NULL, &chunk_len, &chunk_data);
+      }
+
+      /* every chunk is full but the last */
+      if ((int64_t) chunk_len !=
+          BSON_MIN (download->chunk_size, download->length - chunk_offset)) {
+         bson_set_error (&error,
+                         MONGOC_ERROR_GRIDFS,
+                         MONGOC_ERROR_GRIDFS_CHUNK_MISSING,
+                         "corrupt chunk number %" PRId32,
+                         n);
+         _mongoc_gridfs_file_download_fail (download, &error);
+         ok = false;
+         break;
+      }
+
+      lo = BSON_MAX (chunk_offset, download->begin);
+      hi = BSON_MIN (chunk_offset + chunk_len, download->end);
+
+      if (!download->func (chunk_data + (lo - chunk_offset),
+                           (size_t) (hi - lo),
+                           lo,
+                           download->ctx)) {
+         bson_set_error (&error,
+                         MONGOC_ERROR_STREAM,
+                         MONGOC_ERROR_STREAM_INVALID_STATE,
+                         "Failed to write %" PRId64 " bytes at offset %" PRId64,
+                         hi - lo,
+                         lo);
+         _mongoc_gridfs_file_download_fail (download, &error);
+         ok = false;
+         break;
+      }
+
+      n++;
+   }
+
+   if (ok && mongoc_cursor_error (cursor, &error)) {
+      _mongoc_gridfs_file_download_fail (download, &error);
+   } else if (ok && n < range->n_end) {
+      bson_set_error (&error,
+                      MONGOC_ERROR_GRIDFS,
+                      MONGOC_ERROR_GRIDFS_CHUNK_MISSING,
+                      "missing chunk number %" PRId32,
+                      n);
+      _mongoc_gridfs_file_download_fail (download, &error);
+   }
+
+   mongoc_cursor_destroy (cursor);
+   bson_destroy (&opts);
+   bson_destroy (&query);
+
+   return NULL;
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * mongoc_gridfs_file_download_range --
+ *
+ *       Download @len bytes of @file from @offset, or to the end of the
+ *       file if @len is negative, with up to @n_clients clients at once.
+ *       The first is @file's own client, on the calling thread, the others
+ *       are taken from @pool without blocking: the chunks are split into
+ *       one consecutive range per client obtained, each queried on its own
+ *       connection. If @pool has no idle client, the whole download runs
+ *       on @file's client.
+ *
+ *       @func is called with each piece of the file and its offset in the
+ *       file, in order within a range but concurrently across ranges, so
+ *       it must be thread-safe. If it returns false, the download stops.
+ *
+ *       If @n_clients is 0, a default of 4 is used. @file must be saved
+ *       first, only chunks on the server are downloaded.
+ *
+ * Returns:
+ *       true if every byte was passed to @func; otherwise false and
+ *       @error is set.
+ *
+ * Side effects:
+ *       @error may be set.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+bool
+mongoc_gridfs_file_download_range (mongoc_gridfs_file_t *file,
+                                   mongoc_client_pool_t *pool,
+                                   uint32_t n_clients,
+                                   int64_t offset,
+                                   int64_t len,
+                                   mongoc_gridfs_file_download_func_t func,
+                                   void *ctx,
+                                   bson_error_t *error)
+{
+   mongoc_gridfs_file_download_t download;
+   mongoc_gridfs_file_download_range_t *ranges;
+   mongoc_collection_t *gridfs_chunks;
+   mongoc_client_t *client;
+   int64_t n_first;
+   int64_t n_chunks;
+   uint32_t n_ranges;
+   uint32_t i;
+
+   ENTRY;
+
+   BSON_ASSERT (file);
+   BSON_ASSERT (pool);
+   BSON_ASSERT (func);
+
+   if (offset < 0 || offset > file->length ||
+       (len >= 0 && len > file->length - offset)) {
+      bson_set_error (error,
+                      MONGOC_ERROR_COMMAND,
+                      MONGOC_ERROR_COMMAND_INVALID_ARG,
+                      "Range is outside of the file's %" PRId64 " bytes",
+                      file->length);
+      RETURN (false);
+   }
+
+   if (len < 0) {
+      len = file->length - offset;
+   }
+
+   if (len == 0) {
+      RETURN (true);
+   }
+
+   if (n_clients == 0) {
+      n_clients = MONGOC_GRIDFS_FILE_DOWNLOAD_CLIENTS;
+   }
+
+   n_first = offset / file->chunk_size;
+   n_chunks = (offset + len - 1) / file->chunk_size + 1 - n_first;
+   n_clients = (uint32_t) BSON_MIN ((int64_t) n_clients, n_chunks);
+
+   gridfs_chunks = file->gridfs->chunks;
+
+   memset (&download, 0, sizeof download);
+   download.read_prefs = gridfs_chunks->read_prefs;
+   download.files_id = &file->files_id;
+   download.length = file->length;
+   download.chunk_size = file->chunk_size;
+   download.begin = offset;
+   download.end = offset + len;
+   download.func = func;
+   download.ctx = ctx;
+   mongoc_mutex_init (&download.mutex);
+
+   ranges = (mongoc_gridfs_file_download_range_t *) bson_malloc0 (
+      n_clients * sizeof *ranges);
+
+   /* the calling thread downloads the first range with the gridfs client,
+    * so the pool is never blocked on even if the caller holds its last
+    * client. the others use the pool's idle clients, with the gridfs
+    * collection's read preference and read concern */
+   ranges[0].chunks = gridfs_chunks;
+   for (n_ranges = 1; n_ranges < n_clients; n_ranges++) {
+      client = mongoc_client_pool_try_pop (pool);
+      if (!client) {
+         break;
+      }
+
+      ranges[n_ranges].client = client;
+      ranges[n_ranges].chunks = mongoc_client_get_collection (
+         client, gridfs_chunks->db, gridfs_chunks->collection);
+      mongoc_collection_set_read_concern (ranges[n_ranges].chunks,
+                                          gridfs_chunks->read_concern);
+   }
+
+   for (i = 0; i < n_ranges; i++) {
+      ranges[i].download = &download;
+      ranges[i].n_start = (int32_t) (n_first + n_chunks * i / n_ranges);
+      ranges[i].n_end = (int32_t) (n_first + n_chunks * (i + 1) / n_ranges);
+   }
+
+   for (i = 1; i < n_ranges; i++) {
+      ranges[i].started =
+         0 == mongoc_thread_create (&ranges[i].thread,
+                                    _mongoc_gridfs_file_download_thread,
+                                    &ranges[i]);
+   }
+
+   /* download the first range here, and any whose thread failed to start */
+   for (i = 0; i < n_ranges; i++) {
+      if (!ranges[i].started) {
+         _mongoc_gridfs_file_download_thread (&ranges[i]);
+      }
+   }
+
+   for (i = 1; i < n_ranges; i++) {
+      if (ranges[i].started) {
+         mongoc_thread_join (ranges[i].thread);
+      }
+
+      mongoc_collection_destroy (ranges[i].chunks);
+      mongoc_client_pool_push (pool, ranges[i].client);
+   }
+
+   if (download.failed && error) {
+      memcpy (error, &download.error, sizeof (bson_error_t));
+   }
+
+   bson_free (ranges);
+   mongoc_mutex_destroy (&download.mutex);
+
+   RETURN (!download.failed);
+}
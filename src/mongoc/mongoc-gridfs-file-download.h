@@ -0,0 +1,53 @@
+/*
+ * Copyright 2017 MongoDB, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MONGOC_GRIDFS_FILE_DOWNLOAD_H
+#define MONGOC_GRIDFS_FILE_DOWNLOAD_H
+
+#if !defined(MONGOC_INSIDE) && !defined(MONGOC_COMPILATION)
+#error "Only <mongoc.h> can be included directly."
+#endif
+
+#include <bson.h>
+
+#include "mongoc-client-pool.h"
+#include "mongoc-gridfs-file.h"
+
+
+BSON_BEGIN_DECLS
+
+
+typedef bool (*mongoc_gridfs_file_download_func_t) (const uint8_t *data,
+                                                    size_t len,
+                                                    int64_t offset,
+                                                    void *ctx);
+
+
+BSON_EXPORT (bool)
+mongoc_gridfs_file_download_range (mongoc_gridfs_file_t *file,
+                                   mongoc_client_pool_t *pool,
+                                   uint32_t n_clients,
+                                   int64_t offset,
+                                   int64_t len,
+                                   mongoc_gridfs_file_download_func_t func,
+                                   void *ctx,
+                                   bson_error_t *error);
+
+
+BSON_END_DECLS
+
+
+#endif /* MONGOC_GRIDFS_FILE_DOWNLOAD_H */
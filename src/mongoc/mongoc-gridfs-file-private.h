@@ -23,8 +23,10 @@
 
 #include <bson.h>
 
+#include "mongoc-bulk-operation.h"
 #include "mongoc-gridfs.h"
 #include "mongoc-gridfs-file.h"
+#include "mongoc-gridfs-file-cache-private.h"
 #include "mongoc-gridfs-file-page.h"
 #include "mongoc-cursor.h"
 
@@ -40,8 +42,16 @@ struct _mongoc_gridfs_file_t {
    int32_t n;
    bson_error_t error;
    mongoc_cursor_t *cursor;
-   uint32_t cursor_range[2]; /* current chunk, # of chunks */
+   uint32_t cursor_range[2];          /* current chunk, # of chunks */
+   uint32_t read_ahead;               /* chunks per batch, 0 for the default */
+   mongoc_gridfs_file_cache_t *cache; /* chunks read, NULL if disabled */
    bool is_dirty;
+   mongoc_bulk_operation_t *bulk; /* new chunks waiting to be inserted */
+   uint32_t bulk_len;             /* bytes of chunk data in bulk */
+   int32_t n_stored; /* chunks stored or in bulk, -1 to always upsert */
+   bson_md5_t md5_ctx; /* of the first md5_len bytes written */
+   int64_t md5_len;    /* -1 if not computing the md5 */
+   bool md5_computed;  /* md5 is md5_ctx's digest, not the caller's */
 
    bson_value_t files_id;
    int64_t length;
@@ -66,6 +76,8 @@ _mongoc_gridfs_file_new_from_bson (mongoc_gridfs_t *gridfs, const bson_t *data);
 mongoc_gridfs_file_t *
 _mongoc_gridfs_file_new (mongoc_gridfs_t *gridfs,
                          mongoc_gridfs_file_opt_t *opt);
+bool
+_mongoc_gridfs_file_flush_chunks (mongoc_gridfs_file_t *file);
 
 
 BSON_END_DECLS
@@ -22,19 +22,27 @@
 #include <time.h>
 #include <errno.h>
 
+#include "mongoc-bulk-operation.h"
+#include "mongoc-client-private.h"
+#include "mongoc-cluster-private.h"
 #include "mongoc-cursor.h"
 #include "mongoc-cursor-private.h"
 #include "mongoc-collection.h"
 #include "mongoc-gridfs.h"
 #include "mongoc-gridfs-private.h"
 #include "mongoc-gridfs-file.h"
+#include "mongoc-gridfs-file-cache-private.h"
 #include "mongoc-gridfs-file-private.h"
 #include "mongoc-gridfs-file-page.h"
 #include "mongoc-gridfs-file-page-private.h"
 #include "mongoc-iovec.h"
+#include "mongoc-log.h"
 #include "mongoc-trace-private.h"
 #include "mongoc-error.h"
 
+/* chunks fetched per cache miss, unless the file has a read-ahead window */
+#define MONGOC_GRIDFS_FILE_CACHE_BATCH 4
+
 static bool
 _mongoc_gridfs_file_refresh_page (mongoc_gridfs_file_t *file);
 
@@ -89,12 +97,31 @@ _mongoc_gridfs_file_extend (mongoc_gridfs_file_t *file);
       file->is_dirty = 1;                                                   \
    }
 
-MONGOC_GRIDFS_FILE_STR_ACCESSOR (md5)
 MONGOC_GRIDFS_FILE_STR_ACCESSOR (filename)
 MONGOC_GRIDFS_FILE_STR_ACCESSOR (content_type)
 MONGOC_GRIDFS_FILE_BSON_ACCESSOR (aliases)
 MONGOC_GRIDFS_FILE_BSON_ACCESSOR (metadata)
 
+const char *
+mongoc_gridfs_file_get_md5 (mongoc_gridfs_file_t *file)
+{
+   return file->md5 ? file->md5 : file->bson_md5;
+}
+
+void
+mongoc_gridfs_file_set_md5 (mongoc_gridfs_file_t *file, const char *str)
+{
+   if (file->md5) {
+      bson_free (file->md5);
+   }
+   file->md5 = bson_strdup (str);
+   file->is_dirty = 1;
+
+   /* the caller's md5 replaces the one computed while writing */
+   file->md5_len = -1;
+   file->md5_computed = false;
+}
+
 /**
  * mongoc_gridfs_file_set_id:
  *
@@ -124,6 +151,10 @@ bool
 mongoc_gridfs_file_save (mongoc_gridfs_file_t *file)
 {
    bson_t *selector, *update, child;
+   bson_md5_t md5_ctx;
+   uint8_t digest[16];
+   char digest_str[33];
+   int i;
    const char *md5;
    const char *filename;
    const char *content_type;
@@ -141,6 +172,26 @@ mongoc_gridfs_file_save (mongoc_gridfs_file_t *file)
       _mongoc_gridfs_file_flush_page (file);
    }
 
+   if (!_mongoc_gridfs_file_flush_chunks (file)) {
+      RETURN (false);
+   }
+
+   if (file->md5_len >= 0 && file->md5_len == file->length) {
+      /* finish a copy, so later writes can still be appended */
+      md5_ctx = file->md5_ctx;
+      bson_md5_finish (&md5_ctx, digest);
+
+      for (i = 0; i < sizeof digest; i++) {
+         bson_snprintf (&digest_str[i * 2], 3, "%02x", digest[i]);
+      }
+
+      if (file->md5) {
+         bson_free (file->md5);
+      }
+      file->md5 = bson_strdup (digest_str);
+      file->md5_computed = true;
+   }
+
    md5 = mongoc_gridfs_file_get_md5 (file);
    filename = mongoc_gridfs_file_get_filename (file);
    content_type = mongoc_gridfs_file_get_content_type (file);
@@ -178,6 +229,13 @@ mongoc_gridfs_file_save (mongoc_gridfs_file_t *file)
 
    bson_append_document_end (update, &child);
 
+   /* drop an md5 saved before a rewrite made it stale */
+   if (!md5) {
+      bson_append_document_begin (update, "$unset", -1, &child);
+      bson_append_utf8 (&child, "md5", -1, "", 0);
+      bson_append_document_end (update, &child);
+   }
+
    r = mongoc_collection_update (file->gridfs->files,
                                  MONGOC_UPDATE_UPSERT,
                                  selector,
@@ -220,6 +278,8 @@ _mongoc_gridfs_file_new_from_bson (mongoc_gridfs_t *gridfs, const bson_t *data)
    file = (mongoc_gridfs_file_t *) bson_malloc0 (sizeof *file);
 
    file->gridfs = gridfs;
+   file->n_stored = -1; /* rewrite a stored file's chunks with upserts */
+   file->md5_len = -1;
    bson_copy_to (data, &file->bson);
 
    bson_iter_init (&iter, &file->bson);
@@ -335,6 +395,11 @@ _mongoc_gridfs_file_new (mongoc_gridfs_t *gridfs, mongoc_gridfs_file_opt_t *opt)
 
    if (opt->md5) {
       file->md5 = bson_strdup (opt->md5);
+      file->md5_len = -1;
+   } else if (opt->disable_md5) {
+      file->md5_len = -1;
+   } else {
+      bson_md5_init (&file->md5_ctx);
    }
 
    if (opt->filename) {
@@ -370,6 +435,14 @@ mongoc_gridfs_file_destroy (mongoc_gridfs_file_t *file)
       _mongoc_gridfs_file_page_destroy (file->page);
    }
 
+   if (file->bulk) {
+      MONGOC_WARNING ("Discarding %" PRIu32 " bytes of GridFS chunks that "
+                      "were never inserted, call mongoc_gridfs_file_save "
+                      "before mongoc_gridfs_file_destroy",
+                      file->bulk_len);
+      mongoc_bulk_operation_destroy (file->bulk);
+   }
+
    if (file->bson.len) {
       bson_destroy (&file->bson);
    }
@@ -378,6 +451,8 @@ mongoc_gridfs_file_destroy (mongoc_gridfs_file_t *file)
       mongoc_cursor_destroy (file->cursor);
    }
 
+   _mongoc_gridfs_file_cache_destroy (file->cache);
+
    if (file->files_id.value_type) {
       bson_value_destroy (&file->files_id);
    }
@@ -480,6 +555,63 @@ mongoc_gridfs_file_readv (mongoc_gridfs_file_t *file,
 }
 
 
+/**
+ * mongoc_gridfs_file_read_borrowed:
+ *
+ *    Read the rest of the current chunk without copying it: @data is set
+ *    to the chunk's bytes from the file position on, in place in the
+ *    server reply, and the position advances past them.
+ *
+ * Returns:
+ *
+ *    The number of bytes at @data, valid until the next call with @file.
+ *    0 at the end of the file, or -1 on error.
+ */
+ssize_t
+mongoc_gridfs_file_read_borrowed (mongoc_gridfs_file_t *file,
+                                  const uint8_t **data)
+{
+   uint32_t offset;
+   uint32_t len;
+
+   ENTRY;
+
+   BSON_ASSERT (file);
+   BSON_ASSERT (data);
+
+   *data = NULL;
+
+   if (file->pos >= file->length) {
+      RETURN (0);
+   }
+
+   if (!file->page || _mongoc_gridfs_file_page_tell (file->page) ==
+                         _mongoc_gridfs_file_page_get_len (file->page)) {
+      if (!_mongoc_gridfs_file_refresh_page (file)) {
+         RETURN (-1);
+      }
+   }
+
+   offset = _mongoc_gridfs_file_page_tell (file->page);
+   len = _mongoc_gridfs_file_page_get_len (file->page) - offset;
+
+   if (len == 0) {
+      bson_set_error (&file->error,
+                      MONGOC_ERROR_GRIDFS,
+                      MONGOC_ERROR_GRIDFS_CHUNK_MISSING,
+                      "corrupt chunk number %" PRId32,
+                      file->n);
+      RETURN (-1);
+   }
+
+   *data = _mongoc_gridfs_file_page_get_data (file->page) + offset;
+
+   _mongoc_gridfs_file_page_seek (file->page, offset + len);
+   file->pos += len;
+
+   RETURN ((ssize_t) len);
+}
+
 /** writev against a gridfs file
  *  timeout_msec is unused */
 ssize_t
@@ -504,6 +636,19 @@ mongoc_gridfs_file_writev (mongoc_gridfs_file_t *file,
       return -1;
    }
 
+   /* the md5 covers bytes written in order from the start, stop computing
+    * it when a write goes elsewhere, and forget a digest already computed:
+    * it no longer matches the file */
+   if (file->md5_len != (int64_t) file->pos) {
+      file->md5_len = -1;
+
+      if (file->md5_computed) {
+         bson_free (file->md5);
+         file->md5 = NULL;
+         file->md5_computed = false;
+      }
+   }
+
    /* When writing past the end-of-file, fill the gap with zeros */
    if (file->pos > file->length && !_mongoc_gridfs_file_extend (file)) {
       return -1;
@@ -524,6 +669,13 @@ mongoc_gridfs_file_writev (mongoc_gridfs_file_t *file,
             (uint32_t) (iov[i].iov_len - iov_pos));
          BSON_ASSERT (r >= 0);
 
+         if (file->md5_len >= 0) {
+            bson_md5_append (&file->md5_ctx,
+                             (const uint8_t *) iov[i].iov_base + iov_pos,
+                             (uint32_t) r);
+            file->md5_len += r;
+         }
+
          iov_pos += r;
          file->pos += r;
          bytes_written += r;
@@ -536,7 +688,9 @@ mongoc_gridfs_file_writev (mongoc_gridfs_file_t *file,
          } else {
             /** flush the buffer, the next pass through will bring in a new page
              */
-            _mongoc_gridfs_file_flush_page (file);
+            if (!_mongoc_gridfs_file_flush_page (file)) {
+               RETURN (-1);
+            }
          }
       }
    }
@@ -606,15 +760,112 @@ _mongoc_gridfs_file_extend (mongoc_gridfs_file_t *file)
 }
 
 
+/**
+ * _mongoc_gridfs_file_flush_chunks:
+ *
+ *    Insert the new chunks queued by _mongoc_gridfs_file_flush_page. The
+ *    bulk operation splits them into as few insert commands as fit in the
+ *    server's maxMessageSizeBytes.
+ *
+ * Side Effects:
+ *
+ *    On failure, file->error is set and the file's chunks are upserted from
+ *    then on, since some of the queued chunks may have been inserted.
+ *
+ * Returns:
+ *
+ *    True on success; false otherwise.
+ */
+bool
+_mongoc_gridfs_file_flush_chunks (mongoc_gridfs_file_t *file)
+{
+   bool r;
+
+   ENTRY;
+   BSON_ASSERT (file);
+
+   if (!file->bulk) {
+      RETURN (true);
+   }
+
+   r = mongoc_bulk_operation_execute (file->bulk, NULL, &file->error) != 0;
+
+   mongoc_bulk_operation_destroy (file->bulk);
+   file->bulk = NULL;
+   file->bulk_len = 0;
+
+   if (!r) {
+      file->n_stored = -1;
+   }
+
+   RETURN (r);
+}
+
+
+/**
+ * _mongoc_gridfs_file_queue_chunk:
+ *
+ *    Queue a chunk past the end of the stored chunks for insertion, and
+ *    insert the queue once it holds maxMessageSizeBytes of chunk data.
+ *
+ * Returns:
+ *
+ *    True on success; false otherwise.
+ */
+static bool
+_mongoc_gridfs_file_queue_chunk (mongoc_gridfs_file_t *file,
+                                 const uint8_t *buf,
+                                 uint32_t len)
+{
+   bson_t *chunk;
+   int32_t max_msg_size;
+
+   ENTRY;
+
+   if (!file->bulk) {
+      file->bulk = mongoc_collection_create_bulk_operation (
+         file->gridfs->chunks, true, NULL);
+   }
+
+   chunk = bson_sized_new (file->chunk_size + 100);
+
+   bson_append_value (chunk, "files_id", -1, &file->files_id);
+   bson_append_int32 (chunk, "n", -1, file->n);
+   bson_append_binary (chunk, "data", -1, BSON_SUBTYPE_BINARY, buf, len);
+
+   mongoc_bulk_operation_insert (file->bulk, chunk);
+   bson_destroy (chunk);
+
+   file->n_stored++;
+   file->bulk_len += len;
+
+   max_msg_size =
+      mongoc_cluster_get_max_msg_size (&file->gridfs->client->cluster);
+
+   if (file->bulk_len >= (uint32_t) max_msg_size) {
+      RETURN (_mongoc_gridfs_file_flush_chunks (file));
+   }
+
+   RETURN (true);
+}
+
+
 /**
  * _mongoc_gridfs_file_flush_page:
  *
  *    Unconditionally flushes the file's current page to the database.
  *    The page to flush is determined by page->n.
  *
+ *    A chunk past the end of the stored chunks, as when writing a new
+ *    file, is queued and inserted in a batch with the chunks after it by
+ *    _mongoc_gridfs_file_flush_chunks. Other chunks are upserted one at a
+ *    time, once the queue has been inserted. The files document is saved
+ *    after each upsert and each batch insert.
+ *
  * Side Effects:
  *
- *    On success, file->page is properly destroyed and set to NULL.
+ *    On success, file->page is properly destroyed and set to NULL. A queued
+ *    page is destroyed even if inserting the queue fails.
  *
  * Returns:
  *
@@ -635,6 +886,24 @@ _mongoc_gridfs_file_flush_page (mongoc_gridfs_file_t *file)
    buf = _mongoc_gridfs_file_page_get_data (file->page);
    len = _mongoc_gridfs_file_page_get_len (file->page);
 
+   if (file->n == file->n_stored) {
+      r = _mongoc_gridfs_file_queue_chunk (file, buf, len);
+      _mongoc_gridfs_file_page_destroy (file->page);
+      file->page = NULL;
+
+      /* the queue was inserted */
+      if (r && !file->bulk) {
+         r = mongoc_gridfs_file_save (file);
+      }
+
+      RETURN (r);
+   }
+
+   /* keep chunks in order: an upsert must not precede the chunk's insert */
+   if (!_mongoc_gridfs_file_flush_chunks (file)) {
+      RETURN (false);
+   }
+
    selector = bson_new ();
 
    bson_append_value (selector, "files_id", -1, &file->files_id);
@@ -659,6 +928,11 @@ _mongoc_gridfs_file_flush_page (mongoc_gridfs_file_t *file)
    if (r) {
       _mongoc_gridfs_file_page_destroy (file->page);
       file->page = NULL;
+
+      if (file->cache) {
+         _mongoc_gridfs_file_cache_remove (file->cache, (uint32_t) file->n);
+      }
+
       r = mongoc_gridfs_file_save (file);
    }
 
@@ -691,8 +965,13 @@ _mongoc_gridfs_file_keep_cursor (mongoc_gridfs_file_t *file)
    }
 
    chunk_no = (uint32_t) file->n;
-   /* server returns roughly 4 MB batches by default */
-   chunks_per_batch = (4 * 1024 * 1024) / (uint32_t) file->chunk_size;
+
+   if (file->read_ahead) {
+      chunks_per_batch = file->read_ahead;
+   } else {
+      /* server returns roughly 4 MB batches by default */
+      chunks_per_batch = (4 * 1024 * 1024) / (uint32_t) file->chunk_size;
+   }
 
    return (
       /* cursor is on or before the desired chunk */
@@ -711,6 +990,127 @@ divide_round_up (int64_t num, int64_t denom)
 }
 
 
+/**
+ * _mongoc_gridfs_file_read_cached:
+ *
+ *    Get chunk file->n from the file's cache. If it is missing, fetch it
+ *    along with the next uncached chunks in one query, as many as
+ *    file->read_ahead or MONGOC_GRIDFS_FILE_CACHE_BATCH, and no more than
+ *    fit in the cache together.
+ *
+ * Side Effects:
+ *
+ *    @data and @len are set to the cached chunk, valid until the cache is
+ *    next changed. file->error is set on error.
+ */
+static bool
+_mongoc_gridfs_file_read_cached (mongoc_gridfs_file_t *file,
+                                 const uint8_t **data,
+                                 uint32_t *len)
+{
+   mongoc_cursor_t *cursor;
+   const bson_t *chunk;
+   const uint8_t *chunk_data;
+   uint32_t chunk_len;
+   bson_iter_t iter;
+   bson_t query;
+   bson_t opts;
+   bson_t child;
+   bson_t in;
+   char buf[16];
+   const char *key;
+   uint32_t n_chunks;
+   uint32_t batch;
+   uint32_t i;
+   uint32_t n;
+   int64_t chunk_n;
+   bool r = true;
+
+   ENTRY;
+
+   *data = _mongoc_gridfs_file_cache_get (file->cache, (uint32_t) file->n, len);
+   if (*data) {
+      RETURN (true);
+   }
+
+   batch = file->read_ahead ? file->read_ahead : MONGOC_GRIDFS_FILE_CACHE_BATCH;
+   batch = (uint32_t) BSON_MIN (
+      batch, file->cache->max_size / (uint32_t) file->chunk_size);
+   batch = BSON_MAX (batch, 1);
+   n_chunks = (uint32_t) divide_round_up (file->length, file->chunk_size);
+
+   bson_init (&query);
+   BSON_APPEND_VALUE (&query, "files_id", &file->files_id);
+   BSON_APPEND_DOCUMENT_BEGIN (&query, "n", &child);
+   BSON_APPEND_ARRAY_BEGIN (&child, "$in", &in);
+   for (n = (uint32_t) file->n, i = 0; n < n_chunks && i < batch; n++) {
+      if (!_mongoc_gridfs_file_cache_contains (file->cache, n)) {
+         bson_uint32_to_string (i++, &key, buf, sizeof buf);
+         BSON_APPEND_INT32 (&in, key, (int32_t) n);
+      }
+   }
+   bson_append_array_end (&child, &in);
+   bson_append_document_end (&query, &child);
+
+   bson_init (&opts);
+   BSON_APPEND_DOCUMENT_BEGIN (&opts, "projection", &child);
+   BSON_APPEND_INT32 (&child, "n", 1);
+   BSON_APPEND_INT32 (&child, "data", 1);
+   BSON_APPEND_INT32 (&child, "_id", 0);
+   bson_append_document_end (&opts, &child);
+   BSON_APPEND_INT64 (&opts, "batchSize", i);
+
+   cursor = mongoc_collection_find_with_opts (
+      file->gridfs->chunks, &query, &opts, NULL);
+
+   while (mongoc_cursor_next (cursor, &chunk)) {
+      if (!bson_iter_init_find (&iter, chunk, "n") ||
+          (chunk_n = bson_iter_as_int64 (&iter)) < file->n ||
+          chunk_n >= n_chunks || !bson_iter_init_find (&iter, chunk, "data") ||
+          !BSON_ITER_HOLDS_BINARY (&iter)) {
+         continue;
+      }
+
+      bson_iter_binary (&iter, NULL, &chunk_len, &chunk_data);
+      if (chunk_len > (uint32_t) file->chunk_size) {
+         bson_set_error (&file->error,
+                         MONGOC_ERROR_GRIDFS,
+                         MONGOC_ERROR_GRIDFS_CHUNK_MISSING,
+                         "corrupt chunk number %" PRId64,
+                         chunk_n);
+         r = false;
+         break;
+      }
+
+      _mongoc_gridfs_file_cache_put (
+         file->cache, (uint32_t) chunk_n, chunk_data, chunk_len);
+   }
+
+   if (r && mongoc_cursor_error (cursor, &file->error)) {
+      r = false;
+   }
+
+   mongoc_cursor_destroy (cursor);
+   bson_destroy (&opts);
+   bson_destroy (&query);
+
+   if (!r) {
+      RETURN (false);
+   }
+
+   *data = _mongoc_gridfs_file_cache_get (file->cache, (uint32_t) file->n, len);
+   if (!*data) {
+      bson_set_error (&file->error,
+                      MONGOC_ERROR_GRIDFS,
+                      MONGOC_ERROR_GRIDFS_CHUNK_MISSING,
+                      "missing chunk number %" PRId32,
+                      file->n);
+      RETURN (false);
+   }
+
+   RETURN (true);
+}
+
 /**
  * _mongoc_gridfs_file_refresh_page:
  *
@@ -766,76 +1166,104 @@ _mongoc_gridfs_file_refresh_page (mongoc_gridfs_file_t *file)
       data = (uint8_t *) "";
       len = 0;
    } else {
-      /* if we have a cursor, but the cursor doesn't have the chunk we're going
-       * to need, destroy it (we'll grab a new one immediately there after) */
-      if (file->cursor && !_mongoc_gridfs_file_keep_cursor (file)) {
-         mongoc_cursor_destroy (file->cursor);
-         file->cursor = NULL;
-      }
+      /* the chunk may still be queued. insert the queue, and query anew */
+      if (file->bulk) {
+         if (file->cursor) {
+            mongoc_cursor_destroy (file->cursor);
+            file->cursor = NULL;
+         }
 
-      if (!file->cursor) {
-         bson_init (&query);
-         BSON_APPEND_VALUE (&query, "files_id", &file->files_id);
-         BSON_APPEND_DOCUMENT_BEGIN (&query, "n", &child);
-         BSON_APPEND_INT32 (&child, "$gte", file->n);
-         bson_append_document_end (&query, &child);
+         if (!_mongoc_gridfs_file_flush_chunks (file)) {
+            RETURN (0);
+         }
+      }
 
-         bson_init (&opts);
-         BSON_APPEND_DOCUMENT_BEGIN (&opts, "sort", &child);
-         BSON_APPEND_INT32 (&child, "n", 1);
-         bson_append_document_end (&opts, &child);
+      if (file->cache) {
+         if (!_mongoc_gridfs_file_read_cached (file, &data, &len)) {
+            RETURN (0);
+         }
+      } else {
+         /* if we have a cursor, but the cursor doesn't have the chunk we're
+          * going to need, destroy it (we'll grab a new one immediately there
+          * after) */
+         if (file->cursor && !_mongoc_gridfs_file_keep_cursor (file)) {
+            mongoc_cursor_destroy (file->cursor);
+            file->cursor = NULL;
+         }
 
-         BSON_APPEND_DOCUMENT_BEGIN (&opts, "projection", &child);
-         BSON_APPEND_INT32 (&child, "n", 1);
-         BSON_APPEND_INT32 (&child, "data", 1);
-         BSON_APPEND_INT32 (&child, "_id", 0);
-         bson_append_document_end (&opts, &child);
+         if (!file->cursor) {
+            bson_init (&query);
+            BSON_APPEND_VALUE (&query, "files_id", &file->files_id);
+            BSON_APPEND_DOCUMENT_BEGIN (&query, "n", &child);
+            BSON_APPEND_INT32 (&child, "$gte", file->n);
+            bson_append_document_end (&query, &child);
+
+            bson_init (&opts);
+            BSON_APPEND_DOCUMENT_BEGIN (&opts, "sort", &child);
+            BSON_APPEND_INT32 (&child, "n", 1);
+            bson_append_document_end (&opts, &child);
+
+            BSON_APPEND_DOCUMENT_BEGIN (&opts, "projection", &child);
+            BSON_APPEND_INT32 (&child, "n", 1);
+            BSON_APPEND_INT32 (&child, "data", 1);
+            BSON_APPEND_INT32 (&child, "_id", 0);
+            bson_append_document_end (&opts, &child);
+
+            if (file->read_ahead) {
+               BSON_APPEND_INT64 (&opts, "batchSize", file->read_ahead);
+            }
 
-         /* find all chunks greater than or equal to our current file pos */
-         file->cursor = mongoc_collection_find_with_opts (
-            file->gridfs->chunks, &query, &opts, NULL);
+            /* find all chunks greater than or equal to our current file pos */
+            file->cursor = mongoc_collection_find_with_opts (
+               file->gridfs->chunks, &query, &opts, NULL);
 
-         file->cursor_range[0] = file->n;
-         file->cursor_range[1] = (uint32_t) (file->length / file->chunk_size);
+            /* request each batch of chunks while the last one is read */
+            mongoc_cursor_set_prefetch (file->cursor, file->read_ahead > 0);
 
-         bson_destroy (&query);
-         bson_destroy (&opts);
+            file->cursor_range[0] = file->n;
+            file->cursor_range[1] =
+               (uint32_t) (file->length / file->chunk_size);
 
-         BSON_ASSERT (file->cursor);
-      }
+            bson_destroy (&query);
+            bson_destroy (&opts);
 
-      /* we might have had a cursor before, then seeked ahead past a chunk.
-       * iterate until we're on the right chunk */
-      while (file->cursor_range[0] <= file->n) {
-         if (!mongoc_cursor_next (file->cursor, &chunk)) {
-            /* copy cursor error, if any. might just lack a matching chunk. */
-            mongoc_cursor_error (file->cursor, &file->error);
-            RETURN (0);
+            BSON_ASSERT (file->cursor);
          }
 
-         file->cursor_range[0]++;
-      }
-
-      bson_iter_init (&iter, chunk);
+         /* we might have had a cursor before, then seeked ahead past a chunk.
+          * iterate until we're on the right chunk */
+         while (file->cursor_range[0] <= file->n) {
+            if (!mongoc_cursor_next (file->cursor, &chunk)) {
+               /* copy cursor error, if any. might just lack a matching
+                * chunk. */
+               mongoc_cursor_error (file->cursor, &file->error);
+               RETURN (0);
+            }
 
-      /* grab out what we need from the chunk */
-      while (bson_iter_next (&iter)) {
-         key = bson_iter_key (&iter);
+            file->cursor_range[0]++;
+         }
 
-         if (strcmp (key, "n") == 0) {
-            if (file->n != bson_iter_int32 (&iter)) {
-               bson_set_error (&file->error,
-                               MONGOC_ERROR_GRIDFS,
-                               MONGOC_ERROR_GRIDFS_CHUNK_MISSING,
-                               "missing chunk number %" PRId32,
-                               file->n);
+         bson_iter_init (&iter, chunk);
+
+         /* grab out what we need from the chunk */
+         while (bson_iter_next (&iter)) {
+            key = bson_iter_key (&iter);
+
+            if (strcmp (key, "n") == 0) {
+               if (file->n != bson_iter_int32 (&iter)) {
+                  bson_set_error (&file->error,
+                                  MONGOC_ERROR_GRIDFS,
+                                  MONGOC_ERROR_GRIDFS_CHUNK_MISSING,
+                                  "missing chunk number %" PRId32,
+                                  file->n);
+                  RETURN (0);
+               }
+            } else if (strcmp (key, "data") == 0) {
+               bson_iter_binary (&iter, NULL, &len, &data);
+            } else {
+               /* Unexpected key. This should never happen */
                RETURN (0);
             }
-         } else if (strcmp (key, "data") == 0) {
-            bson_iter_binary (&iter, NULL, &len, &data);
-         } else {
-            /* Unexpected key. This should never happen */
-            RETURN (0);
          }
       }
 
@@ -1003,6 +1431,99 @@ mongoc_gridfs_file_get_upload_date (mongoc_gridfs_file_t *file)
    return file->upload_date;
 }
 
+/* an unwritten page reads from the cursor's reply or the cache, drop it
+ * before them. the next read fetches it again */
+static void
+_mongoc_gridfs_file_drop_clean_page (mongoc_gridfs_file_t *file)
+{
+   if (file->page && !_mongoc_gridfs_file_page_is_dirty (file->page)) {
+      _mongoc_gridfs_file_page_destroy (file->page);
+      file->page = NULL;
+   }
+}
+
+/**
+ * mongoc_gridfs_file_set_read_ahead:
+ *
+ *    Read chunks from the server in batches of @n_chunks, and request the
+ *    next batch as soon as one arrives, so it is on its way while the
+ *    current batch is read. 0 restores the server's default batches,
+ *    requested only when the current batch runs out.
+ *
+ * Side Effects:
+ *
+ *    The next read queries the chunks anew.
+ */
+void
+mongoc_gridfs_file_set_read_ahead (mongoc_gridfs_file_t *file,
+                                   uint32_t n_chunks)
+{
+   BSON_ASSERT (file);
+
+   if (file->read_ahead == n_chunks) {
+      return;
+   }
+
+   file->read_ahead = n_chunks;
+
+   if (file->cursor) {
+      _mongoc_gridfs_file_drop_clean_page (file);
+      mongoc_cursor_destroy (file->cursor);
+      file->cursor = NULL;
+   }
+}
+
+uint32_t
+mongoc_gridfs_file_get_read_ahead (mongoc_gridfs_file_t *file)
+{
+   BSON_ASSERT (file);
+
+   return file->read_ahead;
+}
+
+/**
+ * mongoc_gridfs_file_set_cache_size:
+ *
+ *    Keep up to @max_bytes of chunk data read from the server, evicting
+ *    the least recently used chunks, so reads that return to a chunk do
+ *    not query it again. 0 disables the cache.
+ *
+ * Side Effects:
+ *
+ *    While the cache is enabled, reads query the missing chunks by number
+ *    instead of with a cursor over the rest of the file.
+ */
+void
+mongoc_gridfs_file_set_cache_size (mongoc_gridfs_file_t *file,
+                                   size_t max_bytes)
+{
+   BSON_ASSERT (file);
+
+   _mongoc_gridfs_file_drop_clean_page (file);
+
+   if (!max_bytes) {
+      _mongoc_gridfs_file_cache_destroy (file->cache);
+      file->cache = NULL;
+   } else if (file->cache) {
+      _mongoc_gridfs_file_cache_set_max_size (file->cache, max_bytes);
+   } else {
+      file->cache = _mongoc_gridfs_file_cache_new (max_bytes);
+   }
+
+   if (file->cursor) {
+      mongoc_cursor_destroy (file->cursor);
+      file->cursor = NULL;
+   }
+}
+
+size_t
+mongoc_gridfs_file_get_cache_size (mongoc_gridfs_file_t *file)
+{
+   BSON_ASSERT (file);
+
+   return file->cache ? file->cache->max_size : 0;
+}
+
 bool
 mongoc_gridfs_file_remove (mongoc_gridfs_file_t *file, bson_error_t *error)
 {
@@ -1011,6 +1532,12 @@ mongoc_gridfs_file_remove (mongoc_gridfs_file_t *file, bson_error_t *error)
 
    BSON_ASSERT (file);
 
+   if (file->bulk) {
+      mongoc_bulk_operation_destroy (file->bulk);
+      file->bulk = NULL;
+      file->bulk_len = 0;
+   }
+
    BSON_APPEND_VALUE (&sel, "_id", &file->files_id);
 
    if (!mongoc_collection_remove (file->gridfs->files,
@@ -55,6 +55,7 @@ struct _mongoc_gridfs_file_opt_t {
    const bson_t *aliases;
    const bson_t *metadata;
    uint32_t chunk_size;
+   bool disable_md5;
 };
 
 
@@ -88,6 +89,9 @@ mongoc_gridfs_file_readv (mongoc_gridfs_file_t *file,
                           size_t iovcnt,
                           size_t min_bytes,
                           uint32_t timeout_msec);
+BSON_EXPORT (ssize_t)
+mongoc_gridfs_file_read_borrowed (mongoc_gridfs_file_t *file,
+                                  const uint8_t **data);
 BSON_EXPORT (int)
 mongoc_gridfs_file_seek (mongoc_gridfs_file_t *file, int64_t delta, int whence);
 
@@ -111,6 +115,20 @@ mongoc_gridfs_file_error (mongoc_gridfs_file_t *file, bson_error_t *error);
 BSON_EXPORT (bool)
 mongoc_gridfs_file_remove (mongoc_gridfs_file_t *file, bson_error_t *error);
 
+BSON_EXPORT (void)
+mongoc_gridfs_file_set_read_ahead (mongoc_gridfs_file_t *file,
+                                   uint32_t n_chunks);
+
+BSON_EXPORT (uint32_t)
+mongoc_gridfs_file_get_read_ahead (mongoc_gridfs_file_t *file);
+
+BSON_EXPORT (void)
+mongoc_gridfs_file_set_cache_size (mongoc_gridfs_file_t *file,
+                                   size_t max_bytes);
+
+BSON_EXPORT (size_t)
+mongoc_gridfs_file_get_cache_size (mongoc_gridfs_file_t *file);
+
 BSON_END_DECLS
 
 #endif /* MONGOC_GRIDFS_FILE_H */
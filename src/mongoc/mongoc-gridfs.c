@@ -298,7 +298,10 @@ mongoc_gridfs_create_file_from_stream (mongoc_gridfs_t *gridfs,
 
       if (r > 0) {
          iov.iov_len = r;
-         mongoc_gridfs_file_writev (file, &iov, 1, timeout);
+         if (mongoc_gridfs_file_writev (file, &iov, 1, timeout) < 0) {
+            mongoc_gridfs_file_destroy (file);
+            RETURN (NULL);
+         }
       } else if (r == 0) {
          break;
       } else {
@@ -311,6 +314,13 @@ mongoc_gridfs_create_file_from_stream (mongoc_gridfs_t *gridfs,
 
    mongoc_gridfs_file_seek (file, 0, SEEK_SET);
 
+   /* full chunks are inserted in batches, send the last batch and save the
+    * files document */
+   if (!mongoc_gridfs_file_save (file)) {
+      mongoc_gridfs_file_destroy (file);
+      RETURN (NULL);
+   }
+
    RETURN (file);
 }
 
@@ -0,0 +1,441 @@
+/*
+ * Copyright 2017 MongoDB, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <bson.h>
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifdef BSON_OS_UNIX
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "mongoc-array-private.h"
+#include "mongoc-counters-private.h"
+#include "mongoc-error.h"
+#include "mongoc-matcher.h"
+#include "mongoc-matcher-private.h"
+#include "mongoc-thread-private.h"
+#include "mongoc-trace-private.h"
+
+
+/* documents are handed to the threads in runs of about this many bytes */
+#define MONGOC_MATCHER_FILE_CHUNK_SIZE (4 * 1024 * 1024)
+
+
+typedef struct {
+   size_t begin; /* offset of the first document */
+   size_t end;   /* offset past the last document */
+   mongoc_array_t matches; /* of size_t offsets */
+   bool done;
+} mongoc_matcher_file_chunk_t;
+
+
+typedef struct {
+   const mongoc_matcher_t *matcher;
+   const uint8_t *data;
+   mongoc_matcher_file_chunk_t *chunks;
+   size_t n_ready; /* chunks found by splitting so far */
+   size_t next;    /* next chunk for a thread to match */
+   bool split_done;
+   bool stop;
+   mongoc_mutex_t mutex;
+   mongoc_cond_t cond;
+} mongoc_matcher_file_t;
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_matcher_file_map --
+ *
+ *       Map the file at @path into memory, read-only. Where mmap() is
+ *       not available, the file is read into a buffer instead.
+ *
+ * Returns:
+ *       true if successful; otherwise false and @error is set.
+ *
+ * Side effects:
+ *       @data and @size are set, release with _mongoc_matcher_file_unmap().
+ *
+ *--------------------------------------------------------------------------
+ */
+
+static bool
+_mongoc_matcher_file_map (const char *path,    /* IN */
+                          uint8_t **data,      /* OUT */
+                          size_t *size,        /* OUT */
+                          bson_error_t *error) /* OUT */
+{
+#ifdef BSON_OS_UNIX
+   struct stat st;
+   void *mem;
+   int fd;
+
+   if (-1 == (fd = open (path, O_RDONLY))) {
+      goto failure;
+   }
+
+   if (-1 == fstat (fd, &st)) {
+      close (fd);
+      goto failure;
+   }
+
+   *size = (size_t) st.st_size;
+   *data = NULL;
+
+   if (*size == 0) {
+      close (fd);
+      return true;
+   }
+
+   mem = mmap (NULL, *size, PROT_READ, MAP_PRIVATE, fd, 0);
+   close (fd);
+
+   if (mem == MAP_FAILED) {
+      goto failure;
+   }
+
+#ifdef MADV_SEQUENTIAL
+   madvise (mem, *size, MADV_SEQUENTIAL);
+#endif
+
+   *data = (uint8_t *) mem;
+
+   return true;
+
+failure:
+   bson_set_error (error,
+                   MONGOC_ERROR_STREAM,
+                   MONGOC_ERROR_STREAM_INVALID_STATE,
+                   "Failed to map \"%s\": %s",
+                   path,
+                   strerror (errno));
+   return false;
+#else
+   FILE *file;
+   int64_t len;
+
+   if (!(file = fopen (path, "rb"))) {
+      goto failure;
+   }
+
+/* long is 32 bits on Windows, too short for a multi-GB dump */
+#ifdef _WIN32
+   if (_fseeki64 (file, 0, SEEK_END) != 0 || (len = _ftelli64 (file)) < 0 ||
+       _fseeki64 (file, 0, SEEK_SET) != 0 || (uint64_t) len > SIZE_MAX) {
+#else
+   if (fseek (file, 0, SEEK_END) != 0 || (len = ftell (file)) < 0 ||
+       fseek (file, 0, SEEK_SET) != 0) {
+#endif
+      fclose (file);
+      goto failure;
+   }
+
+   *size = (size_t) len;
+   *data = (uint8_t *) bson_malloc (*size ? *size : 1);
+
+   if (fread (*data, 1, *size, file) != *size) {
+      bson_free (*data);
+      fclose (file);
+      goto failure;
+   }
+
+   fclose (file);
+
+   return true;
+
+failure:
+   bson_set_error (error,
+                   MONGOC_ERROR_STREAM,
+                   MONGOC_ERROR_STREAM_INVALID_STATE,
+                   "Failed to read \"%s\"",
+                   path);
+   return false;
+#endif
+}
+
+
+static void
+_mongoc_matcher_file_unmap (uint8_t *data, /* IN */
+                            size_t size)   /* IN */
+{
+#ifdef BSON_OS_UNIX
+   if (data) {
+      munmap (data, size);
+   }
+#else
+   bson_free (data);
+#endif
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_matcher_file_thread --
+ *
+ *       Match the documents of each chunk it claims, in any order, and
+ *       record the offsets of those that match.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+static void *
+_mongoc_matcher_file_thread (void *data)
+{
+   mongoc_matcher_file_t *file = (mongoc_matcher_file_t *) data;
+   mongoc_matcher_file_chunk_t *chunk;
+   uint32_t len;
+   size_t offset;
+   bson_t doc;
+   bool r;
+
+   for (;;) {
+      mongoc_mutex_lock (&file->mutex);
+
+      while (!file->stop && file->next == file->n_ready &&
+             !file->split_done) {
+         mongoc_cond_wait (&file->cond, &file->mutex);
+      }
+
+      if (file->stop || file->next == file->n_ready) {
+         mongoc_mutex_unlock (&file->mutex);
+         break;
+      }
+
+      chunk = &file->chunks[file->next++];
+      mongoc_mutex_unlock (&file->mutex);
+
+      for (offset = chunk->begin; offset < chunk->end; offset += len) {
+         memcpy (&len, file->data + offset, sizeof len);
+         len = BSON_UINT32_FROM_LE (len);
+
+         /* lengths were checked while splitting */
+         r = bson_init_static (&doc, file->data + offset, len);
+         BSON_ASSERT (r);
+
+         if (_mongoc_matcher_program_run (file->matcher->program, &doc)) {
+            _mongoc_array_append_val (&chunk->matches, offset);
+         }
+      }
+
+      mongoc_mutex_lock (&file->mutex);
+      chunk->done = true;
+      mongoc_cond_broadcast (&file->cond);
+      mongoc_mutex_unlock (&file->mutex);
+   }
+
+   return NULL;
+}
+
+
+static void
+_mongoc_matcher_file_publish (mongoc_matcher_file_t *file, /* IN */
+                              size_t begin,                /* IN */
+                              size_t end)                  /* IN */
+{
+   mongoc_matcher_file_chunk_t *chunk;
+
+   mongoc_mutex_lock (&file->mutex);
+   chunk = &file->chunks[file->n_ready];
+   chunk->begin = begin;
+   chunk->end = end;
+   _mongoc_array_init (&chunk->matches, sizeof (size_t));
+   file->n_ready++;
+   mongoc_cond_broadcast (&file->cond);
+   mongoc_mutex_unlock (&file->mutex);
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * mongoc_matcher_match_file --
+ *
+ *       Calls @func for each document in the BSON file at @path, such as
+ *       a mongodump .bson file, that matches @matcher.
+ *
+ *       The file is memory-mapped and split on document boundaries into
+ *       chunks, which @n_threads threads match while the rest of the
+ *       file is split. @func is called from the calling thread, in file
+ *       order, once the whole file has been split. The documents it gets
+ *       point into the mapping and are only valid during the call.
+ *
+ *       If @n_threads is 0, one thread per core is used. If @func returns
+ *       false, no more documents are matched.
+ *
+ * Returns:
+ *       true if the whole file was read; otherwise false and @error is
+ *       set. @func is never called for a file that is not a sequence of
+ *       BSON documents.
+ *
+ * Side effects:
+ *       @error may be set.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+bool
+mongoc_matcher_match_file (const mongoc_matcher_t *matcher,  /* IN */
+                           const char *path,                 /* IN */
+                           uint32_t n_threads,               /* IN */
+                           mongoc_matcher_file_func_t func,  /* IN */
+                           void *ctx,                        /* IN */
+                           bson_error_t *error)              /* OUT */
+{
+   mongoc_matcher_file_t file;
+   mongoc_matcher_file_chunk_t *chunk;
+   mongoc_thread_t *threads;
+   uint8_t *data;
+   size_t size;
+   size_t offset = 0;
+   size_t begin = 0;
+   size_t n_chunks;
+   size_t i;
+   size_t j;
+   uint32_t len;
+   uint32_t n_started = 0;
+   uint32_t t;
+   bson_t doc;
+   bool ret = true;
+   bool r;
+
+   ENTRY;
+
+   BSON_ASSERT (matcher);
+   BSON_ASSERT (path);
+   BSON_ASSERT (func);
+
+   if (!_mongoc_matcher_file_map (path, &data, &size, error)) {
+      RETURN (false);
+   }
+
+   if (n_threads == 0) {
+      n_threads = BSON_MAX (_mongoc_get_cpu_count (), 1);
+   }
+
+   memset (&file, 0, sizeof file);
+   file.matcher = matcher;
+   file.data = data;
+   /* chunks end at least CHUNK_SIZE bytes apart, except the last */
+   n_chunks = size / MONGOC_MATCHER_FILE_CHUNK_SIZE + 1;
+   file.chunks = (mongoc_matcher_file_chunk_t *) bson_malloc0 (
+      n_chunks * sizeof (mongoc_matcher_file_chunk_t));
+   mongoc_mutex_init (&file.mutex);
+   mongoc_cond_init (&file.cond);
+
+   threads = (mongoc_thread_t *) bson_malloc (n_threads * sizeof *threads);
+   for (t = 0; t < n_threads; t++) {
+      if (0 == mongoc_thread_create (
+                  &threads[n_started], _mongoc_matcher_file_thread, &file)) {
+         n_started++;
+      }
+   }
+
+   while (offset < size) {
+      if (size - offset < 5) {
+         ret = false;
+         break;
+      }
+
+      memcpy (&len, data + offset, sizeof len);
+      len = BSON_UINT32_FROM_LE (len);
+
+      if (len < 5 || len > size - offset || data[offset + len - 1] != '\0') {
+         ret = false;
+         break;
+      }
+
+      offset += len;
+
+      if (offset - begin >= MONGOC_MATCHER_FILE_CHUNK_SIZE || offset == size) {
+         _mongoc_matcher_file_publish (&file, begin, offset);
+         begin = offset;
+      }
+   }
+
+   mongoc_mutex_lock (&file.mutex);
+   file.split_done = true;
+   file.stop = !ret;
+   mongoc_cond_broadcast (&file.cond);
+   mongoc_mutex_unlock (&file.mutex);
+
+   if (!ret) {
+      bson_set_error (error,
+                      MONGOC_ERROR_BSON,
+                      MONGOC_ERROR_BSON_INVALID,
+                      "Corrupt BSON document at offset %" PRIu64 " in \"%s\"",
+                      (uint64_t) offset,
+                      path);
+   }
+
+   /* no thread started: match every chunk on this one */
+   if (!n_started) {
+      _mongoc_matcher_file_thread (&file);
+   }
+
+   /* hand the matches to func in file order */
+   for (i = 0; ret && i < file.n_ready; i++) {
+      chunk = &file.chunks[i];
+
+      mongoc_mutex_lock (&file.mutex);
+      while (!chunk->done) {
+         mongoc_cond_wait (&file.cond, &file.mutex);
+      }
+      mongoc_mutex_unlock (&file.mutex);
+
+      for (j = 0; j < chunk->matches.len; j++) {
+         offset = _mongoc_array_index (&chunk->matches, size_t, j);
+         memcpy (&len, data + offset, sizeof len);
+         r = bson_init_static (&doc, data + offset, BSON_UINT32_FROM_LE (len));
+         BSON_ASSERT (r);
+
+         if (!func (&doc, ctx)) {
+            mongoc_mutex_lock (&file.mutex);
+            file.stop = true;
+            mongoc_cond_broadcast (&file.cond);
+            mongoc_mutex_unlock (&file.mutex);
+            break;
+         }
+      }
+
+      if (file.stop) {
+         break;
+      }
+   }
+
+   for (t = 0; t < n_started; t++) {
+      mongoc_thread_join (threads[t]);
+   }
+
+   for (i = 0; i < file.n_ready; i++) {
+      _mongoc_array_destroy (&file.chunks[i].matches);
+   }
+
+   bson_free (threads);
+   bson_free (file.chunks);
+   mongoc_cond_destroy (&file.cond);
+   mongoc_mutex_destroy (&file.mutex);
+   _mongoc_matcher_file_unmap (data, size);
+
+   RETURN (ret);
+}
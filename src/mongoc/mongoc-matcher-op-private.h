@@ -23,6 +23,10 @@
 
 #include <bson.h>
 
+#ifdef BSON_OS_UNIX
+#include <regex.h>
+#endif
+
 
 BSON_BEGIN_DECLS
 
@@ -34,6 +38,9 @@ typedef struct _mongoc_matcher_op_compare_t mongoc_matcher_op_compare_t;
 typedef struct _mongoc_matcher_op_exists_t mongoc_matcher_op_exists_t;
 typedef struct _mongoc_matcher_op_type_t mongoc_matcher_op_type_t;
 typedef struct _mongoc_matcher_op_not_t mongoc_matcher_op_not_t;
+typedef struct _mongoc_matcher_op_regex_t mongoc_matcher_op_regex_t;
+typedef struct _mongoc_matcher_op_elem_match_t mongoc_matcher_op_elem_match_t;
+typedef struct _mongoc_matcher_set_t mongoc_matcher_set_t;
 
 
 typedef enum {
@@ -51,6 +58,8 @@ typedef enum {
    MONGOC_MATCHER_OPCODE_NOR,
    MONGOC_MATCHER_OPCODE_EXISTS,
    MONGOC_MATCHER_OPCODE_TYPE,
+   MONGOC_MATCHER_OPCODE_REGEX,
+   MONGOC_MATCHER_OPCODE_ELEM_MATCH,
 } mongoc_matcher_opcode_t;
 
 
@@ -70,6 +79,7 @@ struct _mongoc_matcher_op_compare_t {
    mongoc_matcher_op_base_t base;
    char *path;
    bson_iter_t iter;
+   mongoc_matcher_set_t *set; /* hashed $in or $nin values, or NULL */
 };
 
 
@@ -94,6 +104,25 @@ struct _mongoc_matcher_op_not_t {
 };
 
 
+struct _mongoc_matcher_op_regex_t {
+   mongoc_matcher_op_base_t base;
+   char *path;
+   char *pattern;
+   char *options;
+#ifdef BSON_OS_UNIX
+   regex_t regex; /* compiled when the op is created */
+#endif
+};
+
+
+struct _mongoc_matcher_op_elem_match_t {
+   mongoc_matcher_op_base_t base;
+   char *path;
+   mongoc_matcher_op_t *child;
+   bool is_query; /* child matches documents, else it matches values */
+};
+
+
 union _mongoc_matcher_op_t {
    mongoc_matcher_op_base_t base;
    mongoc_matcher_op_logical_t logical;
@@ -101,6 +130,8 @@ union _mongoc_matcher_op_t {
    mongoc_matcher_op_exists_t exists;
    mongoc_matcher_op_type_t type;
    mongoc_matcher_op_not_t not_;
+   mongoc_matcher_op_regex_t regex;
+   mongoc_matcher_op_elem_match_t elem_match;
 };
 
 
@@ -118,8 +149,21 @@ mongoc_matcher_op_t *
 _mongoc_matcher_op_type_new (const char *path, bson_type_t type);
 mongoc_matcher_op_t *
 _mongoc_matcher_op_not_new (const char *path, mongoc_matcher_op_t *child);
+mongoc_matcher_op_t *
+_mongoc_matcher_op_regex_new (const char *path,
+                              const char *pattern,
+                              const char *options,
+                              bson_error_t *error);
+mongoc_matcher_op_t *
+_mongoc_matcher_op_elem_match_new (const char *path,
+                                   mongoc_matcher_op_t *child,
+                                   bool is_query);
 bool
 _mongoc_matcher_op_match (mongoc_matcher_op_t *op, const bson_t *bson);
+bool
+_mongoc_matcher_op_match_value (mongoc_matcher_op_t *op, bson_iter_t *iter);
+bool
+_mongoc_matcher_op_missing_match (const mongoc_matcher_op_t *op);
 void
 _mongoc_matcher_op_destroy (mongoc_matcher_op_t *op);
 void
@@ -15,10 +15,20 @@
  */
 
 
+#include <ctype.h>
+
+#include "mongoc-error.h"
 #include "mongoc-log.h"
 #include "mongoc-matcher-op-private.h"
 #include "mongoc-util-private.h"
 
+
+static mongoc_matcher_set_t *
+_mongoc_matcher_set_new (const bson_iter_t *array);
+
+static void
+_mongoc_matcher_set_destroy (mongoc_matcher_set_t *set);
+
 /*
  *--------------------------------------------------------------------------
  *
@@ -170,6 +180,12 @@ _mongoc_matcher_op_compare_new (mongoc_matcher_opcode_t opcode, /* IN */
    op->compare.path = bson_strdup (path);
    memcpy (&op->compare.iter, iter, sizeof *iter);
 
+   if ((opcode == MONGOC_MATCHER_OPCODE_IN ||
+        opcode == MONGOC_MATCHER_OPCODE_NIN) &&
+       BSON_ITER_HOLDS_ARRAY (iter)) {
+      op->compare.set = _mongoc_matcher_set_new (iter);
+   }
+
    return op;
 }
 
@@ -209,77 +225,303 @@ _mongoc_matcher_op_not_new (const char *path,           /* IN */
 }
 
 
+#ifdef BSON_OS_UNIX
+static bool
+_mongoc_matcher_regex_unsupported (const char *pattern, /* IN */
+                                   const char *syntax,  /* IN */
+                                   int len,             /* IN */
+                                   bson_error_t *error) /* OUT */
+{
+   bson_set_error (error,
+                   MONGOC_ERROR_MATCHER,
+                   MONGOC_ERROR_MATCHER_INVALID,
+                   "Unsupported $regex syntax \"%.*s\" in \"%s\": only POSIX "
+                   "extended regular expressions are supported",
+                   len,
+                   syntax,
+                   pattern);
+   return false;
+}
+
+
 /*
  *--------------------------------------------------------------------------
  *
- * _mongoc_matcher_op_destroy --
+ * _mongoc_matcher_regex_translate --
  *
- *       Free a mongoc_matcher_op_t structure and all children structures.
+ *       Translate a $regex @pattern to a POSIX extended regular expression
+ *       in @out, to be compiled with REG_NEWLINE if and only if
+ *       @multiline.
+ *
+ *       PCRE's "." never matches a newline unless @dotall, and a negated
+ *       bracket expression always does. POSIX ties both to REG_NEWLINE,
+ *       which also makes "^" and "$" match at newlines like the "m"
+ *       option, so "." and "[^...]" are rewritten to match or skip
+ *       newlines as PCRE would.
+ *
+ *       Escapes of letters and digits, such as "\d" or "\b", "(?",
+ *       lazy and possessive quantifiers, and escapes within brackets mean
+ *       something else or nothing in POSIX, and are rejected.
  *
  * Returns:
- *       None.
+ *       true if @pattern was translated, false and sets @error if it uses
+ *       unsupported syntax. A pattern that is simply invalid is left for
+ *       regcomp() to reject.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+static bool
+_mongoc_matcher_regex_translate (const char *pattern, /* IN */
+                                 bool multiline,      /* IN */
+                                 bool dotall,         /* IN */
+                                 bson_string_t *out,  /* OUT */
+                                 bson_error_t *error) /* OUT */
+{
+   const char *p = pattern;
+   const char *start;
+   bool after_quantifier = false;
+   bool quantifier;
+   bool negated;
+
+   while (*p) {
+      quantifier = false;
+
+      switch (*p) {
+      case '\\':
+         if (isalnum ((unsigned char) p[1])) {
+            return _mongoc_matcher_regex_unsupported (pattern, p, 2, error);
+         }
+
+         bson_string_append_c (out, *p++);
+         if (!*p) {
+            continue;
+         }
+
+         bson_string_append_c (out, *p);
+         break;
+      case '(':
+         if (p[1] == '?') {
+            return _mongoc_matcher_regex_unsupported (pattern, p, 2, error);
+         }
+
+         bson_string_append_c (out, *p);
+         break;
+      case '*':
+      case '+':
+      case '?':
+         if (after_quantifier) {
+            return _mongoc_matcher_regex_unsupported (pattern, p - 1, 2, error);
+         }
+
+         bson_string_append_c (out, *p);
+         quantifier = true;
+         break;
+      case '{':
+         /* an interval such as {2,3}, otherwise PCRE takes "{" literally */
+         start = p++;
+         while (isdigit ((unsigned char) *p) || *p == ',') {
+            p++;
+         }
+
+         if (*p == '}' && isdigit ((unsigned char) start[1])) {
+            if (after_quantifier) {
+               return _mongoc_matcher_regex_unsupported (
+                  pattern, start - 1, 2, error);
+            }
+
+            bson_string_append_printf (
+               out, "%.*s", (int) (p - start + 1), start);
+            quantifier = true;
+         } else {
+            bson_string_append (out, "\\{");
+            p = start;
+         }
+         break;
+      case '.':
+         if (dotall) {
+            /* REG_NEWLINE stops "." matching newlines */
+            bson_string_append (out, multiline ? "(.|\n)" : ".");
+         } else {
+            bson_string_append (out, multiline ? "." : "[^\n]");
+         }
+         break;
+      case '[':
+         start = p++;
+         negated = (*p == '^');
+         if (negated) {
+            p++;
+         }
+
+         /* a "]" first in the list is literal */
+         if (*p == ']') {
+            p++;
+         }
+
+         while (*p && *p != ']') {
+            if (*p == '\\') {
+               return _mongoc_matcher_regex_unsupported (pattern, p, 1, error);
+            }
+
+            /* skip a class such as [:alpha:], which may contain "]" */
+            if (*p == '[' && (p[1] == ':' || p[1] == '.' || p[1] == '=')) {
+               const char *end = strchr (p + 2, p[1]);
+
+               while (end && end[1] != ']') {
+                  end = strchr (end + 1, p[1]);
+               }
+
+               if (end) {
+                  p = end + 1;
+               }
+            }
+
+            p++;
+         }
+
+         if (*p) {
+            p++;
+         }
+
+         if (negated && multiline) {
+            /* REG_NEWLINE stops negated brackets matching newlines */
+            bson_string_append_printf (
+               out, "(%.*s|\n)", (int) (p - start), start);
+         } else {
+            bson_string_append_printf (out, "%.*s", (int) (p - start), start);
+         }
+
+         after_quantifier = false;
+         continue;
+      default:
+         bson_string_append_c (out, *p);
+         break;
+      }
+
+      after_quantifier = quantifier;
+      p++;
+   }
+
+   return true;
+}
+#endif
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_matcher_op_regex_new --
+ *
+ *       Create a new op for checking {$regex: pattern, $options: ...}.
+ *       The pattern is compiled here, once, as a POSIX extended regular
+ *       expression, with "." and "^" and "$" treating newlines as the
+ *       server's PCRE does. The options "i", "m" and "s" are supported,
+ *       PCRE syntax that POSIX lacks is rejected.
+ *
+ * Returns:
+ *       A newly allocated mongoc_matcher_op_t that should be freed with
+ *       _mongoc_matcher_op_destroy(), or NULL if the pattern is invalid
+ *       and @error is set.
  *
  * Side effects:
- *       None.
+ *       @error may be set.
  *
  *--------------------------------------------------------------------------
  */
-void
-_mongoc_matcher_op_destroy (mongoc_matcher_op_t *op) /* IN */
+
+mongoc_matcher_op_t *
+_mongoc_matcher_op_regex_new (const char *path,    /* IN */
+                              const char *pattern, /* IN */
+                              const char *options, /* IN */
+                              bson_error_t *error) /* OUT */
 {
-   BSON_ASSERT (op);
+#ifdef BSON_OS_UNIX
+   mongoc_matcher_op_t *op;
+   char msg[128];
+   int cflags = REG_EXTENDED | REG_NOSUB;
+   bson_string_t *posix;
+   bool dotall = false;
+   const char *o;
+   int r;
 
-   switch (op->base.opcode) {
-   case MONGOC_MATCHER_OPCODE_EQ:
-   case MONGOC_MATCHER_OPCODE_GT:
-   case MONGOC_MATCHER_OPCODE_GTE:
-   case MONGOC_MATCHER_OPCODE_IN:
-   case MONGOC_MATCHER_OPCODE_LT:
-   case MONGOC_MATCHER_OPCODE_LTE:
-   case MONGOC_MATCHER_OPCODE_NE:
-   case MONGOC_MATCHER_OPCODE_NIN:
-      bson_free (op->compare.path);
-      break;
-   case MONGOC_MATCHER_OPCODE_OR:
-   case MONGOC_MATCHER_OPCODE_AND:
-   case MONGOC_MATCHER_OPCODE_NOR:
-      if (op->logical.left)
-         _mongoc_matcher_op_destroy (op->logical.left);
-      if (op->logical.right)
-         _mongoc_matcher_op_destroy (op->logical.right);
-      break;
-   case MONGOC_MATCHER_OPCODE_NOT:
-      _mongoc_matcher_op_destroy (op->not_.child);
-      bson_free (op->not_.path);
-      break;
-   case MONGOC_MATCHER_OPCODE_EXISTS:
-      bson_free (op->exists.path);
-      break;
-   case MONGOC_MATCHER_OPCODE_TYPE:
-      bson_free (op->type.path);
-      break;
-   default:
-      break;
+   BSON_ASSERT (path);
+   BSON_ASSERT (pattern);
+
+   for (o = options ? options : ""; *o; o++) {
+      switch (*o) {
+      case 'i':
+         cflags |= REG_ICASE;
+         break;
+      case 'm':
+         /* ^ and $ match at newlines */
+         cflags |= REG_NEWLINE;
+         break;
+      case 's':
+         dotall = true;
+         break;
+      default:
+         bson_set_error (error,
+                         MONGOC_ERROR_MATCHER,
+                         MONGOC_ERROR_MATCHER_INVALID,
+                         "Unsupported $regex option \"%c\"",
+                         *o);
+         return NULL;
+      }
    }
 
-   bson_free (op);
+   posix = bson_string_new (NULL);
+   if (!_mongoc_matcher_regex_translate (
+          pattern, (cflags & REG_NEWLINE) != 0, dotall, posix, error)) {
+      bson_string_free (posix, true);
+      return NULL;
+   }
+
+   op = (mongoc_matcher_op_t *) bson_malloc0 (sizeof *op);
+   op->regex.base.opcode = MONGOC_MATCHER_OPCODE_REGEX;
+
+   r = regcomp (&op->regex.regex, posix->str, cflags);
+   bson_string_free (posix, true);
+
+   if (r) {
+      regerror (r, &op->regex.regex, msg, sizeof msg);
+      bson_set_error (error,
+                      MONGOC_ERROR_MATCHER,
+                      MONGOC_ERROR_MATCHER_INVALID,
+                      "Invalid $regex \"%s\": %s",
+                      pattern,
+                      msg);
+      bson_free (op);
+      return NULL;
+   }
+
+   op->regex.path = bson_strdup (path);
+   op->regex.pattern = bson_strdup (pattern);
+   op->regex.options = bson_strdup (options ? options : "");
+
+   return op;
+#else
+   bson_set_error (error,
+                   MONGOC_ERROR_MATCHER,
+                   MONGOC_ERROR_MATCHER_INVALID,
+                   "$regex is not supported on this platform");
+   return NULL;
+#endif
 }
 
 
 /*
  *--------------------------------------------------------------------------
  *
- * _mongoc_matcher_op_exists_match --
+ * _mongoc_matcher_op_elem_match_new --
  *
- *       Checks to see if @bson matches @exists requirements. The
- *       {$exists: bool} query can be either true or fase so we must
- *       handle false as "not exists".
+ *       Create a new op for checking {$elemMatch: {...}}. If @is_query,
+ *       @child is a query that an array's documents must match, such as
+ *       {$elemMatch: {a: 1}}. Otherwise @child's operators apply to the
+ *       array's values, such as {$elemMatch: {$gt: 1, $lt: 5}}.
  *
  * Returns:
- *       true if the field exists and the spec expected it.
- *       true if the field does not exist and the spec expected it to not
- *       exist.
- *       Otherwise, false.
+ *       A newly allocated mongoc_matcher_op_t that should be freed with
+ *       _mongoc_matcher_op_destroy(). It takes ownership of @child.
  *
  * Side effects:
  *       None.
@@ -287,57 +529,93 @@ _mongoc_matcher_op_destroy (mongoc_matcher_op_t *op) /* IN */
  *--------------------------------------------------------------------------
  */
 
-static bool
-_mongoc_matcher_op_exists_match (mongoc_matcher_op_exists_t *exists, /* IN */
-                                 const bson_t *bson)                 /* IN */
+mongoc_matcher_op_t *
+_mongoc_matcher_op_elem_match_new (const char *path,           /* IN */
+                                   mongoc_matcher_op_t *child, /* IN */
+                                   bool is_query)              /* IN */
 {
-   bson_iter_t iter;
-   bson_iter_t desc;
-   bool found;
+   mongoc_matcher_op_t *op;
 
-   BSON_ASSERT (exists);
-   BSON_ASSERT (bson);
+   BSON_ASSERT (path);
+   BSON_ASSERT (child);
 
-   found = (bson_iter_init (&iter, bson) &&
-            bson_iter_find_descendant (&iter, exists->path, &desc));
+   op = (mongoc_matcher_op_t *) bson_malloc0 (sizeof *op);
+   op->elem_match.base.opcode = MONGOC_MATCHER_OPCODE_ELEM_MATCH;
+   op->elem_match.path = bson_strdup (path);
+   op->elem_match.child = child;
+   op->elem_match.is_query = is_query;
 
-   return (found == exists->exists);
+   return op;
 }
 
 
 /*
  *--------------------------------------------------------------------------
  *
- * _mongoc_matcher_op_type_match --
+ * _mongoc_matcher_op_destroy --
  *
- *       Checks if @bson matches the {$type: ...} op.
+ *       Free a mongoc_matcher_op_t structure and all children structures.
  *
  * Returns:
- *       true if the requested field was found and the type matched
- *       the requested type.
+ *       None.
  *
  * Side effects:
  *       None.
  *
  *--------------------------------------------------------------------------
  */
-
-static bool
-_mongoc_matcher_op_type_match (mongoc_matcher_op_type_t *type, /* IN */
-                               const bson_t *bson)             /* IN */
+void
+_mongoc_matcher_op_destroy (mongoc_matcher_op_t *op) /* IN */
 {
-   bson_iter_t iter;
-   bson_iter_t desc;
-
-   BSON_ASSERT (type);
-   BSON_ASSERT (bson);
+   BSON_ASSERT (op);
 
-   if (bson_iter_init (&iter, bson) &&
-       bson_iter_find_descendant (&iter, type->path, &desc)) {
-      return (bson_iter_type (&iter) == type->type);
+   switch (op->base.opcode) {
+   case MONGOC_MATCHER_OPCODE_EQ:
+   case MONGOC_MATCHER_OPCODE_GT:
+   case MONGOC_MATCHER_OPCODE_GTE:
+   case MONGOC_MATCHER_OPCODE_IN:
+   case MONGOC_MATCHER_OPCODE_LT:
+   case MONGOC_MATCHER_OPCODE_LTE:
+   case MONGOC_MATCHER_OPCODE_NE:
+   case MONGOC_MATCHER_OPCODE_NIN:
+      _mongoc_matcher_set_destroy (op->compare.set);
+      bson_free (op->compare.path);
+      break;
+   case MONGOC_MATCHER_OPCODE_OR:
+   case MONGOC_MATCHER_OPCODE_AND:
+   case MONGOC_MATCHER_OPCODE_NOR:
+      if (op->logical.left)
+         _mongoc_matcher_op_destroy (op->logical.left);
+      if (op->logical.right)
+         _mongoc_matcher_op_destroy (op->logical.right);
+      break;
+   case MONGOC_MATCHER_OPCODE_NOT:
+      _mongoc_matcher_op_destroy (op->not_.child);
+      bson_free (op->not_.path);
+      break;
+   case MONGOC_MATCHER_OPCODE_EXISTS:
+      bson_free (op->exists.path);
+      break;
+   case MONGOC_MATCHER_OPCODE_TYPE:
+      bson_free (op->type.path);
+      break;
+   case MONGOC_MATCHER_OPCODE_REGEX:
+#ifdef BSON_OS_UNIX
+      regfree (&op->regex.regex);
+#endif
+      bson_free (op->regex.path);
+      bson_free (op->regex.pattern);
+      bson_free (op->regex.options);
+      break;
+   case MONGOC_MATCHER_OPCODE_ELEM_MATCH:
+      _mongoc_matcher_op_destroy (op->elem_match.child);
+      bson_free (op->elem_match.path);
+      break;
+   default:
+      break;
    }
 
-   return false;
+   bson_free (op);
 }
 
 
@@ -496,6 +774,10 @@ _mongoc_matcher_iter_eq_match (bson_iter_t *compare_iter, /* IN */
       }
    }
 
+   case _TYPE_CODE (BSON_TYPE_OID, BSON_TYPE_OID):
+      return bson_oid_equal (bson_iter_oid (compare_iter),
+                             bson_iter_oid (iter));
+
    case _TYPE_CODE (BSON_TYPE_DOCUMENT, BSON_TYPE_DOCUMENT): {
       uint32_t llen;
       uint32_t rlen;
@@ -538,9 +820,276 @@ _mongoc_matcher_op_eq_match (mongoc_matcher_op_compare_t *compare, /* IN */
    BSON_ASSERT (compare);
    BSON_ASSERT (iter);
 
-   return _mongoc_matcher_iter_eq_match (&compare->iter, iter);
+   return _mongoc_matcher_iter_eq_match (&compare->iter, iter);
+}
+
+
+#define _FNV_OFFSET_BASIS 2166136261u
+#define _FNV_PRIME 16777619u
+
+
+typedef struct {
+   uint32_t hash;
+   bool used;
+   bson_iter_t iter;
+} mongoc_matcher_set_entry_t;
+
+
+/* the values of an {$in: [...]} or {$nin: [...]} array. numbers, strings and
+ * ObjectIds are in an open addressing table, the rare arrays and documents
+ * are compared one by one */
+struct _mongoc_matcher_set_t {
+   mongoc_matcher_set_entry_t *entries;
+   uint32_t mask; /* the number of entries minus one */
+   bool has_null;
+   uint32_t n_others;
+   bson_iter_t *others;
+};
+
+
+static uint32_t
+_mongoc_matcher_fnv1a (uint32_t hash, const void *data, size_t len)
+{
+   const uint8_t *p = (const uint8_t *) data;
+   size_t i;
+
+   for (i = 0; i < len; i++) {
+      hash ^= p[i];
+      hash *= _FNV_PRIME;
+   }
+
+   return hash;
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_matcher_set_hash --
+ *
+ *       Hash the value of @iter so that values which
+ *       _mongoc_matcher_iter_eq_match() considers equal hash the same.
+ *       Numbers of any type hash as the double they compare as, so 1,
+ *       1.0, 1L and true are one key.
+ *
+ * Returns:
+ *       true if @hash was set, false if the value is not hashed.
+ *
+ * Side effects:
+ *       None.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+static bool
+_mongoc_matcher_set_hash (const bson_iter_t *iter, /* IN */
+                          uint32_t *hash)          /* OUT */
+{
+   const char *str;
+   uint32_t len;
+   double d;
+   char tag;
+
+   switch (bson_iter_type (iter)) {
+   case BSON_TYPE_DOUBLE:
+      d = bson_iter_double (iter);
+      break;
+   case BSON_TYPE_BOOL:
+      d = bson_iter_bool (iter) ? 1.0 : 0.0;
+      break;
+   case BSON_TYPE_INT32:
+      d = (double) bson_iter_int32 (iter);
+      break;
+   case BSON_TYPE_INT64:
+      d = (double) bson_iter_int64 (iter);
+      break;
+   case BSON_TYPE_UTF8:
+      tag = 's';
+      str = bson_iter_utf8 (iter, &len);
+      *hash = _mongoc_matcher_fnv1a (
+         _mongoc_matcher_fnv1a (_FNV_OFFSET_BASIS, &tag, 1), str, len);
+      return true;
+   case BSON_TYPE_OID:
+      tag = 'o';
+      *hash = _mongoc_matcher_fnv1a (
+         _mongoc_matcher_fnv1a (_FNV_OFFSET_BASIS, &tag, 1),
+         bson_iter_oid (iter)->bytes,
+         sizeof (bson_oid_t));
+      return true;
+   default:
+      return false;
+   }
+
+   if (d != d) {
+      /* NaN equals nothing */
+      return false;
+   }
+
+   if (d == 0.0) {
+      /* -0.0 == 0.0 */
+      d = 0.0;
+   }
+
+   tag = 'n';
+   *hash = _mongoc_matcher_fnv1a (
+      _mongoc_matcher_fnv1a (_FNV_OFFSET_BASIS, &tag, 1), &d, sizeof d);
+
+   return true;
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_matcher_set_new --
+ *
+ *       Build a set from the values in @array, an iter on the array of
+ *       an $in or $nin spec. The set borrows the values from the query.
+ *
+ * Returns:
+ *       A newly allocated mongoc_matcher_set_t that should be freed with
+ *       _mongoc_matcher_set_destroy().
+ *
+ * Side effects:
+ *       None.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+static mongoc_matcher_set_t *
+_mongoc_matcher_set_new (const bson_iter_t *array) /* IN */
+{
+   mongoc_matcher_set_t *set;
+   bson_iter_t iter;
+   uint32_t n = 0;
+   uint32_t size = 8;
+   uint32_t hash;
+   uint32_t i;
+
+   set = (mongoc_matcher_set_t *) bson_malloc0 (sizeof *set);
+
+   if (bson_iter_recurse (array, &iter)) {
+      while (bson_iter_next (&iter)) {
+         n++;
+      }
+   }
+
+   while (size < n * 2) {
+      size <<= 1;
+   }
+
+   set->entries = (mongoc_matcher_set_entry_t *) bson_malloc0 (
+      size * sizeof (mongoc_matcher_set_entry_t));
+   set->mask = size - 1;
+
+   if (!bson_iter_recurse (array, &iter)) {
+      return set;
+   }
+
+   while (bson_iter_next (&iter)) {
+      switch (bson_iter_type (&iter)) {
+      case BSON_TYPE_DOUBLE:
+      case BSON_TYPE_INT32:
+      case BSON_TYPE_INT64:
+      case BSON_TYPE_UTF8:
+      case BSON_TYPE_OID:
+         if (_mongoc_matcher_set_hash (&iter, &hash)) {
+            i = hash & set->mask;
+            while (set->entries[i].used) {
+               i = (i + 1) & set->mask;
+            }
+
+            set->entries[i].hash = hash;
+            set->entries[i].used = true;
+            memcpy (&set->entries[i].iter, &iter, sizeof iter);
+         }
+         break;
+      case BSON_TYPE_NULL:
+         set->has_null = true;
+         break;
+      case BSON_TYPE_ARRAY:
+      case BSON_TYPE_DOCUMENT:
+         set->others = (bson_iter_t *) bson_realloc (
+            set->others, (set->n_others + 1) * sizeof (bson_iter_t));
+         memcpy (&set->others[set->n_others++], &iter, sizeof iter);
+         break;
+      default:
+         /* booleans and other types on the left equal nothing */
+         break;
+      }
+   }
+
+   return set;
+}
+
+
+static void
+_mongoc_matcher_set_destroy (mongoc_matcher_set_t *set) /* IN */
+{
+   if (set) {
+      bson_free (set->entries);
+      bson_free (set->others);
+      bson_free (set);
+   }
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_matcher_set_contains --
+ *
+ *       Checks if the value of @iter equals a value in @set.
+ *
+ * Returns:
+ *       true if it does, otherwise false.
+ *
+ * Side effects:
+ *       None.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+static bool
+_mongoc_matcher_set_contains (mongoc_matcher_set_t *set, /* IN */
+                              bson_iter_t *iter)         /* IN */
+{
+   mongoc_matcher_set_entry_t *entry;
+   uint32_t hash;
+   uint32_t i;
+
+   switch (bson_iter_type (iter)) {
+   case BSON_TYPE_NULL:
+   case BSON_TYPE_UNDEFINED:
+      return set->has_null;
+   case BSON_TYPE_ARRAY:
+   case BSON_TYPE_DOCUMENT:
+      for (i = 0; i < set->n_others; i++) {
+         if (_mongoc_matcher_iter_eq_match (&set->others[i], iter)) {
+            return true;
+         }
+      }
+      return false;
+   default:
+      break;
+   }
+
+   if (!_mongoc_matcher_set_hash (iter, &hash)) {
+      return false;
+   }
+
+   for (i = hash & set->mask; set->entries[i].used; i = (i + 1) & set->mask) {
+      entry = &set->entries[i];
+      if (entry->hash == hash &&
+          _mongoc_matcher_iter_eq_match (&entry->iter, iter)) {
+         return true;
+      }
+   }
+
+   return false;
 }
 
+
 /*
  *--------------------------------------------------------------------------
  *
@@ -707,6 +1256,10 @@ _mongoc_matcher_op_in_match (mongoc_matcher_op_compare_t *compare, /* IN */
 {
    mongoc_matcher_op_compare_t op;
 
+   if (compare->set) {
+      return _mongoc_matcher_set_contains (compare->set, iter);
+   }
+
    op.base.opcode = MONGOC_MATCHER_OPCODE_EQ;
    op.path = compare->path;
 
@@ -919,10 +1472,10 @@ _mongoc_matcher_op_nin_match (mongoc_matcher_op_compare_t *compare, /* IN */
 /*
  *--------------------------------------------------------------------------
  *
- * _mongoc_matcher_op_compare_match --
+ * _mongoc_matcher_op_compare_match_iter --
  *
  *       Dispatch function for mongoc_matcher_op_compare_t operations
- *       to perform a match.
+ *       to perform a match against the value of @iter.
  *
  * Returns:
  *       Opcode dependent.
@@ -934,50 +1487,423 @@ _mongoc_matcher_op_nin_match (mongoc_matcher_op_compare_t *compare, /* IN */
  */
 
 static bool
-_mongoc_matcher_op_compare_match (mongoc_matcher_op_compare_t *compare, /* IN */
-                                  const bson_t *bson)                   /* IN */
+_mongoc_matcher_op_compare_match_iter (
+   mongoc_matcher_op_compare_t *compare, /* IN */
+   bson_iter_t *iter)                    /* IN */
 {
-   bson_iter_t tmp;
-   bson_iter_t iter;
-
    BSON_ASSERT (compare);
-   BSON_ASSERT (bson);
+   BSON_ASSERT (iter);
 
-   if (strchr (compare->path, '.')) {
-      if (!bson_iter_init (&tmp, bson) ||
-          !bson_iter_find_descendant (&tmp, compare->path, &iter)) {
-         return false;
-      }
-   } else if (!bson_iter_init_find (&iter, bson, compare->path)) {
+   switch ((int) compare->base.opcode) {
+   case MONGOC_MATCHER_OPCODE_EQ:
+      return _mongoc_matcher_op_eq_match (compare, iter);
+   case MONGOC_MATCHER_OPCODE_GT:
+      return _mongoc_matcher_op_gt_match (compare, iter);
+   case MONGOC_MATCHER_OPCODE_GTE:
+      return _mongoc_matcher_op_gte_match (compare, iter);
+   case MONGOC_MATCHER_OPCODE_IN:
+      return _mongoc_matcher_op_in_match (compare, iter);
+   case MONGOC_MATCHER_OPCODE_LT:
+      return _mongoc_matcher_op_lt_match (compare, iter);
+   case MONGOC_MATCHER_OPCODE_LTE:
+      return _mongoc_matcher_op_lte_match (compare, iter);
+   case MONGOC_MATCHER_OPCODE_NE:
+      return _mongoc_matcher_op_ne_match (compare, iter);
+   case MONGOC_MATCHER_OPCODE_NIN:
+      return _mongoc_matcher_op_nin_match (compare, iter);
+   default:
+      BSON_ASSERT (false);
+      break;
+   }
+
+   return false;
+}
+
+
+static bool
+_mongoc_matcher_op_regex_match_iter (mongoc_matcher_op_regex_t *regex, /* IN */
+                                     bson_iter_t *iter)                /* IN */
+{
+#ifdef BSON_OS_UNIX
+   const char *str;
+
+   if (BSON_ITER_HOLDS_UTF8 (iter)) {
+      str = bson_iter_utf8 (iter, NULL);
+   } else if (BSON_ITER_HOLDS_SYMBOL (iter)) {
+      str = bson_iter_symbol (iter, NULL);
+   } else {
       return false;
    }
 
-   switch ((int) compare->base.opcode) {
+   return regexec (&regex->regex, str, 0, NULL, 0) == 0;
+#else
+   return false;
+#endif
+}
+
+
+static bool
+_mongoc_matcher_op_elem_match_iter (
+   mongoc_matcher_op_elem_match_t *elem_match, /* IN */
+   bson_iter_t *iter)                          /* IN */
+{
+   const uint8_t *data;
+   bson_iter_t elem;
+   uint32_t len;
+   bson_t doc;
+
+   if (!BSON_ITER_HOLDS_ARRAY (iter) || !bson_iter_recurse (iter, &elem)) {
+      return false;
+   }
+
+   while (bson_iter_next (&elem)) {
+      if (!elem_match->is_query) {
+         if (_mongoc_matcher_op_match_value (elem_match->child, &elem)) {
+            return true;
+         }
+      } else if (BSON_ITER_HOLDS_DOCUMENT (&elem)) {
+         bson_iter_document (&elem, &len, &data);
+         if (bson_init_static (&doc, data, len) &&
+             _mongoc_matcher_op_match (elem_match->child, &doc)) {
+            return true;
+         }
+      }
+   }
+
+   return false;
+}
+
+
+static bool
+_mongoc_matcher_op_leaf_match_iter (mongoc_matcher_op_t *op, /* IN */
+                                    bson_iter_t *iter)       /* IN */
+{
+   switch (op->base.opcode) {
    case MONGOC_MATCHER_OPCODE_EQ:
-      return _mongoc_matcher_op_eq_match (compare, &iter);
    case MONGOC_MATCHER_OPCODE_GT:
-      return _mongoc_matcher_op_gt_match (compare, &iter);
    case MONGOC_MATCHER_OPCODE_GTE:
-      return _mongoc_matcher_op_gte_match (compare, &iter);
    case MONGOC_MATCHER_OPCODE_IN:
-      return _mongoc_matcher_op_in_match (compare, &iter);
    case MONGOC_MATCHER_OPCODE_LT:
-      return _mongoc_matcher_op_lt_match (compare, &iter);
    case MONGOC_MATCHER_OPCODE_LTE:
-      return _mongoc_matcher_op_lte_match (compare, &iter);
    case MONGOC_MATCHER_OPCODE_NE:
-      return _mongoc_matcher_op_ne_match (compare, &iter);
    case MONGOC_MATCHER_OPCODE_NIN:
-      return _mongoc_matcher_op_nin_match (compare, &iter);
+      return _mongoc_matcher_op_compare_match_iter (&op->compare, iter);
+   case MONGOC_MATCHER_OPCODE_TYPE:
+      return bson_iter_type (iter) == op->type.type;
+   case MONGOC_MATCHER_OPCODE_REGEX:
+      return _mongoc_matcher_op_regex_match_iter (&op->regex, iter);
+   case MONGOC_MATCHER_OPCODE_OR:
+   case MONGOC_MATCHER_OPCODE_AND:
+   case MONGOC_MATCHER_OPCODE_NOT:
+   case MONGOC_MATCHER_OPCODE_NOR:
+   case MONGOC_MATCHER_OPCODE_EXISTS:
+   case MONGOC_MATCHER_OPCODE_ELEM_MATCH:
    default:
       BSON_ASSERT (false);
+      return false;
+   }
+}
+
+
+static bool
+_mongoc_matcher_op_is_negated (const mongoc_matcher_op_t *op) /* IN */
+{
+   return op->base.opcode == MONGOC_MATCHER_OPCODE_NE ||
+          op->base.opcode == MONGOC_MATCHER_OPCODE_NIN;
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_matcher_op_missing_match --
+ *
+ *       Checks if a document without a value at @op's path matches @op.
+ *       As on the server, a missing field is equal to null and to nothing
+ *       else, so {$ne: 1} and {$nin: [1]} match it, {$ne: null} does not.
+ *
+ * Returns:
+ *       true if the missing value matches, otherwise false.
+ *
+ * Side effects:
+ *       None.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+bool
+_mongoc_matcher_op_missing_match (const mongoc_matcher_op_t *op) /* IN */
+{
+   bson_iter_t elem;
+   bool has_null = false;
+
+   BSON_ASSERT (op);
+
+   switch (op->base.opcode) {
+   case MONGOC_MATCHER_OPCODE_EXISTS:
+      return !op->exists.exists;
+   case MONGOC_MATCHER_OPCODE_EQ:
+   case MONGOC_MATCHER_OPCODE_NE:
+      has_null = BSON_ITER_HOLDS_NULL (&op->compare.iter);
+      break;
+   case MONGOC_MATCHER_OPCODE_IN:
+   case MONGOC_MATCHER_OPCODE_NIN:
+      if (BSON_ITER_HOLDS_ARRAY (&op->compare.iter) &&
+          bson_iter_recurse (&op->compare.iter, &elem)) {
+         while (!has_null && bson_iter_next (&elem)) {
+            has_null = BSON_ITER_HOLDS_NULL (&elem);
+         }
+      }
+      break;
+   case MONGOC_MATCHER_OPCODE_GT:
+   case MONGOC_MATCHER_OPCODE_GTE:
+   case MONGOC_MATCHER_OPCODE_LT:
+   case MONGOC_MATCHER_OPCODE_LTE:
+   case MONGOC_MATCHER_OPCODE_OR:
+   case MONGOC_MATCHER_OPCODE_AND:
+   case MONGOC_MATCHER_OPCODE_NOT:
+   case MONGOC_MATCHER_OPCODE_NOR:
+   case MONGOC_MATCHER_OPCODE_TYPE:
+   case MONGOC_MATCHER_OPCODE_REGEX:
+   case MONGOC_MATCHER_OPCODE_ELEM_MATCH:
+   default:
+      return false;
+   }
+
+   return has_null != _mongoc_matcher_op_is_negated (op);
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_matcher_op_match_value --
+ *
+ *       Checks if the value of @iter, found at @op's path, matches @op.
+ *
+ *       As on the server, an array matches if the array itself or any
+ *       of its values matches. For $ne and $nin, neither the array nor
+ *       any of its values may be equal.
+ *
+ * Returns:
+ *       true if the value matches, otherwise false.
+ *
+ * Side effects:
+ *       None.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+bool
+_mongoc_matcher_op_match_value (mongoc_matcher_op_t *op, /* IN */
+                                bson_iter_t *iter)       /* IN */
+{
+   bson_iter_t elem;
+   bool negated;
+   bool r;
+
+   BSON_ASSERT (op);
+   BSON_ASSERT (iter);
+
+   switch (op->base.opcode) {
+   case MONGOC_MATCHER_OPCODE_OR:
+      return (_mongoc_matcher_op_match_value (op->logical.left, iter) ||
+              _mongoc_matcher_op_match_value (op->logical.right, iter));
+   case MONGOC_MATCHER_OPCODE_AND:
+      return (_mongoc_matcher_op_match_value (op->logical.left, iter) &&
+              _mongoc_matcher_op_match_value (op->logical.right, iter));
+   case MONGOC_MATCHER_OPCODE_NOR:
+      return !(_mongoc_matcher_op_match_value (op->logical.left, iter) ||
+               _mongoc_matcher_op_match_value (op->logical.right, iter));
+   case MONGOC_MATCHER_OPCODE_NOT:
+      return !_mongoc_matcher_op_match_value (op->not_.child, iter);
+   case MONGOC_MATCHER_OPCODE_EXISTS:
+      return op->exists.exists;
+   case MONGOC_MATCHER_OPCODE_ELEM_MATCH:
+      return _mongoc_matcher_op_elem_match_iter (&op->elem_match, iter);
+   case MONGOC_MATCHER_OPCODE_EQ:
+   case MONGOC_MATCHER_OPCODE_GT:
+   case MONGOC_MATCHER_OPCODE_GTE:
+   case MONGOC_MATCHER_OPCODE_IN:
+   case MONGOC_MATCHER_OPCODE_LT:
+   case MONGOC_MATCHER_OPCODE_LTE:
+   case MONGOC_MATCHER_OPCODE_NE:
+   case MONGOC_MATCHER_OPCODE_NIN:
+   case MONGOC_MATCHER_OPCODE_TYPE:
+   case MONGOC_MATCHER_OPCODE_REGEX:
+   default:
       break;
    }
 
+   /* stop at the first match, or for $ne and $nin at the first mismatch */
+   negated = _mongoc_matcher_op_is_negated (op);
+   r = _mongoc_matcher_op_leaf_match_iter (op, iter);
+   if (r != negated) {
+      return r;
+   }
+
+   if (BSON_ITER_HOLDS_ARRAY (iter) && bson_iter_recurse (iter, &elem)) {
+      while (bson_iter_next (&elem)) {
+         r = _mongoc_matcher_op_leaf_match_iter (op, &elem);
+         if (r != negated) {
+            return r;
+         }
+      }
+   }
+
+   return negated;
+}
+
+
+typedef bool (*mongoc_matcher_visit_t) (bson_iter_t *value, void *ctx);
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_matcher_visit_path --
+ *
+ *       Calls @visit with each value at the dotted @path in the document
+ *       that @iter is on.
+ *
+ *       As on the server, the rest of a path applies to each document
+ *       in an array, and a numeric component also indexes the array.
+ *       Only the first field with a given key is considered, like
+ *       bson_iter_find_descendant().
+ *
+ * Returns:
+ *       true if @visit returned true, which stops the walk.
+ *
+ * Side effects:
+ *       None.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+static bool
+_mongoc_matcher_visit_path (bson_iter_t *iter,            /* IN */
+                            const char *path,             /* IN */
+                            mongoc_matcher_visit_t visit, /* IN */
+                            void *ctx)                    /* IN */
+{
+   const char *dot;
+   const char *key;
+   bson_iter_t child;
+   bson_iter_t elem;
+   size_t len;
+
+   dot = strchr (path, '.');
+   len = dot ? (size_t) (dot - path) : strlen (path);
+
+   for (;;) {
+      if (!bson_iter_next (iter)) {
+         return false;
+      }
+
+      key = bson_iter_key (iter);
+      if (strncmp (key, path, len) == 0 && key[len] == '\0') {
+         break;
+      }
+   }
+
+   if (!dot) {
+      return visit (iter, ctx);
+   }
+
+   if (BSON_ITER_HOLDS_DOCUMENT (iter)) {
+      return bson_iter_recurse (iter, &child) &&
+             _mongoc_matcher_visit_path (&child, dot + 1, visit, ctx);
+   }
+
+   if (!BSON_ITER_HOLDS_ARRAY (iter)) {
+      return false;
+   }
+
+   if (bson_iter_recurse (iter, &child) &&
+       _mongoc_matcher_visit_path (&child, dot + 1, visit, ctx)) {
+      return true;
+   }
+
+   if (bson_iter_recurse (iter, &child)) {
+      while (bson_iter_next (&child)) {
+         if (BSON_ITER_HOLDS_DOCUMENT (&child) &&
+             bson_iter_recurse (&child, &elem) &&
+             _mongoc_matcher_visit_path (&elem, dot + 1, visit, ctx)) {
+            return true;
+         }
+      }
+   }
+
    return false;
 }
 
 
+typedef struct {
+   mongoc_matcher_op_t *op;
+   bool found;
+   bool result;
+} mongoc_matcher_visit_ctx_t;
+
+
+static bool
+_mongoc_matcher_visit_value (bson_iter_t *value, /* IN */
+                             void *data)         /* IN */
+{
+   mongoc_matcher_visit_ctx_t *ctx = (mongoc_matcher_visit_ctx_t *) data;
+
+   ctx->found = true;
+   ctx->result = _mongoc_matcher_op_match_value (ctx->op, value);
+
+   return ctx->result != _mongoc_matcher_op_is_negated (ctx->op);
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_matcher_op_path_match --
+ *
+ *       Match @op against the values at @path in @bson.
+ *
+ * Returns:
+ *       true if any value matches. For $ne and $nin, true if all values
+ *       match. If there are none, see _mongoc_matcher_op_missing_match.
+ *
+ * Side effects:
+ *       None.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+static bool
+_mongoc_matcher_op_path_match (mongoc_matcher_op_t *op, /* IN */
+                               const char *path,        /* IN */
+                               const bson_t *bson)      /* IN */
+{
+   mongoc_matcher_visit_ctx_t ctx;
+   bson_iter_t iter;
+
+   BSON_ASSERT (op);
+   BSON_ASSERT (path);
+   BSON_ASSERT (bson);
+
+   ctx.op = op;
+   ctx.found = false;
+   ctx.result = false;
+
+   if (bson_iter_init (&iter, bson)) {
+      _mongoc_matcher_visit_path (
+         &iter, path, _mongoc_matcher_visit_value, &ctx);
+   }
+
+   if (!ctx.found) {
+      return _mongoc_matcher_op_missing_match (op);
+   }
+
+   return ctx.result;
+}
+
+
 /*
  *--------------------------------------------------------------------------
  *
@@ -1053,7 +1979,7 @@ _mongoc_matcher_op_match (mongoc_matcher_op_t *op, /* IN */
    case MONGOC_MATCHER_OPCODE_LTE:
    case MONGOC_MATCHER_OPCODE_NE:
    case MONGOC_MATCHER_OPCODE_NIN:
-      return _mongoc_matcher_op_compare_match (&op->compare, bson);
+      return _mongoc_matcher_op_path_match (op, op->compare.path, bson);
    case MONGOC_MATCHER_OPCODE_OR:
    case MONGOC_MATCHER_OPCODE_AND:
    case MONGOC_MATCHER_OPCODE_NOR:
@@ -1061,9 +1987,13 @@ _mongoc_matcher_op_match (mongoc_matcher_op_t *op, /* IN */
    case MONGOC_MATCHER_OPCODE_NOT:
       return _mongoc_matcher_op_not_match (&op->not_, bson);
    case MONGOC_MATCHER_OPCODE_EXISTS:
-      return _mongoc_matcher_op_exists_match (&op->exists, bson);
+      return _mongoc_matcher_op_path_match (op, op->exists.path, bson);
    case MONGOC_MATCHER_OPCODE_TYPE:
-      return _mongoc_matcher_op_type_match (&op->type, bson);
+      return _mongoc_matcher_op_path_match (op, op->type.path, bson);
+   case MONGOC_MATCHER_OPCODE_REGEX:
+      return _mongoc_matcher_op_path_match (op, op->regex.path, bson);
+   case MONGOC_MATCHER_OPCODE_ELEM_MATCH:
+      return _mongoc_matcher_op_path_match (op, op->elem_match.path, bson);
    default:
       break;
    }
@@ -1182,6 +2112,20 @@ _mongoc_matcher_op_to_bson (mongoc_matcher_op_t *op, /* IN */
    case MONGOC_MATCHER_OPCODE_TYPE:
       BSON_APPEND_INT32 (bson, "$type", (int) op->type.type);
       break;
+   case MONGOC_MATCHER_OPCODE_REGEX:
+      if (bson_append_document_begin (bson, op->regex.path, -1, &child)) {
+         BSON_APPEND_UTF8 (&child, "$regex", op->regex.pattern);
+         BSON_APPEND_UTF8 (&child, "$options", op->regex.options);
+         bson_append_document_end (bson, &child);
+      }
+      break;
+   case MONGOC_MATCHER_OPCODE_ELEM_MATCH:
+      bson_append_document_begin (bson, op->elem_match.path, -1, &child);
+      bson_append_document_begin (&child, "$elemMatch", 10, &child2);
+      _mongoc_matcher_op_to_bson (op->elem_match.child, &child2);
+      bson_append_document_end (&child, &child2);
+      bson_append_document_end (bson, &child);
+      break;
    default:
       BSON_ASSERT (false);
       break;
@@ -0,0 +1,89 @@
+/*
+ * Copyright 2017 MongoDB, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MONGOC_MATCHER_PROGRAM_PRIVATE_H
+#define MONGOC_MATCHER_PROGRAM_PRIVATE_H
+
+#if !defined(MONGOC_COMPILATION)
+#error "Only <mongoc.h> can be included directly."
+#endif
+
+#include <bson.h>
+
+#include "mongoc-array-private.h"
+#include "mongoc-matcher-op-private.h"
+
+
+BSON_BEGIN_DECLS
+
+
+typedef enum {
+   MONGOC_MATCHER_INSN_MATCH,
+   MONGOC_MATCHER_INSN_EXISTS,
+   MONGOC_MATCHER_INSN_NOT,
+   MONGOC_MATCHER_INSN_JUMP_IF_FALSE,
+   MONGOC_MATCHER_INSN_JUMP_IF_TRUE,
+} mongoc_matcher_insn_code_t;
+
+
+/* one instruction. predicates set the result register from the value in
+ * "slot", NOT inverts it, jumps go to "target" to short-circuit */
+typedef struct _mongoc_matcher_insn_t {
+   mongoc_matcher_insn_code_t code;
+   int32_t slot;
+   uint32_t target;
+   mongoc_matcher_op_t *op; /* borrowed from the optree */
+} mongoc_matcher_insn_t;
+
+
+/* one component of a dotted path. children are a linked list of node
+ * indexes, slot is -1 if no path ends here */
+typedef struct _mongoc_matcher_node_t {
+   const char *key; /* not NUL-terminated, borrowed from the optree */
+   uint32_t key_len;
+   int32_t slot;
+   int32_t first_child;
+   int32_t next_sibling;
+   uint32_t n_children;
+} mongoc_matcher_node_t;
+
+
+/* a flat form of the optree: every path the query references is found in
+ * one pass over the document, then the instructions run over the values.
+ * documents where a path crosses an array are matched with the optree */
+typedef struct _mongoc_matcher_program_t {
+   mongoc_array_t nodes; /* of mongoc_matcher_node_t, the root is 0 */
+   mongoc_array_t insns; /* of mongoc_matcher_insn_t */
+   uint32_t n_slots;
+   mongoc_matcher_op_t *optree; /* borrowed */
+} mongoc_matcher_program_t;
+
+
+mongoc_matcher_program_t *
+_mongoc_matcher_program_new (mongoc_matcher_op_t *optree);
+
+bool
+_mongoc_matcher_program_run (const mongoc_matcher_program_t *program,
+                             const bson_t *bson);
+
+void
+_mongoc_matcher_program_destroy (mongoc_matcher_program_t *program);
+
+
+BSON_END_DECLS
+
+
+#endif /* MONGOC_MATCHER_PROGRAM_PRIVATE_H */
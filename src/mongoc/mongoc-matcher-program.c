@@ -0,0 +1,650 @@
+/*
+ * Copyright 2017 MongoDB, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "mongoc-matcher-program-private.h"
+
+
+/* scratch space for this many slots and nodes lives on the stack */
+#define MONGOC_MATCHER_PROGRAM_STACK_SLOTS 16
+#define MONGOC_MATCHER_PROGRAM_STACK_NODES 32
+
+
+typedef struct {
+   mongoc_matcher_op_t *op;
+   int32_t slot; /* INT32_MAX for logical operands, so they run last */
+   uint32_t order;
+} mongoc_matcher_operand_t;
+
+
+static bool
+_mongoc_matcher_op_is_logical (const mongoc_matcher_op_t *op)
+{
+   return op->base.opcode == MONGOC_MATCHER_OPCODE_OR ||
+          op->base.opcode == MONGOC_MATCHER_OPCODE_AND ||
+          op->base.opcode == MONGOC_MATCHER_OPCODE_NOR;
+}
+
+
+static const char *
+_mongoc_matcher_op_path (const mongoc_matcher_op_t *op)
+{
+   switch (op->base.opcode) {
+   case MONGOC_MATCHER_OPCODE_EQ:
+   case MONGOC_MATCHER_OPCODE_GT:
+   case MONGOC_MATCHER_OPCODE_GTE:
+   case MONGOC_MATCHER_OPCODE_IN:
+   case MONGOC_MATCHER_OPCODE_LT:
+   case MONGOC_MATCHER_OPCODE_LTE:
+   case MONGOC_MATCHER_OPCODE_NE:
+   case MONGOC_MATCHER_OPCODE_NIN:
+      return op->compare.path;
+   case MONGOC_MATCHER_OPCODE_EXISTS:
+      return op->exists.path;
+   case MONGOC_MATCHER_OPCODE_TYPE:
+      return op->type.path;
+   case MONGOC_MATCHER_OPCODE_REGEX:
+      return op->regex.path;
+   case MONGOC_MATCHER_OPCODE_ELEM_MATCH:
+      return op->elem_match.path;
+   case MONGOC_MATCHER_OPCODE_NOT:
+   case MONGOC_MATCHER_OPCODE_OR:
+   case MONGOC_MATCHER_OPCODE_AND:
+   case MONGOC_MATCHER_OPCODE_NOR:
+   default:
+      return NULL;
+   }
+}
+
+
+static void
+_mongoc_matcher_collect_paths (mongoc_matcher_op_t *op, /* IN */
+                               mongoc_array_t *paths)   /* OUT */
+{
+   const char *path;
+
+   if (_mongoc_matcher_op_is_logical (op)) {
+      _mongoc_matcher_collect_paths (op->logical.left, paths);
+      _mongoc_matcher_collect_paths (op->logical.right, paths);
+   } else if (op->base.opcode == MONGOC_MATCHER_OPCODE_NOT) {
+      _mongoc_matcher_collect_paths (op->not_.child, paths);
+   } else if ((path = _mongoc_matcher_op_path (op))) {
+      _mongoc_array_append_val (paths, path);
+   }
+}
+
+
+static int
+_mongoc_matcher_path_cmp (const void *a, const void *b)
+{
+   return strcmp (*(const char *const *) a, *(const char *const *) b);
+}
+
+
+static int
+_mongoc_matcher_operand_cmp (const void *a, const void *b)
+{
+   const mongoc_matcher_operand_t *l = (const mongoc_matcher_operand_t *) a;
+   const mongoc_matcher_operand_t *r = (const mongoc_matcher_operand_t *) b;
+
+   if (l->slot != r->slot) {
+      return l->slot < r->slot ? -1 : 1;
+   }
+
+   return l->order < r->order ? -1 : (l->order > r->order ? 1 : 0);
+}
+
+
+static int32_t
+_mongoc_matcher_program_slot (const mongoc_array_t *paths, /* IN */
+                              const char *path)            /* IN */
+{
+   const char **found;
+
+   found = (const char **) bsearch (&path,
+                                    paths->data,
+                                    paths->len,
+                                    sizeof (const char *),
+                                    _mongoc_matcher_path_cmp);
+   BSON_ASSERT (found);
+
+   return (int32_t) (found - (const char **) paths->data);
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_matcher_program_add_path --
+ *
+ *       Add the components of the dotted @path to the path trie, and
+ *       mark the last one with @slot.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+static void
+_mongoc_matcher_program_add_path (mongoc_matcher_program_t *program, /* IN */
+                                  const char *path,                  /* IN */
+                                  int32_t slot)                      /* IN */
+{
+   mongoc_matcher_node_t *node;
+   mongoc_matcher_node_t child;
+   const char *key = path;
+   const char *dot;
+   uint32_t key_len;
+   int32_t parent = 0;
+   int32_t last;
+   int32_t i;
+
+   for (;;) {
+      dot = strchr (key, '.');
+      key_len = dot ? (uint32_t) (dot - key) : (uint32_t) strlen (key);
+
+      last = -1;
+      node = &_mongoc_array_index (
+         &program->nodes, mongoc_matcher_node_t, parent);
+
+      for (i = node->first_child; i != -1;) {
+         node =
+            &_mongoc_array_index (&program->nodes, mongoc_matcher_node_t, i);
+         if (node->key_len == key_len && !memcmp (node->key, key, key_len)) {
+            break;
+         }
+
+         last = i;
+         i = node->next_sibling;
+      }
+
+      if (i == -1) {
+         /* append, so siblings stay in sorted path order */
+         child.key = key;
+         child.key_len = key_len;
+         child.slot = -1;
+         child.first_child = -1;
+         child.next_sibling = -1;
+         child.n_children = 0;
+
+         i = (int32_t) program->nodes.len;
+         _mongoc_array_append_val (&program->nodes, child);
+
+         if (last == -1) {
+            _mongoc_array_index (&program->nodes, mongoc_matcher_node_t, parent)
+               .first_child = i;
+         } else {
+            _mongoc_array_index (&program->nodes, mongoc_matcher_node_t, last)
+               .next_sibling = i;
+         }
+
+         _mongoc_array_index (&program->nodes, mongoc_matcher_node_t, parent)
+            .n_children++;
+      }
+
+      if (!dot) {
+         _mongoc_array_index (&program->nodes, mongoc_matcher_node_t, i).slot =
+            slot;
+         return;
+      }
+
+      parent = i;
+      key = dot + 1;
+   }
+}
+
+
+static uint32_t
+_mongoc_matcher_program_emit (mongoc_matcher_program_t *program, /* IN */
+                              mongoc_matcher_insn_code_t code,   /* IN */
+                              int32_t slot,                      /* IN */
+                              mongoc_matcher_op_t *op)           /* IN */
+{
+   mongoc_matcher_insn_t insn;
+
+   insn.code = code;
+   insn.slot = slot;
+   insn.target = 0;
+   insn.op = op;
+
+   _mongoc_array_append_val (&program->insns, insn);
+
+   return (uint32_t) (program->insns.len - 1);
+}
+
+
+static void
+_mongoc_matcher_program_patch (mongoc_matcher_program_t *program, /* IN */
+                               uint32_t jump)                     /* IN */
+{
+   _mongoc_array_index (&program->insns, mongoc_matcher_insn_t, jump).target =
+      (uint32_t) program->insns.len;
+}
+
+
+static int32_t
+_mongoc_matcher_operand_slot (const mongoc_array_t *paths, /* IN */
+                              mongoc_matcher_op_t *op)     /* IN */
+{
+   const char *path;
+
+   while (op->base.opcode == MONGOC_MATCHER_OPCODE_NOT) {
+      op = op->not_.child;
+   }
+
+   if (!(path = _mongoc_matcher_op_path (op))) {
+      return INT32_MAX;
+   }
+
+   return _mongoc_matcher_program_slot (paths, path);
+}
+
+
+/* gather the operands of a chain of @opcode, the parser nests them to the
+ * right. $nor is not associative so it is never flattened */
+static void
+_mongoc_matcher_flatten (mongoc_matcher_opcode_t opcode, /* IN */
+                         mongoc_matcher_op_t *op,        /* IN */
+                         const mongoc_array_t *paths,    /* IN */
+                         mongoc_array_t *operands)       /* OUT */
+{
+   mongoc_matcher_operand_t operand;
+
+   if (op->base.opcode == opcode) {
+      _mongoc_matcher_flatten (opcode, op->logical.left, paths, operands);
+      _mongoc_matcher_flatten (opcode, op->logical.right, paths, operands);
+      return;
+   }
+
+   operand.op = op;
+   operand.slot = _mongoc_matcher_operand_slot (paths, op);
+   operand.order = (uint32_t) operands->len;
+
+   _mongoc_array_append_val (operands, operand);
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_matcher_program_compile --
+ *
+ *       Append the instructions for @op to @program. The result of @op
+ *       is in the result register once they have run.
+ *
+ *       The operands of $and and $or are sorted by the order of their
+ *       fields, and jump past the rest of the chain as soon as the
+ *       result is known.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+static void
+_mongoc_matcher_program_compile (mongoc_matcher_program_t *program, /* IN */
+                                 const mongoc_array_t *paths,       /* IN */
+                                 mongoc_matcher_op_t *op)           /* IN */
+{
+   mongoc_matcher_insn_code_t jump_code;
+   mongoc_matcher_operand_t *operand;
+   mongoc_array_t operands;
+   mongoc_array_t jumps;
+   uint32_t jump;
+   size_t i;
+
+   switch (op->base.opcode) {
+   case MONGOC_MATCHER_OPCODE_EQ:
+   case MONGOC_MATCHER_OPCODE_GT:
+   case MONGOC_MATCHER_OPCODE_GTE:
+   case MONGOC_MATCHER_OPCODE_IN:
+   case MONGOC_MATCHER_OPCODE_LT:
+   case MONGOC_MATCHER_OPCODE_LTE:
+   case MONGOC_MATCHER_OPCODE_NE:
+   case MONGOC_MATCHER_OPCODE_NIN:
+   case MONGOC_MATCHER_OPCODE_TYPE:
+   case MONGOC_MATCHER_OPCODE_REGEX:
+   case MONGOC_MATCHER_OPCODE_ELEM_MATCH:
+      _mongoc_matcher_program_emit (
+         program,
+         MONGOC_MATCHER_INSN_MATCH,
+         _mongoc_matcher_program_slot (paths, _mongoc_matcher_op_path (op)),
+         op);
+      break;
+   case MONGOC_MATCHER_OPCODE_EXISTS:
+      _mongoc_matcher_program_emit (
+         program,
+         MONGOC_MATCHER_INSN_EXISTS,
+         _mongoc_matcher_program_slot (paths, op->exists.path),
+         op);
+      break;
+   case MONGOC_MATCHER_OPCODE_NOT:
+      _mongoc_matcher_program_compile (program, paths, op->not_.child);
+      _mongoc_matcher_program_emit (
+         program, MONGOC_MATCHER_INSN_NOT, -1, NULL);
+      break;
+   case MONGOC_MATCHER_OPCODE_NOR:
+      /* !(left || right) */
+      _mongoc_matcher_program_compile (program, paths, op->logical.left);
+      jump = _mongoc_matcher_program_emit (
+         program, MONGOC_MATCHER_INSN_JUMP_IF_TRUE, -1, NULL);
+      _mongoc_matcher_program_compile (program, paths, op->logical.right);
+      _mongoc_matcher_program_patch (program, jump);
+      _mongoc_matcher_program_emit (
+         program, MONGOC_MATCHER_INSN_NOT, -1, NULL);
+      break;
+   case MONGOC_MATCHER_OPCODE_OR:
+   case MONGOC_MATCHER_OPCODE_AND:
+      jump_code = op->base.opcode == MONGOC_MATCHER_OPCODE_OR
+                     ? MONGOC_MATCHER_INSN_JUMP_IF_TRUE
+                     : MONGOC_MATCHER_INSN_JUMP_IF_FALSE;
+
+      _mongoc_array_init (&operands, sizeof (mongoc_matcher_operand_t));
+      _mongoc_array_init (&jumps, sizeof (uint32_t));
+
+      _mongoc_matcher_flatten (op->base.opcode, op, paths, &operands);
+      qsort (operands.data,
+             operands.len,
+             sizeof (mongoc_matcher_operand_t),
+             _mongoc_matcher_operand_cmp);
+
+      for (i = 0; i < operands.len; i++) {
+         operand =
+            &_mongoc_array_index (&operands, mongoc_matcher_operand_t, i);
+         _mongoc_matcher_program_compile (program, paths, operand->op);
+
+         if (i + 1 < operands.len) {
+            jump =
+               _mongoc_matcher_program_emit (program, jump_code, -1, NULL);
+            _mongoc_array_append_val (&jumps, jump);
+         }
+      }
+
+      for (i = 0; i < jumps.len; i++) {
+         _mongoc_matcher_program_patch (
+            program, _mongoc_array_index (&jumps, uint32_t, i));
+      }
+
+      _mongoc_array_destroy (&jumps);
+      _mongoc_array_destroy (&operands);
+      break;
+   default:
+      BSON_ASSERT (false);
+      break;
+   }
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_matcher_program_new --
+ *
+ *       Compile @optree into a flat program. @optree must outlive the
+ *       program, which borrows its paths and values.
+ *
+ * Returns:
+ *       A newly allocated mongoc_matcher_program_t that should be freed
+ *       with _mongoc_matcher_program_destroy().
+ *
+ * Side effects:
+ *       None.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+mongoc_matcher_program_t *
+_mongoc_matcher_program_new (mongoc_matcher_op_t *optree) /* IN */
+{
+   mongoc_matcher_program_t *program;
+   mongoc_matcher_node_t root = {0};
+   mongoc_array_t paths;
+   const char **path;
+   size_t i;
+   size_t n;
+
+   BSON_ASSERT (optree);
+
+   program = (mongoc_matcher_program_t *) bson_malloc0 (sizeof *program);
+   program->optree = optree;
+   _mongoc_array_init (&program->nodes, sizeof (mongoc_matcher_node_t));
+   _mongoc_array_init (&program->insns, sizeof (mongoc_matcher_insn_t));
+
+   root.slot = -1;
+   root.first_child = -1;
+   root.next_sibling = -1;
+   _mongoc_array_append_val (&program->nodes, root);
+
+   /* sorted, distinct paths. a path's index is its slot */
+   _mongoc_array_init (&paths, sizeof (const char *));
+   _mongoc_matcher_collect_paths (optree, &paths);
+   qsort (paths.data, paths.len, sizeof (const char *),
+          _mongoc_matcher_path_cmp);
+
+   path = (const char **) paths.data;
+   for (i = 0, n = 0; i < paths.len; i++) {
+      if (n == 0 || strcmp (path[n - 1], path[i]) != 0) {
+         path[n++] = path[i];
+      }
+   }
+
+   paths.len = n;
+   program->n_slots = (uint32_t) n;
+
+   for (i = 0; i < n; i++) {
+      _mongoc_matcher_program_add_path (program, path[i], (int32_t) i);
+   }
+
+   _mongoc_matcher_program_compile (program, &paths, optree);
+   _mongoc_array_destroy (&paths);
+
+   return program;
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_matcher_program_scan --
+ *
+ *       Find the children of @node_id among the fields of @iter, and
+ *       descend into those with children of their own. Like
+ *       bson_iter_find_descendant(), only the first field with a given
+ *       key is considered. Stops once every child has been seen, or
+ *       at an array that a longer path would have to cross.
+ *
+ * Returns:
+ *       false if the document needs the optree's array traversal.
+ *
+ * Side effects:
+ *       @values and @found are set for the slots that were found.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+static bool
+_mongoc_matcher_program_scan (const mongoc_matcher_program_t *program,
+                              int32_t node_id,     /* IN */
+                              bson_iter_t *iter,   /* IN */
+                              bson_iter_t *values, /* OUT */
+                              bool *found,         /* OUT */
+                              bool *seen)          /* INOUT */
+{
+   const mongoc_matcher_node_t *nodes;
+   const mongoc_matcher_node_t *child;
+   bson_iter_t sub;
+   const char *key;
+   uint32_t remaining;
+   int32_t i;
+
+   nodes = (const mongoc_matcher_node_t *) program->nodes.data;
+   remaining = nodes[node_id].n_children;
+
+   while (remaining && bson_iter_next (iter)) {
+      key = bson_iter_key (iter);
+
+      for (i = nodes[node_id].first_child; i != -1; i = child->next_sibling) {
+         child = &nodes[i];
+
+         if (strncmp (key, child->key, child->key_len) != 0 ||
+             key[child->key_len] != '\0') {
+            continue;
+         }
+
+         if (seen[i]) {
+            break;
+         }
+
+         seen[i] = true;
+         remaining--;
+
+         if (child->slot >= 0) {
+            values[child->slot] = *iter;
+            found[child->slot] = true;
+         }
+
+         if (child->n_children && BSON_ITER_HOLDS_ARRAY (iter)) {
+            return false;
+         }
+
+         if (child->n_children && BSON_ITER_HOLDS_DOCUMENT (iter) &&
+             bson_iter_recurse (iter, &sub) &&
+             !_mongoc_matcher_program_scan (
+                program, i, &sub, values, found, seen)) {
+            return false;
+         }
+
+         break;
+      }
+   }
+
+   return true;
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_matcher_program_run --
+ *
+ *       Checks to see if @bson matches the compiled query.
+ *
+ * Returns:
+ *       true if @bson matched, otherwise false.
+ *
+ * Side effects:
+ *       None.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+bool
+_mongoc_matcher_program_run (const mongoc_matcher_program_t *program, /* IN */
+                             const bson_t *bson)                       /* IN */
+{
+   bson_iter_t values_buf[MONGOC_MATCHER_PROGRAM_STACK_SLOTS];
+   bool found_buf[MONGOC_MATCHER_PROGRAM_STACK_SLOTS];
+   bool seen_buf[MONGOC_MATCHER_PROGRAM_STACK_NODES];
+   const mongoc_matcher_insn_t *insns;
+   const mongoc_matcher_insn_t *insn;
+   bson_iter_t *values = values_buf;
+   bool *found = found_buf;
+   bool *seen = seen_buf;
+   bson_iter_t iter;
+   bool result = false;
+   bool scanned = true;
+   uint32_t pc = 0;
+
+   BSON_ASSERT (program);
+   BSON_ASSERT (bson);
+
+   if (program->n_slots > MONGOC_MATCHER_PROGRAM_STACK_SLOTS) {
+      values = (bson_iter_t *) bson_malloc (program->n_slots * sizeof *values);
+      found = (bool *) bson_malloc (program->n_slots * sizeof *found);
+   }
+
+   if (program->nodes.len > MONGOC_MATCHER_PROGRAM_STACK_NODES) {
+      seen = (bool *) bson_malloc (program->nodes.len * sizeof *seen);
+   }
+
+   memset (found, 0, program->n_slots * sizeof *found);
+   memset (seen, 0, program->nodes.len * sizeof *seen);
+
+   if (bson_iter_init (&iter, bson)) {
+      scanned =
+         _mongoc_matcher_program_scan (program, 0, &iter, values, found, seen);
+   }
+
+   insns = (const mongoc_matcher_insn_t *) program->insns.data;
+
+   if (!scanned) {
+      result = _mongoc_matcher_op_match (program->optree, bson);
+      pc = (uint32_t) program->insns.len;
+   }
+
+   while (pc < program->insns.len) {
+      insn = &insns[pc++];
+
+      switch (insn->code) {
+      case MONGOC_MATCHER_INSN_MATCH:
+         result = found[insn->slot]
+                     ? _mongoc_matcher_op_match_value (insn->op,
+                                                       &values[insn->slot])
+                     : _mongoc_matcher_op_missing_match (insn->op);
+         break;
+      case MONGOC_MATCHER_INSN_EXISTS:
+         result = (found[insn->slot] == insn->op->exists.exists);
+         break;
+      case MONGOC_MATCHER_INSN_NOT:
+         result = !result;
+         break;
+      case MONGOC_MATCHER_INSN_JUMP_IF_FALSE:
+         if (!result) {
+            pc = insn->target;
+         }
+         break;
+      case MONGOC_MATCHER_INSN_JUMP_IF_TRUE:
+         if (result) {
+            pc = insn->target;
+         }
+         break;
+      default:
+         BSON_ASSERT (false);
+         break;
+      }
+   }
+
+   if (values != values_buf) {
+      bson_free (values);
+      bson_free (found);
+   }
+
+   if (seen != seen_buf) {
+      bson_free (seen);
+   }
+
+   return result;
+}
+
+
+void
+_mongoc_matcher_program_destroy (mongoc_matcher_program_t *program) /* IN */
+{
+   if (program) {
+      _mongoc_array_destroy (&program->nodes);
+      _mongoc_array_destroy (&program->insns);
+      bson_free (program);
+   }
+}
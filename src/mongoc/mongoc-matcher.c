@@ -29,6 +29,232 @@ _mongoc_matcher_parse_logical (mongoc_matcher_opcode_t opcode,
                                bool is_root,
                                bson_error_t *error);
 
+static mongoc_matcher_op_t *
+_mongoc_matcher_parse_compare (bson_iter_t *iter,
+                               const char *path,
+                               bson_error_t *error);
+
+static mongoc_matcher_op_t *
+_mongoc_matcher_parse_operator (const bson_iter_t *iter,
+                                bson_iter_t *child,
+                                const char *path,
+                                bson_error_t *error);
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_matcher_parse_regex --
+ *
+ *       Parse {$regex: pattern, $options: options} in the document held
+ *       by @doc. The pattern may be a string or a BSON regular
+ *       expression, whose options are used if there is no $options.
+ *
+ * Returns:
+ *       A newly allocated mongoc_matcher_op_t if successful; otherwise
+ *       NULL and @error is set.
+ *
+ * Side effects:
+ *       @error may be set.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+static mongoc_matcher_op_t *
+_mongoc_matcher_parse_regex (const bson_iter_t *doc, /* IN */
+                             const char *path,       /* IN */
+                             bson_error_t *error)    /* OUT */
+{
+   const char *pattern = NULL;
+   const char *options = NULL;
+   const char *key;
+   bson_iter_t child;
+
+   if (bson_iter_recurse (doc, &child)) {
+      while (bson_iter_next (&child)) {
+         key = bson_iter_key (&child);
+
+         if (strcmp (key, "$regex") == 0) {
+            if (BSON_ITER_HOLDS_UTF8 (&child)) {
+               pattern = bson_iter_utf8 (&child, NULL);
+            } else if (BSON_ITER_HOLDS_REGEX (&child)) {
+               pattern = bson_iter_regex (&child, options ? NULL : &options);
+            }
+         } else if (strcmp (key, "$options") == 0 &&
+                    BSON_ITER_HOLDS_UTF8 (&child)) {
+            options = bson_iter_utf8 (&child, NULL);
+         }
+      }
+   }
+
+   if (!pattern) {
+      bson_set_error (error,
+                      MONGOC_ERROR_MATCHER,
+                      MONGOC_ERROR_MATCHER_INVALID,
+                      "Invalid $regex for \"%s\"",
+                      path);
+      return NULL;
+   }
+
+   return _mongoc_matcher_op_regex_new (path, pattern, options, error);
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_matcher_parse_elem_match --
+ *
+ *       Parse the value of {$elemMatch: ...} observed by @iter. It is
+ *       either a query for the documents in an array, such as
+ *       {$elemMatch: {a: 1}}, or operators that one value in an array
+ *       must match together, such as {$elemMatch: {$gt: 1, $lt: 5}}.
+ *
+ * Returns:
+ *       A newly allocated mongoc_matcher_op_t if successful; otherwise
+ *       NULL and @error is set.
+ *
+ * Side effects:
+ *       @error may be set.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+static mongoc_matcher_op_t *
+_mongoc_matcher_parse_elem_match (bson_iter_t *iter,   /* IN */
+                                  const char *path,    /* IN */
+                                  bson_error_t *error) /* OUT */
+{
+   mongoc_matcher_op_t *op = NULL;
+   mongoc_matcher_op_t *next;
+   bson_iter_t child;
+   bson_iter_t field;
+   const char *key;
+   bool has_regex;
+
+   if (!BSON_ITER_HOLDS_DOCUMENT (iter) || !bson_iter_recurse (iter, &child) ||
+       !bson_iter_next (&child)) {
+      bson_set_error (error,
+                      MONGOC_ERROR_MATCHER,
+                      MONGOC_ERROR_MATCHER_INVALID,
+                      "$elemMatch needs a non-empty document.");
+      return NULL;
+   }
+
+   key = bson_iter_key (&child);
+
+   if (key[0] != '$' || strcmp (key, "$and") == 0 ||
+       strcmp (key, "$or") == 0 || strcmp (key, "$nor") == 0) {
+      bson_iter_recurse (iter, &child);
+      if (!(op = _mongoc_matcher_parse_logical (
+               MONGOC_MATCHER_OPCODE_AND, &child, true, error))) {
+         return NULL;
+      }
+
+      return _mongoc_matcher_op_elem_match_new (path, op, true);
+   }
+
+   /* each operator applies to the value itself, so its path is unused */
+   has_regex = bson_iter_recurse (iter, &field) &&
+               bson_iter_find (&field, "$regex");
+   bson_iter_recurse (iter, &child);
+
+   while (bson_iter_next (&child)) {
+      key = bson_iter_key (&child);
+
+      if (has_regex && strcmp (key, "$options") == 0) {
+         continue;
+      }
+
+      if (!(next = _mongoc_matcher_parse_operator (iter, &child, "", error))) {
+         if (op) {
+            _mongoc_matcher_op_destroy (op);
+         }
+         return NULL;
+      }
+
+      op = op ? _mongoc_matcher_op_logical_new (
+                   MONGOC_MATCHER_OPCODE_AND, op, next)
+              : next;
+   }
+
+   return _mongoc_matcher_op_elem_match_new (path, op, false);
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_matcher_parse_operator --
+ *
+ *       Parse the operator observed by @child, such as $gt or $in, in
+ *       the document held by @iter.
+ *
+ * Returns:
+ *       A newly allocated mongoc_matcher_op_t if successful; otherwise
+ *       NULL and @error is set.
+ *
+ * Side effects:
+ *       @error may be set.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+static mongoc_matcher_op_t *
+_mongoc_matcher_parse_operator (const bson_iter_t *iter, /* IN */
+                                bson_iter_t *child,      /* IN */
+                                const char *path,        /* IN */
+                                bson_error_t *error)     /* OUT */
+{
+   mongoc_matcher_op_t *op_child;
+   const char *key;
+
+   key = bson_iter_key (child);
+
+   if (strcmp (key, "$not") == 0) {
+      if (!(op_child = _mongoc_matcher_parse_compare (child, path, error))) {
+         return NULL;
+      }
+      return _mongoc_matcher_op_not_new (path, op_child);
+   } else if (strcmp (key, "$gt") == 0) {
+      return _mongoc_matcher_op_compare_new (
+         MONGOC_MATCHER_OPCODE_GT, path, child);
+   } else if (strcmp (key, "$gte") == 0) {
+      return _mongoc_matcher_op_compare_new (
+         MONGOC_MATCHER_OPCODE_GTE, path, child);
+   } else if (strcmp (key, "$in") == 0) {
+      return _mongoc_matcher_op_compare_new (
+         MONGOC_MATCHER_OPCODE_IN, path, child);
+   } else if (strcmp (key, "$lt") == 0) {
+      return _mongoc_matcher_op_compare_new (
+         MONGOC_MATCHER_OPCODE_LT, path, child);
+   } else if (strcmp (key, "$lte") == 0) {
+      return _mongoc_matcher_op_compare_new (
+         MONGOC_MATCHER_OPCODE_LTE, path, child);
+   } else if (strcmp (key, "$ne") == 0) {
+      return _mongoc_matcher_op_compare_new (
+         MONGOC_MATCHER_OPCODE_NE, path, child);
+   } else if (strcmp (key, "$nin") == 0) {
+      return _mongoc_matcher_op_compare_new (
+         MONGOC_MATCHER_OPCODE_NIN, path, child);
+   } else if (strcmp (key, "$exists") == 0) {
+      return _mongoc_matcher_op_exists_new (path, bson_iter_bool (child));
+   } else if (strcmp (key, "$type") == 0) {
+      return _mongoc_matcher_op_type_new (path, bson_iter_type (child));
+   } else if (strcmp (key, "$regex") == 0 || strcmp (key, "$options") == 0) {
+      return _mongoc_matcher_parse_regex (iter, path, error);
+   } else if (strcmp (key, "$elemMatch") == 0) {
+      return _mongoc_matcher_parse_elem_match (child, path, error);
+   }
+
+   bson_set_error (error,
+                   MONGOC_ERROR_MATCHER,
+                   MONGOC_ERROR_MATCHER_INVALID,
+                   "Invalid operator \"%s\"",
+                   key);
+   return NULL;
+}
+
 
 /*
  *--------------------------------------------------------------------------
@@ -56,8 +282,8 @@ _mongoc_matcher_parse_compare (bson_iter_t *iter,   /* IN */
                                const char *path,    /* IN */
                                bson_error_t *error) /* OUT */
 {
-   const char *key;
-   mongoc_matcher_op_t *op = NULL, *op_child;
+   const char *pattern;
+   const char *options;
    bson_iter_t child;
 
    BSON_ASSERT (iter);
@@ -72,58 +298,15 @@ _mongoc_matcher_parse_compare (bson_iter_t *iter,   /* IN */
          return NULL;
       }
 
-      key = bson_iter_key (&child);
-
-      if (key[0] != '$') {
-         op = _mongoc_matcher_op_compare_new (
-            MONGOC_MATCHER_OPCODE_EQ, path, iter);
-      } else if (strcmp (key, "$not") == 0) {
-         if (!(op_child =
-                  _mongoc_matcher_parse_compare (&child, path, error))) {
-            return NULL;
-         }
-         op = _mongoc_matcher_op_not_new (path, op_child);
-      } else if (strcmp (key, "$gt") == 0) {
-         op = _mongoc_matcher_op_compare_new (
-            MONGOC_MATCHER_OPCODE_GT, path, &child);
-      } else if (strcmp (key, "$gte") == 0) {
-         op = _mongoc_matcher_op_compare_new (
-            MONGOC_MATCHER_OPCODE_GTE, path, &child);
-      } else if (strcmp (key, "$in") == 0) {
-         op = _mongoc_matcher_op_compare_new (
-            MONGOC_MATCHER_OPCODE_IN, path, &child);
-      } else if (strcmp (key, "$lt") == 0) {
-         op = _mongoc_matcher_op_compare_new (
-            MONGOC_MATCHER_OPCODE_LT, path, &child);
-      } else if (strcmp (key, "$lte") == 0) {
-         op = _mongoc_matcher_op_compare_new (
-            MONGOC_MATCHER_OPCODE_LTE, path, &child);
-      } else if (strcmp (key, "$ne") == 0) {
-         op = _mongoc_matcher_op_compare_new (
-            MONGOC_MATCHER_OPCODE_NE, path, &child);
-      } else if (strcmp (key, "$nin") == 0) {
-         op = _mongoc_matcher_op_compare_new (
-            MONGOC_MATCHER_OPCODE_NIN, path, &child);
-      } else if (strcmp (key, "$exists") == 0) {
-         op = _mongoc_matcher_op_exists_new (path, bson_iter_bool (&child));
-      } else if (strcmp (key, "$type") == 0) {
-         op = _mongoc_matcher_op_type_new (path, bson_iter_type (&child));
-      } else {
-         bson_set_error (error,
-                         MONGOC_ERROR_MATCHER,
-                         MONGOC_ERROR_MATCHER_INVALID,
-                         "Invalid operator \"%s\"",
-                         key);
-         return NULL;
+      if (bson_iter_key (&child)[0] == '$') {
+         return _mongoc_matcher_parse_operator (iter, &child, path, error);
       }
-   } else {
-      op =
-         _mongoc_matcher_op_compare_new (MONGOC_MATCHER_OPCODE_EQ, path, iter);
+   } else if (bson_iter_type (iter) == BSON_TYPE_REGEX) {
+      pattern = bson_iter_regex (iter, &options);
+      return _mongoc_matcher_op_regex_new (path, pattern, options, error);
    }
 
-   BSON_ASSERT (op);
-
-   return op;
+   return _mongoc_matcher_op_compare_new (MONGOC_MATCHER_OPCODE_EQ, path, iter);
 }
 
 
@@ -302,8 +485,9 @@ _mongoc_matcher_parse_logical (mongoc_matcher_opcode_t opcode, /* IN */
  *       Create a new mongoc_matcher_t using the query specification
  *       provided in @query.
  *
- *       This will build an operation tree that can be applied to arbitrary
- *       bson documents using mongoc_matcher_match().
+ *       This will build an operation tree and compile it into a program
+ *       that can be applied to arbitrary bson documents using
+ *       mongoc_matcher_match().
  *
  * Returns:
  *       A newly allocated mongoc_matcher_t if successful; otherwise NULL
@@ -341,6 +525,7 @@ mongoc_matcher_new (const bson_t *query, /* IN */
    }
 
    matcher->optree = op;
+   matcher->program = _mongoc_matcher_program_new (op);
 
    return matcher;
 
@@ -373,10 +558,10 @@ mongoc_matcher_match (const mongoc_matcher_t *matcher, /* IN */
                       const bson_t *document)          /* IN */
 {
    BSON_ASSERT (matcher);
-   BSON_ASSERT (matcher->optree);
+   BSON_ASSERT (matcher->program);
    BSON_ASSERT (document);
 
-   return _mongoc_matcher_op_match (matcher->optree, document);
+   return _mongoc_matcher_program_run (matcher->program, document);
 }
 
 
@@ -401,6 +586,7 @@ mongoc_matcher_destroy (mongoc_matcher_t *matcher) /* IN */
 {
    BSON_ASSERT (matcher);
 
+   _mongoc_matcher_program_destroy (matcher->program);
    _mongoc_matcher_op_destroy (matcher->optree);
    bson_destroy (&matcher->query);
    bson_free (matcher);
@@ -28,6 +28,7 @@ BSON_BEGIN_DECLS
 
 
 typedef struct _mongoc_matcher_t mongoc_matcher_t;
+typedef bool (*mongoc_matcher_file_func_t) (const bson_t *document, void *ctx);
 
 
 BSON_EXPORT (mongoc_matcher_t *)
@@ -36,6 +37,13 @@ mongoc_matcher_new (const bson_t *query,
 BSON_EXPORT (bool)
 mongoc_matcher_match (const mongoc_matcher_t *matcher,
                       const bson_t *document) BSON_GNUC_DEPRECATED;
+BSON_EXPORT (bool)
+mongoc_matcher_match_file (const mongoc_matcher_t *matcher,
+                           const char *path,
+                           uint32_t n_threads,
+                           mongoc_matcher_file_func_t func,
+                           void *ctx,
+                           bson_error_t *error);
 BSON_EXPORT (void)
 mongoc_matcher_destroy (mongoc_matcher_t *matcher) BSON_GNUC_DEPRECATED;
 
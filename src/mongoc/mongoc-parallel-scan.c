@@ -0,0 +1,547 @@
+/*
+ * Copyright 2017 MongoDB, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "mongoc-client-pool-private.h"
+#include "mongoc-client-private.h"
+#include "mongoc-collection-private.h"
+#include "mongoc-cursor-private.h"
+#include "mongoc-error.h"
+#include "mongoc-parallel-scan.h"
+#include "mongoc-read-prefs-private.h"
+#include "mongoc-topology-private.h"
+#include "mongoc-trace-private.h"
+
+
+#undef MONGOC_LOG_DOMAIN
+#define MONGOC_LOG_DOMAIN "parallel-scan"
+
+
+/* how many $sample documents to take per requested cursor when choosing
+ * _id range boundaries; more samples give more even ranges */
+#define MONGOC_PARALLEL_SCAN_SAMPLES_PER_CURSOR 16
+
+
+struct _mongoc_parallel_scan_t {
+   mongoc_client_pool_t *pool;
+   mongoc_client_t **clients; /* popped from pool, or NULL */
+   mongoc_cursor_t **cursors;
+   uint32_t n_cursors;
+};
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_parallel_scan_client --
+ *
+ *       Get the client for the next cursor. With a pool, each cursor gets
+ *       its own client so that it may be iterated on its own thread.
+ *
+ * Returns:
+ *       A client, or NULL if the pool is exhausted and @error is set.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+static mongoc_client_t *
+_mongoc_parallel_scan_client (mongoc_parallel_scan_t *scan,
+                              mongoc_collection_t *collection,
+                              bson_error_t *error)
+{
+   mongoc_client_t *client;
+
+   if (!scan->pool) {
+      return collection->client;
+   }
+
+   client = mongoc_client_pool_try_pop (scan->pool);
+   if (!client) {
+      bson_set_error (error,
+                      MONGOC_ERROR_CLIENT,
+                      MONGOC_ERROR_CLIENT_NOT_READY,
+                      "Client pool exhausted after %u of the parallel scan's "
+                      "cursors",
+                      scan->n_cursors);
+      return NULL;
+   }
+
+   scan->clients[scan->n_cursors] = client;
+
+   return client;
+}
+
+
+static void
+_mongoc_parallel_scan_apply_batch_size (mongoc_cursor_t *cursor,
+                                        const bson_t *opts)
+{
+   bson_iter_t iter;
+
+   if (opts && bson_iter_init_find (&iter, opts, "batchSize") &&
+       BSON_ITER_HOLDS_NUMBER (&iter)) {
+      mongoc_cursor_set_batch_size (cursor,
+                                    (uint32_t) bson_iter_as_int64 (&iter));
+   }
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_parallel_scan_from_command --
+ *
+ *       Run "parallelCollectionScan" on @server_id and wrap each of the
+ *       cursors in its reply with mongoc_cursor_new_from_command_reply.
+ *
+ * Returns:
+ *       True on success. False if the command or a client could not be
+ *       obtained, and @error is set.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+static bool
+_mongoc_parallel_scan_from_command (mongoc_parallel_scan_t *scan,
+                                    mongoc_collection_t *collection,
+                                    uint32_t num_cursors,
+                                    const bson_t *opts,
+                                    const mongoc_read_prefs_t *read_prefs,
+                                    uint32_t server_id,
+                                    bson_error_t *error)
+{
+   bson_t cmd = BSON_INITIALIZER;
+   bson_t cmd_opts = BSON_INITIALIZER;
+   bson_t reply;
+   bson_t cursor_doc;
+   bson_iter_t iter;
+   bson_iter_t child;
+   const uint8_t *data;
+   uint32_t data_len;
+   mongoc_client_t *client;
+   mongoc_cursor_t *cursor;
+   bool ret = false;
+
+   ENTRY;
+
+   BSON_APPEND_UTF8 (&cmd, "parallelCollectionScan", collection->collection);
+   BSON_APPEND_INT32 (&cmd, "numCursors", (int32_t) num_cursors);
+   BSON_APPEND_INT32 (&cmd_opts, "serverId", (int32_t) server_id);
+
+   if (!mongoc_collection_read_command_with_opts (
+          collection, &cmd, read_prefs, &cmd_opts, &reply, error)) {
+      GOTO (done);
+   }
+
+   if (!bson_iter_init_find (&iter, &reply, "cursors") ||
+       !BSON_ITER_HOLDS_ARRAY (&iter) || !bson_iter_recurse (&iter, &child)) {
+      bson_set_error (error,
+                      MONGOC_ERROR_CURSOR,
+                      MONGOC_ERROR_CURSOR_INVALID_CURSOR,
+                      "Invalid reply to parallelCollectionScan command.");
+      GOTO (done);
+   }
+
+   while (bson_iter_next (&child) && scan->n_cursors < num_cursors) {
+      if (!BSON_ITER_HOLDS_DOCUMENT (&child)) {
+         bson_set_error (error,
+                         MONGOC_ERROR_CURSOR,
+                         MONGOC_ERROR_CURSOR_INVALID_CURSOR,
+                         "Invalid reply to parallelCollectionScan command.");
+         GOTO (done);
+      }
+
+      client = _mongoc_parallel_scan_client (scan, collection, error);
+      if (!client) {
+         GOTO (done);
+      }
+
+      bson_iter_document (&child, &data_len, &data);
+      BSON_ASSERT (bson_init_static (&cursor_doc, data, data_len));
+
+      /* each element is {cursor: {id, ns, firstBatch}, ok: 1} */
+      cursor = mongoc_cursor_new_from_command_reply (
+         client, bson_copy (&cursor_doc), server_id);
+      _mongoc_parallel_scan_apply_batch_size (cursor, opts);
+      scan->cursors[scan->n_cursors++] = cursor;
+   }
+
+   ret = true;
+
+done:
+   bson_destroy (&cmd);
+   bson_destroy (&cmd_opts);
+   bson_destroy (&reply);
+
+   RETURN (ret);
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_parallel_scan_from_sample --
+ *
+ *       For servers without "parallelCollectionScan": sample _ids with
+ *       $sample, choose up to @num_cursors - 1 distinct boundaries, and
+ *       open one find cursor per _id range using "min" and "max" bounds
+ *       on the _id index.
+ *
+ * Returns:
+ *       True on success. False if sampling failed or a client could not be
+ *       obtained, and @error is set.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+static bool
+_mongoc_parallel_scan_from_sample (mongoc_parallel_scan_t *scan,
+                                   mongoc_collection_t *collection,
+                                   uint32_t num_cursors,
+                                   const bson_t *opts,
+                                   const mongoc_read_prefs_t *read_prefs,
+                                   uint32_t server_id,
+                                   bson_error_t *error)
+{
+   uint32_t n_wanted;
+   uint32_t n_samples = 0;
+   uint32_t n_bounds = 0;
+   uint32_t i;
+   bson_t **samples;
+   bson_t **bounds;
+   bson_t *pipeline;
+   bson_t *agg_opts;
+   bson_t find_opts;
+   bson_t filter = BSON_INITIALIZER;
+   bson_t id_index = BSON_INITIALIZER;
+   bson_iter_t iter;
+   mongoc_cursor_t *agg_cursor;
+   mongoc_collection_t *range_collection;
+   mongoc_client_t *client;
+   mongoc_cursor_t *cursor;
+   const bson_t *doc;
+   bool ret = false;
+
+   ENTRY;
+
+   n_wanted = num_cursors * MONGOC_PARALLEL_SCAN_SAMPLES_PER_CURSOR;
+   samples = (bson_t **) bson_malloc0 (n_wanted * sizeof (bson_t *));
+   bounds = (bson_t **) bson_malloc0 (num_cursors * sizeof (bson_t *));
+
+   pipeline = BCON_NEW ("pipeline",
+                        "[",
+                        "{",
+                        "$sample",
+                        "{",
+                        "size",
+                        BCON_INT64 (n_wanted),
+                        "}",
+                        "}",
+                        "{",
+                        "$project",
+                        "{",
+                        "_id",
+                        BCON_INT32 (1),
+                        "}",
+                        "}",
+                        "{",
+                        "$sort",
+                        "{",
+                        "_id",
+                        BCON_INT32 (1),
+                        "}",
+                        "}",
+                        "]");
+
+   agg_opts = BCON_NEW ("serverId",
+                        BCON_INT32 ((int32_t) server_id),
+                        "batchSize",
+                        BCON_INT32 ((int32_t) n_wanted));
+
+   agg_cursor = mongoc_collection_aggregate (
+      collection, MONGOC_QUERY_NONE, pipeline, agg_opts, read_prefs);
+
+   while (n_samples < n_wanted && mongoc_cursor_next (agg_cursor, &doc)) {
+      samples[n_samples++] = bson_copy (doc);
+   }
+
+   if (mongoc_cursor_error (agg_cursor, error)) {
+      mongoc_cursor_destroy (agg_cursor);
+      GOTO (done);
+   }
+
+   mongoc_cursor_destroy (agg_cursor);
+
+   /* samples are sorted, but $sample may return a document twice */
+   for (i = 1; i < num_cursors && n_samples; i++) {
+      doc = samples[(uint64_t) i * n_samples / num_cursors];
+      if (n_bounds && bson_equal (bounds[n_bounds - 1], doc)) {
+         continue;
+      }
+
+      bounds[n_bounds++] = (bson_t *) doc;
+   }
+
+   /* "min" and "max" require a hint */
+   BSON_APPEND_INT32 (&id_index, "_id", 1);
+
+   /* n_bounds boundaries make n_bounds + 1 ranges: [min, max) */
+   for (i = 0; i <= n_bounds; i++) {
+      client = _mongoc_parallel_scan_client (scan, collection, error);
+      if (!client) {
+         GOTO (done);
+      }
+
+      bson_init (&find_opts);
+      BSON_APPEND_INT32 (&find_opts, "serverId", (int32_t) server_id);
+      BSON_APPEND_DOCUMENT (&find_opts, "hint", &id_index);
+
+      if (i > 0) {
+         BSON_APPEND_DOCUMENT (&find_opts, "min", bounds[i - 1]);
+      }
+
+      if (i < n_bounds) {
+         BSON_APPEND_DOCUMENT (&find_opts, "max", bounds[i]);
+      }
+
+      if (opts && bson_iter_init_find (&iter, opts, "batchSize")) {
+         bson_append_iter (&find_opts, "batchSize", 9, &iter);
+      }
+
+      if (client == collection->client) {
+         cursor = mongoc_collection_find_with_opts (
+            collection, &filter, &find_opts, read_prefs);
+      } else {
+         range_collection = mongoc_client_get_collection (
+            client, collection->db, collection->collection);
+         mongoc_collection_set_read_concern (range_collection,
+                                             collection->read_concern);
+         cursor = mongoc_collection_find_with_opts (
+            range_collection, &filter, &find_opts, read_prefs);
+         mongoc_collection_destroy (range_collection);
+      }
+
+      bson_destroy (&find_opts);
+      scan->cursors[scan->n_cursors++] = cursor;
+   }
+
+   ret = true;
+
+done:
+   for (i = 0; i < n_samples; i++) {
+      bson_destroy (samples[i]);
+   }
+
+   bson_free (samples);
+   bson_free (bounds);
+   bson_destroy (pipeline);
+   bson_destroy (agg_opts);
+   bson_destroy (&filter);
+   bson_destroy (&id_index);
+
+   RETURN (ret);
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * mongoc_collection_parallel_scan --
+ *
+ *       Split a scan of @collection into up to @num_cursors independent
+ *       cursors on one server, using "parallelCollectionScan" where the
+ *       server supports it and $sample _id ranges otherwise.
+ *
+ *       If @pool is not NULL, each cursor is created on its own client
+ *       popped from @pool, so the cursors may be iterated concurrently on
+ *       different threads. The collection's client must come from the
+ *       same pool. If @pool is NULL, all cursors share the collection's
+ *       client.
+ *
+ * Returns:
+ *       A newly allocated mongoc_parallel_scan_t that should be freed with
+ *       mongoc_parallel_scan_destroy(), or NULL and @error is set.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+mongoc_parallel_scan_t *
+mongoc_collection_parallel_scan (mongoc_collection_t *collection,
+                                 mongoc_client_pool_t *pool,
+                                 uint32_t num_cursors,
+                                 const bson_t *opts,
+                                 const mongoc_read_prefs_t *read_prefs,
+                                 bson_error_t *error)
+{
+   mongoc_parallel_scan_t *scan;
+   uint32_t server_id;
+   bson_error_t cmd_error;
+
+   ENTRY;
+
+   BSON_ASSERT (collection);
+
+   if (num_cursors < 1 || num_cursors > 10000) {
+      bson_set_error (error,
+                      MONGOC_ERROR_COMMAND,
+                      MONGOC_ERROR_COMMAND_INVALID_ARG,
+                      "num_cursors must be from 1 to 10000, not %u",
+                      num_cursors);
+      RETURN (NULL);
+   }
+
+   if (pool &&
+       _mongoc_client_pool_get_topology (pool) !=
+          collection->client->topology) {
+      bson_set_error (error,
+                      MONGOC_ERROR_COMMAND,
+                      MONGOC_ERROR_COMMAND_INVALID_ARG,
+                      "The collection's client must come from the pool");
+      RETURN (NULL);
+   }
+
+   if (!read_prefs) {
+      read_prefs = collection->read_prefs;
+   }
+
+   if (!_mongoc_read_prefs_validate (read_prefs, error)) {
+      RETURN (NULL);
+   }
+
+   /* all cursors must be on the server that created them */
+   server_id = mongoc_topology_select_server_id (
+      collection->client->topology, MONGOC_SS_READ, read_prefs, error);
+
+   if (!server_id) {
+      RETURN (NULL);
+   }
+
+   scan = (mongoc_parallel_scan_t *) bson_malloc0 (sizeof *scan);
+   scan->pool = pool;
+   scan->clients =
+      (mongoc_client_t **) bson_malloc0 (num_cursors * sizeof (void *));
+   scan->cursors =
+      (mongoc_cursor_t **) bson_malloc0 (num_cursors * sizeof (void *));
+
+   if (_mongoc_parallel_scan_from_command (scan,
+                                           collection,
+                                           num_cursors,
+                                           opts,
+                                           read_prefs,
+                                           server_id,
+                                           &cmd_error)) {
+      RETURN (scan);
+   }
+
+   /* removed in MongoDB 4.2, and never supported by mongos */
+   if (scan->n_cursors ||
+       (cmd_error.domain != MONGOC_ERROR_QUERY &&
+        cmd_error.domain != MONGOC_ERROR_SERVER) ||
+       cmd_error.code != MONGOC_ERROR_QUERY_COMMAND_NOT_FOUND) {
+      if (error) {
+         memcpy (error, &cmd_error, sizeof *error);
+      }
+
+      mongoc_parallel_scan_destroy (scan);
+      RETURN (NULL);
+   }
+
+   if (!_mongoc_parallel_scan_from_sample (scan,
+                                           collection,
+                                           num_cursors,
+                                           opts,
+                                           read_prefs,
+                                           server_id,
+                                           error)) {
+      mongoc_parallel_scan_destroy (scan);
+      RETURN (NULL);
+   }
+
+   RETURN (scan);
+}
+
+
+uint32_t
+mongoc_parallel_scan_get_n_cursors (const mongoc_parallel_scan_t *scan)
+{
+   BSON_ASSERT (scan);
+
+   return scan->n_cursors;
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * mongoc_parallel_scan_get_cursor --
+ *
+ *       Get the @i'th cursor. The cursor is owned by @scan and must not be
+ *       destroyed by the caller.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+mongoc_cursor_t *
+mongoc_parallel_scan_get_cursor (const mongoc_parallel_scan_t *scan,
+                                 uint32_t i)
+{
+   BSON_ASSERT (scan);
+
+   if (i >= scan->n_cursors) {
+      return NULL;
+   }
+
+   return scan->cursors[i];
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * mongoc_parallel_scan_destroy --
+ *
+ *       Destroy all cursors, then return their clients to the pool.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+void
+mongoc_parallel_scan_destroy (mongoc_parallel_scan_t *scan)
+{
+   uint32_t i;
+
+   ENTRY;
+
+   if (!scan) {
+      EXIT;
+   }
+
+   for (i = 0; i < scan->n_cursors; i++) {
+      mongoc_cursor_destroy (scan->cursors[i]);
+   }
+
+   for (i = 0; i < scan->n_cursors; i++) {
+      if (scan->clients[i]) {
+         mongoc_client_pool_push (scan->pool, scan->clients[i]);
+      }
+   }
+
+   bson_free (scan->clients);
+   bson_free (scan->cursors);
+   bson_free (scan);
+
+   EXIT;
+}
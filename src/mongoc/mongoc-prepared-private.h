@@ -0,0 +1,68 @@
+/*
+ * Copyright 2017 MongoDB, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MONGOC_PREPARED_PRIVATE_H
+#define MONGOC_PREPARED_PRIVATE_H
+
+#if !defined(MONGOC_INSIDE) && !defined(MONGOC_COMPILATION)
+#error "Only <mongoc.h> can be included directly."
+#endif
+
+#include <bson.h>
+
+#include "mongoc-client.h"
+#include "mongoc-prepared.h"
+#include "mongoc-read-concern.h"
+
+BSON_BEGIN_DECLS
+
+struct _mongoc_prepared_find_t {
+   mongoc_client_t *client;
+   char *ns;
+   /* validated opts without "serverId", copied to each cursor */
+   bson_t opts;
+   /* the find command's fields after "find" and "filter", except those a
+    * cursor can still change: "limit", "batchSize", and "singleBatch" */
+   bson_t find_tail;
+   uint32_t server_id;
+   bool has_collation;
+   bool exhaust;
+   mongoc_read_prefs_t *read_prefs;
+   mongoc_read_concern_t *read_concern;
+};
+
+struct _mongoc_prepared_count_t {
+   mongoc_client_t *client;
+   char *db;
+   char *collection;
+   int collectionlen;
+   /* the count command's fields after "count", "query", "limit", "skip" */
+   bson_t count_tail;
+   /* appended only if the server supports it */
+   bson_t write_concern;
+   uint32_t server_id;
+   bool has_collation;
+   bool has_read_concern;
+   bool has_write_concern;
+   mongoc_query_flags_t flags;
+   mongoc_read_prefs_t *read_prefs;
+   mongoc_read_concern_t *read_concern;
+};
+
+BSON_END_DECLS
+
+
+#endif /* MONGOC_PREPARED_PRIVATE_H */
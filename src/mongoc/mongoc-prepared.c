@@ -0,0 +1,441 @@
+/*
+ * Copyright 2017 MongoDB, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "mongoc-client-private.h"
+#include "mongoc-collection-private.h"
+#include "mongoc-cursor-private.h"
+#include "mongoc-error.h"
+#include "mongoc-prepared.h"
+#include "mongoc-prepared-private.h"
+#include "mongoc-read-concern-private.h"
+#include "mongoc-read-prefs-private.h"
+#include "mongoc-trace-private.h"
+#include "mongoc-util-private.h"
+#include "mongoc-write-concern-private.h"
+
+
+#undef MONGOC_LOG_DOMAIN
+#define MONGOC_LOG_DOMAIN "prepared"
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * mongoc_prepared_find_new --
+ *
+ *       Validate @opts and serialize the parts of a "find" command that
+ *       do not depend on the filter, so that running the same query shape
+ *       many times only copies the filter.
+ *
+ *       The collection's client, read concern, and the resolved read
+ *       preferences are captured now; later changes to @collection do
+ *       not affect the prepared find.
+ *
+ * Returns:
+ *       A newly allocated mongoc_prepared_find_t that should be freed with
+ *       mongoc_prepared_find_destroy(), or NULL and @error is set.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+mongoc_prepared_find_t *
+mongoc_prepared_find_new (mongoc_collection_t *collection,
+                          const bson_t *opts,
+                          const mongoc_read_prefs_t *read_prefs,
+                          bson_error_t *error)
+{
+   mongoc_prepared_find_t *prepared;
+   bson_iter_t iter;
+   const char *key;
+
+   ENTRY;
+
+   BSON_ASSERT (collection);
+
+   if (!read_prefs) {
+      read_prefs = collection->read_prefs;
+   }
+
+   if (!_mongoc_read_prefs_validate (read_prefs, error)) {
+      RETURN (NULL);
+   }
+
+   prepared = (mongoc_prepared_find_t *) bson_malloc0 (sizeof *prepared);
+   prepared->client = collection->client;
+   prepared->ns = bson_strdup (collection->ns);
+   bson_init (&prepared->opts);
+   bson_init (&prepared->find_tail);
+   prepared->read_prefs = read_prefs
+                             ? mongoc_read_prefs_copy (read_prefs)
+                             : mongoc_read_prefs_new (MONGOC_READ_PRIMARY);
+   prepared->read_concern = collection->read_concern
+                               ? mongoc_read_concern_copy (
+                                    collection->read_concern)
+                               : mongoc_read_concern_new ();
+
+   if (opts) {
+      if (!_mongoc_cursor_validate_opts (opts, error)) {
+         GOTO (fail);
+      }
+
+      if (!_mongoc_get_server_id_from_opts (opts,
+                                            MONGOC_ERROR_CURSOR,
+                                            MONGOC_ERROR_CURSOR_INVALID_CURSOR,
+                                            &prepared->server_id,
+                                            error)) {
+         GOTO (fail);
+      }
+
+      BSON_ASSERT (bson_iter_init (&iter, opts));
+      while (bson_iter_next (&iter)) {
+         key = bson_iter_key (&iter);
+
+         if (!strcmp (key, "serverId")) {
+            continue;
+         }
+
+         bson_append_iter (&prepared->opts, key, -1, &iter);
+
+         if (!strcmp (key, MONGOC_CURSOR_COLLATION)) {
+            prepared->has_collation = true;
+         } else if (!strcmp (key, MONGOC_CURSOR_EXHAUST)) {
+            prepared->exhaust = bson_iter_as_bool (&iter);
+         }
+
+         /* cursor setters may still change these, see
+          * _mongoc_cursor_append_prepared_find */
+         if (!strcmp (key, MONGOC_CURSOR_MAX_AWAIT_TIME_MS) ||
+             !strcmp (key, MONGOC_CURSOR_LIMIT) ||
+             !strcmp (key, MONGOC_CURSOR_BATCH_SIZE) ||
+             !strcmp (key, MONGOC_CURSOR_SINGLE_BATCH)) {
+            continue;
+         }
+
+         if (!bson_append_iter (&prepared->find_tail, key, -1, &iter)) {
+            bson_set_error (error,
+                            MONGOC_ERROR_BSON,
+                            MONGOC_ERROR_BSON_INVALID,
+                            "Cursor opts too large");
+            GOTO (fail);
+         }
+      }
+   }
+
+   if (prepared->exhaust && bson_iter_init_find (&iter, opts, "limit") &&
+       bson_iter_as_int64 (&iter)) {
+      bson_set_error (error,
+                      MONGOC_ERROR_CURSOR,
+                      MONGOC_ERROR_CURSOR_INVALID_CURSOR,
+                      "Cannot specify both 'exhaust' and 'limit'.");
+      GOTO (fail);
+   }
+
+   if (prepared->read_concern->level != NULL) {
+      bson_append_document (
+         &prepared->find_tail,
+         MONGOC_CURSOR_READ_CONCERN,
+         MONGOC_CURSOR_READ_CONCERN_LEN,
+         _mongoc_read_concern_get_bson (prepared->read_concern));
+   }
+
+   RETURN (prepared);
+
+fail:
+   mongoc_prepared_find_destroy (prepared);
+
+   RETURN (NULL);
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * mongoc_prepared_find_execute --
+ *
+ *       Create a cursor that runs the prepared find with @filter.
+ *
+ * Returns:
+ *       A newly allocated mongoc_cursor_t that should be freed with
+ *       mongoc_cursor_destroy(). @prepared must be valid for the lifetime
+ *       of the cursor.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+mongoc_cursor_t *
+mongoc_prepared_find_execute (const mongoc_prepared_find_t *prepared,
+                              const bson_t *filter)
+{
+   BSON_ASSERT (prepared);
+   BSON_ASSERT (filter);
+
+   return _mongoc_cursor_new_prepared (prepared, filter);
+}
+
+
+void
+mongoc_prepared_find_destroy (mongoc_prepared_find_t *prepared)
+{
+   if (prepared) {
+      bson_free (prepared->ns);
+      bson_destroy (&prepared->opts);
+      bson_destroy (&prepared->find_tail);
+      mongoc_read_prefs_destroy (prepared->read_prefs);
+      mongoc_read_concern_destroy (prepared->read_concern);
+      bson_free (prepared);
+   }
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * mongoc_prepared_count_new --
+ *
+ *       Validate @opts and serialize them once, for repeated "count"
+ *       commands that only differ in their query, skip, and limit.
+ *
+ * Returns:
+ *       A newly allocated mongoc_prepared_count_t that should be freed with
+ *       mongoc_prepared_count_destroy(), or NULL and @error is set.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+mongoc_prepared_count_t *
+mongoc_prepared_count_new (mongoc_collection_t *collection,
+                           mongoc_query_flags_t flags,
+                           const bson_t *opts,
+                           const mongoc_read_prefs_t *read_prefs,
+                           bson_error_t *error)
+{
+   mongoc_prepared_count_t *prepared;
+   bson_iter_t iter;
+   uint32_t len;
+   const uint8_t *data;
+   bson_t wc;
+
+   ENTRY;
+
+   BSON_ASSERT (collection);
+
+   read_prefs = COALESCE (read_prefs, collection->read_prefs);
+
+   if (!_mongoc_read_prefs_validate (read_prefs, error)) {
+      RETURN (NULL);
+   }
+
+   prepared = (mongoc_prepared_count_t *) bson_malloc0 (sizeof *prepared);
+   prepared->client = collection->client;
+   prepared->db = bson_strdup (collection->db);
+   prepared->collection = bson_strdup (collection->collection);
+   prepared->collectionlen = (int) collection->collectionlen;
+   prepared->flags = flags;
+   bson_init (&prepared->count_tail);
+   bson_init (&prepared->write_concern);
+   prepared->read_prefs = read_prefs ? mongoc_read_prefs_copy (read_prefs)
+                                     : NULL;
+   prepared->read_concern = collection->read_concern
+                               ? mongoc_read_concern_copy (
+                                    collection->read_concern)
+                               : mongoc_read_concern_new ();
+
+   if (!_mongoc_get_server_id_from_opts (opts,
+                                         MONGOC_ERROR_COMMAND,
+                                         MONGOC_ERROR_COMMAND_INVALID_ARG,
+                                         &prepared->server_id,
+                                         error)) {
+      GOTO (fail);
+   }
+
+   if (opts && bson_iter_init (&iter, opts)) {
+      while (bson_iter_next (&iter)) {
+         if (BSON_ITER_IS_KEY (&iter, "serverId")) {
+            continue;
+         } else if (BSON_ITER_IS_KEY (&iter, "writeConcern")) {
+            if (!_mongoc_write_concern_iter_is_valid (&iter)) {
+               bson_set_error (error,
+                               MONGOC_ERROR_COMMAND,
+                               MONGOC_ERROR_COMMAND_INVALID_ARG,
+                               "Invalid writeConcern");
+               GOTO (fail);
+            }
+
+            /* only sent to servers that accept it, see below */
+            bson_iter_document (&iter, &len, &data);
+            BSON_ASSERT (bson_init_static (&wc, data, len));
+            bson_reinit (&prepared->write_concern);
+            bson_concat (&prepared->write_concern, &wc);
+            prepared->has_write_concern = true;
+            continue;
+         } else if (BSON_ITER_IS_KEY (&iter, "collation")) {
+            prepared->has_collation = true;
+         } else if (BSON_ITER_IS_KEY (&iter, "readConcern")) {
+            prepared->has_read_concern = true;
+         }
+
+         bson_append_iter (
+            &prepared->count_tail, bson_iter_key (&iter), -1, &iter);
+      }
+   }
+
+   RETURN (prepared);
+
+fail:
+   mongoc_prepared_count_destroy (prepared);
+
+   RETURN (NULL);
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * mongoc_prepared_count_execute --
+ *
+ *       Run the prepared "count" with @query, @skip, and @limit. Behaves
+ *       like mongoc_collection_count_with_opts() with the opts given to
+ *       mongoc_prepared_count_new().
+ *
+ * Returns:
+ *       The count, or -1 on failure and @error is set.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+int64_t
+mongoc_prepared_count_execute (const mongoc_prepared_count_t *prepared,
+                               const bson_t *query,
+                               int64_t skip,
+                               int64_t limit,
+                               bson_error_t *error)
+{
+   mongoc_cluster_t *cluster;
+   mongoc_server_stream_t *server_stream;
+   mongoc_query_flags_t flags;
+   bson_t cmd = BSON_INITIALIZER;
+   bson_t reply;
+   bson_t empty = BSON_INITIALIZER;
+   bson_iter_t iter;
+   int32_t max_wire_version;
+   int64_t ret = -1;
+
+   ENTRY;
+
+   BSON_ASSERT (prepared);
+
+   cluster = &prepared->client->cluster;
+   flags = prepared->flags;
+
+   if (prepared->server_id) {
+      server_stream = mongoc_cluster_stream_for_server (
+         cluster, prepared->server_id, true /* reconnect ok */, error);
+
+      if (server_stream && server_stream->sd->type != MONGOC_SERVER_MONGOS) {
+         flags |= MONGOC_QUERY_SLAVE_OK;
+      }
+   } else {
+      server_stream =
+         mongoc_cluster_stream_for_reads (cluster, prepared->read_prefs, error);
+   }
+
+   if (!server_stream) {
+      RETURN (-1);
+   }
+
+   max_wire_version = server_stream->sd->max_wire_version;
+
+   if (prepared->has_collation && max_wire_version < WIRE_VERSION_COLLATION) {
+      bson_set_error (error,
+                      MONGOC_ERROR_COMMAND,
+                      MONGOC_ERROR_PROTOCOL_BAD_WIRE_VERSION,
+                      "The selected server does not support collation");
+      GOTO (done);
+   }
+
+   if (prepared->has_read_concern &&
+       max_wire_version < WIRE_VERSION_READ_CONCERN) {
+      bson_set_error (error,
+                      MONGOC_ERROR_COMMAND,
+                      MONGOC_ERROR_PROTOCOL_BAD_WIRE_VERSION,
+                      "The selected server does not support readConcern");
+      GOTO (done);
+   }
+
+   bson_append_utf8 (
+      &cmd, "count", 5, prepared->collection, prepared->collectionlen);
+   bson_append_document (&cmd, "query", 5, query ? query : &empty);
+   if (limit) {
+      bson_append_int64 (&cmd, "limit", 5, limit);
+   }
+   if (skip) {
+      bson_append_int64 (&cmd, "skip", 4, skip);
+   }
+
+   bson_concat (&cmd, &prepared->count_tail);
+
+   if (prepared->has_write_concern &&
+       max_wire_version >= WIRE_VERSION_CMD_WRITE_CONCERN) {
+      bson_append_document (&cmd, "writeConcern", 12, &prepared->write_concern);
+   }
+
+   if (!prepared->has_read_concern &&
+       max_wire_version >= WIRE_VERSION_READ_CONCERN &&
+       !_mongoc_read_concern_is_default (prepared->read_concern)) {
+      bson_append_document (
+         &cmd,
+         "readConcern",
+         11,
+         _mongoc_read_concern_get_bson (prepared->read_concern));
+   }
+
+   if (_mongoc_client_command_with_stream (prepared->client,
+                                           prepared->db,
+                                           &cmd,
+                                           server_stream,
+                                           flags,
+                                           prepared->read_prefs,
+                                           &reply,
+                                           error)) {
+      if (bson_iter_init_find (&iter, &reply, "n")) {
+         ret = bson_iter_as_int64 (&iter);
+      }
+   }
+
+   bson_destroy (&reply);
+
+done:
+   mongoc_server_stream_cleanup (server_stream);
+   bson_destroy (&cmd);
+
+   RETURN (ret);
+}
+
+
+void
+mongoc_prepared_count_destroy (mongoc_prepared_count_t *prepared)
+{
+   if (prepared) {
+      bson_free (prepared->db);
+      bson_free (prepared->collection);
+      bson_destroy (&prepared->count_tail);
+      bson_destroy (&prepared->write_concern);
+      mongoc_read_prefs_destroy (prepared->read_prefs);
+      mongoc_read_concern_destroy (prepared->read_concern);
+      bson_free (prepared);
+   }
+}
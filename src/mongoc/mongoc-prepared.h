@@ -0,0 +1,68 @@
+/*
+ * Copyright 2017 MongoDB, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MONGOC_PREPARED_H
+#define MONGOC_PREPARED_H
+
+#if !defined(MONGOC_INSIDE) && !defined(MONGOC_COMPILATION)
+#error "Only <mongoc.h> can be included directly."
+#endif
+
+#include <bson.h>
+
+#include "mongoc-collection.h"
+#include "mongoc-cursor.h"
+#include "mongoc-read-prefs.h"
+
+BSON_BEGIN_DECLS
+
+typedef struct _mongoc_prepared_find_t mongoc_prepared_find_t;
+typedef struct _mongoc_prepared_count_t mongoc_prepared_count_t;
+
+BSON_EXPORT (mongoc_prepared_find_t *)
+mongoc_prepared_find_new (mongoc_collection_t *collection,
+                          const bson_t *opts,
+                          const mongoc_read_prefs_t *read_prefs,
+                          bson_error_t *error);
+
+BSON_EXPORT (mongoc_cursor_t *)
+mongoc_prepared_find_execute (const mongoc_prepared_find_t *prepared,
+                              const bson_t *filter);
+
+BSON_EXPORT (void)
+mongoc_prepared_find_destroy (mongoc_prepared_find_t *prepared);
+
+BSON_EXPORT (mongoc_prepared_count_t *)
+mongoc_prepared_count_new (mongoc_collection_t *collection,
+                           mongoc_query_flags_t flags,
+                           const bson_t *opts,
+                           const mongoc_read_prefs_t *read_prefs,
+                           bson_error_t *error);
+
+BSON_EXPORT (int64_t)
+mongoc_prepared_count_execute (const mongoc_prepared_count_t *prepared,
+                               const bson_t *query,
+                               int64_t skip,
+                               int64_t limit,
+                               bson_error_t *error);
+
+BSON_EXPORT (void)
+mongoc_prepared_count_destroy (mongoc_prepared_count_t *prepared);
+
+BSON_END_DECLS
+
+
+#endif /* MONGOC_PREPARED_H */
@@ -0,0 +1,105 @@
+/*
+ * Copyright 2017 MongoDB, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MONGOC_QUERY_CACHE_PRIVATE_H
+#define MONGOC_QUERY_CACHE_PRIVATE_H
+
+#if !defined(MONGOC_COMPILATION)
+#error "Only <mongoc.h> can be included directly."
+#endif
+
+#include <bson.h>
+
+#include "mongoc-array-private.h"
+#include "mongoc-cursor.h"
+#include "mongoc-thread-private.h"
+
+BSON_BEGIN_DECLS
+
+
+/* the results of one find, keyed by namespace, filter, opts, read prefs and
+ * read concern. "reply" is like a find command reply with every document in
+ * firstBatch, so it can be returned by mongoc_cursor_new_from_command_reply */
+typedef struct _mongoc_query_cache_entry_t {
+   uint32_t hash;
+   bson_t *key;
+   bson_t *reply;
+   char *ns;
+   uint32_t server_id;
+   int64_t expires; /* monotonic time, in microseconds */
+   int64_t last_used;
+   size_t size;
+} mongoc_query_cache_entry_t;
+
+
+/* opt-in cache shared by the clients of a pool. entries expire after
+ * ttl_msec, the least recently used are evicted to stay under max_bytes */
+typedef struct _mongoc_query_cache_t {
+   mongoc_mutex_t mutex;
+   int64_t ttl_msec; /* 0 if disabled */
+   size_t max_bytes;
+   size_t bytes;
+   uint32_t generation; /* changed by invalidation */
+   mongoc_array_t entries; /* of mongoc_query_cache_entry_t * */
+} mongoc_query_cache_t;
+
+
+/* the documents a cursor returned so far, cached once it is exhausted */
+typedef struct _mongoc_query_cache_fill_t {
+   mongoc_query_cache_t *cache;
+   bson_t *key;
+   uint32_t hash;
+   uint32_t generation;
+   size_t max_bytes;
+   bson_t docs;
+   uint32_t n_docs;
+   bool overflow; /* too large to cache */
+} mongoc_query_cache_fill_t;
+
+
+mongoc_query_cache_t *
+_mongoc_query_cache_new (void);
+
+void
+_mongoc_query_cache_destroy (mongoc_query_cache_t *cache);
+
+void
+_mongoc_query_cache_configure (mongoc_query_cache_t *cache,
+                               int64_t ttl_msec,
+                               size_t max_bytes);
+
+void
+_mongoc_query_cache_invalidate (mongoc_query_cache_t *cache, const char *ns);
+
+mongoc_cursor_t *
+_mongoc_query_cache_find (mongoc_query_cache_t *cache,
+                          mongoc_cursor_t *cursor);
+
+void
+_mongoc_query_cache_fill_add (mongoc_query_cache_fill_t *fill,
+                              const bson_t *doc);
+
+void
+_mongoc_query_cache_fill_finish (mongoc_cursor_t *cursor);
+
+void
+_mongoc_query_cache_fill_destroy (mongoc_query_cache_fill_t *fill);
+
+
+BSON_END_DECLS
+
+
+#endif /* MONGOC_QUERY_CACHE_PRIVATE_H */
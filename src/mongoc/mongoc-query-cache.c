@@ -0,0 +1,516 @@
+/*
+ * Copyright 2017 MongoDB, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "mongoc-counters-private.h"
+#include "mongoc-cursor-private.h"
+#include "mongoc-query-cache-private.h"
+#include "mongoc-read-concern.h"
+#include "mongoc-read-prefs.h"
+#include "mongoc-trace-private.h"
+
+
+#undef MONGOC_LOG_DOMAIN
+#define MONGOC_LOG_DOMAIN "query-cache"
+
+
+mongoc_query_cache_t *
+_mongoc_query_cache_new (void)
+{
+   mongoc_query_cache_t *cache;
+
+   cache = (mongoc_query_cache_t *) bson_malloc0 (sizeof *cache);
+   mongoc_mutex_init (&cache->mutex);
+   _mongoc_array_init (&cache->entries, sizeof (mongoc_query_cache_entry_t *));
+
+   return cache;
+}
+
+
+static void
+_mongoc_query_cache_entry_destroy (mongoc_query_cache_entry_t *entry)
+{
+   bson_destroy (entry->key);
+   bson_destroy (entry->reply);
+   bson_free (entry->ns);
+   bson_free (entry);
+}
+
+
+/* remove the entry at index i. the last entry takes its place */
+static void
+_mongoc_query_cache_remove (mongoc_query_cache_t *cache, size_t i)
+{
+   mongoc_query_cache_entry_t **entries;
+
+   entries = (mongoc_query_cache_entry_t **) cache->entries.data;
+
+   cache->bytes -= entries[i]->size;
+   _mongoc_query_cache_entry_destroy (entries[i]);
+   entries[i] = entries[--cache->entries.len];
+}
+
+
+static void
+_mongoc_query_cache_clear (mongoc_query_cache_t *cache)
+{
+   while (cache->entries.len) {
+      _mongoc_query_cache_remove (cache, cache->entries.len - 1);
+   }
+}
+
+
+void
+_mongoc_query_cache_destroy (mongoc_query_cache_t *cache)
+{
+   if (!cache) {
+      return;
+   }
+
+   _mongoc_query_cache_clear (cache);
+   _mongoc_array_destroy (&cache->entries);
+   mongoc_mutex_destroy (&cache->mutex);
+   bson_free (cache);
+}
+
+
+/* drop expired entries, then the least recently used until "size" more
+ * bytes fit. called with the mutex locked */
+static void
+_mongoc_query_cache_evict (mongoc_query_cache_t *cache,
+                           size_t size,
+                           int64_t now)
+{
+   mongoc_query_cache_entry_t **entries;
+   size_t i;
+   size_t lru;
+
+   entries = (mongoc_query_cache_entry_t **) cache->entries.data;
+
+   i = 0;
+   while (i < cache->entries.len) {
+      if (entries[i]->expires <= now) {
+         _mongoc_query_cache_remove (cache, i);
+         mongoc_counter_query_cache_evictions_inc ();
+      } else {
+         i++;
+      }
+   }
+
+   while (cache->entries.len && cache->bytes + size > cache->max_bytes) {
+      lru = 0;
+      for (i = 1; i < cache->entries.len; i++) {
+         if (entries[i]->last_used < entries[lru]->last_used) {
+            lru = i;
+         }
+      }
+
+      _mongoc_query_cache_remove (cache, lru);
+      mongoc_counter_query_cache_evictions_inc ();
+   }
+}
+
+
+void
+_mongoc_query_cache_configure (mongoc_query_cache_t *cache,
+                               int64_t ttl_msec,
+                               size_t max_bytes)
+{
+   mongoc_mutex_lock (&cache->mutex);
+
+   cache->ttl_msec = BSON_MAX (ttl_msec, 0);
+   cache->max_bytes = max_bytes;
+
+   /* cursors filling the cache now may have used the old settings */
+   cache->generation++;
+
+   if (!cache->ttl_msec) {
+      _mongoc_query_cache_clear (cache);
+   } else {
+      _mongoc_query_cache_evict (cache, 0, bson_get_monotonic_time ());
+   }
+
+   mongoc_mutex_unlock (&cache->mutex);
+}
+
+
+void
+_mongoc_query_cache_invalidate (mongoc_query_cache_t *cache, const char *ns)
+{
+   mongoc_query_cache_entry_t **entries;
+   size_t i;
+
+   mongoc_mutex_lock (&cache->mutex);
+
+   /* results read before the invalidation aren't cached afterward */
+   cache->generation++;
+
+   if (!ns) {
+      _mongoc_query_cache_clear (cache);
+   } else {
+      entries = (mongoc_query_cache_entry_t **) cache->entries.data;
+      i = 0;
+      while (i < cache->entries.len) {
+         if (!strcmp (entries[i]->ns, ns)) {
+            _mongoc_query_cache_remove (cache, i);
+         } else {
+            i++;
+         }
+      }
+   }
+
+   mongoc_mutex_unlock (&cache->mutex);
+}
+
+
+/* the cursor's find, or NULL if its results aren't cached */
+static bson_t *
+_mongoc_query_cache_key (const mongoc_cursor_t *cursor)
+{
+   bson_t *key;
+   bson_t child;
+   mongoc_read_mode_t mode;
+   const bson_t *tags;
+   const char *level;
+
+   if (cursor->error.domain || cursor->is_command || cursor->decoded.tailable ||
+       cursor->decoded.exhaust) {
+      return NULL;
+   }
+
+   key = bson_new ();
+   BSON_APPEND_UTF8 (key, "ns", cursor->ns);
+   BSON_APPEND_DOCUMENT (key, "filter", &cursor->filter);
+   BSON_APPEND_DOCUMENT (key, "opts", &cursor->opts);
+
+   if (cursor->server_id_set) {
+      BSON_APPEND_INT64 (key, "serverId", (int64_t) cursor->server_id);
+   }
+
+   BSON_APPEND_DOCUMENT_BEGIN (key, "readPrefs", &child);
+   mode = mongoc_read_prefs_get_mode (cursor->read_prefs);
+   BSON_APPEND_INT32 (&child, "mode", (int32_t) mode);
+   tags = mongoc_read_prefs_get_tags (cursor->read_prefs);
+   if (tags) {
+      BSON_APPEND_ARRAY (&child, "tags", tags);
+   }
+   BSON_APPEND_INT64 (
+      &child,
+      "maxStalenessSeconds",
+      mongoc_read_prefs_get_max_staleness_seconds (cursor->read_prefs));
+   bson_append_document_end (key, &child);
+
+   level = mongoc_read_concern_get_level (cursor->read_concern);
+   if (level) {
+      BSON_APPEND_UTF8 (key, "readConcern", level);
+   }
+
+   return key;
+}
+
+
+/* FNV-1a */
+static uint32_t
+_mongoc_query_cache_hash (const bson_t *key)
+{
+   const uint8_t *data;
+   uint32_t hash = 2166136261u;
+   uint32_t i;
+
+   data = bson_get_data (key);
+
+   for (i = 0; i < key->len; i++) {
+      hash ^= data[i];
+      hash *= 16777619u;
+   }
+
+   return hash;
+}
+
+
+static bool
+_mongoc_query_cache_key_equal (const bson_t *a, const bson_t *b)
+{
+   return a->len == b->len &&
+          !memcmp (bson_get_data (a), bson_get_data (b), a->len);
+}
+
+
+/* index of the entry for "key", or -1. called with the mutex locked */
+static ssize_t
+_mongoc_query_cache_lookup (mongoc_query_cache_t *cache,
+                            const bson_t *key,
+                            uint32_t hash)
+{
+   mongoc_query_cache_entry_t **entries;
+   size_t i;
+
+   entries = (mongoc_query_cache_entry_t **) cache->entries.data;
+
+   for (i = 0; i < cache->entries.len; i++) {
+      if (entries[i]->hash == hash &&
+          _mongoc_query_cache_key_equal (entries[i]->key, key)) {
+         return (ssize_t) i;
+      }
+   }
+
+   return -1;
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_query_cache_find --
+ *
+ *       Look up the results of @cursor's find. On a hit, @cursor is
+ *       destroyed and a cursor over a copy of the cached reply is
+ *       returned. On a miss, @cursor is returned and records the
+ *       documents it returns, see _mongoc_query_cache_fill_finish.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+mongoc_cursor_t *
+_mongoc_query_cache_find (mongoc_query_cache_t *cache,
+                          mongoc_cursor_t *cursor)
+{
+   mongoc_query_cache_entry_t *entry;
+   mongoc_query_cache_fill_t *fill;
+   mongoc_cursor_t *cached;
+   bson_t *key;
+   bson_t *reply = NULL;
+   uint32_t hash;
+   uint32_t server_id = 0;
+   uint32_t generation;
+   size_t max_bytes;
+   ssize_t i;
+   int64_t now;
+   bool enabled;
+
+   ENTRY;
+
+   mongoc_mutex_lock (&cache->mutex);
+   enabled = cache->ttl_msec > 0;
+   mongoc_mutex_unlock (&cache->mutex);
+
+   if (!enabled || !(key = _mongoc_query_cache_key (cursor))) {
+      RETURN (cursor);
+   }
+
+   hash = _mongoc_query_cache_hash (key);
+   now = bson_get_monotonic_time ();
+
+   mongoc_mutex_lock (&cache->mutex);
+
+   i = _mongoc_query_cache_lookup (cache, key, hash);
+   if (i >= 0) {
+      entry = _mongoc_array_index (
+         &cache->entries, mongoc_query_cache_entry_t *, i);
+
+      if (entry->expires <= now) {
+         _mongoc_query_cache_remove (cache, (size_t) i);
+         mongoc_counter_query_cache_evictions_inc ();
+      } else {
+         entry->last_used = now;
+         reply = bson_copy (entry->reply);
+         server_id = entry->server_id;
+      }
+   }
+
+   generation = cache->generation;
+   max_bytes = cache->max_bytes;
+
+   mongoc_mutex_unlock (&cache->mutex);
+
+   if (reply) {
+      mongoc_counter_query_cache_hits_inc ();
+      bson_destroy (key);
+
+      cached = mongoc_cursor_new_from_command_reply (
+         cursor->client, reply, server_id);
+      mongoc_cursor_destroy (cursor);
+
+      RETURN (cached);
+   }
+
+   mongoc_counter_query_cache_misses_inc ();
+
+   fill = (mongoc_query_cache_fill_t *) bson_malloc0 (sizeof *fill);
+   fill->cache = cache;
+   fill->key = key;
+   fill->hash = hash;
+   fill->generation = generation;
+   fill->max_bytes = max_bytes;
+   bson_init (&fill->docs);
+
+   cursor->cache_fill = fill;
+
+   RETURN (cursor);
+}
+
+
+void
+_mongoc_query_cache_fill_add (mongoc_query_cache_fill_t *fill,
+                              const bson_t *doc)
+{
+   char buf[16];
+   const char *key;
+   size_t key_len;
+
+   if (fill->overflow) {
+      return;
+   }
+
+   if ((size_t) fill->docs.len + doc->len > fill->max_bytes) {
+      fill->overflow = true;
+      bson_reinit (&fill->docs);
+      return;
+   }
+
+   key_len = bson_uint32_to_string (fill->n_docs++, &key, buf, sizeof buf);
+   bson_append_document (&fill->docs, key, (int) key_len, doc);
+}
+
+
+/* called with the mutex locked */
+static void
+_mongoc_query_cache_insert (mongoc_query_cache_t *cache,
+                            mongoc_query_cache_entry_t *entry)
+{
+   ssize_t i;
+   int64_t now;
+
+   i = _mongoc_query_cache_lookup (cache, entry->key, entry->hash);
+   if (i >= 0) {
+      /* another cursor with the same find finished first */
+      _mongoc_query_cache_remove (cache, (size_t) i);
+   }
+
+   now = bson_get_monotonic_time ();
+   entry->expires = now + cache->ttl_msec * 1000;
+   entry->last_used = now;
+
+   _mongoc_query_cache_evict (cache, entry->size, now);
+   _mongoc_array_append_val (&cache->entries, entry);
+   cache->bytes += entry->size;
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_query_cache_fill_finish --
+ *
+ *       Called when mongoc_cursor_next returns false. If @cursor returned
+ *       all its results without error, cache them, unless the cache was
+ *       invalidated or reconfigured meanwhile, the results are too large,
+ *       or the cursor's options were changed after the lookup.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+void
+_mongoc_query_cache_fill_finish (mongoc_cursor_t *cursor)
+{
+   mongoc_query_cache_fill_t *fill;
+   mongoc_query_cache_t *cache;
+   mongoc_query_cache_entry_t *entry;
+   bson_t *key;
+   bson_t *reply;
+   bson_t child;
+
+   ENTRY;
+
+   fill = cursor->cache_fill;
+   cursor->cache_fill = NULL;
+
+   if (!fill) {
+      EXIT;
+   }
+
+   cache = fill->cache;
+
+   if (fill->overflow || cursor->error.domain ||
+       mongoc_cursor_get_id (cursor)) {
+      GOTO (done);
+   }
+
+   /* the cursor's options may have changed since the lookup */
+   key = _mongoc_query_cache_key (cursor);
+   if (!key) {
+      GOTO (done);
+   }
+
+   if (!_mongoc_query_cache_key_equal (key, fill->key)) {
+      bson_destroy (key);
+      GOTO (done);
+   }
+
+   bson_destroy (key);
+
+   reply = bson_new ();
+   BSON_APPEND_DOCUMENT_BEGIN (reply, "cursor", &child);
+   BSON_APPEND_INT64 (&child, "id", 0);
+   BSON_APPEND_UTF8 (&child, "ns", cursor->ns);
+   BSON_APPEND_ARRAY (&child, "firstBatch", &fill->docs);
+   bson_append_document_end (reply, &child);
+   BSON_APPEND_DOUBLE (reply, "ok", 1.0);
+
+   entry = (mongoc_query_cache_entry_t *) bson_malloc0 (sizeof *entry);
+   entry->hash = fill->hash;
+   entry->key = fill->key;
+   entry->reply = reply;
+   entry->ns = bson_strdup (cursor->ns);
+   entry->server_id = cursor->server_id;
+   entry->size = sizeof *entry + entry->key->len + reply->len;
+   fill->key = NULL;
+
+   mongoc_mutex_lock (&cache->mutex);
+
+   if (cache->ttl_msec && fill->generation == cache->generation &&
+       entry->size <= cache->max_bytes) {
+      _mongoc_query_cache_insert (cache, entry);
+      entry = NULL;
+   }
+
+   mongoc_mutex_unlock (&cache->mutex);
+
+   if (entry) {
+      _mongoc_query_cache_entry_destroy (entry);
+   }
+
+done:
+   _mongoc_query_cache_fill_destroy (fill);
+
+   EXIT;
+}
+
+
+void
+_mongoc_query_cache_fill_destroy (mongoc_query_cache_fill_t *fill)
+{
+   if (!fill) {
+      return;
+   }
+
+   if (fill->key) {
+      bson_destroy (fill->key);
+   }
+
+   bson_destroy (&fill->docs);
+   bson_free (fill);
+}
@@ -33,6 +33,14 @@
 BSON_BEGIN_DECLS
 
 
+/* OP_MSG flagBits: the sender will not wait for (and the server must not
+ * send) a reply */
+#define MONGOC_OP_MSG_FLAG_MORE_TO_COME (1u << 1)
+/* OP_MSG section kinds */
+#define MONGOC_OP_MSG_SECTION_BODY 0
+#define MONGOC_OP_MSG_SECTION_DOCUMENT_SEQUENCE 1
+
+
 #define RPC(_name, _code) \
    typedef struct {       \
       _code               \
@@ -30,6 +30,10 @@
 #define MONGOC_LOG_DOMAIN "stream-gridfs"
 
 
+/* a sequential stream reads ahead about this many bytes of chunks */
+#define MONGOC_STREAM_GRIDFS_READ_AHEAD (8 * 1024 * 1024)
+
+
 typedef struct {
    mongoc_stream_t stream;
    mongoc_gridfs_file_t *file;
@@ -180,3 +184,26 @@ mongoc_stream_gridfs_new (mongoc_gridfs_file_t *file)
 
    RETURN ((mongoc_stream_t *) stream);
 }
+
+
+/* unless the file has a read-ahead window already, keep the next chunks in
+ * flight so that reading from start to end rarely waits for a round trip */
+mongoc_stream_t *
+mongoc_stream_gridfs_new_sequential (mongoc_gridfs_file_t *file)
+{
+   int32_t chunk_size;
+
+   ENTRY;
+
+   BSON_ASSERT (file);
+
+   chunk_size = mongoc_gridfs_file_get_chunk_size (file);
+
+   if (chunk_size > 0 && !mongoc_gridfs_file_get_read_ahead (file)) {
+      mongoc_gridfs_file_set_read_ahead (
+         file,
+         (uint32_t) BSON_MAX (1, MONGOC_STREAM_GRIDFS_READ_AHEAD / chunk_size));
+   }
+
+   RETURN (mongoc_stream_gridfs_new (file));
+}
@@ -32,6 +32,8 @@ BSON_BEGIN_DECLS
 
 BSON_EXPORT (mongoc_stream_t *)
 mongoc_stream_gridfs_new (mongoc_gridfs_file_t *file);
+BSON_EXPORT (mongoc_stream_t *)
+mongoc_stream_gridfs_new_sequential (mongoc_gridfs_file_t *file);
 
 
 BSON_END_DECLS
@@ -115,6 +115,11 @@ mongoc_topology_server_timestamp (mongoc_topology_t *topology, uint32_t id);
 mongoc_topology_description_type_t
 _mongoc_topology_get_type (mongoc_topology_t *topology);
 
+void
+_mongoc_topology_suitable_server_ids (mongoc_topology_t *topology,
+                                      mongoc_ss_optype_t optype,
+                                      mongoc_array_t *server_ids);
+
 bool
 _mongoc_topology_start_background_scanner (mongoc_topology_t *topology);
 
@@ -911,6 +911,52 @@ _mongoc_topology_get_type (mongoc_topology_t *topology)
    return td_type;
 }
 
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_topology_suitable_server_ids --
+ *
+ *      Append to @server_ids, an array of uint32_t, the id of each server
+ *      suitable for @optype with the primary read preference, within the
+ *      latency window. Unlike mongoc_topology_select_server_id, this does
+ *      not wait for a suitable server to be discovered.
+ *
+ *      NOTE: this method uses @topology's mutex.
+ *
+ *--------------------------------------------------------------------------
+ */
+void
+_mongoc_topology_suitable_server_ids (mongoc_topology_t *topology,
+                                      mongoc_ss_optype_t optype,
+                                      mongoc_array_t *server_ids)
+{
+   mongoc_array_t suitable_servers;
+   mongoc_server_description_t *sd;
+   size_t i;
+
+   _mongoc_array_init (&suitable_servers,
+                       sizeof (mongoc_server_description_t *));
+
+   mongoc_mutex_lock (&topology->mutex);
+
+   mongoc_topology_description_suitable_servers (
+      &suitable_servers,
+      optype,
+      &topology->description,
+      NULL,
+      (size_t) topology->local_threshold_msec);
+
+   for (i = 0; i < suitable_servers.len; i++) {
+      sd = _mongoc_array_index (
+         &suitable_servers, mongoc_server_description_t *, i);
+      _mongoc_array_append_val (server_ids, sd->id);
+   }
+
+   mongoc_mutex_unlock (&topology->mutex);
+
+   _mongoc_array_destroy (&suitable_servers);
+}
+
 /*
  *--------------------------------------------------------------------------
  *
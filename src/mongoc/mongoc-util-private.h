@@ -85,6 +85,11 @@ _mongoc_get_server_id_from_opts (const bson_t *opts,
 bool
 _mongoc_validate_new_document (const bson_t *insert, bson_error_t *error);
 
+bool
+_mongoc_validate_new_document_find_id (const bson_t *insert,
+                                       bool *has_id /* OUT */,
+                                       bson_error_t *error);
+
 bool
 _mongoc_validate_replace (const bson_t *insert, bson_error_t *error);
 
@@ -17,6 +17,15 @@
 
 #include <string.h>
 
+#if defined(__SSE2__) || defined(_M_X64) || \
+   (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define MONGOC_UTF8_SCAN_SSE2
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define MONGOC_UTF8_SCAN_NEON
+#endif
+
 #include "mongoc-util-private.h"
 #include "mongoc-client.h"
 #include "mongoc-trace-private.h"
@@ -196,10 +205,256 @@ const bson_validate_flags_t insert_vflags =
    (bson_validate_flags_t) BSON_VALIDATE_UTF8 | BSON_VALIDATE_EMPTY_KEYS |
    BSON_VALIDATE_DOT_KEYS | BSON_VALIDATE_DOLLAR_KEYS;
 
+
+/* deeper documents are left to bson_validate */
+#define FAST_VALIDATE_MAX_DEPTH 100
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_utf8_fast_validate --
+ *
+ *       Check that @len bytes at @str are UTF-8 without embedded NULs, as
+ *       bson_utf8_validate (str, len, false) does. Plain ASCII, the common
+ *       case, is scanned 16 bytes at a time with SSE2 or NEON where
+ *       available; once a multi-byte sequence is found the rest of the
+ *       string is handed to bson_utf8_validate.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+static bool
+_mongoc_utf8_fast_validate (const uint8_t *str, size_t len)
+{
+   size_t i = 0;
+
+#if defined(MONGOC_UTF8_SCAN_SSE2)
+   const __m128i zero = _mm_setzero_si128 ();
+   __m128i chunk;
+
+   for (; i + 16 <= len; i += 16) {
+      chunk = _mm_loadu_si128 ((const __m128i *) (str + i));
+      /* high bit set in any byte, or any byte equal to zero */
+      if (_mm_movemask_epi8 (
+             _mm_or_si128 (chunk, _mm_cmpeq_epi8 (chunk, zero)))) {
+         break;
+      }
+   }
+#elif defined(MONGOC_UTF8_SCAN_NEON)
+   uint8x16_t chunk;
+
+   for (; i + 16 <= len; i += 16) {
+      chunk = vld1q_u8 (str + i);
+      /* min byte of zero means a NUL, max byte >= 0x80 means non-ASCII */
+      if (vminvq_u8 (chunk) == 0 || vmaxvq_u8 (chunk) >= 0x80) {
+         break;
+      }
+   }
+#endif
+
+   for (; i < len; i++) {
+      if (str[i] == 0 || str[i] >= 0x80) {
+         return bson_utf8_validate (
+            (const char *) str + i, len - i, false /* allow_null */);
+      }
+   }
+
+   return true;
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_validate_fast --
+ *
+ *       Single pass over a BSON document that checks it the way
+ *       bson_validate with insert_vflags would, and notes whether the
+ *       top-level document has an "_id" field.
+ *
+ *       This is deliberately conservative: it returns true only if the
+ *       document is certainly valid. Anything unusual - "$" keys (which
+ *       may be DBRefs), non-ASCII keys, rare element types, malformed
+ *       lengths - makes it return false and the caller falls back to
+ *       bson_validate, so results never differ from bson_validate's.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+static bool
+_mongoc_validate_fast (const uint8_t *data,
+                       uint32_t len,
+                       int depth,
+                       bool *has_id /* OUT */)
+{
+   const uint8_t *end;
+   const uint8_t *key;
+   uint32_t doc_len;
+   uint32_t l;
+   uint8_t type;
+
+   if (depth > FAST_VALIDATE_MAX_DEPTH || len < 5) {
+      return false;
+   }
+
+   memcpy (&doc_len, data, sizeof doc_len);
+   if (BSON_UINT32_FROM_LE (doc_len) != len || data[len - 1] != '\0') {
+      return false;
+   }
+
+   data += 4;
+   end = data + len - 5; /* position of the trailing NUL */
+
+   while (data < end) {
+      type = *data++;
+      key = data;
+
+      /* scan the key: ASCII, non-empty, no '.', must not start with '$' */
+      if (*key == '\0' || *key == '$') {
+         return false;
+      }
+
+      while (data < end && *data) {
+         if (*data == '.' || *data >= 0x80) {
+            return false;
+         }
+         data++;
+      }
+
+      if (data == end) {
+         return false;
+      }
+
+      if (has_id && data - key == 3 && !memcmp (key, "_id", 3)) {
+         *has_id = true;
+      }
+
+      data++; /* key terminator */
+
+#define FAST_VALIDATE_NEED(n)             \
+   do {                                   \
+      if ((size_t) (end - data) < (n)) {  \
+         return false;                    \
+      }                                   \
+   } while (0)
+
+      switch (type) {
+      case BSON_TYPE_DOUBLE:
+      case BSON_TYPE_DATE_TIME:
+      case BSON_TYPE_TIMESTAMP:
+      case BSON_TYPE_INT64:
+         FAST_VALIDATE_NEED (8);
+         data += 8;
+         break;
+      case BSON_TYPE_INT32:
+         FAST_VALIDATE_NEED (4);
+         data += 4;
+         break;
+      case BSON_TYPE_OID:
+         FAST_VALIDATE_NEED (12);
+         data += 12;
+         break;
+      case BSON_TYPE_DECIMAL128:
+         FAST_VALIDATE_NEED (16);
+         data += 16;
+         break;
+      case BSON_TYPE_BOOL:
+         FAST_VALIDATE_NEED (1);
+         if (*data > 1) {
+            return false;
+         }
+         data++;
+         break;
+      case BSON_TYPE_UNDEFINED:
+      case BSON_TYPE_NULL:
+      case BSON_TYPE_MAXKEY:
+      case BSON_TYPE_MINKEY:
+         break;
+      case BSON_TYPE_UTF8:
+         FAST_VALIDATE_NEED (4);
+         memcpy (&l, data, sizeof l);
+         l = BSON_UINT32_FROM_LE (l);
+         data += 4;
+         if (l < 1 || l > (size_t) (end - data) || data[l - 1] != '\0' ||
+             !_mongoc_utf8_fast_validate (data, l - 1)) {
+            return false;
+         }
+         data += l;
+         break;
+      case BSON_TYPE_DOCUMENT:
+      case BSON_TYPE_ARRAY:
+         FAST_VALIDATE_NEED (4);
+         memcpy (&l, data, sizeof l);
+         l = BSON_UINT32_FROM_LE (l);
+         if (l > (size_t) (end - data) ||
+             !_mongoc_validate_fast (data, l, depth + 1, NULL)) {
+            return false;
+         }
+         data += l;
+         break;
+      case BSON_TYPE_BINARY:
+         FAST_VALIDATE_NEED (5);
+         memcpy (&l, data, sizeof l);
+         l = BSON_UINT32_FROM_LE (l);
+         /* the old binary subtype has a nested length, let libbson check */
+         if (data[4] == BSON_SUBTYPE_BINARY_DEPRECATED ||
+             l > (size_t) (end - data) - 5) {
+            return false;
+         }
+         data += 5 + l;
+         break;
+      default:
+         /* regex, code, symbol, DBPointer, code with scope, unknown */
+         return false;
+      }
+
+#undef FAST_VALIDATE_NEED
+   }
+
+   return true;
+}
+
+
+static bool
+_mongoc_validate_insert_doc (const bson_t *doc, bool *has_id)
+{
+   if (has_id) {
+      *has_id = false;
+   }
+
+   if (_mongoc_validate_fast (bson_get_data (doc), doc->len, 0, has_id)) {
+      return true;
+   }
+
+   if (!bson_validate (doc, insert_vflags, NULL)) {
+      return false;
+   }
+
+   /* valid, but the fast path gave up before it could see every key */
+   if (has_id) {
+      *has_id = bson_has_field (doc, "_id");
+   }
+
+   return true;
+}
+
+
 bool
 _mongoc_validate_new_document (const bson_t *doc, bson_error_t *error)
 {
-   if (!bson_validate (doc, insert_vflags, NULL)) {
+   return _mongoc_validate_new_document_find_id (doc, NULL, error);
+}
+
+
+/* validate a document to insert and, in the same pass, check whether it
+ * has an "_id" field so the caller need not search for one */
+bool
+_mongoc_validate_new_document_find_id (const bson_t *doc,
+                                       bool *has_id /* OUT */,
+                                       bson_error_t *error)
+{
+   if (!_mongoc_validate_insert_doc (doc, has_id)) {
       bson_set_error (error,
                       MONGOC_ERROR_COMMAND,
                       MONGOC_ERROR_COMMAND_INVALID_ARG,
@@ -214,7 +469,7 @@ _mongoc_validate_new_document (const bson_t *doc, bson_error_t *error)
 bool
 _mongoc_validate_replace (const bson_t *doc, bson_error_t *error)
 {
-   if (!bson_validate (doc, insert_vflags, NULL)) {
+   if (!_mongoc_validate_insert_doc (doc, NULL)) {
       bson_set_error (error,
                       MONGOC_ERROR_COMMAND,
                       MONGOC_ERROR_COMMAND_INVALID_ARG,
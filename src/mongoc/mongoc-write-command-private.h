@@ -23,6 +23,7 @@
 
 #include <bson.h>
 
+#include "mongoc-array-private.h"
 #include "mongoc-client.h"
 #include "mongoc-error.h"
 #include "mongoc-write-concern.h"
@@ -64,6 +65,24 @@ typedef struct {
 } mongoc_write_command_t;
 
 
+/* one entry of a write result's "upserted" array */
+typedef struct {
+   int32_t index; /* into the whole bulk operation, not the batch */
+   bson_value_t id;
+} mongoc_write_result_upsert_t;
+
+
+/* one entry of a write result's "writeErrors" array */
+typedef struct {
+   int32_t index; /* into the whole bulk operation, not the batch */
+   /* the error as the server sent it, like {"index": int, "code": int,
+    * "errmsg": str}; its "index" is relative to the batch */
+   bson_t *doc;
+} mongoc_write_result_error_t;
+
+
+/* Batch results are kept in native arrays and only converted to BSON by
+ * _mongoc_write_result_complete, if the caller asks for a reply. */
 typedef struct {
    /* true after a legacy update prevents us from calculating nModified */
    bool omit_nModified;
@@ -72,17 +91,16 @@ typedef struct {
    uint32_t nModified;
    uint32_t nRemoved;
    uint32_t nUpserted;
-   /* like [{"index": int, "_id": value}, ...] */
-   bson_t writeErrors;
-   /* like [{"index": int, "code": int, "errmsg": str}, ...] */
-   bson_t upserted;
+   /* array of mongoc_write_result_error_t, allocated on first use */
+   mongoc_array_t writeErrors;
+   /* array of mongoc_write_result_upsert_t, allocated on first use */
+   mongoc_array_t upserted;
    /* like [{"code": 64, "errmsg": "duplicate"}, ...] */
    uint32_t n_writeConcernErrors;
    bson_t writeConcernErrors;
    bool failed;    /* The command failed */
    bool must_stop; /* The stream may have been disonnected */
    bson_error_t error;
-   uint32_t upsert_append_count;
 } mongoc_write_result_t;
 
 
@@ -110,6 +128,12 @@ _mongoc_write_command_init_update (mongoc_write_command_t *command,
 void
 _mongoc_write_command_insert_append (mongoc_write_command_t *command,
                                      const bson_t *document);
+bool
+_mongoc_write_command_insert_append_validated (
+   mongoc_write_command_t *command,
+   const bson_t *document,
+   bool validate,
+   bson_error_t *error);
 void
 _mongoc_write_command_update_append (mongoc_write_command_t *command,
                                      const bson_t *selector,
@@ -121,6 +145,12 @@ _mongoc_write_command_delete_append (mongoc_write_command_t *command,
                                      const bson_t *selector,
                                      const bson_t *opts);
 
+void
+_mongoc_write_command_init_slice (mongoc_write_command_t *slice,
+                                  const mongoc_write_command_t *command,
+                                  uint32_t first,
+                                  uint32_t n);
+
 void
 _mongoc_write_command_execute (mongoc_write_command_t *command,
                                mongoc_client_t *client,
@@ -138,6 +168,9 @@ _mongoc_write_result_merge (mongoc_write_result_t *result,
                             const bson_t *reply,
                             uint32_t offset);
 void
+_mongoc_write_result_merge_result (mongoc_write_result_t *result,
+                                   mongoc_write_result_t *part);
+void
 _mongoc_write_result_merge_legacy (mongoc_write_result_t *result,
                                    mongoc_write_command_t *command,
                                    const bson_t *reply,
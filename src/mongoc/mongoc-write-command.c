@@ -53,9 +53,8 @@ static const char *gCommandFields[] = {"deletes", "documents", "updates"};
 static const uint32_t gCommandFieldLens[] = {7, 9, 7};
 
 static int32_t
-_mongoc_write_result_merge_arrays (uint32_t offset,
+_mongoc_write_result_merge_errors (uint32_t offset,
                                    mongoc_write_result_t *result,
-                                   bson_t *dest,
                                    bson_iter_t *iter);
 
 static bool
@@ -67,12 +66,12 @@ _is_duplicate_key_error (int32_t code)
 }
 
 
-void
-_mongoc_write_command_insert_append (mongoc_write_command_t *command,
-                                     const bson_t *document)
+static void
+_mongoc_write_command_insert_append_internal (mongoc_write_command_t *command,
+                                              const bson_t *document,
+                                              bool has_id)
 {
    const char *key;
-   bson_iter_t iter;
    bson_oid_t oid;
    bson_t tmp;
    char keydata[16];
@@ -93,7 +92,7 @@ _mongoc_write_command_insert_append (mongoc_write_command_t *command,
     * If the document does not contain an "_id" field, we need to generate
     * a new oid for "_id".
     */
-   if (!bson_iter_init_find (&iter, document, "_id")) {
+   if (!has_id) {
       bson_init (&tmp);
       bson_oid_init (&oid, NULL);
       BSON_APPEND_OID (&tmp, "_id", &oid);
@@ -109,6 +108,55 @@ _mongoc_write_command_insert_append (mongoc_write_command_t *command,
    EXIT;
 }
 
+
+void
+_mongoc_write_command_insert_append (mongoc_write_command_t *command,
+                                     const bson_t *document)
+{
+   _mongoc_write_command_insert_append_internal (
+      command, document, bson_has_field (document, "_id"));
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_write_command_insert_append_validated --
+ *
+ *       Like _mongoc_write_command_insert_append, but if @validate is true
+ *       first check @document's keys and UTF-8 strings. Validation and the
+ *       search for "_id" share a single pass over the document.
+ *
+ * Returns:
+ *       true if @document was appended, false and sets @error if it is
+ *       invalid.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+bool
+_mongoc_write_command_insert_append_validated (
+   mongoc_write_command_t *command,
+   const bson_t *document,
+   bool validate,
+   bson_error_t *error)
+{
+   bool has_id;
+
+   if (validate) {
+      if (!_mongoc_validate_new_document_find_id (document, &has_id, error)) {
+         return false;
+      }
+   } else {
+      has_id = bson_has_field (document, "_id");
+   }
+
+   _mongoc_write_command_insert_append_internal (command, document, has_id);
+
+   return true;
+}
+
+
 void
 _mongoc_write_command_update_append (mongoc_write_command_t *command,
                                      const bson_t *selector,
@@ -1244,6 +1292,7 @@ _mongoc_write_command (mongoc_write_command_t *command,
    int32_t min_wire_version;
    uint32_t overhead;
    uint32_t key_len;
+   bool fire_and_forget;
 
    ENTRY;
 
@@ -1260,13 +1309,18 @@ _mongoc_write_command (mongoc_write_command_t *command,
       mongoc_server_stream_max_write_batch_size (server_stream);
 
    /*
-    * If we have an unacknowledged write and the server supports the legacy
-    * opcodes, then submit the legacy opcode so we don't need to wait for
-    * a response from the server.
+    * If we have an unacknowledged write and the server accepts OP_MSG, send
+    * the write command with the "moreToCome" flag so we don't need to wait
+    * for a response from the server. Otherwise, if the server supports the
+    * legacy opcodes, submit the legacy opcode for the same reason.
     */
 
+   fire_and_forget =
+      !mongoc_write_concern_is_acknowledged (write_concern) &&
+      server_stream->sd->max_wire_version >= WIRE_VERSION_OP_MSG;
+
    min_wire_version = server_stream->sd->min_wire_version;
-   if ((min_wire_version == 0) &&
+   if (!fire_and_forget && (min_wire_version == 0) &&
        !mongoc_write_concern_is_acknowledged (write_concern)) {
       if (command->flags.bypass_document_validation !=
           MONGOC_BYPASS_DOCUMENT_VALIDATION_DEFAULT) {
@@ -1316,9 +1370,11 @@ again:
    i = 0;
 
    _mongoc_write_command_init (&cmd, command, collection, write_concern);
+   /* the OP_MSG body also carries "$db": type byte, key, length, value */
+   overhead = fire_and_forget ? (uint32_t) (10 + strlen (database)) : 0;
 
    /* 1 byte to specify array type, 1 byte for field name's null terminator */
-   overhead = cmd.len + 2 + gCommandFieldLens[command->type];
+   overhead += cmd.len + 2 + gCommandFieldLens[command->type];
 
    if (!_mongoc_write_command_will_overflow (overhead,
                                              command->documents->len,
@@ -1375,6 +1431,21 @@ again:
       too_large_error (error, i, len, max_bson_obj_size, NULL);
       result->failed = true;
       ret = false;
+   } else if (fire_and_forget) {
+      ret = mongoc_cluster_run_command_unacknowledged (&client->cluster,
+                                                       server_stream,
+                                                       database,
+                                                       &cmd,
+                                                       command->operation_id,
+                                                       error);
+
+      if (!ret) {
+         /* the node was disconnected */
+         result->failed = true;
+         result->must_stop = true;
+      }
+
+      offset += i;
    } else {
       ret = mongoc_cluster_run_command_monitored (&client->cluster,
                                                   server_stream,
@@ -1501,6 +1572,45 @@ _mongoc_write_command_destroy (mongoc_write_command_t *command)
 }
 
 
+/* init @slice with @n documents of @command, starting at index @first */
+void
+_mongoc_write_command_init_slice (mongoc_write_command_t *slice,
+                                  const mongoc_write_command_t *command,
+                                  uint32_t first,
+                                  uint32_t n)
+{
+   bson_iter_t iter;
+   const char *key;
+   char str[16];
+   size_t keylen;
+   uint32_t i = 0;
+
+   ENTRY;
+
+   BSON_ASSERT (slice);
+   BSON_ASSERT (command);
+
+   memcpy (slice, command, sizeof *slice);
+   slice->documents = bson_new ();
+   slice->n_documents = 0;
+
+   if (bson_iter_init (&iter, command->documents)) {
+      while (slice->n_documents < n && bson_iter_next (&iter)) {
+         if (i++ < first) {
+            continue;
+         }
+
+         keylen =
+            bson_uint32_to_string (slice->n_documents, &key, str, sizeof str);
+         bson_append_iter (slice->documents, key, (int) keylen, &iter);
+         slice->n_documents++;
+      }
+   }
+
+   EXIT;
+}
+
+
 void
 _mongoc_write_result_init (mongoc_write_result_t *result) /* IN */
 {
@@ -1508,11 +1618,11 @@ _mongoc_write_result_init (mongoc_write_result_t *result) /* IN */
 
    BSON_ASSERT (result);
 
+   /* the upserted and writeErrors arrays stay unallocated (zeroed) until
+    * a batch reports an upsert or an error */
    memset (result, 0, sizeof *result);
 
-   bson_init (&result->upserted);
    bson_init (&result->writeConcernErrors);
-   bson_init (&result->writeErrors);
 
    EXIT;
 }
@@ -1521,13 +1631,29 @@ _mongoc_write_result_init (mongoc_write_result_t *result) /* IN */
 void
 _mongoc_write_result_destroy (mongoc_write_result_t *result)
 {
+   mongoc_write_result_upsert_t *upsert;
+   mongoc_write_result_error_t *write_error;
+   size_t i;
+
    ENTRY;
 
    BSON_ASSERT (result);
 
-   bson_destroy (&result->upserted);
+   for (i = 0; i < result->upserted.len; i++) {
+      upsert = &_mongoc_array_index (
+         &result->upserted, mongoc_write_result_upsert_t, i);
+      bson_value_destroy (&upsert->id);
+   }
+
+   for (i = 0; i < result->writeErrors.len; i++) {
+      write_error = &_mongoc_array_index (
+         &result->writeErrors, mongoc_write_result_error_t, i);
+      bson_destroy (write_error->doc);
+   }
+
+   _mongoc_array_destroy (&result->upserted);
+   _mongoc_array_destroy (&result->writeErrors);
    bson_destroy (&result->writeConcernErrors);
-   bson_destroy (&result->writeErrors);
 
    EXIT;
 }
@@ -1538,23 +1664,49 @@ _mongoc_write_result_append_upsert (mongoc_write_result_t *result,
                                     int32_t idx,
                                     const bson_value_t *value)
 {
-   bson_t child;
-   const char *keyptr = NULL;
-   char key[12];
-   int len;
+   mongoc_write_result_upsert_t upsert;
 
    BSON_ASSERT (result);
    BSON_ASSERT (value);
 
-   len = (int) bson_uint32_to_string (
-      result->upsert_append_count, &keyptr, key, sizeof key);
+   if (!result->upserted.element_size) {
+      _mongoc_array_init (&result->upserted,
+                          sizeof (mongoc_write_result_upsert_t));
+   }
+
+   upsert.index = idx;
+   bson_value_copy (value, &upsert.id);
+   _mongoc_array_append_val (&result->upserted, upsert);
+}
 
-   bson_append_document_begin (&result->upserted, keyptr, len, &child);
-   BSON_APPEND_INT32 (&child, "index", idx);
-   BSON_APPEND_VALUE (&child, "_id", value);
-   bson_append_document_end (&result->upserted, &child);
 
-   result->upsert_append_count++;
+/* store a copy of a server write error like {"index": 0, "code": 1, ...},
+ * whose index is relative to the batch beginning at @offset */
+static void
+_mongoc_write_result_append_error (mongoc_write_result_t *result,
+                                   uint32_t offset,
+                                   const uint8_t *data,
+                                   uint32_t len)
+{
+   mongoc_write_result_error_t write_error;
+   bson_iter_t iter;
+
+   BSON_ASSERT (result);
+
+   if (!result->writeErrors.element_size) {
+      _mongoc_array_init (&result->writeErrors,
+                          sizeof (mongoc_write_result_error_t));
+   }
+
+   write_error.doc = bson_new_from_data (data, len);
+   BSON_ASSERT (write_error.doc);
+   write_error.index = (int32_t) offset;
+   if (bson_iter_init_find (&iter, write_error.doc, "index") &&
+       BSON_ITER_HOLDS_INT32 (&iter)) {
+      write_error.index += bson_iter_int32 (&iter);
+   }
+
+   _mongoc_array_append_val (&result->writeErrors, write_error);
 }
 
 
@@ -1591,8 +1743,7 @@ _append_write_err_legacy (mongoc_write_result_t *result,
                           int32_t code,
                           uint32_t offset)
 {
-   bson_t holder, write_errors, child;
-   bson_iter_t iter;
+   bson_t write_error;
 
    BSON_ASSERT (code > 0);
 
@@ -1603,23 +1754,18 @@ _append_write_err_legacy (mongoc_write_result_t *result,
    /* stop processing, if result->ordered */
    result->failed = true;
 
-   bson_init (&holder);
-   bson_append_array_begin (&holder, "0", 1, &write_errors);
-   bson_append_document_begin (&write_errors, "0", 1, &child);
+   /* set error's "index" to 0, it's relative to the batch at @offset */
+   bson_init (&write_error);
+   bson_append_int32 (&write_error, "index", 5, 0);
+   bson_append_int32 (&write_error, "code", 4, code);
+   bson_append_utf8 (&write_error, "errmsg", 6, err, -1);
 
-   /* set error's "index" to 0; fixed up in _mongoc_write_result_merge_arrays */
-   bson_append_int32 (&child, "index", 5, 0);
-   bson_append_int32 (&child, "code", 4, code);
-   bson_append_utf8 (&child, "errmsg", 6, err, -1);
-   bson_append_document_end (&write_errors, &child);
-   bson_append_array_end (&holder, &write_errors);
-   bson_iter_init (&iter, &holder);
-   bson_iter_next (&iter);
-
-   _mongoc_write_result_merge_arrays (
-      offset, result, &result->writeErrors, &iter);
+   _mongoc_write_result_append_error (result,
+                                      offset,
+                                      bson_get_data (&write_error),
+                                      write_error.len);
 
-   bson_destroy (&holder);
+   bson_destroy (&write_error);
 }
 
 
@@ -1739,48 +1885,26 @@ _mongoc_write_result_merge_legacy (mongoc_write_result_t *result,   /* IN */
 
 
 static int32_t
-_mongoc_write_result_merge_arrays (uint32_t offset,
+_mongoc_write_result_merge_errors (uint32_t offset,
                                    mongoc_write_result_t *result, /* IN */
-                                   bson_t *dest,                  /* IN */
                                    bson_iter_t *iter)             /* IN */
 {
-   const bson_value_t *value;
    bson_iter_t ar;
-   bson_iter_t citer;
-   int32_t idx;
+   const uint8_t *data;
+   uint32_t len;
    int32_t count = 0;
-   int32_t aridx;
-   bson_t child;
-   const char *keyptr = NULL;
-   char key[12];
-   int len;
 
    ENTRY;
 
    BSON_ASSERT (result);
-   BSON_ASSERT (dest);
    BSON_ASSERT (iter);
    BSON_ASSERT (BSON_ITER_HOLDS_ARRAY (iter));
 
-   aridx = bson_count_keys (dest);
-
    if (bson_iter_recurse (iter, &ar)) {
       while (bson_iter_next (&ar)) {
-         if (BSON_ITER_HOLDS_DOCUMENT (&ar) &&
-             bson_iter_recurse (&ar, &citer)) {
-            len =
-               (int) bson_uint32_to_string (aridx++, &keyptr, key, sizeof key);
-            bson_append_document_begin (dest, keyptr, len, &child);
-            while (bson_iter_next (&citer)) {
-               if (BSON_ITER_IS_KEY (&citer, "index")) {
-                  idx = bson_iter_int32 (&citer) + offset;
-                  BSON_APPEND_INT32 (&child, "index", idx);
-               } else {
-                  value = bson_iter_value (&citer);
-                  BSON_APPEND_VALUE (&child, bson_iter_key (&citer), value);
-               }
-            }
-            bson_append_document_end (dest, &child);
+         if (BSON_ITER_HOLDS_DOCUMENT (&ar)) {
+            bson_iter_document (&ar, &len, &data);
+            _mongoc_write_result_append_error (result, offset, data, len);
             count++;
          }
       }
@@ -1883,8 +2007,7 @@ _mongoc_write_result_merge (mongoc_write_result_t *result,   /* IN */
 
    if (bson_iter_init_find (&iter, reply, "writeErrors") &&
        BSON_ITER_HOLDS_ARRAY (&iter)) {
-      _mongoc_write_result_merge_arrays (
-         offset, result, &result->writeErrors, &iter);
+      _mongoc_write_result_merge_errors (offset, result, &iter);
    }
 
    if (bson_iter_init_find (&iter, reply, "writeConcernError") &&
@@ -1913,6 +2036,177 @@ _mongoc_write_result_merge (mongoc_write_result_t *result,   /* IN */
 }
 
 
+static int
+_mongoc_write_result_upsert_cmp (const void *a, const void *b)
+{
+   return ((const mongoc_write_result_upsert_t *) a)->index -
+          ((const mongoc_write_result_upsert_t *) b)->index;
+}
+
+
+static int
+_mongoc_write_result_error_cmp (const void *a, const void *b)
+{
+   return ((const mongoc_write_result_error_t *) a)->index -
+          ((const mongoc_write_result_error_t *) b)->index;
+}
+
+
+/*
+ * Move the counts and details of @part, the result of running other
+ * documents of the same bulk operation, into @result. Indexes in both are
+ * already relative to the whole operation; the merged arrays are kept
+ * sorted by index. @part is left empty but must still be destroyed.
+ */
+void
+_mongoc_write_result_merge_result (mongoc_write_result_t *result,
+                                   mongoc_write_result_t *part)
+{
+   bson_iter_t iter;
+   const char *key;
+   char str[16];
+   size_t keylen;
+
+   ENTRY;
+
+   BSON_ASSERT (result);
+   BSON_ASSERT (part);
+
+   result->omit_nModified |= part->omit_nModified;
+   result->nInserted += part->nInserted;
+   result->nMatched += part->nMatched;
+   result->nModified += part->nModified;
+   result->nRemoved += part->nRemoved;
+   result->nUpserted += part->nUpserted;
+   result->failed |= part->failed;
+   result->must_stop |= part->must_stop;
+
+   if (part->error.domain && !result->error.domain) {
+      memcpy (&result->error, &part->error, sizeof result->error);
+   }
+
+   /* the array entries own their values, so moving them is enough */
+   if (part->upserted.len) {
+      if (!result->upserted.element_size) {
+         _mongoc_array_init (&result->upserted,
+                             sizeof (mongoc_write_result_upsert_t));
+      }
+
+      _mongoc_array_append_vals (
+         &result->upserted, part->upserted.data, (uint32_t) part->upserted.len);
+      part->upserted.len = 0;
+      qsort (result->upserted.data,
+             result->upserted.len,
+             sizeof (mongoc_write_result_upsert_t),
+             _mongoc_write_result_upsert_cmp);
+   }
+
+   if (part->writeErrors.len) {
+      if (!result->writeErrors.element_size) {
+         _mongoc_array_init (&result->writeErrors,
+                             sizeof (mongoc_write_result_error_t));
+      }
+
+      _mongoc_array_append_vals (&result->writeErrors,
+                                 part->writeErrors.data,
+                                 (uint32_t) part->writeErrors.len);
+      part->writeErrors.len = 0;
+      qsort (result->writeErrors.data,
+             result->writeErrors.len,
+             sizeof (mongoc_write_result_error_t),
+             _mongoc_write_result_error_cmp);
+   }
+
+   if (part->n_writeConcernErrors &&
+       bson_iter_init (&iter, &part->writeConcernErrors)) {
+      while (bson_iter_next (&iter)) {
+         keylen = bson_uint32_to_string (
+            result->n_writeConcernErrors, &key, str, sizeof str);
+         bson_append_iter (
+            &result->writeConcernErrors, key, (int) keylen, &iter);
+         result->n_writeConcernErrors++;
+      }
+   }
+
+   EXIT;
+}
+
+
+/*
+ * Accumulates a bson_error_t from a list of error documents like
+ * {"code": 64, "errmsg": "duplicate"}: the code comes from the first
+ * document, the message from all of them.
+ */
+typedef struct {
+   bson_string_t *compound_err;
+   uint32_t n_errors;
+   uint32_t i;
+   int32_t code;
+} _error_from_response_t;
+
+
+static void
+_error_from_response_init (_error_from_response_t *state,
+                           uint32_t n_errors,
+                           const char *error_type)
+{
+   state->compound_err = bson_string_new (NULL);
+   state->n_errors = n_errors;
+   state->i = 0;
+   state->code = 0;
+
+   if (n_errors > 1) {
+      bson_string_append_printf (
+         state->compound_err, "Multiple %s errors: ", error_type);
+   }
+}
+
+
+static void
+_error_from_response_add (_error_from_response_t *state, bson_iter_t *doc_iter)
+{
+   const char *errmsg;
+
+   /* parse doc, which is like {"code": 64, "errmsg": "duplicate"} */
+   while (bson_iter_next (doc_iter)) {
+      /* use the first error code we find */
+      if (BSON_ITER_IS_KEY (doc_iter, "code") && state->code == 0) {
+         state->code = bson_iter_int32 (doc_iter);
+      } else if (BSON_ITER_IS_KEY (doc_iter, "errmsg")) {
+         errmsg = bson_iter_utf8 (doc_iter, NULL);
+
+         /* build message like 'Multiple write errors: "foo", "bar"' */
+         if (state->n_errors > 1) {
+            bson_string_append_printf (
+               state->compound_err, "\"%s\"", errmsg);
+            if (state->i < state->n_errors - 1) {
+               bson_string_append (state->compound_err, ", ");
+            }
+         } else {
+            /* single error message */
+            bson_string_append (state->compound_err, errmsg);
+         }
+      }
+   }
+
+   state->i++;
+}
+
+
+static void
+_error_from_response_finish (_error_from_response_t *state,
+                             mongoc_error_domain_t domain,
+                             bson_error_t *error /* OUT */)
+{
+   if (state->code && state->compound_err->len) {
+      bson_set_error (
+         error, domain, (uint32_t) state->code, "%s", state->compound_err->str);
+   }
+
+   bson_string_free (state->compound_err, true);
+}
+
+
 /*
  * If error is not set, set code from first document in array like
  * [{"code": 64, "errmsg": "duplicate"}, ...]. Format the error message
@@ -1924,59 +2218,107 @@ _set_error_from_response (bson_t *bson_array,
                           const char *error_type,
                           bson_error_t *error /* OUT */)
 {
+   _error_from_response_t state;
    bson_iter_t array_iter;
    bson_iter_t doc_iter;
-   bson_string_t *compound_err;
-   const char *errmsg = NULL;
-   int32_t code = 0;
-   uint32_t n_keys, i;
 
-   compound_err = bson_string_new (NULL);
-   n_keys = bson_count_keys (bson_array);
-   if (n_keys > 1) {
-      bson_string_append_printf (
-         compound_err, "Multiple %s errors: ", error_type);
-   }
+   _error_from_response_init (&state, bson_count_keys (bson_array), error_type);
 
    if (!bson_empty0 (bson_array) && bson_iter_init (&array_iter, bson_array)) {
       /* get first code and all error messages */
-      i = 0;
-
       while (bson_iter_next (&array_iter)) {
          if (BSON_ITER_HOLDS_DOCUMENT (&array_iter) &&
              bson_iter_recurse (&array_iter, &doc_iter)) {
-            /* parse doc, which is like {"code": 64, "errmsg": "duplicate"} */
-            while (bson_iter_next (&doc_iter)) {
-               /* use the first error code we find */
-               if (BSON_ITER_IS_KEY (&doc_iter, "code") && code == 0) {
-                  code = bson_iter_int32 (&doc_iter);
-               } else if (BSON_ITER_IS_KEY (&doc_iter, "errmsg")) {
-                  errmsg = bson_iter_utf8 (&doc_iter, NULL);
-
-                  /* build message like 'Multiple write errors: "foo", "bar"' */
-                  if (n_keys > 1) {
-                     bson_string_append_printf (compound_err, "\"%s\"", errmsg);
-                     if (i < n_keys - 1) {
-                        bson_string_append (compound_err, ", ");
-                     }
-                  } else {
-                     /* single error message */
-                     bson_string_append (compound_err, errmsg);
-                  }
-               }
-            }
-
-            i++;
+            _error_from_response_add (&state, &doc_iter);
          }
       }
+   }
 
-      if (code && compound_err->len) {
-         bson_set_error (
-            error, domain, (uint32_t) code, "%s", compound_err->str);
+   _error_from_response_finish (&state, domain, error);
+}
+
+
+/* like _set_error_from_response, for the native writeErrors array */
+static void
+_set_error_from_write_errors (mongoc_write_result_t *result,
+                              mongoc_error_domain_t domain,
+                              bson_error_t *error /* OUT */)
+{
+   _error_from_response_t state;
+   mongoc_write_result_error_t *write_error;
+   bson_iter_t doc_iter;
+   size_t i;
+
+   if (!result->writeErrors.len) {
+      return;
+   }
+
+   _error_from_response_init (
+      &state, (uint32_t) result->writeErrors.len, "write");
+
+   for (i = 0; i < result->writeErrors.len; i++) {
+      write_error = &_mongoc_array_index (
+         &result->writeErrors, mongoc_write_result_error_t, i);
+      if (bson_iter_init (&doc_iter, write_error->doc)) {
+         _error_from_response_add (&state, &doc_iter);
+      }
+   }
+
+   _error_from_response_finish (&state, domain, error);
+}
+
+
+/* build the reply's "upserted" and "writeErrors" arrays, with indexes
+ * relative to the whole bulk operation */
+static void
+_mongoc_write_result_append_arrays (mongoc_write_result_t *result,
+                                    bson_t *bson /* OUT */)
+{
+   mongoc_write_result_upsert_t *upsert;
+   mongoc_write_result_error_t *write_error;
+   bson_iter_t iter;
+   bson_t ar;
+   bson_t child;
+   const char *keyptr = NULL;
+   char key[12];
+   int len;
+   size_t i;
+
+   if (result->upserted.len) {
+      BSON_APPEND_ARRAY_BEGIN (bson, "upserted", &ar);
+      for (i = 0; i < result->upserted.len; i++) {
+         upsert = &_mongoc_array_index (
+            &result->upserted, mongoc_write_result_upsert_t, i);
+         len = (int) bson_uint32_to_string (
+            (uint32_t) i, &keyptr, key, sizeof key);
+         bson_append_document_begin (&ar, keyptr, len, &child);
+         BSON_APPEND_INT32 (&child, "index", upsert->index);
+         BSON_APPEND_VALUE (&child, "_id", &upsert->id);
+         bson_append_document_end (&ar, &child);
       }
+      bson_append_array_end (bson, &ar);
    }
 
-   bson_string_free (compound_err, true);
+   BSON_APPEND_ARRAY_BEGIN (bson, "writeErrors", &ar);
+   for (i = 0; i < result->writeErrors.len; i++) {
+      write_error = &_mongoc_array_index (
+         &result->writeErrors, mongoc_write_result_error_t, i);
+      len =
+         (int) bson_uint32_to_string ((uint32_t) i, &keyptr, key, sizeof key);
+      bson_append_document_begin (&ar, keyptr, len, &child);
+      if (bson_iter_init (&iter, write_error->doc)) {
+         while (bson_iter_next (&iter)) {
+            if (BSON_ITER_IS_KEY (&iter, "index")) {
+               BSON_APPEND_INT32 (&child, "index", write_error->index);
+            } else {
+               BSON_APPEND_VALUE (
+                  &child, bson_iter_key (&iter), bson_iter_value (&iter));
+            }
+         }
+      }
+      bson_append_document_end (&ar, &child);
+   }
+   bson_append_array_end (bson, &ar);
 }
 
 
@@ -2013,10 +2355,7 @@ _mongoc_write_result_complete (
       }
       BSON_APPEND_INT32 (bson, "nRemoved", result->nRemoved);
       BSON_APPEND_INT32 (bson, "nUpserted", result->nUpserted);
-      if (!bson_empty0 (&result->upserted)) {
-         BSON_APPEND_ARRAY (bson, "upserted", &result->upserted);
-      }
-      BSON_APPEND_ARRAY (bson, "writeErrors", &result->writeErrors);
+      _mongoc_write_result_append_arrays (result, bson);
       if (result->n_writeConcernErrors) {
          BSON_APPEND_ARRAY (
             bson, "writeConcernErrors", &result->writeConcernErrors);
@@ -2024,8 +2363,7 @@ _mongoc_write_result_complete (
    }
 
    /* set bson_error_t from first write error or write concern error */
-   _set_error_from_response (
-      &result->writeErrors, domain, "write", &result->error);
+   _set_error_from_write_errors (result, domain, &result->error);
 
    if (!result->error.code) {
       _set_error_from_response (&result->writeConcernErrors,
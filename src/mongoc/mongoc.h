@@ -27,6 +27,7 @@
 #include "mongoc-client.h"
 #include "mongoc-client-pool.h"
 #include "mongoc-collection.h"
+#include "mongoc-columnar.h"
 #include "mongoc-config.h"
 #include "mongoc-cursor.h"
 #include "mongoc-database.h"
@@ -35,6 +36,7 @@
 #include "mongoc-flags.h"
 #include "mongoc-gridfs.h"
 #include "mongoc-gridfs-file.h"
+#include "mongoc-gridfs-file-download.h"
 #include "mongoc-gridfs-file-list.h"
 #include "mongoc-gridfs-file-page.h"
 #include "mongoc-host-list.h"
@@ -42,6 +44,8 @@
 #include "mongoc-matcher.h"
 #include "mongoc-handshake.h"
 #include "mongoc-opcode.h"
+#include "mongoc-parallel-scan.h"
+#include "mongoc-prepared.h"
 #include "mongoc-log.h"
 #include "mongoc-socket.h"
 #include "mongoc-stream.h"
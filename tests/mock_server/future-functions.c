@@ -562,6 +562,25 @@ background_mongoc_gridfs_file_remove (void *data)
    return NULL;
 }
 
+static void *
+background_mongoc_gridfs_file_save (void *data)
+{
+   future_t *future = (future_t *) data;
+   future_value_t return_value;
+
+   return_value.type = future_value_bool_type;
+
+   future_value_set_bool (
+      &return_value,
+      mongoc_gridfs_file_save (
+         future_value_get_mongoc_gridfs_file_ptr (future_get_param (future, 0))
+      ));
+
+   future_resolve (future, return_value);
+
+   return NULL;
+}
+
 static void *
 background_mongoc_gridfs_file_seek (void *data)
 {
@@ -605,6 +624,29 @@ background_mongoc_gridfs_file_writev (void *data)
    return NULL;
 }
 
+static void *
+background_mongoc_prepared_count_execute (void *data)
+{
+   future_t *future = (future_t *) data;
+   future_value_t return_value;
+
+   return_value.type = future_value_int64_t_type;
+
+   future_value_set_int64_t (
+      &return_value,
+      mongoc_prepared_count_execute (
+         future_value_get_const_mongoc_prepared_count_ptr (future_get_param (future, 0)),
+         future_value_get_const_bson_ptr (future_get_param (future, 1)),
+         future_value_get_int64_t (future_get_param (future, 2)),
+         future_value_get_int64_t (future_get_param (future, 3)),
+         future_value_get_bson_error_ptr (future_get_param (future, 4))
+      ));
+
+   future_resolve (future, return_value);
+
+   return NULL;
+}
+
 static void *
 background_mongoc_topology_select (void *data)
 {
@@ -1335,6 +1377,20 @@ future_gridfs_file_remove (
    return future;
 }
 
+future_t *
+future_gridfs_file_save (
+   mongoc_gridfs_file_ptr file)
+{
+   future_t *future = future_new (future_value_bool_type,
+                                  1);
+   
+   future_value_set_mongoc_gridfs_file_ptr (
+      future_get_param (future, 0), file);
+   
+   future_start (future, background_mongoc_gridfs_file_save);
+   return future;
+}
+
 future_t *
 future_gridfs_file_seek (
    mongoc_gridfs_file_ptr file,
@@ -1383,6 +1439,36 @@ future_gridfs_file_writev (
    return future;
 }
 
+future_t *
+future_prepared_count_execute (
+   const_mongoc_prepared_count_ptr prepared,
+   const_bson_ptr query,
+   int64_t skip,
+   int64_t limit,
+   bson_error_ptr error)
+{
+   future_t *future = future_new (future_value_int64_t_type,
+                                  5);
+   
+   future_value_set_const_mongoc_prepared_count_ptr (
+      future_get_param (future, 0), prepared);
+   
+   future_value_set_const_bson_ptr (
+      future_get_param (future, 1), query);
+   
+   future_value_set_int64_t (
+      future_get_param (future, 2), skip);
+   
+   future_value_set_int64_t (
+      future_get_param (future, 3), limit);
+   
+   future_value_set_bson_error_ptr (
+      future_get_param (future, 4), error);
+   
+   future_start (future, background_mongoc_prepared_count_execute);
+   return future;
+}
+
 future_t *
 future_topology_select (
    mongoc_topology_ptr topology,
@@ -269,6 +269,13 @@ future_gridfs_file_remove (
 );
 
 
+future_t *
+future_gridfs_file_save (
+
+   mongoc_gridfs_file_ptr file
+);
+
+
 future_t *
 future_gridfs_file_seek (
 
@@ -288,6 +295,17 @@ future_gridfs_file_writev (
 );
 
 
+future_t *
+future_prepared_count_execute (
+
+   const_mongoc_prepared_count_ptr prepared,
+   const_bson_ptr query,
+   int64_t skip,
+   int64_t limit,
+   bson_error_ptr error
+);
+
+
 future_t *
 future_topology_select (
 
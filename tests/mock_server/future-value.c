@@ -459,6 +459,22 @@ future_value_get_const_mongoc_find_and_modify_opts_ptr (
    return future_value->const_mongoc_find_and_modify_opts_ptr_value;
 }
 
+void
+future_value_set_const_mongoc_prepared_count_ptr (
+   future_value_t *future_value, const_mongoc_prepared_count_ptr value)
+{
+   future_value->type = future_value_const_mongoc_prepared_count_ptr_type;
+   future_value->const_mongoc_prepared_count_ptr_value = value;
+}
+
+const_mongoc_prepared_count_ptr
+future_value_get_const_mongoc_prepared_count_ptr (future_value_t *future_value)
+{
+   BSON_ASSERT (future_value->type ==
+                future_value_const_mongoc_prepared_count_ptr_type);
+   return future_value->const_mongoc_prepared_count_ptr_value;
+}
+
 void
 future_value_set_const_mongoc_read_prefs_ptr (future_value_t *future_value,
                                               const_mongoc_read_prefs_ptr value)
@@ -38,6 +38,7 @@ typedef mongoc_server_description_t * mongoc_server_description_ptr;
 typedef mongoc_topology_t * mongoc_topology_ptr;
 typedef mongoc_write_concern_t * mongoc_write_concern_ptr;
 typedef const mongoc_find_and_modify_opts_t * const_mongoc_find_and_modify_opts_ptr;
+typedef const mongoc_prepared_count_t * const_mongoc_prepared_count_ptr;
 typedef const mongoc_read_prefs_t * const_mongoc_read_prefs_ptr;
 typedef const mongoc_write_concern_t * const_mongoc_write_concern_ptr;
 
@@ -72,6 +73,7 @@ typedef enum {
    future_value_mongoc_topology_ptr_type,
    future_value_mongoc_write_concern_ptr_type,
    future_value_const_mongoc_find_and_modify_opts_ptr_type,
+   future_value_const_mongoc_prepared_count_ptr_type,
    future_value_const_mongoc_read_prefs_ptr_type,
    future_value_const_mongoc_write_concern_ptr_type,
    future_value_void_type,
@@ -111,6 +113,7 @@ typedef struct _future_value_t
       mongoc_topology_ptr mongoc_topology_ptr_value;
       mongoc_write_concern_ptr mongoc_write_concern_ptr_value;
       const_mongoc_find_and_modify_opts_ptr const_mongoc_find_and_modify_opts_ptr_value;
+      const_mongoc_prepared_count_ptr const_mongoc_prepared_count_ptr_value;
       const_mongoc_read_prefs_ptr const_mongoc_read_prefs_ptr_value;
       const_mongoc_write_concern_ptr const_mongoc_write_concern_ptr_value;
 
@@ -390,6 +393,15 @@ const_mongoc_find_and_modify_opts_ptr
 future_value_get_const_mongoc_find_and_modify_opts_ptr (
    future_value_t *future_value);
 
+void
+future_value_set_const_mongoc_prepared_count_ptr(
+   future_value_t *future_value,
+   const_mongoc_prepared_count_ptr value);
+
+const_mongoc_prepared_count_ptr
+future_value_get_const_mongoc_prepared_count_ptr (
+   future_value_t *future_value);
+
 void
 future_value_set_const_mongoc_read_prefs_ptr(
    future_value_t *future_value,
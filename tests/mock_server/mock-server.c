@@ -507,6 +507,104 @@ mock_server_auto_ismaster (mock_server_t *server,
 }
 
 
+typedef struct {
+   int64_t cursor_id;
+   int n_batches;
+   int batch_size;
+   int n_sent;
+} stream_cursor_t;
+
+
+static bool
+auto_stream_cursor (request_t *request, void *data)
+{
+   stream_cursor_t *cursor = (stream_cursor_t *) data;
+   bson_iter_t iter;
+   bson_t reply;
+   bson_t cursor_doc;
+   bson_t batch;
+   bson_t doc;
+   const char *key;
+   char buf[16];
+   int i;
+
+   if (!request->is_command || strcmp (request->command_name, "getMore") ||
+       !bson_iter_init_find (&iter, request_get_doc (request, 0), "getMore") ||
+       bson_iter_as_int64 (&iter) != cursor->cursor_id) {
+      return false;
+   }
+
+   bson_init (&reply);
+
+   if (cursor->n_sent == cursor->n_batches) {
+      /* like a server, fail getMores sent after the last batch */
+      BSON_APPEND_INT32 (&reply, "ok", 0);
+      BSON_APPEND_INT32 (&reply, "code", 43);
+      BSON_APPEND_UTF8 (&reply, "errmsg", "cursor not found");
+   } else {
+      cursor->n_sent++;
+      BSON_APPEND_INT32 (&reply, "ok", 1);
+      BSON_APPEND_DOCUMENT_BEGIN (&reply, "cursor", &cursor_doc);
+      BSON_APPEND_INT64 (&cursor_doc,
+                         "id",
+                         cursor->n_sent == cursor->n_batches
+                            ? 0
+                            : cursor->cursor_id);
+      BSON_APPEND_ARRAY_BEGIN (&cursor_doc, "nextBatch", &batch);
+      for (i = 0; i < cursor->batch_size; i++) {
+         bson_uint32_to_string ((uint32_t) i, &key, buf, sizeof buf);
+         BSON_APPEND_DOCUMENT_BEGIN (&batch, key, &doc);
+         BSON_APPEND_INT32 (&doc, "batch", cursor->n_sent);
+         BSON_APPEND_INT32 (&doc, "i", i);
+         bson_append_document_end (&batch, &doc);
+      }
+
+      bson_append_array_end (&cursor_doc, &batch);
+      bson_append_document_end (&reply, &cursor_doc);
+   }
+
+   mock_server_reply_multi (request, MONGOC_REPLY_NONE, &reply, 1, 0);
+
+   bson_destroy (&reply);
+   request_destroy (request);
+   return true;
+}
+
+
+/*--------------------------------------------------------------------------
+ *
+ * mock_server_streams_cursor --
+ *
+ *       Autorespond to getMore commands for @cursor_id with @n_batches
+ *       batches of @batch_size documents like {batch: n, i: i}, numbered
+ *       from 1. The last batch closes the cursor, and later getMores fail
+ *       with CursorNotFound. Requests are answered as they are read, so
+ *       a client may send several before reading the replies.
+ *
+ * Returns:
+ *       An id for mock_server_remove_autoresponder.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+int
+mock_server_streams_cursor (mock_server_t *server,
+                            int64_t cursor_id,
+                            int n_batches,
+                            int batch_size)
+{
+   stream_cursor_t *cursor;
+
+   cursor = (stream_cursor_t *) bson_malloc0 (sizeof *cursor);
+   cursor->cursor_id = cursor_id;
+   cursor->n_batches = n_batches;
+   cursor->batch_size = batch_size;
+
+   return mock_server_autoresponds (
+      server, auto_stream_cursor, (void *) cursor, bson_free);
+}
+
+
 /*--------------------------------------------------------------------------
  *
  * mock_server_get_uri --
@@ -765,6 +863,54 @@ mock_server_receives_command (mock_server_t *server,
 }
 
 
+/*--------------------------------------------------------------------------
+ *
+ * mock_server_receives_msg --
+ *
+ *       Pop a client OP_MSG request if one is enqueued, or wait up to
+ *       request_timeout_ms for the client to send a request.
+ *
+ * Returns:
+ *       A request you must request_destroy, or NULL if the request does
+ *       not match.
+ *
+ * Side effects:
+ *       Logs if the current request is not an OP_MSG matching flags and
+ *       command_json.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+request_t *
+mock_server_receives_msg (mock_server_t *server,
+                          uint32_t flags,
+                          const char *command_json,
+                          ...)
+{
+   va_list args;
+   char *formatted_command_json = NULL;
+   request_t *request;
+
+   va_start (args, command_json);
+   if (command_json) {
+      formatted_command_json = bson_strdupv_printf (command_json, args);
+   }
+   va_end (args);
+
+   request = mock_server_receives_request (server);
+
+   if (request &&
+       !request_matches_msg (request, flags, formatted_command_json)) {
+      request_destroy (request);
+      request = NULL;
+   }
+
+   bson_free (formatted_command_json);
+
+   return request;
+}
+
+
 /*--------------------------------------------------------------------------
  *
  * mock_server_receives_ismaster --
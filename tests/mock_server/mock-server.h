@@ -60,6 +60,12 @@ mock_server_auto_ismaster (mock_server_t *server,
                            const char *response_json,
                            ...);
 
+int
+mock_server_streams_cursor (mock_server_t *server,
+                            int64_t cursor_id,
+                            int n_batches,
+                            int batch_size);
+
 #ifdef MONGOC_ENABLE_SSL
 
 void
@@ -105,6 +111,12 @@ mock_server_receives_command (mock_server_t *server,
                               const char *command_json,
                               ...);
 
+request_t *
+mock_server_receives_msg (mock_server_t *server,
+                          uint32_t flags,
+                          const char *command_json,
+                          ...);
+
 request_t *
 mock_server_receives_ismaster (mock_server_t *server);
 
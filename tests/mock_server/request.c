@@ -44,6 +44,12 @@ request_from_killcursors (request_t *request, const mongoc_rpc_t *rpc);
 static void
 request_from_getmore (request_t *request, const mongoc_rpc_t *rpc);
 
+static bool
+request_from_op_msg (request_t *request);
+
+static uint32_t
+length_prefix (void *data);
+
 static char *
 query_flags_str (uint32_t flags);
 static char *
@@ -70,6 +76,24 @@ request_new (const mongoc_buffer_t *buffer,
    request->data_len = (size_t) msg_len;
    request->replies = replies;
 
+   if (msg_len >= 16 && length_prefix (data + 12) == MONGOC_OPCODE_MSG) {
+      /* modern OP_MSG, which mongoc_rpc_t doesn't describe */
+      request->opcode = MONGOC_OPCODE_MSG;
+      request->server = server;
+      request->client = client;
+      request->client_port = client_port;
+      _mongoc_array_init (&request->docs, sizeof (bson_t *));
+
+      if (!request_from_op_msg (request)) {
+         MONGOC_WARNING (
+            "%s():%d: %s", BSON_FUNC, __LINE__, "Failed to parse OP_MSG");
+         request_destroy (request);
+         return NULL;
+      }
+
+      return request;
+   }
+
    if (!_mongoc_rpc_scatter (&request->request_rpc, data, (size_t) msg_len)) {
       MONGOC_WARNING ("%s():%d: %s", BSON_FUNC, __LINE__, "Failed to scatter");
       bson_free (data);
@@ -454,6 +478,38 @@ request_matches_getmore (const request_t *request,
 
 
 /* TODO: take file, line, function params from caller, wrap in macro */
+bool
+request_matches_msg (const request_t *request,
+                     uint32_t flags,
+                     const char *command_json)
+{
+   const bson_t *doc;
+
+   BSON_ASSERT (request);
+
+   if (request->opcode != MONGOC_OPCODE_MSG) {
+      test_error ("request's opcode does not match MSG");
+      return false;
+   }
+
+   if (request->op_msg_flags != flags) {
+      test_error ("request's OP_MSG flags are %u, expected %u",
+                  request->op_msg_flags,
+                  flags);
+      return false;
+   }
+
+   BSON_ASSERT (request->docs.len >= 1);
+   doc = request_get_doc (request, 0);
+   if (!match_json (doc, true, __FILE__, __LINE__, BSON_FUNC, command_json)) {
+      /* match_json has logged the err */
+      return false;
+   }
+
+   return true;
+}
+
+
 bool
 request_matches_kill_cursors (const request_t *request, int64_t cursor_id)
 {
@@ -694,6 +750,88 @@ request_from_query (request_t *request, const mongoc_rpc_t *rpc)
 }
 
 
+/* parse an OP_MSG: the body section becomes docs[0], followed by the
+ * documents of any document sequence sections */
+static bool
+request_from_op_msg (request_t *request)
+{
+   uint8_t *pos = request->data + 16;
+   uint8_t *end = request->data + request->data_len;
+   uint8_t *section_end;
+   bson_string_t *msg_as_str = bson_string_new ("OP_MSG");
+   bson_t *doc;
+   bson_iter_t iter;
+   uint32_t len;
+   uint8_t kind;
+   char *str;
+   bool ret = false;
+
+   if (end - pos < 4) {
+      goto done;
+   }
+
+   request->op_msg_flags = length_prefix (pos);
+   pos += 4;
+
+   while (pos < end) {
+      kind = *pos++;
+
+      if (kind == MONGOC_OP_MSG_SECTION_BODY) {
+         if (end - pos < 5 ||
+             (len = length_prefix (pos)) > (uint32_t) (end - pos)) {
+            goto done;
+         }
+
+         doc = bson_new_from_data (pos, len);
+         BSON_ASSERT (doc);
+         _mongoc_array_append_val (&request->docs, doc);
+         pos += len;
+
+         str = bson_as_json (doc, NULL);
+         bson_string_append_printf (msg_as_str, " %s", str);
+         bson_free (str);
+
+         if (request->docs.len == 1 && bson_iter_init (&iter, doc) &&
+             bson_iter_next (&iter)) {
+            request->is_command = true;
+            request->command_name = bson_strdup (bson_iter_key (&iter));
+         }
+      } else if (kind == MONGOC_OP_MSG_SECTION_DOCUMENT_SEQUENCE) {
+         if (end - pos < 4 ||
+             (len = length_prefix (pos)) > (uint32_t) (end - pos)) {
+            goto done;
+         }
+
+         section_end = pos + len;
+         pos += 4;
+         bson_string_append_printf (msg_as_str, " %s:", (char *) pos);
+         pos += strlen ((char *) pos) + 1;
+
+         while (pos < section_end) {
+            len = length_prefix (pos);
+            doc = bson_new_from_data (pos, len);
+            BSON_ASSERT (doc);
+            _mongoc_array_append_val (&request->docs, doc);
+            pos += len;
+         }
+      } else {
+         goto done;
+      }
+   }
+
+   if (request->op_msg_flags & MONGOC_OP_MSG_FLAG_MORE_TO_COME) {
+      bson_string_append (msg_as_str, " flags=MORE_TO_COME");
+   }
+
+   ret = request->docs.len > 0;
+
+done:
+   request->as_str = bson_string_free (msg_as_str, false);
+
+   return ret;
+}
+
+
 static char *
 insert_flags_str (uint32_t flags)
 {
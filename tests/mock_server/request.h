@@ -35,6 +35,7 @@ typedef struct _request_t {
    struct _mock_server_t *server;
    mongoc_stream_t *client;
    uint16_t client_port;
+   uint32_t op_msg_flags; /* OP_MSG flagBits, if opcode is MSG */
    bool is_command;
    char *command_name;
    char *as_str;
@@ -98,6 +99,11 @@ request_matches_getmore (const request_t *request,
                          int32_t n_return,
                          int64_t cursor_id);
 
+bool
+request_matches_msg (const request_t *request,
+                     uint32_t flags,
+                     const char *command_json);
+
 bool
 request_matches_kill_cursors (const request_t *request, int64_t cursor_id);
 
@@ -2,6 +2,8 @@
 #include <mongoc-bulk-operation-private.h>
 #include <mongoc-client-private.h>
 #include <mongoc-cursor-private.h>
+#include <mongoc-topology-private.h>
+#include <mongoc-util-private.h>
 
 #include "TestSuite.h"
 
@@ -540,6 +542,252 @@ test_insert_check_keys (void)
 }
 
 
+static void
+test_insert_with_opts_validate (void)
+{
+   mock_server_t *mock_server;
+   mongoc_client_t *client;
+   mongoc_collection_t *collection;
+   mongoc_bulk_operation_t *bulk;
+   bson_t reply;
+   bson_error_t error;
+   request_t *request;
+   future_t *future;
+   bool r;
+
+   mock_server = mock_server_with_autoismaster (WIRE_VERSION_WRITE_CMD);
+   mock_server_run (mock_server);
+   client = mongoc_client_new_from_uri (mock_server_get_uri (mock_server));
+   collection = mongoc_client_get_collection (client, "test", "test");
+   bulk = mongoc_collection_create_bulk_operation (collection, true, NULL);
+
+   /* "validate" must be a boolean */
+   r = mongoc_bulk_operation_insert_with_opts (
+      bulk, tmp_bson ("{}"), tmp_bson ("{'validate': 1}"), &error);
+   ASSERT (!r);
+   ASSERT_ERROR_CONTAINS (error,
+                          MONGOC_ERROR_COMMAND,
+                          MONGOC_ERROR_COMMAND_INVALID_ARG,
+                          "'validate' option to be a boolean");
+
+   /* validated by default */
+   r = mongoc_bulk_operation_insert_with_opts (
+      bulk, tmp_bson ("{'a.b': 1}"), NULL, &error);
+   ASSERT (!r);
+   ASSERT_ERROR_CONTAINS (error,
+                          MONGOC_ERROR_COMMAND,
+                          MONGOC_ERROR_COMMAND_INVALID_ARG,
+                          "document to insert contains invalid keys");
+
+   /* trusted producers can skip validation */
+   r = mongoc_bulk_operation_insert_with_opts (
+      bulk, tmp_bson ("{'a.b': 1}"), tmp_bson ("{'validate': false}"), &error);
+   ASSERT_OR_PRINT (r, error);
+
+   future = future_bulk_operation_execute (bulk, &reply, &error);
+   request = mock_server_receives_command (
+      mock_server, "test", MONGOC_QUERY_NONE, "{'insert': 'test'}", NULL);
+
+   mock_server_replies_simple (request, "{'ok': 1, 'n': 1}");
+   ASSERT_OR_PRINT (future_get_uint32_t (future), error);
+   ASSERT_MATCH (&reply, "{'nInserted': 1}");
+
+   bson_destroy (&reply);
+   future_destroy (future);
+   request_destroy (request);
+   mongoc_bulk_operation_destroy (bulk);
+   mongoc_collection_destroy (collection);
+   mongoc_client_destroy (client);
+   mock_server_destroy (mock_server);
+}
+
+
+/* wait for the pool's background scanner to discover n mongos */
+static void
+_wait_for_mongoses (mongoc_client_t *client, uint32_t n)
+{
+   mongoc_array_t server_ids;
+   int64_t start;
+
+   _mongoc_array_init (&server_ids, sizeof (uint32_t));
+   start = bson_get_monotonic_time ();
+   while (server_ids.len < n) {
+      ASSERT_CMPINT64 (
+         bson_get_monotonic_time () - start, <, (int64_t) 10 * 1000 * 1000);
+      _mongoc_usleep (10 * 1000);
+      _mongoc_array_clear (&server_ids);
+      _mongoc_topology_suitable_server_ids (
+         client->topology, MONGOC_SS_WRITE, &server_ids);
+   }
+
+   _mongoc_array_destroy (&server_ids);
+}
+
+
+/* unordered bulk write split across two mongos, results merged */
+static void
+test_parallel_mongos (void)
+{
+   mock_server_t *servers[2];
+   char *uri_str;
+   mongoc_uri_t *uri;
+   mongoc_client_pool_t *pool;
+   mongoc_client_t *client;
+   mongoc_collection_t *collection;
+   mongoc_bulk_operation_t *bulk;
+   bson_t reply;
+   bson_error_t error;
+   request_t *request;
+   future_t *future;
+   int i;
+
+   for (i = 0; i < 2; i++) {
+      servers[i] = mock_mongos_new (WIRE_VERSION_WRITE_CMD);
+      mock_server_run (servers[i]);
+   }
+
+   uri_str = bson_strdup_printf ("mongodb://%s,%s",
+                                 mock_server_get_host_and_port (servers[0]),
+                                 mock_server_get_host_and_port (servers[1]));
+
+   uri = mongoc_uri_new (uri_str);
+   pool = mongoc_client_pool_new (uri);
+   client = mongoc_client_pool_pop (pool);
+
+   _wait_for_mongoses (client, 2);
+
+   collection = mongoc_client_get_collection (client, "db", "collection");
+   bulk = mongoc_collection_create_bulk_operation (collection, false, NULL);
+   mongoc_bulk_operation_set_client_pool (bulk, pool);
+   for (i = 0; i < 4; i++) {
+      mongoc_bulk_operation_insert (bulk, tmp_bson ("{'_id': %d}", i));
+   }
+
+   future = future_bulk_operation_execute (bulk, &reply, &error);
+
+   /* each mongos gets a contiguous half of the documents */
+   request = mock_server_receives_command (
+      servers[0],
+      "db",
+      MONGOC_QUERY_NONE,
+      "{'insert': 'collection', 'documents': [{'_id': 0}, {'_id': 1}]}",
+      NULL);
+   mock_server_replies_simple (request, "{'ok': 1, 'n': 2}");
+   request_destroy (request);
+
+   /* the second document of the second half fails */
+   request = mock_server_receives_command (
+      servers[1],
+      "db",
+      MONGOC_QUERY_NONE,
+      "{'insert': 'collection', 'documents': [{'_id': 2}, {'_id': 3}]}",
+      NULL);
+   mock_server_replies_simple (request,
+                               "{'ok': 1, 'n': 1, 'writeErrors': [{'index': "
+                               "1, 'code': 11000, 'errmsg': 'dupe'}]}");
+   request_destroy (request);
+
+   ASSERT (!future_get_uint32_t (future));
+   ASSERT_ERROR_CONTAINS (error, MONGOC_ERROR_COMMAND, 11000, "dupe");
+   ASSERT_MATCH (&reply,
+                 "{'nInserted': 3,"
+                 " 'writeErrors': [{'index': 3, 'code': 11000}]}");
+
+   bson_destroy (&reply);
+   future_destroy (future);
+   mongoc_bulk_operation_destroy (bulk);
+   mongoc_collection_destroy (collection);
+   mongoc_client_pool_push (pool, client);
+   mongoc_client_pool_destroy (pool);
+   mongoc_uri_destroy (uri);
+   bson_free (uri_str);
+
+   for (i = 0; i < 2; i++) {
+      mock_server_destroy (servers[i]);
+   }
+}
+
+
+static bool
+parallel_insert_responder (request_t *request, void *data)
+{
+   int *n_inserts = (int *) data;
+
+   if (!request->is_command || strcmp (request->command_name, "insert")) {
+      return false;
+   }
+
+   (*n_inserts)++;
+   mock_server_replies_simple (request, "{'ok': 1, 'n': 4}");
+   request_destroy (request);
+
+   return true;
+}
+
+
+/* the bulk operation's client is the pool's only one: don't block on the
+ * pool, execute serially on one mongos */
+static void
+test_parallel_mongos_pool_size_1 (void)
+{
+   mock_server_t *servers[2];
+   int n_inserts[2] = {0};
+   char *uri_str;
+   mongoc_uri_t *uri;
+   mongoc_client_pool_t *pool;
+   mongoc_client_t *client;
+   mongoc_collection_t *collection;
+   mongoc_bulk_operation_t *bulk;
+   bson_t reply;
+   bson_error_t error;
+   int i;
+
+   for (i = 0; i < 2; i++) {
+      servers[i] = mock_mongos_new (WIRE_VERSION_WRITE_CMD);
+      mock_server_autoresponds (
+         servers[i], parallel_insert_responder, &n_inserts[i], NULL);
+      mock_server_run (servers[i]);
+   }
+
+   uri_str = bson_strdup_printf ("mongodb://%s,%s/?maxPoolSize=1",
+                                 mock_server_get_host_and_port (servers[0]),
+                                 mock_server_get_host_and_port (servers[1]));
+
+   uri = mongoc_uri_new (uri_str);
+   pool = mongoc_client_pool_new (uri);
+   client = mongoc_client_pool_pop (pool);
+   ASSERT (!mongoc_client_pool_try_pop (pool));
+
+   _wait_for_mongoses (client, 2);
+
+   collection = mongoc_client_get_collection (client, "db", "collection");
+   bulk = mongoc_collection_create_bulk_operation (collection, false, NULL);
+   mongoc_bulk_operation_set_client_pool (bulk, pool);
+   for (i = 0; i < 4; i++) {
+      mongoc_bulk_operation_insert (bulk, tmp_bson ("{'_id': %d}", i));
+   }
+
+   ASSERT_OR_PRINT (mongoc_bulk_operation_execute (bulk, &reply, &error),
+                    error);
+   ASSERT_MATCH (&reply, "{'nInserted': 4}");
+
+   /* all documents in one insert command, to one mongos */
+   ASSERT_CMPINT (n_inserts[0] + n_inserts[1], ==, 1);
+
+   bson_destroy (&reply);
+   mongoc_bulk_operation_destroy (bulk);
+   mongoc_collection_destroy (collection);
+   mongoc_client_pool_push (pool, client);
+   mongoc_client_pool_destroy (pool);
+   mongoc_uri_destroy (uri);
+   bson_free (uri_str);
+
+   for (i = 0; i < 2; i++) {
+      mock_server_destroy (servers[i]);
+   }
+}
+
+
 static void
 test_upsert (bool ordered)
 {
@@ -3990,6 +4238,14 @@ test_bulk_install (TestSuite *suite)
       suite, "/BulkOperation/insert_unordered", test_insert_unordered);
    TestSuite_AddLive (
       suite, "/BulkOperation/insert_check_keys", test_insert_check_keys);
+   TestSuite_Add (suite,
+                  "/BulkOperation/insert_with_opts/validate",
+                  test_insert_with_opts_validate);
+   TestSuite_Add (
+      suite, "/BulkOperation/parallel_mongos", test_parallel_mongos);
+   TestSuite_Add (suite,
+                  "/BulkOperation/parallel_mongos/pool_size_1",
+                  test_parallel_mongos_pool_size_1);
    TestSuite_AddLive (
       suite, "/BulkOperation/update_ordered", test_update_ordered);
    TestSuite_AddLive (
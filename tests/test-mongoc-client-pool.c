@@ -1,10 +1,14 @@
 #include <mongoc.h>
 #include "mongoc-client-pool-private.h"
+#include "mongoc-client-private.h"
 #include "mongoc-array-private.h"
+#include "mongoc-util-private.h"
 
 
 #include "TestSuite.h"
 #include "test-libmongoc.h"
+#include "test-conveniences.h"
+#include "mock_server/mock-server.h"
 
 
 static void
@@ -272,6 +276,127 @@ test_mongoc_client_pool_handshake (void)
    mongoc_client_pool_destroy (pool);
 }
 
+static bool
+query_cache_responder (request_t *request, void *data)
+{
+   int *n_finds = (int *) data;
+
+   if (!request->is_command || strcmp (request->command_name, "find")) {
+      return false;
+   }
+
+   (*n_finds)++;
+   mock_server_replies_simple (request,
+                               "{'ok': 1, 'cursor': {'id': 0, 'ns': 'db.coll',"
+                               " 'firstBatch': [{'_id': 1}, {'_id': 2}]}}");
+   request_destroy (request);
+
+   return true;
+}
+
+
+static void
+_query_cache_find (mongoc_collection_t *collection,
+                   const char *filter,
+                   const char *opts)
+{
+   mongoc_cursor_t *cursor;
+   const bson_t *doc;
+   bson_error_t error;
+
+   cursor = mongoc_collection_find_with_opts (
+      collection, tmp_bson (filter), opts ? tmp_bson (opts) : NULL, NULL);
+
+   ASSERT (mongoc_cursor_next (cursor, &doc));
+   ASSERT_MATCH (doc, "{'_id': 1}");
+   ASSERT (mongoc_cursor_next (cursor, &doc));
+   ASSERT_MATCH (doc, "{'_id': 2}");
+   ASSERT (!mongoc_cursor_next (cursor, &doc));
+   ASSERT_OR_PRINT (!mongoc_cursor_error (cursor, &error), error);
+
+   mongoc_cursor_destroy (cursor);
+}
+
+
+/* identical finds are answered from the cache until they expire or are
+ * invalidated */
+static void
+test_mongoc_client_pool_query_cache (void)
+{
+   mock_server_t *server;
+   mongoc_client_pool_t *pool;
+   mongoc_client_t *client;
+   mongoc_client_t *client2;
+   mongoc_collection_t *collection;
+   mongoc_collection_t *collection2;
+   int n_finds = 0;
+
+   server = mock_server_with_autoismaster (WIRE_VERSION_FIND_CMD);
+   mock_server_autoresponds (server, query_cache_responder, &n_finds, NULL);
+   mock_server_run (server);
+
+   pool = mongoc_client_pool_new (mock_server_get_uri (server));
+   client = mongoc_client_pool_pop (pool);
+   collection = mongoc_client_get_collection (client, "db", "coll");
+
+   /* disabled by default */
+   _query_cache_find (collection, "{'a': 1}", NULL);
+   _query_cache_find (collection, "{'a': 1}", NULL);
+   ASSERT_CMPINT (n_finds, ==, 2);
+
+   mongoc_client_pool_set_query_cache (pool, 60 * 1000, 1024 * 1024);
+   _query_cache_find (collection, "{'a': 1}", NULL);
+   _query_cache_find (collection, "{'a': 1}", NULL);
+   ASSERT_CMPINT (n_finds, ==, 3);
+
+   /* another filter or other opts miss */
+   _query_cache_find (collection, "{'a': 2}", NULL);
+   ASSERT_CMPINT (n_finds, ==, 4);
+   _query_cache_find (collection, "{'a': 1}", "{'projection': {'_id': 1}}");
+   ASSERT_CMPINT (n_finds, ==, 5);
+
+   /* the pool's clients share the cache */
+   client2 = mongoc_client_pool_pop (pool);
+   collection2 = mongoc_client_get_collection (client2, "db", "coll");
+   _query_cache_find (collection2, "{'a': 1}", NULL);
+   ASSERT_CMPINT (n_finds, ==, 5);
+
+   /* invalidate by namespace */
+   mongoc_client_pool_invalidate_query_cache (pool, "db.other");
+   _query_cache_find (collection, "{'a': 1}", NULL);
+   ASSERT_CMPINT (n_finds, ==, 5);
+   mongoc_client_pool_invalidate_query_cache (pool, "db.coll");
+   _query_cache_find (collection, "{'a': 1}", NULL);
+   _query_cache_find (collection, "{'a': 1}", NULL);
+   ASSERT_CMPINT (n_finds, ==, 6);
+
+   /* invalidate all */
+   mongoc_client_pool_invalidate_query_cache (pool, NULL);
+   _query_cache_find (collection2, "{'a': 1}", NULL);
+   ASSERT_CMPINT (n_finds, ==, 7);
+
+   /* expired entries miss */
+   mongoc_client_pool_set_query_cache (pool, 1, 1024 * 1024);
+   _query_cache_find (collection, "{'a': 3}", NULL);
+   _mongoc_usleep (10 * 1000);
+   _query_cache_find (collection, "{'a': 3}", NULL);
+   ASSERT_CMPINT (n_finds, ==, 9);
+
+   /* results larger than the cache aren't stored */
+   mongoc_client_pool_set_query_cache (pool, 60 * 1000, 10);
+   _query_cache_find (collection, "{'a': 4}", NULL);
+   _query_cache_find (collection, "{'a': 4}", NULL);
+   ASSERT_CMPINT (n_finds, ==, 11);
+
+   mongoc_collection_destroy (collection2);
+   mongoc_client_pool_push (pool, client2);
+   mongoc_collection_destroy (collection);
+   mongoc_client_pool_push (pool, client);
+   mongoc_client_pool_destroy (pool);
+   mock_server_destroy (server);
+}
+
+
 void
 test_client_pool_install (TestSuite *suite)
 {
@@ -291,6 +416,8 @@ test_client_pool_install (TestSuite *suite)
 
    TestSuite_Add (
       suite, "/ClientPool/handshake", test_mongoc_client_pool_handshake);
+   TestSuite_Add (
+      suite, "/ClientPool/query_cache", test_mongoc_client_pool_query_cache);
 
 #ifndef MONGOC_ENABLE_SSL
    TestSuite_Add (
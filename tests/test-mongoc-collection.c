@@ -2529,6 +2529,382 @@ test_count_with_opts (void)
 }
 
 
+static void
+test_prepared_find (void)
+{
+   mock_server_t *server;
+   mongoc_client_t *client;
+   mongoc_collection_t *collection;
+   mongoc_read_concern_t *rc;
+   mongoc_prepared_find_t *prepared;
+   mongoc_cursor_t *cursor;
+   future_t *future;
+   request_t *request;
+   bson_error_t error;
+   const bson_t *doc;
+   int i;
+
+   server = mock_server_with_autoismaster (WIRE_VERSION_FIND_CMD);
+   mock_server_run (server);
+   client = mongoc_client_new_from_uri (mock_server_get_uri (server));
+   collection = mongoc_client_get_collection (client, "db", "collection");
+   rc = mongoc_read_concern_new ();
+   mongoc_read_concern_set_level (rc, "majority");
+   mongoc_collection_set_read_concern (collection, rc);
+
+   prepared = mongoc_prepared_find_new (
+      collection,
+      tmp_bson ("{'projection': {'a': 1},"
+                " 'limit': {'$numberLong': '2'},"
+                " 'maxAwaitTimeMS': 1}"),
+      NULL,
+      &error);
+   ASSERT_OR_PRINT (prepared, error);
+
+   /* later changes to the collection don't affect the prepared find */
+   mongoc_collection_set_read_concern (collection, NULL);
+
+   for (i = 0; i < 2; i++) {
+      cursor =
+         mongoc_prepared_find_execute (prepared, tmp_bson ("{'_id': %d}", i));
+      if (i == 1) {
+         /* cursor setters still apply */
+         ASSERT (mongoc_cursor_set_limit (cursor, 5));
+      }
+
+      future = future_cursor_next (cursor, &doc);
+      request = mock_server_receives_command (
+         server,
+         "db",
+         MONGOC_QUERY_SLAVE_OK,
+         "{'find': 'collection', 'filter': {'_id': %d},"
+         " 'projection': {'a': 1}, 'limit': %d,"
+         " 'readConcern': {'level': 'majority'},"
+         " 'maxAwaitTimeMS': {'$exists': false}}",
+         i,
+         i == 0 ? 2 : 5);
+
+      mock_server_replies_simple (request,
+                                  "{'ok': 1, 'cursor': {'id': 0, 'ns': "
+                                  "'db.collection', 'firstBatch': [{'a': 1}]}}");
+      ASSERT (future_get_bool (future));
+      ASSERT_MATCH (doc, "{'a': 1}");
+
+      future_destroy (future);
+      request_destroy (request);
+      mongoc_cursor_destroy (cursor);
+   }
+
+   mongoc_prepared_find_destroy (prepared);
+
+   /* opts are validated once, when the find is prepared */
+   prepared = mongoc_prepared_find_new (
+      collection, tmp_bson ("{'$foo': 1}"), NULL, &error);
+   ASSERT (!prepared);
+   ASSERT_ERROR_CONTAINS (error,
+                          MONGOC_ERROR_CURSOR,
+                          MONGOC_ERROR_CURSOR_INVALID_CURSOR,
+                          "Cannot use $-modifiers in 'opts'.");
+
+   prepared = mongoc_prepared_find_new (
+      collection, tmp_bson ("{'exhaust': true, 'limit': 1}"), NULL, &error);
+   ASSERT (!prepared);
+   ASSERT_ERROR_CONTAINS (error,
+                          MONGOC_ERROR_CURSOR,
+                          MONGOC_ERROR_CURSOR_INVALID_CURSOR,
+                          "Cannot specify both 'exhaust' and 'limit'.");
+
+   mongoc_read_concern_destroy (rc);
+   mongoc_collection_destroy (collection);
+   mongoc_client_destroy (client);
+   mock_server_destroy (server);
+}
+
+
+static void
+test_prepared_count (void)
+{
+   mock_server_t *server;
+   mongoc_client_t *client;
+   mongoc_collection_t *collection;
+   mongoc_prepared_count_t *prepared;
+   future_t *future;
+   request_t *request;
+   bson_error_t error;
+   int i;
+
+   /* use a mongos since we don't send SLAVE_OK to mongos by default */
+   server = mock_mongos_new (WIRE_VERSION_READ_CONCERN);
+   mock_server_run (server);
+   client = mongoc_client_new_from_uri (mock_server_get_uri (server));
+   collection = mongoc_client_get_collection (client, "db", "collection");
+
+   prepared = mongoc_prepared_count_new (
+      collection,
+      MONGOC_QUERY_SLAVE_OK,
+      tmp_bson ("{'opt': 1, 'writeConcern': {'w': 2}}"),
+      NULL,
+      &error);
+   ASSERT_OR_PRINT (prepared, error);
+
+   for (i = 0; i < 2; i++) {
+      future = future_prepared_count_execute (
+         prepared, tmp_bson ("{'x': %d}", i), i, 10, &error);
+
+      /* writeConcern is not sent to servers older than 3.4 */
+      request = mock_server_receives_command (
+         server,
+         "db",
+         MONGOC_QUERY_SLAVE_OK,
+         "{'count': 'collection', 'query': {'x': %d}, 'limit': 10,"
+         " 'skip': %s, 'opt': 1, 'writeConcern': {'$exists': false}}",
+         i,
+         i ? "1" : "{'$exists': false}");
+
+      mock_server_replies_simple (request, "{'ok': 1, 'n': 3}");
+      ASSERT_OR_PRINT (3 == future_get_int64_t (future), error);
+
+      request_destroy (request);
+      future_destroy (future);
+   }
+
+   mongoc_prepared_count_destroy (prepared);
+
+   prepared = mongoc_prepared_count_new (
+      collection,
+      MONGOC_QUERY_NONE,
+      tmp_bson ("{'collation': {'locale': 'en'}}"),
+      NULL,
+      &error);
+   ASSERT_OR_PRINT (prepared, error);
+
+   /* the wire version is checked when the count runs */
+   ASSERT (-1 == mongoc_prepared_count_execute (prepared, NULL, 0, 0, &error));
+   ASSERT_ERROR_CONTAINS (error,
+                          MONGOC_ERROR_COMMAND,
+                          MONGOC_ERROR_PROTOCOL_BAD_WIRE_VERSION,
+                          "The selected server does not support collation");
+
+   mongoc_prepared_count_destroy (prepared);
+   mongoc_collection_destroy (collection);
+   mongoc_client_destroy (client);
+   mock_server_destroy (server);
+}
+
+
+static bool
+parallel_scan_responder (request_t *request, void *data)
+{
+   if (!request->is_command ||
+       strcmp (request->command_name, "parallelCollectionScan")) {
+      return false;
+   }
+
+   ASSERT (match_json (request_get_doc (request, 0),
+                       true,
+                       __FILE__,
+                       __LINE__,
+                       BSON_FUNC,
+                       "{'parallelCollectionScan': 'collection',"
+                       " 'numCursors': 2}"));
+
+   mock_server_replies_simple (
+      request,
+      "{'ok': 1, 'cursors': ["
+      "  {'ok': 1, 'cursor': {'id': 0, 'ns': 'db.collection',"
+      "                       'firstBatch': [{'_id': 1}]}},"
+      "  {'ok': 1, 'cursor': {'id': 0, 'ns': 'db.collection',"
+      "                       'firstBatch': [{'_id': 2}]}}]}");
+
+   request_destroy (request);
+   return true;
+}
+
+
+static void
+_check_parallel_scan (mongoc_parallel_scan_t *scan,
+                      mongoc_client_t *client,
+                      const char *const *batches)
+{
+   mongoc_cursor_t *cursors[2];
+   const bson_t *doc;
+   bson_error_t error;
+   uint32_t i;
+
+   ASSERT_CMPUINT32 (mongoc_parallel_scan_get_n_cursors (scan), ==, 2);
+   ASSERT (!mongoc_parallel_scan_get_cursor (scan, 2));
+
+   for (i = 0; i < 2; i++) {
+      cursors[i] = mongoc_parallel_scan_get_cursor (scan, i);
+      ASSERT (cursors[i]);
+
+      /* each cursor is pinned to its own pooled client */
+      ASSERT (cursors[i]->client != client);
+
+      ASSERT (mongoc_cursor_next (cursors[i], &doc));
+      ASSERT_MATCH (doc, batches[i]);
+      while (mongoc_cursor_next (cursors[i], &doc)) {
+      }
+
+      ASSERT_OR_PRINT (!mongoc_cursor_error (cursors[i], &error), error);
+   }
+
+   ASSERT (cursors[0]->client != cursors[1]->client);
+}
+
+
+static void
+test_parallel_scan (void)
+{
+   mock_server_t *server;
+   mongoc_client_pool_t *pool;
+   mongoc_client_t *client;
+   mongoc_collection_t *collection;
+   mongoc_parallel_scan_t *scan;
+   const char *batches[] = {"{'_id': 1}", "{'_id': 2}"};
+   bson_error_t error;
+
+   server = mock_server_with_autoismaster (WIRE_VERSION_FIND_CMD);
+   mock_server_autoresponds (server, parallel_scan_responder, NULL, NULL);
+   mock_server_run (server);
+
+   pool = mongoc_client_pool_new (mock_server_get_uri (server));
+   client = mongoc_client_pool_pop (pool);
+   collection = mongoc_client_get_collection (client, "db", "collection");
+
+   scan = mongoc_collection_parallel_scan (
+      collection, pool, 2, NULL, NULL, &error);
+   ASSERT_OR_PRINT (scan, error);
+   _check_parallel_scan (scan, client, batches);
+
+   mongoc_parallel_scan_destroy (scan);
+
+   scan = mongoc_collection_parallel_scan (
+      collection, pool, 0, NULL, NULL, &error);
+   ASSERT (!scan);
+   ASSERT_ERROR_CONTAINS (error,
+                          MONGOC_ERROR_COMMAND,
+                          MONGOC_ERROR_COMMAND_INVALID_ARG,
+                          "num_cursors must be from 1 to 10000");
+
+   mongoc_collection_destroy (collection);
+   mongoc_client_pool_push (pool, client);
+   mongoc_client_pool_destroy (pool);
+   mock_server_destroy (server);
+}
+
+
+static bool
+parallel_scan_sample_responder (request_t *request, void *data)
+{
+   int *n_finds = (int *) data;
+   const bson_t *cmd;
+
+   if (!request->is_command) {
+      return false;
+   }
+
+   cmd = request_get_doc (request, 0);
+
+   if (!strcmp (request->command_name, "parallelCollectionScan")) {
+      /* like MongoDB 4.2 */
+      mock_server_replies_simple (
+         request, "{'ok': 0, 'code': 59, 'errmsg': 'no such command'}");
+   } else if (!strcmp (request->command_name, "aggregate")) {
+      /* 16 samples per cursor */
+      ASSERT (match_json (cmd,
+                          true,
+                          __FILE__,
+                          __LINE__,
+                          BSON_FUNC,
+                          "{'aggregate': 'collection', 'pipeline': ["
+                          "  {'$sample': {'size': 32}},"
+                          "  {'$project': {'_id': 1}},"
+                          "  {'$sort': {'_id': 1}}]}"));
+
+      mock_server_replies_simple (
+         request,
+         "{'ok': 1, 'cursor': {'id': 0, 'ns': 'db.collection', 'firstBatch': "
+         "[{'_id': 1}, {'_id': 3}, {'_id': 3}, {'_id': 4}]}}");
+   } else if (!strcmp (request->command_name, "find")) {
+      if (*n_finds == 0) {
+         ASSERT (match_json (cmd,
+                             true,
+                             __FILE__,
+                             __LINE__,
+                             BSON_FUNC,
+                             "{'find': 'collection', 'filter': {},"
+                             " 'hint': {'_id': 1},"
+                             " 'min': {'$exists': false},"
+                             " 'max': {'_id': 3}}"));
+
+         mock_server_replies_simple (
+            request,
+            "{'ok': 1, 'cursor': {'id': 0, 'ns': 'db.collection', "
+            "'firstBatch': [{'_id': 1}, {'_id': 2}]}}");
+      } else {
+         ASSERT (match_json (cmd,
+                             true,
+                             __FILE__,
+                             __LINE__,
+                             BSON_FUNC,
+                             "{'find': 'collection', 'filter': {},"
+                             " 'hint': {'_id': 1},"
+                             " 'min': {'_id': 3},"
+                             " 'max': {'$exists': false}}"));
+
+         mock_server_replies_simple (
+            request,
+            "{'ok': 1, 'cursor': {'id': 0, 'ns': 'db.collection', "
+            "'firstBatch': [{'_id': 3}, {'_id': 4}]}}");
+      }
+
+      (*n_finds)++;
+   } else {
+      return false;
+   }
+
+   request_destroy (request);
+   return true;
+}
+
+
+/* without parallelCollectionScan, split the _id index with $sample */
+static void
+test_parallel_scan_sample (void)
+{
+   mock_server_t *server;
+   mongoc_client_pool_t *pool;
+   mongoc_client_t *client;
+   mongoc_collection_t *collection;
+   mongoc_parallel_scan_t *scan;
+   const char *batches[] = {"{'_id': 1}", "{'_id': 3}"};
+   int n_finds = 0;
+   bson_error_t error;
+
+   server = mock_server_with_autoismaster (WIRE_VERSION_FIND_CMD);
+   mock_server_autoresponds (
+      server, parallel_scan_sample_responder, &n_finds, NULL);
+   mock_server_run (server);
+
+   pool = mongoc_client_pool_new (mock_server_get_uri (server));
+   client = mongoc_client_pool_pop (pool);
+   collection = mongoc_client_get_collection (client, "db", "collection");
+
+   scan = mongoc_collection_parallel_scan (
+      collection, pool, 2, NULL, NULL, &error);
+   ASSERT_OR_PRINT (scan, error);
+   _check_parallel_scan (scan, client, batches);
+   ASSERT_CMPINT (n_finds, ==, 2);
+
+   mongoc_parallel_scan_destroy (scan);
+   mongoc_collection_destroy (collection);
+   mongoc_client_pool_push (pool, client);
+   mongoc_client_pool_destroy (pool);
+   mock_server_destroy (server);
+}
+
+
 static void
 test_count_with_collation (int wire)
 {
@@ -4850,6 +5226,11 @@ test_collection_install (TestSuite *suite)
                       test_framework_skip_if_slow_or_live);
    TestSuite_AddLive (suite, "/Collection/count", test_count);
    TestSuite_Add (suite, "/Collection/count_with_opts", test_count_with_opts);
+   TestSuite_Add (suite, "/Collection/prepared_find", test_prepared_find);
+   TestSuite_Add (suite, "/Collection/prepared_count", test_prepared_count);
+   TestSuite_Add (suite, "/Collection/parallel_scan", test_parallel_scan);
+   TestSuite_Add (
+      suite, "/Collection/parallel_scan/sample", test_parallel_scan_sample);
    TestSuite_Add (suite, "/Collection/count/read_pref", test_count_read_pref);
    TestSuite_Add (
       suite, "/Collection/count/read_concern", test_count_read_concern);
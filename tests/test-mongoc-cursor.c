@@ -422,6 +422,210 @@ test_kill_cursors_pooled_cmd (void)
 }
 
 
+static void
+_open_cursor_for_deferred_kill (mock_server_t *server,
+                                mongoc_collection_t *collection,
+                                int64_t cursor_id,
+                                mongoc_cursor_t **cursor)
+{
+   const bson_t *doc;
+   future_t *future;
+   request_t *request;
+   char *reply;
+
+   *cursor = mongoc_collection_find_with_opts (
+      collection, tmp_bson ("{}"), NULL, NULL);
+
+   future = future_cursor_next (*cursor, &doc);
+   request = mock_server_receives_command (
+      server, "db", MONGOC_QUERY_SLAVE_OK, "{'find': 'coll'}");
+
+   reply = bson_strdup_printf ("{'ok': 1, 'cursor': {"
+                               "   'id': {'$numberLong': '%" PRId64 "'},"
+                               "   'ns': 'db.coll',"
+                               "   'firstBatch': [{}]}}",
+                               cursor_id);
+
+   mock_server_replies_simple (request, reply);
+   BSON_ASSERT (future_get_bool (future));
+
+   bson_free (reply);
+   future_destroy (future);
+   request_destroy (request);
+}
+
+
+/* cursor ids are queued on destroy and killed in one command before the
+ * next operation on the server */
+static void
+test_kill_cursors_deferred (void)
+{
+   mock_server_t *server;
+   mongoc_client_t *client;
+   mongoc_collection_t *collection;
+   mongoc_cursor_t *cursor_a;
+   mongoc_cursor_t *cursor_b;
+   future_t *future;
+   request_t *request;
+   bson_error_t error;
+   const char *ns_out;
+   int64_t cursor_a_out;
+   int64_t cursor_b_out;
+
+   server = mock_server_with_autoismaster (WIRE_VERSION_KILLCURSORS_CMD);
+   mock_server_run (server);
+   client = mongoc_client_new_from_uri (mock_server_get_uri (server));
+   collection = mongoc_client_get_collection (client, "db", "coll");
+
+   BSON_ASSERT (!mongoc_client_get_defer_kill_cursors (client));
+   mongoc_client_set_defer_kill_cursors (client, true);
+   BSON_ASSERT (mongoc_client_get_defer_kill_cursors (client));
+
+   _open_cursor_for_deferred_kill (server, collection, 123, &cursor_a);
+   _open_cursor_for_deferred_kill (server, collection, 124, &cursor_b);
+
+   /* no network round trip */
+   mongoc_cursor_destroy (cursor_a);
+   mongoc_cursor_destroy (cursor_b);
+
+   future = future_client_command_simple (
+      client, "admin", tmp_bson ("{'ping': 1}"), NULL, NULL, &error);
+
+   request = mock_server_receives_command (
+      server, "db", MONGOC_QUERY_SLAVE_OK, "{'killCursors': 'coll'}");
+
+   ASSERT (BCON_EXTRACT ((bson_t *) request_get_doc (request, 0),
+                         "killCursors",
+                         BCONE_UTF8 (ns_out),
+                         "cursors",
+                         "[",
+                         BCONE_INT64 (cursor_a_out),
+                         BCONE_INT64 (cursor_b_out),
+                         "]"));
+
+   ASSERT_CMPSTR ("coll", ns_out);
+   ASSERT_CMPINT64 ((int64_t) 123, ==, cursor_a_out);
+   ASSERT_CMPINT64 ((int64_t) 124, ==, cursor_b_out);
+
+   mock_server_replies_simple (request, "{'ok': 1}");
+   request_destroy (request);
+
+   request = mock_server_receives_command (
+      server, "admin", MONGOC_QUERY_SLAVE_OK, "{'ping': 1}");
+   mock_server_replies_simple (request, "{'ok': 1}");
+   ASSERT_OR_PRINT (future_get_bool (future), error);
+
+   future_destroy (future);
+   request_destroy (request);
+   mongoc_collection_destroy (collection);
+   mongoc_client_destroy (client);
+   mock_server_destroy (server);
+}
+
+
+/* the document wasn't copied out of the buffer its batch was received in */
+static void
+_assert_in_cursor_buffer (const mongoc_cursor_t *cursor, const bson_t *doc)
+{
+   const uint8_t *data = bson_get_data (doc);
+
+   ASSERT (data >= cursor->buffer.data);
+   ASSERT (data + doc->len <= cursor->buffer.data + cursor->buffer.len);
+}
+
+
+/* several getMore commands are in flight at once, their replies are read
+ * before another operation uses the connection */
+static void
+test_stream_getmore_cmd (void)
+{
+   mock_server_t *server;
+   mongoc_client_t *client;
+   mongoc_collection_t *collection;
+   mongoc_cursor_t *cursor;
+   const bson_t *doc;
+   future_t *future;
+   request_t *requests[3];
+   request_t *request;
+   bson_error_t error;
+   int i;
+
+   server = mock_server_with_autoismaster (WIRE_VERSION_FIND_CMD);
+   mock_server_run (server);
+   client = mongoc_client_new_from_uri (mock_server_get_uri (server));
+   collection = mongoc_client_get_collection (client, "db", "coll");
+   cursor = mongoc_collection_find_with_opts (
+      collection, tmp_bson ("{}"), NULL, NULL);
+
+   mongoc_cursor_set_stream_depth (cursor, 3);
+
+   future = future_cursor_next (cursor, &doc);
+   request = mock_server_receives_command (
+      server, "db", MONGOC_QUERY_SLAVE_OK, "{'find': 'coll'}");
+   mock_server_replies_simple (request,
+                               "{'ok': 1, 'cursor': {"
+                               "   'id': {'$numberLong': '123'},"
+                               "   'ns': 'db.coll',"
+                               "   'firstBatch': [{'a': 0}]}}");
+   ASSERT (future_get_bool (future));
+   ASSERT_MATCH (doc, "{'a': 0}");
+   future_destroy (future);
+   request_destroy (request);
+
+   /* sent without waiting for the application */
+   for (i = 0; i < 3; i++) {
+      requests[i] = mock_server_receives_command (
+         server,
+         "db",
+         MONGOC_QUERY_SLAVE_OK,
+         "{'getMore': {'$numberLong': '123'}, 'collection': 'coll'}");
+   }
+
+   mock_server_replies_simple (requests[0],
+                               "{'ok': 1, 'cursor': {"
+                               "   'id': {'$numberLong': '123'},"
+                               "   'ns': 'db.coll',"
+                               "   'nextBatch': [{'a': 1}]}}");
+   mock_server_replies_simple (requests[1],
+                               "{'ok': 1, 'cursor': {"
+                               "   'id': {'$numberLong': '0'},"
+                               "   'ns': 'db.coll',"
+                               "   'nextBatch': [{'a': 2}]}}");
+   /* sent after the last batch */
+   mock_server_replies_simple (
+      requests[2], "{'ok': 0, 'code': 43, 'errmsg': 'cursor not found'}");
+
+   /* the ping waits for the streamed replies */
+   future = future_client_command_simple (
+      client, "admin", tmp_bson ("{'ping': 1}"), NULL, NULL, &error);
+   request = mock_server_receives_command (
+      server, "admin", MONGOC_QUERY_SLAVE_OK, "{'ping': 1}");
+   mock_server_replies_simple (request, "{'ok': 1}");
+   ASSERT_OR_PRINT (future_get_bool (future), error);
+   future_destroy (future);
+   request_destroy (request);
+
+   ASSERT (mongoc_cursor_next (cursor, &doc));
+   ASSERT_MATCH (doc, "{'a': 1}");
+   _assert_in_cursor_buffer (cursor, doc);
+   ASSERT (mongoc_cursor_next (cursor, &doc));
+   ASSERT_MATCH (doc, "{'a': 2}");
+   _assert_in_cursor_buffer (cursor, doc);
+   ASSERT (!mongoc_cursor_next (cursor, &doc));
+   ASSERT_OR_PRINT (!mongoc_cursor_error (cursor, &error), error);
+
+   for (i = 0; i < 3; i++) {
+      request_destroy (requests[i]);
+   }
+
+   /* no killCursors, the server closed the cursor */
+   mongoc_cursor_destroy (cursor);
+   mongoc_collection_destroy (collection);
+   mongoc_client_destroy (client);
+   mock_server_destroy (server);
+}
+
+
 static void
 _test_getmore_fail (bool has_primary, bool pooled)
 {
@@ -1596,6 +1800,647 @@ test_n_return_find_cmd_with_opts (void)
 }
 
 
+/* the next batch is requested as soon as a batch arrives, and read once the
+ * application has iterated the current batch */
+static void
+_test_cursor_prefetch (bool find_cmd)
+{
+   mock_server_t *server;
+   mongoc_client_t *client;
+   mongoc_collection_t *collection;
+   mongoc_cursor_t *cursor;
+   bson_t *reply_docs;
+   const bson_t *doc;
+   request_t *request;
+   future_t *future;
+   bson_string_t *reply;
+   bson_error_t error;
+   int i;
+
+   server =
+      mock_server_with_autoismaster (find_cmd ? WIRE_VERSION_FIND_CMD : 0);
+   mock_server_run (server);
+   client = mongoc_client_new_from_uri (mock_server_get_uri (server));
+   collection = mongoc_client_get_collection (client, "db", "coll");
+   cursor = mongoc_collection_find_with_opts (
+      collection,
+      tmp_bson (NULL),
+      tmp_bson ("{'limit': 5, 'batchSize': 2}"),
+      NULL);
+
+   ASSERT (!mongoc_cursor_get_prefetch (cursor));
+   mongoc_cursor_set_prefetch (cursor, true);
+   ASSERT (mongoc_cursor_get_prefetch (cursor));
+
+   future = future_cursor_next (cursor, &doc);
+
+   if (find_cmd) {
+      request = mock_server_receives_command (
+         server, "db", MONGOC_QUERY_SLAVE_OK, "{'find': 'coll'}");
+      reply = bson_string_new (NULL);
+      _make_reply_batch (reply, 2, true, false);
+      mock_server_replies_simple (request, reply->str);
+      bson_string_free (reply, true);
+   } else {
+      request = mock_server_receives_query (
+         server, "db.coll", MONGOC_QUERY_SLAVE_OK, 0, 2, NULL, NULL);
+      reply_docs = _make_n_empty_docs (2);
+      mock_server_reply_multi (
+         request, MONGOC_REPLY_NONE, reply_docs, 2, 123 /* cursor_id */);
+      bson_free (reply_docs);
+   }
+
+   ASSERT (future_get_bool (future));
+   future_destroy (future);
+   request_destroy (request);
+
+   /* the getMore for the second batch was sent with the first batch unread */
+   for (i = 0; i < 2; i++) {
+      if (find_cmd) {
+         request = mock_server_receives_command (
+            server,
+            "db",
+            MONGOC_QUERY_SLAVE_OK,
+            "{'getMore': {'$numberLong': '123'}, 'batchSize': %d}",
+            i == 0 ? 2 : 1);
+         reply = bson_string_new (NULL);
+         _make_reply_batch (reply, i == 0 ? 2 : 1, false, i == 1);
+         mock_server_replies_simple (request, reply->str);
+         bson_string_free (reply, true);
+      } else {
+         request =
+            mock_server_receives_getmore (server, "db.coll", i == 0 ? 2 : 1, 123);
+         reply_docs = _make_n_empty_docs (i == 0 ? 2 : 1);
+         mock_server_reply_multi (request,
+                                  MONGOC_REPLY_NONE,
+                                  reply_docs,
+                                  i == 0 ? 2 : 1,
+                                  i == 0 ? 123 : 0);
+         bson_free (reply_docs);
+      }
+
+      request_destroy (request);
+
+      /* finish this batch, take the prefetched one, which sends the next */
+      ASSERT (mongoc_cursor_next (cursor, &doc));
+      ASSERT (mongoc_cursor_next (cursor, &doc));
+      _assert_in_cursor_buffer (cursor, doc);
+   }
+
+   ASSERT (!mongoc_cursor_next (cursor, &doc));
+   ASSERT_OR_PRINT (!mongoc_cursor_error (cursor, &error), error);
+
+   /* cursor is closed, no killCursors */
+   mongoc_cursor_destroy (cursor);
+   mongoc_collection_destroy (collection);
+   mongoc_client_destroy (client);
+   mock_server_destroy (server);
+}
+
+
+static void
+test_prefetch_op_getmore (void)
+{
+   _test_cursor_prefetch (false);
+}
+
+
+static void
+test_prefetch_getmore_cmd (void)
+{
+   _test_cursor_prefetch (true);
+}
+
+
+static void
+_reply_adaptive (request_t *request,
+                 bool find_cmd,
+                 uint32_t n_docs,
+                 bool first_batch,
+                 bool finished)
+{
+   bson_string_t *reply;
+   bson_t *reply_docs;
+
+   if (find_cmd) {
+      reply = bson_string_new (NULL);
+      _make_reply_batch (reply, n_docs, first_batch, finished);
+      mock_server_replies_simple (request, reply->str);
+      bson_string_free (reply, true);
+   } else {
+      reply_docs = _make_n_empty_docs (n_docs);
+      mock_server_reply_multi (
+         request, MONGOC_REPLY_NONE, reply_docs, n_docs, finished ? 0 : 123);
+      bson_free (reply_docs);
+   }
+
+   request_destroy (request);
+}
+
+
+static request_t *
+_receives_adaptive (mock_server_t *server, bool find_cmd, int32_t batch_size)
+{
+   if (find_cmd) {
+      return mock_server_receives_command (
+         server,
+         "db",
+         MONGOC_QUERY_SLAVE_OK,
+         "{'getMore': {'$numberLong': '123'}, 'batchSize': %d}",
+         batch_size);
+   }
+
+   return mock_server_receives_getmore (server, "db.coll", batch_size, 123);
+}
+
+
+static void
+_test_cursor_adaptive_batch_size (bool find_cmd)
+{
+   mock_server_t *server;
+   mongoc_client_t *client;
+   mongoc_collection_t *collection;
+   mongoc_cursor_t *cursor;
+   const bson_t *doc;
+   request_t *request;
+   future_t *future;
+   int32_t batch_size;
+   int32_t i;
+   int round;
+
+   server =
+      mock_server_with_autoismaster (find_cmd ? WIRE_VERSION_FIND_CMD : 0);
+   mock_server_run (server);
+   client = mongoc_client_new_from_uri (mock_server_get_uri (server));
+   collection = mongoc_client_get_collection (client, "db", "coll");
+
+   /* round 0: batches grow while the application outpaces round trips.
+    * round 1: a 1-byte cap allows one document per getMore */
+   for (round = 0; round < 2; round++) {
+      cursor = mongoc_collection_find_with_opts (
+         collection, tmp_bson (NULL), NULL, NULL);
+
+      ASSERT_CMPUINT32 (mongoc_cursor_get_adaptive_batch_size (cursor), ==, 0);
+      mongoc_cursor_set_adaptive_batch_size (
+         cursor, round == 0 ? 16 * 1024 * 1024 : 1);
+      ASSERT_CMPUINT32 (mongoc_cursor_get_adaptive_batch_size (cursor),
+                        ==,
+                        round == 0 ? 16 * 1024 * 1024 : 1);
+
+      /* the first batch is small */
+      ASSERT_CMPUINT32 (mongoc_cursor_get_batch_size (cursor), ==, 16);
+
+      future = future_cursor_next (cursor, &doc);
+      if (find_cmd) {
+         request = mock_server_receives_command (
+            server,
+            "db",
+            MONGOC_QUERY_SLAVE_OK,
+            "{'find': 'coll', 'batchSize': 16}");
+      } else {
+         request = mock_server_receives_query (
+            server, "db.coll", MONGOC_QUERY_SLAVE_OK, 0, 16, NULL, NULL);
+      }
+
+      _reply_adaptive (request, find_cmd, 16, true, false);
+      ASSERT (future_get_bool (future));
+      future_destroy (future);
+
+      batch_size = 16;
+      for (i = 0; i < (round == 0 ? 2 : 1); i++) {
+         /* finish the batch */
+         while (--batch_size) {
+            ASSERT (mongoc_cursor_next (cursor, &doc));
+         }
+
+         batch_size = round == 0 ? 32 << i : 1;
+         future = future_cursor_next (cursor, &doc);
+         request = _receives_adaptive (server, find_cmd, batch_size);
+         _reply_adaptive (request,
+                          find_cmd,
+                          (uint32_t) batch_size,
+                          false,
+                          round == 1 || i == 1);
+         ASSERT (future_get_bool (future));
+         future_destroy (future);
+      }
+
+      while (mongoc_cursor_next (cursor, &doc)) {
+      }
+
+      mongoc_cursor_destroy (cursor);
+   }
+
+   mongoc_collection_destroy (collection);
+   mongoc_client_destroy (client);
+   mock_server_destroy (server);
+}
+
+
+static void
+test_adaptive_batch_size_op_getmore (void)
+{
+   _test_cursor_adaptive_batch_size (false);
+}
+
+
+static void
+test_adaptive_batch_size_getmore_cmd (void)
+{
+   _test_cursor_adaptive_batch_size (true);
+}
+
+
+/* check the documents {i: first}, {i: first + 1}, ... from next_batch */
+static void
+_check_batch (const uint8_t *data,
+              size_t data_len,
+              const uint32_t *offsets,
+              uint32_t n_docs,
+              int32_t first)
+{
+   uint32_t i;
+   uint32_t len;
+   bson_t doc;
+   bson_iter_t iter;
+
+   for (i = 0; i < n_docs; i++) {
+      memcpy (&len, data + offsets[i], sizeof len);
+      len = BSON_UINT32_FROM_LE (len);
+      ASSERT_CMPSIZE_T ((size_t) offsets[i] + len, <=, data_len);
+      ASSERT (bson_init_static (&doc, data + offsets[i], len));
+      ASSERT (bson_iter_init_find (&iter, &doc, "i"));
+      ASSERT_CMPINT32 (bson_iter_int32 (&iter), ==, first + (int32_t) i);
+   }
+}
+
+
+static void
+_test_cursor_next_batch (bool find_cmd)
+{
+   mock_server_t *server;
+   mongoc_client_t *client;
+   mongoc_collection_t *collection;
+   mongoc_cursor_t *cursor;
+   bson_t reply_docs[3];
+   const bson_t *doc;
+   const uint8_t *data;
+   size_t data_len;
+   const uint32_t *offsets;
+   uint32_t n_docs;
+   request_t *request;
+   future_t *future;
+   bson_error_t error;
+   int32_t i;
+
+   server =
+      mock_server_with_autoismaster (find_cmd ? WIRE_VERSION_FIND_CMD : 0);
+   mock_server_run (server);
+   client = mongoc_client_new_from_uri (mock_server_get_uri (server));
+   collection = mongoc_client_get_collection (client, "db", "coll");
+   cursor = mongoc_collection_find_with_opts (
+      collection,
+      tmp_bson (NULL),
+      tmp_bson ("{'limit': 5, 'batchSize': 3}"),
+      NULL);
+
+   future = future_cursor_next (cursor, &doc);
+
+   if (find_cmd) {
+      request = mock_server_receives_command (
+         server, "db", MONGOC_QUERY_SLAVE_OK, "{'find': 'coll'}");
+      mock_server_replies_simple (request,
+                                  "{'ok': 1, 'cursor': {"
+                                  "    'id': 123, 'ns': 'db.coll',"
+                                  "    'firstBatch': [{'i': 0}, {'i': 1},"
+                                  "                   {'i': 2}]}}");
+   } else {
+      request = mock_server_receives_query (
+         server, "db.coll", MONGOC_QUERY_SLAVE_OK, 0, 3, NULL, NULL);
+      for (i = 0; i < 3; i++) {
+         bson_init (&reply_docs[i]);
+         BSON_APPEND_INT32 (&reply_docs[i], "i", i);
+      }
+
+      mock_server_reply_multi (
+         request, MONGOC_REPLY_NONE, reply_docs, 3, 123 /* cursor_id */);
+      for (i = 0; i < 3; i++) {
+         bson_destroy (&reply_docs[i]);
+      }
+   }
+
+   ASSERT (future_get_bool (future));
+   future_destroy (future);
+   request_destroy (request);
+
+   /* the rest of the first batch */
+   ASSERT (mongoc_cursor_next_batch (
+      cursor, &data, &data_len, &offsets, &n_docs));
+   ASSERT_CMPUINT32 (n_docs, ==, (uint32_t) 2);
+   _check_batch (data, data_len, offsets, n_docs, 1);
+   ASSERT_MATCH (mongoc_cursor_current (cursor), "{'i': 1}");
+
+   /* OP_GET_MORE: the server returns more than the limit allows */
+   future = future_cursor_next (cursor, &doc);
+
+   if (find_cmd) {
+      request = mock_server_receives_command (
+         server,
+         "db",
+         MONGOC_QUERY_SLAVE_OK,
+         "{'getMore': {'$numberLong': '123'}, 'batchSize': 2}");
+      mock_server_replies_simple (request,
+                                  "{'ok': 1, 'cursor': {"
+                                  "    'id': 0, 'ns': 'db.coll',"
+                                  "    'nextBatch': [{'i': 3}, {'i': 4}]}}");
+   } else {
+      request = mock_server_receives_getmore (server, "db.coll", 2, 123);
+      for (i = 0; i < 3; i++) {
+         bson_init (&reply_docs[i]);
+         BSON_APPEND_INT32 (&reply_docs[i], "i", i + 3);
+      }
+
+      mock_server_reply_multi (
+         request, MONGOC_REPLY_NONE, reply_docs, 3, 0 /* cursor_id */);
+      for (i = 0; i < 3; i++) {
+         bson_destroy (&reply_docs[i]);
+      }
+   }
+
+   ASSERT (future_get_bool (future));
+   future_destroy (future);
+   request_destroy (request);
+
+   ASSERT (mongoc_cursor_next_batch (
+      cursor, &data, &data_len, &offsets, &n_docs));
+   ASSERT_CMPUINT32 (n_docs, ==, (uint32_t) 1);
+   _check_batch (data, data_len, offsets, n_docs, 4);
+
+   ASSERT (!mongoc_cursor_next_batch (
+      cursor, &data, &data_len, &offsets, &n_docs));
+   ASSERT_CMPUINT32 (n_docs, ==, (uint32_t) 0);
+   ASSERT_OR_PRINT (!mongoc_cursor_error (cursor, &error), error);
+
+   mongoc_cursor_destroy (cursor);
+   mongoc_collection_destroy (collection);
+   mongoc_client_destroy (client);
+   mock_server_destroy (server);
+}
+
+
+static void
+test_next_batch_op_query (void)
+{
+   _test_cursor_next_batch (false);
+}
+
+
+static void
+test_next_batch_find_cmd (void)
+{
+   _test_cursor_next_batch (true);
+}
+
+
+/* documents per second with mongoc_cursor_next and mongoc_cursor_next_batch,
+ * iterating a large command reply without a server */
+static void
+test_next_batch_bench (void *ctx)
+{
+   const int32_t n = 500 * 1000;
+   mongoc_client_t *client;
+   mongoc_cursor_t *cursor;
+   bson_t reply;
+   bson_t cursor_doc;
+   bson_t batch;
+   bson_t doc;
+   const bson_t *next_doc;
+   const uint8_t *data;
+   size_t data_len;
+   const uint32_t *offsets;
+   uint32_t n_docs;
+   char key[16];
+   const char *k;
+   int64_t started;
+   int64_t total;
+   int32_t i;
+   int mode;
+
+   bson_init (&reply);
+   BSON_APPEND_DOCUMENT_BEGIN (&reply, "cursor", &cursor_doc);
+   BSON_APPEND_INT64 (&cursor_doc, "id", 0);
+   BSON_APPEND_UTF8 (&cursor_doc, "ns", "db.coll");
+   BSON_APPEND_ARRAY_BEGIN (&cursor_doc, "firstBatch", &batch);
+   for (i = 0; i < n; i++) {
+      bson_uint32_to_string ((uint32_t) i, &k, key, sizeof key);
+      bson_append_document_begin (&batch, k, -1, &doc);
+      BSON_APPEND_INT32 (&doc, "_id", i);
+      BSON_APPEND_UTF8 (&doc, "x", "abcdefghijklmnopqrstuvwxyz");
+      bson_append_document_end (&batch, &doc);
+   }
+   bson_append_array_end (&cursor_doc, &batch);
+   bson_append_document_end (&reply, &cursor_doc);
+   BSON_APPEND_INT32 (&reply, "ok", 1);
+
+   client = mongoc_client_new ("mongodb://localhost");
+
+   for (mode = 0; mode < 2; mode++) {
+      /* the cursor steals the reply */
+      cursor =
+         mongoc_cursor_new_from_command_reply (client, bson_copy (&reply), 0);
+      total = 0;
+      started = bson_get_monotonic_time ();
+
+      if (mode == 0) {
+         while (mongoc_cursor_next (cursor, &next_doc)) {
+            total++;
+         }
+      } else {
+         while (mongoc_cursor_next_batch (
+            cursor, &data, &data_len, &offsets, &n_docs)) {
+            total += n_docs;
+         }
+      }
+
+      ASSERT_CMPINT64 (total, ==, (int64_t) n);
+      fprintf (stderr,
+               "%s: %.0f docs/sec\n",
+               mode == 0 ? "mongoc_cursor_next" : "mongoc_cursor_next_batch",
+               (double) total * 1000000.0 /
+                  (double) BSON_MAX (bson_get_monotonic_time () - started, 1));
+
+      mongoc_cursor_destroy (cursor);
+   }
+
+   mongoc_client_destroy (client);
+   bson_destroy (&reply);
+}
+
+
+static void
+test_next_columnar (void)
+{
+   mongoc_client_t *client;
+   mongoc_cursor_t *cursor;
+   mongoc_columnar_t *columns;
+   const int32_t *ids;
+   const double *xs;
+   const char *const *names;
+   const uint32_t *name_lens;
+   const int64_t *ns;
+   const bool *flags;
+   bson_error_t error;
+
+   client = mongoc_client_new ("mongodb://localhost");
+   cursor = mongoc_cursor_new_from_command_reply (
+      client,
+      bson_copy (tmp_bson (
+         "{'ok': 1, 'cursor': {'id': 0, 'ns': 'db.coll', 'firstBatch': ["
+         "  {'_id': 1, 'x': 1.5, 'name': 'a',"
+         "   'sub': {'n': {'$numberLong': '10'}, 'flag': true}},"
+         "  {'_id': 2, 'x': 2, 'name': null, 'sub': {'n': 11}},"
+         "  {'sub': 5, 'name': 'ccc', 'x': 'bad', '_id': 'three'}]}}")),
+      0);
+
+   columns = mongoc_columnar_new ();
+   ASSERT_OR_PRINT (
+      mongoc_columnar_add_column (columns, "_id", BSON_TYPE_INT32, &error),
+      error);
+   ASSERT_OR_PRINT (
+      mongoc_columnar_add_column (columns, "x", BSON_TYPE_DOUBLE, &error),
+      error);
+   ASSERT_OR_PRINT (
+      mongoc_columnar_add_column (columns, "name", BSON_TYPE_UTF8, &error),
+      error);
+   ASSERT_OR_PRINT (
+      mongoc_columnar_add_column (columns, "sub.n", BSON_TYPE_INT64, &error),
+      error);
+   ASSERT_OR_PRINT (
+      mongoc_columnar_add_column (columns, "sub.flag", BSON_TYPE_BOOL, &error),
+      error);
+
+   ASSERT (!mongoc_columnar_add_column (columns, "x", BSON_TYPE_INT32, &error));
+   ASSERT_ERROR_CONTAINS (error,
+                          MONGOC_ERROR_COMMAND,
+                          MONGOC_ERROR_COMMAND_INVALID_ARG,
+                          "Duplicate column path: \"x\"");
+   ASSERT (
+      !mongoc_columnar_add_column (columns, "a..b", BSON_TYPE_INT32, &error));
+   ASSERT_ERROR_CONTAINS (error,
+                          MONGOC_ERROR_COMMAND,
+                          MONGOC_ERROR_COMMAND_INVALID_ARG,
+                          "Invalid column path");
+   ASSERT (!mongoc_columnar_add_column (columns, "y", BSON_TYPE_ARRAY, &error));
+   ASSERT_ERROR_CONTAINS (error,
+                          MONGOC_ERROR_COMMAND,
+                          MONGOC_ERROR_COMMAND_INVALID_ARG,
+                          "Cannot decode BSON type 0x04");
+
+   ASSERT_CMPUINT32 (mongoc_columnar_get_n_columns (columns), ==, 5);
+   ASSERT (mongoc_cursor_next_columnar (cursor, columns));
+   ASSERT_CMPUINT32 (mongoc_columnar_get_n_rows (columns), ==, 3);
+
+   /* getters check the column's type */
+   ASSERT (!mongoc_columnar_get_double (columns, 0));
+   ASSERT (!mongoc_columnar_get_int32 (columns, 5));
+
+   ids = mongoc_columnar_get_int32 (columns, 0);
+   ASSERT_CMPINT (ids[0], ==, 1);
+   ASSERT_CMPINT (ids[1], ==, 2);
+   ASSERT_CMPINT (ids[2], ==, 0);
+   ASSERT (mongoc_columnar_is_null (columns, 0, 2));
+   ASSERT_CMPINT (mongoc_columnar_get_null_bitmap (columns, 0)[0] & 7, ==, 4);
+
+   /* int32 converted to double, a string is null */
+   xs = mongoc_columnar_get_double (columns, 1);
+   ASSERT (xs[0] == 1.5);
+   ASSERT (xs[1] == 2.0);
+   ASSERT (mongoc_columnar_is_null (columns, 1, 2));
+
+   names = mongoc_columnar_get_utf8 (columns, 2, &name_lens);
+   ASSERT_CMPSTR (names[0], "a");
+   ASSERT_CMPUINT32 (name_lens[0], ==, 1);
+   ASSERT (!names[1]);
+   ASSERT (mongoc_columnar_is_null (columns, 2, 1));
+   ASSERT_CMPSTR (names[2], "ccc");
+   ASSERT_CMPUINT32 (name_lens[2], ==, 3);
+
+   ns = mongoc_columnar_get_int64 (columns, 3);
+   ASSERT_CMPINT64 (ns[0], ==, (int64_t) 10);
+   ASSERT_CMPINT64 (ns[1], ==, (int64_t) 11);
+   ASSERT (mongoc_columnar_is_null (columns, 3, 2));
+
+   flags = mongoc_columnar_get_bool (columns, 4);
+   ASSERT (flags[0]);
+   ASSERT (!mongoc_columnar_is_null (columns, 4, 0));
+   ASSERT (mongoc_columnar_is_null (columns, 4, 1));
+   ASSERT (mongoc_columnar_is_null (columns, 4, 2));
+
+   ASSERT (!mongoc_cursor_next_columnar (cursor, columns));
+   ASSERT_CMPUINT32 (mongoc_columnar_get_n_rows (columns), ==, 0);
+   ASSERT_OR_PRINT (!mongoc_cursor_error (cursor, &error), error);
+
+   mongoc_columnar_destroy (columns);
+   mongoc_cursor_destroy (cursor);
+   mongoc_client_destroy (client);
+}
+
+
+/* nanoseconds per document in mongoc_cursor_next, for a cursor with a limit
+ * iterating one large OP_REPLY */
+static void
+test_next_overhead_bench (void *ctx)
+{
+   const int n = 200 * 1000;
+   mock_server_t *server;
+   mongoc_client_t *client;
+   mongoc_collection_t *collection;
+   mongoc_cursor_t *cursor;
+   bson_t *reply_docs;
+   const bson_t *doc;
+   request_t *request;
+   future_t *future;
+   int64_t started;
+   int64_t duration;
+   int i;
+
+   server = mock_server_with_autoismaster (0);
+   mock_server_run (server);
+   client = mongoc_client_new_from_uri (mock_server_get_uri (server));
+   collection = mongoc_client_get_collection (client, "db", "coll");
+   cursor = mongoc_collection_find_with_opts (
+      collection, tmp_bson (NULL), tmp_bson ("{'limit': %d}", n), NULL);
+
+   future = future_cursor_next (cursor, &doc);
+   request = mock_server_receives_query (
+      server, "db.coll", MONGOC_QUERY_SLAVE_OK, 0, n, NULL, NULL);
+   reply_docs = _make_n_empty_docs (n);
+   mock_server_reply_multi (
+      request, MONGOC_REPLY_NONE, reply_docs, (uint32_t) n, 0 /* cursor_id */);
+   ASSERT (future_get_bool (future));
+
+   started = bson_get_monotonic_time ();
+   for (i = 1; i < n; i++) {
+      ASSERT (mongoc_cursor_next (cursor, &doc));
+   }
+
+   duration = bson_get_monotonic_time () - started;
+   fprintf (stderr,
+            "mongoc_cursor_next: %.1f ns/doc\n",
+            (double) duration * 1000.0 / (double) (n - 1));
+
+   ASSERT (!mongoc_cursor_next (cursor, &doc));
+
+   bson_free (reply_docs);
+   future_destroy (future);
+   request_destroy (request);
+   mongoc_cursor_destroy (cursor);
+   mongoc_collection_destroy (collection);
+   mongoc_client_destroy (client);
+   mock_server_destroy (server);
+}
+
+
 void
 test_cursor_install (TestSuite *suite)
 {
@@ -1609,6 +2454,8 @@ test_cursor_install (TestSuite *suite)
       suite, "/Cursor/kill/single/cmd", test_kill_cursors_single_cmd);
    TestSuite_Add (
       suite, "/Cursor/kill/pooled/cmd", test_kill_cursors_pooled_cmd);
+   TestSuite_Add (suite, "/Cursor/kill/deferred", test_kill_cursors_deferred);
+   TestSuite_Add (suite, "/Cursor/stream/getmore_cmd", test_stream_getmore_cmd);
    TestSuite_Add (suite,
                   "/Cursor/getmore_fail/with_primary/pooled",
                   test_getmore_fail_with_primary_pooled);
@@ -1689,4 +2536,31 @@ test_cursor_install (TestSuite *suite)
    TestSuite_Add (suite,
                   "/Cursor/n_return/find_cmd/with_opts",
                   test_n_return_find_cmd_with_opts);
+   TestSuite_Add (
+      suite, "/Cursor/prefetch/op_getmore", test_prefetch_op_getmore);
+   TestSuite_Add (
+      suite, "/Cursor/prefetch/getmore_cmd", test_prefetch_getmore_cmd);
+   TestSuite_Add (
+      suite, "/Cursor/next_batch/op_query", test_next_batch_op_query);
+   TestSuite_Add (
+      suite, "/Cursor/next_batch/find_cmd", test_next_batch_find_cmd);
+   TestSuite_AddFull (suite,
+                      "/Cursor/next_batch/bench",
+                      test_next_batch_bench,
+                      NULL,
+                      NULL,
+                      test_framework_skip_if_slow);
+   TestSuite_Add (suite, "/Cursor/next_columnar", test_next_columnar);
+   TestSuite_Add (suite,
+                  "/Cursor/adaptive_batch_size/op_getmore",
+                  test_adaptive_batch_size_op_getmore);
+   TestSuite_Add (suite,
+                  "/Cursor/adaptive_batch_size/getmore_cmd",
+                  test_adaptive_batch_size_getmore_cmd);
+   TestSuite_AddFull (suite,
+                      "/Cursor/next/overhead_bench",
+                      test_next_overhead_bench,
+                      NULL,
+                      NULL,
+                      test_framework_skip_if_slow);
 }
@@ -533,6 +533,77 @@ test_exhaust_server_err_2nd_batch_pooled (void)
    _mock_test_exhaust (true, SECOND_BATCH, SERVER_ERROR);
 }
 
+/* with a stream depth, exhaust on a find command server streams getMore
+ * commands instead, and doesn't tie up the client */
+static void
+test_exhaust_stream (void)
+{
+   mock_server_t *server;
+   mongoc_client_t *client;
+   mongoc_collection_t *collection;
+   mongoc_cursor_t *cursor;
+   const bson_t *doc;
+   future_t *future;
+   request_t *request;
+   bson_error_t error;
+   int n_docs;
+
+   server = mock_server_with_autoismaster (WIRE_VERSION_FIND_CMD);
+   mock_server_run (server);
+   mock_server_streams_cursor (server, 123, 5, 10);
+
+   client = mongoc_client_new_from_uri (mock_server_get_uri (server));
+   collection = mongoc_client_get_collection (client, "db", "test");
+   cursor = mongoc_collection_find (
+      collection, MONGOC_QUERY_EXHAUST, 0, 0, 0, tmp_bson ("{}"), NULL, NULL);
+
+   mongoc_cursor_set_stream_depth (cursor, 2);
+   ASSERT_CMPUINT32 (2, ==, mongoc_cursor_get_stream_depth (cursor));
+
+   future = future_cursor_next (cursor, &doc);
+   request = mock_server_receives_command (
+      server,
+      "db",
+      MONGOC_QUERY_SLAVE_OK,
+      "{'find': 'test', 'filter': {}, 'exhaust': {'$exists': false}}");
+
+   mock_server_replies_simple (request,
+                               "{'ok': 1, 'cursor': {"
+                               "   'id': {'$numberLong': '123'},"
+                               "   'ns': 'db.test',"
+                               "   'firstBatch': [{'batch': 0}]}}");
+
+   ASSERT (future_get_bool (future));
+   ASSERT_MATCH (doc, "{'batch': 0}");
+   BSON_ASSERT (!client->in_exhaust);
+   future_destroy (future);
+   request_destroy (request);
+
+   /* the client is usable while batches stream */
+   future = future_client_command_simple (
+      client, "admin", tmp_bson ("{'ping': 1}"), NULL, NULL, &error);
+   request = mock_server_receives_command (
+      server, "admin", MONGOC_QUERY_SLAVE_OK, "{'ping': 1}");
+   mock_server_replies_simple (request, "{'ok': 1}");
+   ASSERT_OR_PRINT (future_get_bool (future), error);
+   future_destroy (future);
+   request_destroy (request);
+
+   n_docs = 1;
+   while (mongoc_cursor_next (cursor, &doc)) {
+      n_docs++;
+   }
+
+   ASSERT_OR_PRINT (!mongoc_cursor_error (cursor, &error), error);
+   ASSERT_CMPINT (51, ==, n_docs);
+   ASSERT_CMPINT64 ((int64_t) 0, ==, mongoc_cursor_get_id (cursor));
+
+   mongoc_cursor_destroy (cursor);
+   mongoc_collection_destroy (collection);
+   mongoc_client_destroy (client);
+   mock_server_destroy (server);
+}
+
 void
 test_exhaust_install (TestSuite *suite)
 {
@@ -581,4 +652,5 @@ test_exhaust_install (TestSuite *suite)
    TestSuite_Add (suite,
                   "/Client/exhaust_cursor/err/server/2nd_batch/pooled",
                   test_exhaust_server_err_2nd_batch_pooled);
+   TestSuite_Add (suite, "/Client/exhaust_cursor/stream", test_exhaust_stream);
 }
@@ -372,6 +372,7 @@ test_create_from_stream (void)
 {
    mongoc_gridfs_t *gridfs;
    mongoc_gridfs_file_t *file;
+   mongoc_gridfs_file_t *found;
    mongoc_stream_t *stream;
    mongoc_client_t *client;
    bson_error_t error;
@@ -391,8 +392,20 @@ test_create_from_stream (void)
 
    file = mongoc_gridfs_create_file_from_stream (gridfs, stream, NULL);
    ASSERT (file);
+
+   /* the files document is saved, with the file's length and md5 */
+   ASSERT_OR_PRINT (found = mongoc_gridfs_find_one_with_opts (
+                       gridfs, tmp_bson (NULL), NULL, &error),
+                    error);
+   ASSERT_CMPINT64 (mongoc_gridfs_file_get_length (found),
+                    ==,
+                    mongoc_gridfs_file_get_length (file));
+   ASSERT_CMPSTR (mongoc_gridfs_file_get_md5 (found),
+                  mongoc_gridfs_file_get_md5 (file));
+
    ASSERT (mongoc_gridfs_file_save (file));
 
+   mongoc_gridfs_file_destroy (found);
    mongoc_gridfs_file_destroy (file);
 
    drop_collections (gridfs, &error);
@@ -402,6 +415,84 @@ test_create_from_stream (void)
 }
 
 
+static void
+test_md5 (void)
+{
+   mongoc_gridfs_t *gridfs;
+   mongoc_gridfs_file_t *file;
+   mongoc_gridfs_file_opt_t opt = {0};
+   mongoc_client_t *client;
+   mongoc_iovec_t iov[2];
+   bson_error_t error;
+
+   client = test_framework_client_new ();
+   ASSERT (client);
+
+   ASSERT_OR_PRINT ((gridfs = get_test_gridfs (client, "md5", &error)), error);
+
+   mongoc_gridfs_drop (gridfs, &error);
+
+   iov[0].iov_base = (void *) "hello ";
+   iov[0].iov_len = 6;
+   iov[1].iov_base = (void *) "world";
+   iov[1].iov_len = 5;
+
+   /* the md5 is computed as the bytes are written, across chunks */
+   opt.filename = "hello";
+   opt.chunk_size = 4;
+   file = mongoc_gridfs_create_file (gridfs, &opt);
+   ASSERT_CMPSSIZE_T (
+      mongoc_gridfs_file_writev (file, iov, 2, 0), ==, (ssize_t) 11);
+   ASSERT (mongoc_gridfs_file_save (file));
+   ASSERT_CMPSTR (mongoc_gridfs_file_get_md5 (file),
+                  "5eb63bbbe01eeed093cb22bb8f5acdc3");
+   mongoc_gridfs_file_destroy (file);
+
+   file = mongoc_gridfs_find_one_by_filename (gridfs, "hello", &error);
+   ASSERT_OR_PRINT (file, error);
+   ASSERT_CMPSTR (mongoc_gridfs_file_get_md5 (file),
+                  "5eb63bbbe01eeed093cb22bb8f5acdc3");
+   mongoc_gridfs_file_destroy (file);
+
+   /* not if disabled */
+   opt.filename = "hello-no-md5";
+   opt.disable_md5 = true;
+   file = mongoc_gridfs_create_file (gridfs, &opt);
+   ASSERT_CMPSSIZE_T (
+      mongoc_gridfs_file_writev (file, iov, 2, 0), ==, (ssize_t) 11);
+   ASSERT (mongoc_gridfs_file_save (file));
+   ASSERT (!mongoc_gridfs_file_get_md5 (file));
+   mongoc_gridfs_file_destroy (file);
+   opt.disable_md5 = false;
+
+   /* not after a write that is not an append, even if the md5 was saved
+    * before it */
+   opt.filename = "jello";
+   file = mongoc_gridfs_create_file (gridfs, &opt);
+   ASSERT_CMPSSIZE_T (
+      mongoc_gridfs_file_writev (file, iov, 2, 0), ==, (ssize_t) 11);
+   ASSERT (mongoc_gridfs_file_save (file));
+   ASSERT (mongoc_gridfs_file_get_md5 (file));
+   ASSERT_CMPINT (mongoc_gridfs_file_seek (file, 0, SEEK_SET), ==, 0);
+   iov[0].iov_base = (void *) "j";
+   iov[0].iov_len = 1;
+   ASSERT_CMPSSIZE_T (
+      mongoc_gridfs_file_writev (file, iov, 1, 0), ==, (ssize_t) 1);
+   ASSERT (mongoc_gridfs_file_save (file));
+   ASSERT (!mongoc_gridfs_file_get_md5 (file));
+   mongoc_gridfs_file_destroy (file);
+
+   file = mongoc_gridfs_find_one_by_filename (gridfs, "jello", &error);
+   ASSERT_OR_PRINT (file, error);
+   ASSERT (!mongoc_gridfs_file_get_md5 (file));
+   mongoc_gridfs_file_destroy (file);
+
+   drop_collections (gridfs, &error);
+   mongoc_gridfs_destroy (gridfs);
+
+   mongoc_client_destroy (client);
+}
+
 static void
 test_seek (void)
 {
@@ -518,6 +609,70 @@ test_read (void)
 }
 
 
+static void
+test_read_borrowed (void)
+{
+   mongoc_gridfs_t *gridfs;
+   mongoc_gridfs_file_t *file;
+   mongoc_gridfs_file_opt_t opt = {0};
+   mongoc_stream_t *stream;
+   mongoc_client_t *client;
+   mongoc_iovec_t iov;
+   bson_error_t error;
+   const uint8_t *data;
+   uint8_t *expected;
+   int64_t len;
+   int64_t pos;
+   int64_t chunk_left;
+   ssize_t r;
+
+   client = test_framework_client_new ();
+   ASSERT (client);
+
+   ASSERT_OR_PRINT (gridfs = get_test_gridfs (client, "borrowed", &error),
+                    error);
+
+   mongoc_gridfs_drop (gridfs, &error);
+
+   stream = mongoc_stream_file_new_for_path (
+      BINARY_DIR "/gridfs-large.dat", O_RDONLY, 0);
+
+   opt.chunk_size = 4096;
+   file = mongoc_gridfs_create_file_from_stream (gridfs, stream, &opt);
+   ASSERT (file);
+   ASSERT (mongoc_gridfs_file_save (file));
+
+   len = mongoc_gridfs_file_get_length (file);
+   expected = bson_malloc ((size_t) len);
+
+   iov.iov_base = (void *) expected;
+   iov.iov_len = (size_t) len;
+   r = mongoc_gridfs_file_readv (file, &iov, 1, (size_t) len, 0);
+   ASSERT_CMPSSIZE_T (r, ==, (ssize_t) len);
+
+   /* start within the first chunk, then get one whole chunk at a time */
+   ASSERT_CMPINT (mongoc_gridfs_file_seek (file, 100, SEEK_SET), ==, 0);
+   pos = 100;
+
+   while ((r = mongoc_gridfs_file_read_borrowed (file, &data)) > 0) {
+      chunk_left = BSON_MIN (4096 - pos % 4096, len - pos);
+      ASSERT_CMPSSIZE_T (r, ==, (ssize_t) chunk_left);
+      ASSERT (!memcmp (data, expected + pos, (size_t) r));
+      pos += r;
+      ASSERT_CMPINT64 ((int64_t) mongoc_gridfs_file_tell (file), ==, pos);
+   }
+
+   ASSERT_CMPSSIZE_T (r, ==, (ssize_t) 0);
+   ASSERT_CMPINT64 (pos, ==, len);
+   ASSERT (!data);
+
+   bson_free (expected);
+   mongoc_gridfs_file_destroy (file);
+   drop_collections (gridfs, &error);
+   mongoc_gridfs_destroy (gridfs);
+   mongoc_client_destroy (client);
+}
+
 static void
 _check_chunk_count (mongoc_gridfs_t *gridfs, int64_t len, int64_t chunk_size)
 {
@@ -1099,6 +1254,433 @@ test_set_id (void)
    mongoc_client_destroy (client);
 }
 
+/* new chunks are inserted in batches, not upserted one round trip each */
+static void
+test_write_batches_chunks (void)
+{
+   mock_server_t *server;
+   mongoc_client_t *client;
+   mongoc_gridfs_t *gridfs;
+   mongoc_gridfs_file_t *file;
+   mongoc_gridfs_file_opt_t opt = {0};
+   mongoc_iovec_t iov;
+   char buf[] = "aaaabbbbccccdd";
+   future_t *future;
+   request_t *request;
+
+   server = mock_server_with_autoismaster (4);
+   mock_server_run (server);
+   client = mongoc_client_new_from_uri (mock_server_get_uri (server));
+   gridfs = _get_gridfs (server, client);
+
+   opt.chunk_size = 4;
+   file = mongoc_gridfs_create_file (gridfs, &opt);
+
+   /* three full chunks are queued without a round trip */
+   iov.iov_base = buf;
+   iov.iov_len = sizeof (buf) - 1;
+   ASSERT_CMPSSIZE_T (
+      mongoc_gridfs_file_writev (file, &iov, 1, 0), ==, (ssize_t) iov.iov_len);
+
+   /* saving inserts every chunk, including the last partial one, at once */
+   future = future_gridfs_file_save (file);
+   request = mock_server_receives_command (
+      server,
+      "db",
+      MONGOC_QUERY_NONE,
+      "{'insert': 'fs.chunks',"
+      " 'documents': [{'n': 0}, {'n': 1}, {'n': 2}, {'n': 3}]}");
+
+   mock_server_replies_simple (request, "{'ok': 1, 'n': 4}");
+   request_destroy (request);
+
+   request = mock_server_receives_command (
+      server,
+      "db",
+      MONGOC_QUERY_NONE,
+      "{'update': 'fs.files', 'updates': [{'u': {'$set': {'length': 14}}}]}");
+
+   mock_server_replies_simple (request, "{'ok': 1, 'n': 1}");
+   request_destroy (request);
+
+   ASSERT (future_get_bool (future));
+   future_destroy (future);
+
+   mongoc_gridfs_file_destroy (file);
+   mongoc_gridfs_destroy (gridfs);
+   mongoc_client_destroy (client);
+   mock_server_destroy (server);
+}
+
+
+/* a read-ahead window sets the batch size and prefetches the next batch */
+static void
+test_read_ahead (void)
+{
+   mock_server_t *server;
+   mongoc_client_t *client;
+   mongoc_gridfs_t *gridfs;
+   mongoc_gridfs_file_t *file;
+   mongoc_iovec_t iov;
+   char buf[12];
+   future_t *future;
+   request_t *request;
+
+   server = mock_server_with_autoismaster (4);
+   mock_server_run (server);
+   client = mongoc_client_new_from_uri (mock_server_get_uri (server));
+   gridfs = _get_gridfs (server, client);
+
+   file = _mongoc_gridfs_file_new_from_bson (
+      gridfs, tmp_bson ("{'_id': 1, 'length': 12, 'chunkSize': 4}"));
+   ASSERT (file);
+
+   ASSERT_CMPUINT32 (mongoc_gridfs_file_get_read_ahead (file), ==, 0);
+   mongoc_gridfs_file_set_read_ahead (file, 2);
+   ASSERT_CMPUINT32 (mongoc_gridfs_file_get_read_ahead (file), ==, 2);
+
+   /* read only the first batch, chunks 0 and 1 */
+   iov.iov_base = buf;
+   iov.iov_len = 8;
+   future = future_gridfs_file_readv (file, &iov, 1, 8, 0);
+
+   request = mock_server_receives_command (
+      server,
+      "db",
+      MONGOC_QUERY_SLAVE_OK,
+      "{'find': 'fs.chunks', 'filter': {'files_id': 1}, 'batchSize': 2}");
+
+   mock_server_replies_simple (
+      request,
+      "{'ok': 1, 'cursor': {'id': {'$numberLong': '123'},"
+      " 'ns': 'db.fs.chunks', 'firstBatch': ["
+      "  {'n': 0, 'data': {'$binary': 'YWFhYQ==', '$type': '00'}},"
+      "  {'n': 1, 'data': {'$binary': 'YmJiYg==', '$type': '00'}}]}}");
+
+   request_destroy (request);
+
+   ASSERT_CMPSSIZE_T (future_get_ssize_t (future), ==, (ssize_t) 8);
+   future_destroy (future);
+   ASSERT (memcmp (buf, "aaaabbbb", 8) == 0);
+
+   /* chunk 2 is not requested yet, but its getMore was sent with the first
+    * batch: without prefetch the driver would not send it until now */
+   request = mock_server_receives_command (
+      server,
+      "db",
+      MONGOC_QUERY_SLAVE_OK,
+      "{'getMore': {'$numberLong': '123'}, 'batchSize': 2}");
+
+   mock_server_replies_simple (
+      request,
+      "{'ok': 1, 'cursor': {'id': 0, 'ns': 'db.fs.chunks', 'nextBatch': ["
+      "  {'n': 2, 'data': {'$binary': 'Y2NjYw==', '$type': '00'}}]}}");
+
+   request_destroy (request);
+
+   /* chunk 2 comes from the prefetched reply, without another request */
+   iov.iov_base = buf + 8;
+   iov.iov_len = 4;
+   ASSERT_CMPSSIZE_T (mongoc_gridfs_file_readv (file, &iov, 1, 4, 0),
+                      ==,
+                      (ssize_t) 4);
+   ASSERT (memcmp (buf, "aaaabbbbcccc", sizeof buf) == 0);
+
+   mongoc_gridfs_file_destroy (file);
+   mongoc_gridfs_destroy (gridfs);
+   mongoc_client_destroy (client);
+   mock_server_destroy (server);
+}
+
+
+static void
+test_stream_sequential (void)
+{
+   mock_server_t *server;
+   mongoc_client_t *client;
+   mongoc_gridfs_t *gridfs;
+   mongoc_gridfs_file_t *file;
+   mongoc_stream_t *stream;
+   mongoc_iovec_t iov;
+   char buf[8];
+   future_t *future;
+   request_t *request;
+
+   server = mock_server_with_autoismaster (4);
+   mock_server_run (server);
+   client = mongoc_client_new_from_uri (mock_server_get_uri (server));
+   gridfs = _get_gridfs (server, client);
+
+   /* a window of 8 MB of chunks */
+   file = _mongoc_gridfs_file_new_from_bson (
+      gridfs, tmp_bson ("{'_id': 1, 'length': 8, 'chunkSize': 4}"));
+   ASSERT (file);
+   stream = mongoc_stream_gridfs_new_sequential (file);
+   ASSERT (stream);
+   ASSERT_CMPUINT32 (
+      mongoc_gridfs_file_get_read_ahead (file), ==, (uint32_t) 2 * 1024 * 1024);
+
+   /* the stream reads the chunks with that batch size */
+   iov.iov_base = buf;
+   iov.iov_len = sizeof buf;
+   future = future_gridfs_file_readv (file, &iov, 1, sizeof buf, 0);
+
+   request = mock_server_receives_command (
+      server,
+      "db",
+      MONGOC_QUERY_SLAVE_OK,
+      "{'find': 'fs.chunks', 'filter': {'files_id': 1}, 'batchSize': %d}",
+      2 * 1024 * 1024);
+
+   mock_server_replies_simple (
+      request,
+      "{'ok': 1, 'cursor': {'id': 0, 'ns': 'db.fs.chunks', 'firstBatch': ["
+      "  {'n': 0, 'data': {'$binary': 'YWFhYQ==', '$type': '00'}},"
+      "  {'n': 1, 'data': {'$binary': 'YmJiYg==', '$type': '00'}}]}}");
+
+   request_destroy (request);
+
+   ASSERT_CMPSSIZE_T (future_get_ssize_t (future), ==, (ssize_t) sizeof buf);
+   future_destroy (future);
+   ASSERT (memcmp (buf, "aaaabbbb", sizeof buf) == 0);
+
+   mongoc_stream_destroy (stream);
+   mongoc_gridfs_file_destroy (file);
+
+   /* chunks larger than the window are read one at a time */
+   file = _mongoc_gridfs_file_new_from_bson (
+      gridfs,
+      tmp_bson ("{'_id': 1, 'length': 8, 'chunkSize': %d}", 16 * 1024 * 1024));
+   ASSERT (file);
+   stream = mongoc_stream_gridfs_new_sequential (file);
+   ASSERT_CMPUINT32 (mongoc_gridfs_file_get_read_ahead (file), ==, 1);
+   mongoc_stream_destroy (stream);
+   mongoc_gridfs_file_destroy (file);
+
+   /* a window the caller set is kept */
+   file = _mongoc_gridfs_file_new_from_bson (
+      gridfs, tmp_bson ("{'_id': 1, 'length': 8, 'chunkSize': 4}"));
+   ASSERT (file);
+   mongoc_gridfs_file_set_read_ahead (file, 3);
+   stream = mongoc_stream_gridfs_new_sequential (file);
+   ASSERT_CMPUINT32 (mongoc_gridfs_file_get_read_ahead (file), ==, 3);
+   mongoc_stream_destroy (stream);
+   mongoc_gridfs_file_destroy (file);
+
+   mongoc_gridfs_destroy (gridfs);
+   mongoc_client_destroy (client);
+   mock_server_destroy (server);
+}
+
+
+static void
+_read_chunk (mongoc_gridfs_file_t *file, int64_t pos, const char *expected)
+{
+   mongoc_iovec_t iov;
+   char buf[4];
+
+   iov.iov_base = buf;
+   iov.iov_len = sizeof buf;
+
+   ASSERT_CMPINT (mongoc_gridfs_file_seek (file, pos, SEEK_SET), ==, 0);
+   ASSERT_CMPSSIZE_T (mongoc_gridfs_file_readv (file, &iov, 1, sizeof buf, 0),
+                      ==,
+                      (ssize_t) sizeof buf);
+   ASSERT (memcmp (buf, expected, sizeof buf) == 0);
+}
+
+
+static void
+_read_chunk_from_server (mock_server_t *server,
+                         mongoc_gridfs_file_t *file,
+                         int64_t pos,
+                         const char *filter,
+                         const char *reply,
+                         const char *expected)
+{
+   mongoc_iovec_t iov;
+   char buf[4];
+   future_t *future;
+   request_t *request;
+
+   iov.iov_base = buf;
+   iov.iov_len = sizeof buf;
+
+   ASSERT_CMPINT (mongoc_gridfs_file_seek (file, pos, SEEK_SET), ==, 0);
+   future = future_gridfs_file_readv (file, &iov, 1, sizeof buf, 0);
+   request = mock_server_receives_command (
+      server,
+      "db",
+      MONGOC_QUERY_SLAVE_OK,
+      "{'find': 'fs.chunks', 'filter': %s}",
+      filter);
+
+   mock_server_replies_simple (request, reply);
+   request_destroy (request);
+
+   ASSERT_CMPSSIZE_T (future_get_ssize_t (future), ==, (ssize_t) sizeof buf);
+   future_destroy (future);
+   ASSERT (memcmp (buf, expected, sizeof buf) == 0);
+}
+
+
+static void
+test_chunk_cache (void)
+{
+   mock_server_t *server;
+   mongoc_client_t *client;
+   mongoc_gridfs_t *gridfs;
+   mongoc_gridfs_file_t *file;
+
+   server = mock_server_with_autoismaster (4);
+   mock_server_run (server);
+   client = mongoc_client_new_from_uri (mock_server_get_uri (server));
+   gridfs = _get_gridfs (server, client);
+
+   file = _mongoc_gridfs_file_new_from_bson (
+      gridfs, tmp_bson ("{'_id': 1, 'length': 16, 'chunkSize': 4}"));
+   ASSERT (file);
+
+   /* room for two chunks */
+   ASSERT_CMPSIZE_T (mongoc_gridfs_file_get_cache_size (file), ==, (size_t) 0);
+   mongoc_gridfs_file_set_cache_size (file, 8);
+   ASSERT_CMPSIZE_T (mongoc_gridfs_file_get_cache_size (file), ==, (size_t) 8);
+
+   /* a miss fetches the chunk and the next one */
+   _read_chunk_from_server (
+      server,
+      file,
+      8,
+      "{'files_id': 1, 'n': {'$in': [2, 3]}}",
+      "{'ok': 1, 'cursor': {'id': 0, 'ns': 'db.fs.chunks', 'firstBatch': ["
+      "  {'n': 2, 'data': {'$binary': 'Y2NjYw==', '$type': '00'}},"
+      "  {'n': 3, 'data': {'$binary': 'ZGRkZA==', '$type': '00'}}]}}",
+      "cccc");
+
+   /* hits */
+   _read_chunk (file, 12, "dddd");
+   _read_chunk (file, 8, "cccc");
+
+   /* chunks 0 and 1 evict 3, then 2 */
+   _read_chunk_from_server (
+      server,
+      file,
+      0,
+      "{'files_id': 1, 'n': {'$in': [0, 1]}}",
+      "{'ok': 1, 'cursor': {'id': 0, 'ns': 'db.fs.chunks', 'firstBatch': ["
+      "  {'n': 0, 'data': {'$binary': 'YWFhYQ==', '$type': '00'}},"
+      "  {'n': 1, 'data': {'$binary': 'YmJiYg==', '$type': '00'}}]}}",
+      "aaaa");
+
+   _read_chunk (file, 4, "bbbb");
+
+   _read_chunk_from_server (
+      server,
+      file,
+      12,
+      "{'files_id': 1, 'n': {'$in': [3]}}",
+      "{'ok': 1, 'cursor': {'id': 0, 'ns': 'db.fs.chunks', 'firstBatch': ["
+      "  {'n': 3, 'data': {'$binary': 'ZGRkZA==', '$type': '00'}}]}}",
+      "dddd");
+
+   mongoc_gridfs_file_destroy (file);
+   mongoc_gridfs_destroy (gridfs);
+   mongoc_client_destroy (client);
+   mock_server_destroy (server);
+}
+
+static bool
+download_to_buf (const uint8_t *data, size_t len, int64_t offset, void *ctx)
+{
+   memcpy ((uint8_t *) ctx + offset, data, len);
+
+   return true;
+}
+
+
+static void
+test_download_range (void)
+{
+   mongoc_client_pool_t *pool;
+   mongoc_client_t *client;
+   mongoc_gridfs_t *gridfs;
+   mongoc_gridfs_file_t *file;
+   mongoc_gridfs_file_opt_t opt = {0};
+   mongoc_stream_t *stream;
+   mongoc_iovec_t iov;
+   bson_error_t error;
+   uint8_t *expected;
+   uint8_t *buf;
+   int64_t len;
+   ssize_t r;
+
+   pool = test_framework_client_pool_new ();
+   client = mongoc_client_pool_pop (pool);
+
+   ASSERT_OR_PRINT (gridfs = get_test_gridfs (client, "download", &error),
+                    error);
+
+   mongoc_gridfs_drop (gridfs, &error);
+
+   stream = mongoc_stream_file_new_for_path (
+      BINARY_DIR "/gridfs-large.dat", O_RDONLY, 0);
+
+   opt.chunk_size = 4096;
+   file = mongoc_gridfs_create_file_from_stream (gridfs, stream, &opt);
+   ASSERT (file);
+   ASSERT (mongoc_gridfs_file_save (file));
+
+   len = mongoc_gridfs_file_get_length (file);
+   expected = bson_malloc ((size_t) len);
+   buf = bson_malloc0 ((size_t) len);
+
+   iov.iov_base = (void *) expected;
+   iov.iov_len = (size_t) len;
+   r = mongoc_gridfs_file_readv (file, &iov, 1, (size_t) len, 0);
+   ASSERT_CMPSSIZE_T (r, ==, (ssize_t) len);
+
+   /* the pool's only client is checked out: don't block, download on the
+    * gridfs client alone */
+   mongoc_client_pool_max_size (pool, 1);
+   ASSERT_OR_PRINT (mongoc_gridfs_file_download_range (
+                       file, pool, 3, 0, -1, download_to_buf, buf, &error),
+                    error);
+   ASSERT (!memcmp (buf, expected, (size_t) len));
+   mongoc_client_pool_max_size (pool, 100);
+
+   /* the whole file, on three connections */
+   memset (buf, 0, (size_t) len);
+   ASSERT_OR_PRINT (mongoc_gridfs_file_download_range (
+                       file, pool, 3, 0, -1, download_to_buf, buf, &error),
+                    error);
+   ASSERT (!memcmp (buf, expected, (size_t) len));
+
+   /* a range starting and ending within chunks */
+   memset (buf, 0, (size_t) len);
+   ASSERT_OR_PRINT (
+      mongoc_gridfs_file_download_range (
+         file, pool, 0, 5000, 20000, download_to_buf, buf, &error),
+      error);
+   ASSERT (!memcmp (buf + 5000, expected + 5000, 20000));
+   ASSERT_CMPINT (buf[4999], ==, 0);
+   ASSERT_CMPINT (buf[25000], ==, 0);
+
+   ASSERT (!mongoc_gridfs_file_download_range (
+      file, pool, 3, len, 1, download_to_buf, buf, &error));
+   ASSERT_ERROR_CONTAINS (error,
+                          MONGOC_ERROR_COMMAND,
+                          MONGOC_ERROR_COMMAND_INVALID_ARG,
+                          "Range is outside of the file");
+
+   bson_free (buf);
+   bson_free (expected);
+   mongoc_gridfs_file_destroy (file);
+   drop_collections (gridfs, &error);
+   mongoc_gridfs_destroy (gridfs);
+   mongoc_client_pool_push (pool, client);
+   mongoc_client_pool_destroy (pool);
+}
+
 /* check gridfs inherits read / write concern, read prefs from the client */
 static void
 test_inherit_client_config (void)
@@ -1194,7 +1776,9 @@ test_gridfs_install (TestSuite *suite)
    TestSuite_AddLive (suite, "/GridFS/find_with_opts", test_find_with_opts);
    TestSuite_AddLive (suite, "/GridFS/properties", test_properties);
    TestSuite_AddLive (suite, "/GridFS/empty", test_empty);
+   TestSuite_AddLive (suite, "/GridFS/md5", test_md5);
    TestSuite_AddLive (suite, "/GridFS/read", test_read);
+   TestSuite_AddLive (suite, "/GridFS/read_borrowed", test_read_borrowed);
    TestSuite_AddLive (suite, "/GridFS/seek", test_seek);
    TestSuite_AddLive (suite, "/GridFS/stream", test_stream);
    TestSuite_AddLive (suite, "/GridFS/remove", test_remove);
@@ -1202,6 +1786,12 @@ test_gridfs_install (TestSuite *suite)
    TestSuite_AddLive (
       suite, "/GridFS/write_at_boundary", test_write_at_boundary);
    TestSuite_AddLive (suite, "/GridFS/write_past_end", test_write_past_end);
+   TestSuite_Add (
+      suite, "/GridFS/write_batches_chunks", test_write_batches_chunks);
+   TestSuite_Add (suite, "/GridFS/read_ahead", test_read_ahead);
+   TestSuite_Add (suite, "/GridFS/stream_sequential", test_stream_sequential);
+   TestSuite_Add (suite, "/GridFS/chunk_cache", test_chunk_cache);
+   TestSuite_AddLive (suite, "/GridFS/download_range", test_download_range);
    TestSuite_AddFull (suite,
                       "/GridFS/test_long_seek",
                       test_long_seek,
@@ -4,6 +4,8 @@
 #include <mongoc-matcher-private.h>
 
 #include "TestSuite.h"
+#include "test-libmongoc.h"
+#include "test-conveniences.h"
 
 BEGIN_IGNORE_DEPRECATIONS;
 
@@ -547,6 +549,598 @@ test_mongoc_matcher_in_basic (void)
    mongoc_matcher_destroy (matcher);
 }
 
+/* {key: {<op>: [0, 1, ..., 999, "a", ObjectId, 2.5, null, [1, 2]]}} */
+static bson_t *
+_in_hashed_spec (const char *op)
+{
+   bson_t *spec;
+   bson_t child;
+   bson_t array;
+   bson_oid_t oid;
+   char key[16];
+   const char *k;
+   uint32_t i;
+
+   bson_oid_init_from_string (&oid, "000000000000000000001234");
+
+   spec = bson_new ();
+   BSON_APPEND_DOCUMENT_BEGIN (spec, "key", &child);
+   bson_append_array_begin (&child, op, -1, &array);
+   for (i = 0; i < 1000; i++) {
+      bson_uint32_to_string (i, &k, key, sizeof key);
+      bson_append_int32 (&array, k, -1, (int32_t) i);
+   }
+   BSON_APPEND_UTF8 (&array, "1000", "a");
+   BSON_APPEND_OID (&array, "1001", &oid);
+   BSON_APPEND_DOUBLE (&array, "1002", 2.5);
+   BSON_APPEND_NULL (&array, "1003");
+   BSON_APPEND_ARRAY (&array, "1004", tmp_bson ("{'0': 1, '1': 2}"));
+   bson_append_array_end (&child, &array);
+   bson_append_document_end (spec, &child);
+
+   return spec;
+}
+
+
+static void
+test_mongoc_matcher_in_hashed (void)
+{
+   struct {
+      const char *doc;
+      bool in;
+   } checks[] = {
+      {"{'key': 500}", true},
+      {"{'key': {'$numberLong': '999'}}", true},
+      {"{'key': 7.0}", true},
+      {"{'key': -0.0}", true},
+      {"{'key': true}", true},
+      {"{'key': 2.5}", true},
+      {"{'key': 7.5}", false},
+      {"{'key': 1000}", false},
+      {"{'key': -1}", false},
+      {"{'key': 'a'}", true},
+      {"{'key': 'b'}", false},
+      {"{'key': '1'}", false},
+      {"{'key': {'$oid': '000000000000000000001234'}}", true},
+      {"{'key': {'$oid': '000000000000000000004321'}}", false},
+      {"{'key': null}", true},
+      {"{'key': {'$undefined': true}}", true},
+      {"{'key': [1, 2]}", true},
+      {"{'key': [2, 1]}", false},
+      {"{'key': {'a': 1}}", false},
+   };
+   const char *ops[] = {"$in", "$nin"};
+   mongoc_matcher_t *matcher;
+   bson_t *spec;
+   bson_error_t error;
+   size_t i;
+   int j;
+   bool r;
+
+   for (j = 0; j < 2; j++) {
+      spec = _in_hashed_spec (ops[j]);
+      matcher = mongoc_matcher_new (spec, &error);
+      ASSERT_OR_PRINT (matcher, error);
+
+      for (i = 0; i < sizeof checks / sizeof checks[0]; i++) {
+         r = mongoc_matcher_match (matcher, tmp_bson (checks[i].doc));
+         if (r != (checks[i].in == (j == 0))) {
+            fprintf (stderr,
+                     "%s should %shave matched %s\n",
+                     ops[j],
+                     r ? "not " : "",
+                     checks[i].doc);
+            abort ();
+         }
+      }
+
+      mongoc_matcher_destroy (matcher);
+      bson_destroy (spec);
+   }
+}
+
+
+typedef struct {
+   int32_t last;
+   int32_t n;
+   int32_t stop_after;
+} match_file_ctx_t;
+
+
+static bool
+_match_file_cb (const bson_t *doc, void *data)
+{
+   match_file_ctx_t *ctx = (match_file_ctx_t *) data;
+   bson_iter_t iter;
+
+   BSON_ASSERT (bson_iter_init_find (&iter, doc, "i"));
+   ASSERT_CMPINT (bson_iter_int32 (&iter), >, ctx->last);
+   ASSERT_CMPINT (bson_iter_int32 (&iter) % 3, ==, 0);
+   ctx->last = bson_iter_int32 (&iter);
+   ctx->n++;
+
+   return ctx->n != ctx->stop_after;
+}
+
+
+static void
+_match_file (mongoc_matcher_t *matcher,
+             const char *path,
+             uint32_t n_threads,
+             int32_t stop_after,
+             match_file_ctx_t *ctx,
+             bool expect_ok)
+{
+   bson_error_t error;
+   bool r;
+
+   ctx->last = -1;
+   ctx->n = 0;
+   ctx->stop_after = stop_after;
+
+   r = mongoc_matcher_match_file (
+      matcher, path, n_threads, _match_file_cb, ctx, &error);
+
+   if (expect_ok) {
+      ASSERT_OR_PRINT (r, error);
+   } else {
+      BSON_ASSERT (!r);
+      ASSERT_CMPINT (ctx->n, ==, 0);
+   }
+}
+
+
+/* several chunks of documents, matched in parallel, reported in order */
+static void
+test_mongoc_matcher_match_file (void)
+{
+   const int32_t n = 200 * 1000;
+   mongoc_matcher_t *matcher;
+   match_file_ctx_t ctx;
+   bson_error_t error;
+   char path[64];
+   FILE *file;
+   bson_t doc;
+   int32_t i;
+
+   bson_snprintf (path,
+                  sizeof path,
+                  "test-matcher-%" PRId64 ".bson",
+                  bson_get_monotonic_time ());
+
+   file = fopen (path, "wb");
+   BSON_ASSERT (file);
+
+   for (i = 0; i < n; i++) {
+      bson_init (&doc);
+      BSON_APPEND_INT32 (&doc, "i", i);
+      BSON_APPEND_BOOL (&doc, "three", i % 3 == 0);
+      BSON_APPEND_UTF8 (&doc, "pad", "abcdefghijklmnopqrstuvwxyz");
+      BSON_ASSERT (fwrite (bson_get_data (&doc), 1, doc.len, file) ==
+                   doc.len);
+      bson_destroy (&doc);
+   }
+
+   BSON_ASSERT (fclose (file) == 0);
+
+   matcher = mongoc_matcher_new (tmp_bson ("{'three': true}"), &error);
+   ASSERT_OR_PRINT (matcher, error);
+
+   _match_file (matcher, path, 0, 0, &ctx, true);
+   ASSERT_CMPINT (ctx.n, ==, (n + 2) / 3);
+
+   _match_file (matcher, path, 3, 0, &ctx, true);
+   ASSERT_CMPINT (ctx.n, ==, (n + 2) / 3);
+
+   /* stop when the callback returns false */
+   _match_file (matcher, path, 2, 10, &ctx, true);
+   ASSERT_CMPINT (ctx.n, ==, 10);
+
+   /* a truncated document at the end */
+   file = fopen (path, "ab");
+   BSON_ASSERT (file);
+   BSON_ASSERT (fwrite ("\x10\x00\x00", 1, 3, file) == 3);
+   BSON_ASSERT (fclose (file) == 0);
+
+   _match_file (matcher, path, 0, 0, &ctx, false);
+   BSON_ASSERT (remove (path) == 0);
+
+   /* no such file */
+   _match_file (matcher, path, 0, 0, &ctx, false);
+
+   mongoc_matcher_destroy (matcher);
+}
+
+
+typedef struct {
+   const char *spec;
+   const char *doc;
+   bool match;
+} program_test_t;
+
+
+/* the compiled program must agree with the optree it was compiled from */
+static void
+_check_program_tests (const program_test_t *tests, size_t n_tests)
+{
+   size_t i;
+   bson_t *spec;
+   bson_t *doc;
+   bson_error_t error;
+   mongoc_matcher_t *matcher;
+
+   for (i = 0; i < n_tests; i++) {
+      spec = bson_new_from_json ((uint8_t *) tests[i].spec, -1, &error);
+      ASSERT_OR_PRINT (spec, error);
+      doc = bson_new_from_json ((uint8_t *) tests[i].doc, -1, &error);
+      ASSERT_OR_PRINT (doc, error);
+
+      matcher = mongoc_matcher_new (spec, &error);
+      ASSERT_OR_PRINT (matcher, error);
+
+      if (mongoc_matcher_match (matcher, doc) != tests[i].match ||
+          _mongoc_matcher_op_match (matcher->optree, doc) != tests[i].match) {
+         fprintf (stderr,
+                  "query:\n\n%s\n\nshould %shave matched:\n\n%s\n",
+                  tests[i].spec,
+                  tests[i].match ? "" : "not ",
+                  tests[i].doc);
+         abort ();
+      }
+
+      mongoc_matcher_destroy (matcher);
+      bson_destroy (doc);
+      bson_destroy (spec);
+   }
+}
+
+
+static void
+test_mongoc_matcher_program (void)
+{
+   program_test_t tests[] = {
+      {"{\"a.b\": 1}", "{\"a\": {\"b\": 1}}", true},
+      {"{\"a.b\": 1}", "{\"a\": {\"b\": 2}}", false},
+      {"{\"a.b\": 1}", "{\"a\": 1}", false},
+      {"{\"a.b\": 1}", "{\"a\": 1, \"a\": {\"b\": 1}}", false},
+      {"{\"a\": 1}", "{\"a\": 1, \"a\": 2}", true},
+      {"{\"a\": 2}", "{\"a\": 1, \"a\": 2}", false},
+      {"{\"a.1\": 5}", "{\"a\": [4, 5]}", true},
+      {"{\"a.b.c\": 1, \"a.b\": {\"$exists\": true}}",
+       "{\"a\": {\"b\": {\"c\": 1}}}",
+       true},
+      {"{\"a\": {\"$exists\": false}, \"ab\": 1}", "{\"ab\": 1}", true},
+      {"{\"a.b\": {\"$exists\": false}}", "{\"a\": {\"c\": 1}}", true},
+      {"{\"a.b\": {\"$type\": \"x\"}}", "{\"a\": {\"b\": \"y\"}}", true},
+      {"{\"a.b\": {\"$type\": \"x\"}}", "{\"a\": {\"b\": 1}}", false},
+      {"{\"a.b\": {\"$not\": {\"$gt\": 1}}}", "{\"a\": {\"b\": 0}}", true},
+      {"{\"a.b\": {\"$not\": {\"$gt\": 1}}}", "{\"a\": {\"b\": 2}}", false},
+      {"{\"$nor\": [{\"a\": 1}, {\"b\": 1}]}", "{\"a\": 2, \"b\": 2}", true},
+      {"{\"$nor\": [{\"a\": 1}, {\"b\": 1}]}", "{\"a\": 2, \"b\": 1}", false},
+      {"{\"$or\": [{\"x.y\": 1}, {\"a\": 1}, {\"$and\": [{\"b\": 1}, "
+       "{\"x.z\": 1}]}]}",
+       "{\"b\": 1, \"x\": {\"z\": 1}}",
+       true},
+      {"{\"z\": 1, \"$or\": [{\"a\": {\"$lt\": 0}}, {\"a\": {\"$gt\": 9}}], "
+       "\"b\": {\"$in\": [1, 2]}}",
+       "{\"a\": 10, \"b\": 2, \"z\": 1}",
+       true},
+      {"{\"z\": 1, \"$or\": [{\"a\": {\"$lt\": 0}}, {\"a\": {\"$gt\": 9}}], "
+       "\"b\": {\"$in\": [1, 2]}}",
+       "{\"a\": 5, \"b\": 2, \"z\": 1}",
+       false},
+   };
+
+   _check_program_tests (tests, sizeof tests / sizeof (program_test_t));
+}
+
+
+/* like the server, paths reach into arrays and match any of their values */
+static void
+test_mongoc_matcher_array_traversal (void)
+{
+   program_test_t tests[] = {
+      {"{\"a\": 2}", "{\"a\": [1, 2, 3]}", true},
+      {"{\"a\": 4}", "{\"a\": [1, 2, 3]}", false},
+      {"{\"a\": {\"$gt\": 2}}", "{\"a\": [1, 3]}", true},
+      {"{\"a\": {\"$gt\": 5}}", "{\"a\": [1, 3]}", false},
+      {"{\"a\": {\"$in\": [5, 2]}}", "{\"a\": [1, 2]}", true},
+      {"{\"a\": {\"$ne\": 2}}", "{\"a\": [1, 2]}", false},
+      {"{\"a\": {\"$ne\": 4}}", "{\"a\": [1, 2]}", true},
+      {"{\"a\": {\"$nin\": [2, 5]}}", "{\"a\": [1, 2]}", false},
+      /* a missing field is equal to null, and to nothing else */
+      {"{\"a\": {\"$ne\": 2}}", "{\"b\": 2}", true},
+      {"{\"a\": {\"$nin\": [2, 5]}}", "{\"b\": 2}", true},
+      {"{\"a.b\": {\"$ne\": 2}}", "{\"a\": [{\"c\": 2}]}", true},
+      {"{\"a\": {\"$ne\": null}}", "{\"b\": 2}", false},
+      {"{\"a\": {\"$nin\": [2, null]}}", "{\"b\": 2}", false},
+      {"{\"a\": null}", "{\"b\": 2}", true},
+      {"{\"a\": {\"$in\": [2, null]}}", "{\"b\": 2}", true},
+      {"{\"a\": 2}", "{\"b\": 2}", false},
+      {"{\"a\": {\"$type\": \"x\"}}", "{\"a\": [1, \"y\"]}", true},
+      {"{\"a.b\": 2}", "{\"a\": [{\"b\": 1}, {\"b\": 2}]}", true},
+      {"{\"a.b\": 3}", "{\"a\": [{\"b\": 1}, {\"b\": 2}]}", false},
+      {"{\"a.b.c\": 1}",
+       "{\"a\": [{\"b\": [{\"c\": 2}, {\"c\": 1}]}]}",
+       true},
+      {"{\"a.0.b\": 1}", "{\"a\": [{\"b\": 1}]}", true},
+      {"{\"a.b\": {\"$exists\": true}}",
+       "{\"a\": [{\"c\": 1}, {\"b\": 1}]}",
+       true},
+      {"{\"a.b\": {\"$exists\": false}}", "{\"a\": [{\"c\": 1}]}", true},
+      {"{\"a.b\": 1, \"c\": 1}", "{\"a\": [{\"b\": 1}], \"c\": 1}", true},
+      {"{\"$or\": [{\"a.b\": 5}, {\"c\": 1}]}",
+       "{\"a\": [{\"b\": 5}], \"c\": 2}",
+       true},
+   };
+
+   _check_program_tests (tests, sizeof tests / sizeof (program_test_t));
+}
+
+
+static void
+test_mongoc_matcher_elem_match (void)
+{
+   program_test_t tests[] = {
+      {"{\"a\": {\"$elemMatch\": {\"$gt\": 1, \"$lt\": 3}}}",
+       "{\"a\": [0, 2]}",
+       true},
+      {"{\"a\": {\"$elemMatch\": {\"$gt\": 1, \"$lt\": 3}}}",
+       "{\"a\": [0, 4]}",
+       false},
+      {"{\"a\": {\"$elemMatch\": {\"b\": 1, \"c\": 2}}}",
+       "{\"a\": [{\"b\": 1, \"c\": 1}, {\"b\": 2, \"c\": 2}]}",
+       false},
+      {"{\"a\": {\"$elemMatch\": {\"b\": 1, \"c\": 2}}}",
+       "{\"a\": [{\"b\": 1}, {\"b\": 1, \"c\": 2}]}",
+       true},
+      {"{\"a\": {\"$elemMatch\": {\"b\": 1}}}", "{\"a\": {\"b\": 1}}", false},
+      {"{\"x.a\": {\"$elemMatch\": {\"$or\": [{\"b\": 1}, {\"b\": 2}]}}}",
+       "{\"x\": {\"a\": [{\"b\": 2}]}}",
+       true},
+      {"{\"a\": {\"$elemMatch\": {\"$elemMatch\": {\"$gt\": 1}}}}",
+       "{\"a\": [[0], [2]]}",
+       true},
+   };
+
+   bson_error_t error;
+   bson_t *spec;
+
+   _check_program_tests (tests, sizeof tests / sizeof (program_test_t));
+
+   spec = BCON_NEW ("a", "{", "$elemMatch", BCON_INT32 (1), "}");
+   BSON_ASSERT (!mongoc_matcher_new (spec, &error));
+   ASSERT_ERROR_CONTAINS (error,
+                          MONGOC_ERROR_MATCHER,
+                          MONGOC_ERROR_MATCHER_INVALID,
+                          "$elemMatch needs a non-empty document");
+   bson_destroy (spec);
+}
+
+
+#ifdef BSON_OS_UNIX
+typedef struct {
+   const char *pattern;
+   const char *options;
+   const char *value;
+   bool match;
+} regex_test_t;
+
+
+static void
+test_mongoc_matcher_regex (void)
+{
+   regex_test_t tests[] = {
+      {"^ab", "", "abc", true},
+      {"^ab", "", "xabc", false},
+      {"^AB", "i", "abc", true},
+      {"^b", "", "a\nb", false},
+      {"^b", "m", "a\nb", true},
+      {"^b", "s", "a\nb", false},
+      /* like PCRE, "." matches a newline only with "s" */
+      {"a.b", "", "a\nb", false},
+      {"a.b", "s", "a\nb", true},
+      {"a.b", "m", "a\nb", false},
+      {"a.b", "ms", "a\nb", true},
+      {"^b.c", "ms", "a\nb\nc", true},
+      /* and a negated bracket expression always does */
+      {"a[^x]b", "", "a\nb", true},
+      {"a[^x]b", "m", "a\nb", true},
+      {"a[^x]b", "m", "axb", false},
+      {"[[:digit:]]{2}", "", "a12", true},
+   };
+
+   const char *pcre_only[] = {
+      "\\d+", "\\bword", "a+?", "a*+", "a{2}?", "(?:ab)", "a(?=b)", "[\\w]"};
+   int n_tests = sizeof tests / sizeof (regex_test_t);
+   mongoc_matcher_t *matcher;
+   bson_error_t error;
+   bson_t *specs[2];
+   bson_t *doc;
+   int i;
+   int j;
+
+   for (i = 0; i < n_tests; i++) {
+      /* a BSON regular expression, and the $regex operator */
+      specs[0] =
+         BCON_NEW ("a", BCON_REGEX (tests[i].pattern, tests[i].options));
+      specs[1] = BCON_NEW ("a",
+                           "{",
+                           "$regex",
+                           BCON_UTF8 (tests[i].pattern),
+                           "$options",
+                           BCON_UTF8 (tests[i].options),
+                           "}");
+      doc = BCON_NEW ("a", "[", "x", BCON_UTF8 (tests[i].value), "]");
+
+      for (j = 0; j < 2; j++) {
+         matcher = mongoc_matcher_new (specs[j], &error);
+         ASSERT_OR_PRINT (matcher, error);
+
+         if (mongoc_matcher_match (matcher, doc) != tests[i].match ||
+             _mongoc_matcher_op_match (matcher->optree, doc) !=
+                tests[i].match) {
+            fprintf (stderr,
+                     "/%s/%s should %shave matched \"%s\"\n",
+                     tests[i].pattern,
+                     tests[i].options,
+                     tests[i].match ? "" : "not ",
+                     tests[i].value);
+            abort ();
+         }
+
+         mongoc_matcher_destroy (matcher);
+         bson_destroy (specs[j]);
+      }
+
+      bson_destroy (doc);
+   }
+
+   specs[0] = BCON_NEW ("a", "{", "$regex", "(", "}");
+   BSON_ASSERT (!mongoc_matcher_new (specs[0], &error));
+   ASSERT_ERROR_CONTAINS (error,
+                          MONGOC_ERROR_MATCHER,
+                          MONGOC_ERROR_MATCHER_INVALID,
+                          "Invalid $regex \"(\"");
+   bson_destroy (specs[0]);
+
+   specs[0] = BCON_NEW ("a", "{", "$regex", "a", "$options", "q", "}");
+   BSON_ASSERT (!mongoc_matcher_new (specs[0], &error));
+   ASSERT_ERROR_CONTAINS (error,
+                          MONGOC_ERROR_MATCHER,
+                          MONGOC_ERROR_MATCHER_INVALID,
+                          "Unsupported $regex option \"q\"");
+   bson_destroy (specs[0]);
+
+   /* PCRE syntax that POSIX reads differently, or not at all */
+   for (i = 0; i < (int) (sizeof pcre_only / sizeof pcre_only[0]); i++) {
+      specs[0] = BCON_NEW ("a", "{", "$regex", pcre_only[i], "}");
+      BSON_ASSERT (!mongoc_matcher_new (specs[0], &error));
+      ASSERT_ERROR_CONTAINS (error,
+                             MONGOC_ERROR_MATCHER,
+                             MONGOC_ERROR_MATCHER_INVALID,
+                             "Unsupported $regex syntax");
+      bson_destroy (specs[0]);
+   }
+
+   specs[0] = BCON_NEW ("a", "{", "$options", "i", "}");
+   BSON_ASSERT (!mongoc_matcher_new (specs[0], &error));
+   ASSERT_ERROR_CONTAINS (error,
+                          MONGOC_ERROR_MATCHER,
+                          MONGOC_ERROR_MATCHER_INVALID,
+                          "Invalid $regex for \"a\"");
+   bson_destroy (specs[0]);
+}
+#endif
+
+
+/* documents per second with the optree and with the compiled program, for a
+ * query with several predicates on one subdocument */
+static void
+test_mongoc_matcher_bench (void *ctx)
+{
+   const int n = 1000 * 1000;
+   mongoc_matcher_t *matcher;
+   bson_t *spec;
+   bson_t *doc;
+   bson_error_t error;
+   int64_t started;
+   int matched;
+   int mode;
+   int i;
+
+   spec = BCON_NEW ("kind",
+                    "user",
+                    "profile.age",
+                    "{",
+                    "$gte",
+                    BCON_INT32 (18),
+                    "}",
+                    "profile.age",
+                    "{",
+                    "$lt",
+                    BCON_INT32 (65),
+                    "}",
+                    "profile.city",
+                    "New York",
+                    "profile.zip",
+                    "{",
+                    "$in",
+                    "[",
+                    BCON_INT32 (10001),
+                    BCON_INT32 (11201),
+                    "]",
+                    "}",
+                    "profile.color",
+                    "{",
+                    "$ne",
+                    "red",
+                    "}",
+                    "profile.score",
+                    "{",
+                    "$gt",
+                    BCON_DOUBLE (0.5),
+                    "}",
+                    "profile.active",
+                    BCON_BOOL (true));
+
+   doc = BCON_NEW ("_id",
+                   BCON_INT32 (1),
+                   "kind",
+                   "user",
+                   "name",
+                   "Jane Doe",
+                   "profile",
+                   "{",
+                   "active",
+                   BCON_BOOL (true),
+                   "age",
+                   BCON_INT32 (30),
+                   "city",
+                   "New York",
+                   "color",
+                   "blue",
+                   "score",
+                   BCON_DOUBLE (0.75),
+                   "state",
+                   "New York",
+                   "zip",
+                   BCON_INT32 (11201),
+                   "}",
+                   "tags",
+                   "[",
+                   "a",
+                   "b",
+                   "c",
+                   "]");
+
+   matcher = mongoc_matcher_new (spec, &error);
+   ASSERT_OR_PRINT (matcher, error);
+
+   for (mode = 0; mode < 2; mode++) {
+      matched = 0;
+      started = bson_get_monotonic_time ();
+
+      for (i = 0; i < n; i++) {
+         if (mode == 0 ? _mongoc_matcher_op_match (matcher->optree, doc)
+                       : mongoc_matcher_match (matcher, doc)) {
+            matched++;
+         }
+      }
+
+      ASSERT_CMPINT (matched, ==, n);
+      fprintf (stderr,
+               "%s: %.0f docs/sec\n",
+               mode == 0 ? "optree" : "program",
+               (double) n * 1000000.0 /
+                  (double) BSON_MAX (bson_get_monotonic_time () - started, 1));
+   }
+
+   mongoc_matcher_destroy (matcher);
+   bson_destroy (doc);
+   bson_destroy (spec);
+}
+
 END_IGNORE_DEPRECATIONS;
 
 void
@@ -554,6 +1148,12 @@ test_matcher_install (TestSuite *suite)
 {
    TestSuite_Add (suite, "/Matcher/basic", test_mongoc_matcher_basic);
    TestSuite_Add (suite, "/Matcher/array", test_mongoc_matcher_array);
+   TestSuite_Add (
+      suite, "/Matcher/array/traversal", test_mongoc_matcher_array_traversal);
+   TestSuite_Add (suite, "/Matcher/elem_match", test_mongoc_matcher_elem_match);
+#ifdef BSON_OS_UNIX
+   TestSuite_Add (suite, "/Matcher/regex", test_mongoc_matcher_regex);
+#endif
    TestSuite_Add (suite, "/Matcher/compare", test_mongoc_matcher_compare);
    TestSuite_Add (suite, "/Matcher/logic", test_mongoc_matcher_logic_ops);
    TestSuite_Add (suite, "/Matcher/bad_spec", test_mongoc_matcher_bad_spec);
@@ -562,4 +1162,13 @@ test_matcher_install (TestSuite *suite)
    TestSuite_Add (suite, "/Matcher/eq/int64", test_mongoc_matcher_eq_int64);
    TestSuite_Add (suite, "/Matcher/eq/doc", test_mongoc_matcher_eq_doc);
    TestSuite_Add (suite, "/Matcher/in/basic", test_mongoc_matcher_in_basic);
+   TestSuite_Add (suite, "/Matcher/in/hashed", test_mongoc_matcher_in_hashed);
+   TestSuite_Add (suite, "/Matcher/program", test_mongoc_matcher_program);
+   TestSuite_Add (suite, "/Matcher/match_file", test_mongoc_matcher_match_file);
+   TestSuite_AddFull (suite,
+                      "/Matcher/bench",
+                      test_mongoc_matcher_bench,
+                      NULL,
+                      NULL,
+                      test_framework_skip_if_slow);
 }
@@ -47,9 +47,81 @@ test_rand_simple (void)
 }
 
 
+static void
+test_validate_new_document (void)
+{
+   /* long strings so the vectorized ASCII scan runs on every platform */
+   const char *long_ascii = "0123456789abcdef0123456789abcdef";
+   const char *long_utf8 = "0123456789abcdef\xc3\xa9 0123456789abcdef";
+   const char *bad_utf8 = "0123456789abcdef0123456789\xc3";
+   bson_t *docs[] = {
+      tmp_bson ("{}"),
+      tmp_bson ("{'_id': 1}"),
+      tmp_bson ("{'a': 1, '_id': {'b': [1, 2, {'c': 'd'}]}}"),
+      tmp_bson ("{'a': {'_id': 1}}"),
+      tmp_bson ("{'a.b': 1}"),
+      tmp_bson ("{'a': {'b.c': 1}}"),
+      tmp_bson ("{'a': [{'b.c': 1}]}"),
+      tmp_bson ("{'$a': 1}"),
+      tmp_bson ("{'a': {'$b': 1}}"),
+      tmp_bson ("{'': 1}"),
+      tmp_bson ("{'a': {'': 1}}"),
+      tmp_bson ("{'a': {'$ref': 'c', '$id': 1}}"),
+      tmp_bson ("{'a': {'$ref': 'c', '$id': 1, '$db': 'd'}}"),
+      tmp_bson ("{'a': {'$ref': 'c'}}"),
+      tmp_bson ("{'a': {'$id': 1, '$ref': 'c'}}"),
+      tmp_bson ("{'a': {'$regex': 'x', '$options': ''}}"),
+      tmp_bson ("{'a': {'$date': 0}, '_id': {'$oid': '%s'}}",
+                "0123456789abcdef01234567"),
+      tmp_bson ("{'a': {'$numberLong': '1'}, 'b': {'$minKey': 1}}"),
+      tmp_bson ("{'\xc3\xa9': 1}"),
+      bson_new (),
+      bson_new (),
+      bson_new (),
+      bson_new (),
+   };
+   const size_t n_docs = sizeof docs / sizeof (bson_t *);
+   bson_error_t error;
+   bool has_id;
+   bool r;
+   size_t i;
+
+   BSON_APPEND_UTF8 (docs[n_docs - 4], "a", long_ascii);
+   BSON_APPEND_UTF8 (docs[n_docs - 3], "a", long_utf8);
+   bson_append_utf8 (docs[n_docs - 2], "a", 1, bad_utf8, -1);
+   bson_append_utf8 (docs[n_docs - 1], "_id", 3, "a\0b", 3);
+
+   for (i = 0; i < n_docs; i++) {
+      r = _mongoc_validate_new_document_find_id (docs[i], &has_id, &error);
+      ASSERT_CMPINT (
+         r,
+         ==,
+         bson_validate (docs[i],
+                        BSON_VALIDATE_UTF8 | BSON_VALIDATE_EMPTY_KEYS |
+                           BSON_VALIDATE_DOT_KEYS | BSON_VALIDATE_DOLLAR_KEYS,
+                        NULL));
+
+      if (r) {
+         ASSERT_CMPINT (has_id, ==, bson_has_field (docs[i], "_id"));
+      } else {
+         ASSERT_ERROR_CONTAINS (error,
+                                MONGOC_ERROR_COMMAND,
+                                MONGOC_ERROR_COMMAND_INVALID_ARG,
+                                "document to insert contains invalid keys");
+      }
+   }
+
+   for (i = n_docs - 4; i < n_docs; i++) {
+      bson_destroy (docs[i]);
+   }
+}
+
+
 void
 test_util_install (TestSuite *suite)
 {
    TestSuite_Add (suite, "/Util/command_name", test_command_name);
    TestSuite_Add (suite, "/Util/rand_simple", test_rand_simple);
+   TestSuite_Add (
+      suite, "/Util/validate_new_document", test_validate_new_document);
 }
@@ -10,6 +10,7 @@
 
 #include "test-libmongoc.h"
 #include "test-conveniences.h"
+#include "mock_server/mock-server.h"
 
 
 static void
@@ -231,7 +232,8 @@ test_bypass_validation (void *context)
    mongoc_bulk_operation_destroy (bulk);
    /* }}} */
 
-   /* {{{ w=0 and bypass_document_validation=set fails */
+   /* {{{ w=0 and bypass_document_validation=set fails, unless the server
+    * accepts OP_MSG and the write is sent with moreToCome */
    bulk = mongoc_collection_create_bulk_operation (collection, true, NULL);
    wr = mongoc_write_concern_new ();
    mongoc_write_concern_set_w (wr, 0);
@@ -244,12 +246,16 @@ test_bypass_validation (void *context)
    }
    r = mongoc_bulk_operation_execute (bulk, &reply, &error);
    bson_destroy (&reply);
-   ASSERT_OR_PRINT (!r, error);
-   ASSERT_ERROR_CONTAINS (
-      error,
-      MONGOC_ERROR_COMMAND,
-      MONGOC_ERROR_COMMAND_INVALID_ARG,
-      "Cannot set bypassDocumentValidation for unacknowledged writes");
+   if (test_framework_max_wire_version_at_least (WIRE_VERSION_OP_MSG)) {
+      ASSERT_OR_PRINT (r, error);
+   } else {
+      ASSERT (!r);
+      ASSERT_ERROR_CONTAINS (
+         error,
+         MONGOC_ERROR_COMMAND,
+         MONGOC_ERROR_COMMAND_INVALID_ARG,
+         "Cannot set bypassDocumentValidation for unacknowledged writes");
+   }
    mongoc_bulk_operation_destroy (bulk);
    mongoc_write_concern_destroy (wr);
    /* }}} */
@@ -263,10 +269,153 @@ test_bypass_validation (void *context)
    mongoc_client_destroy (client);
 }
 
+/* unacknowledged writes to servers that accept OP_MSG are sent with the
+ * "moreToCome" flag, and the client does not wait for a reply */
+static void
+test_unacknowledged_op_msg (void)
+{
+   mock_server_t *server;
+   mongoc_client_t *client;
+   mongoc_collection_t *collection;
+   mongoc_write_concern_t *wc;
+   mongoc_bulk_operation_t *bulk;
+   request_t *request;
+   bson_error_t error;
+   bson_t reply;
+   uint32_t r;
+
+   server = mock_server_with_autoismaster (WIRE_VERSION_OP_MSG);
+   mock_server_run (server);
+   client = mongoc_client_new_from_uri (mock_server_get_uri (server));
+   collection = mongoc_client_get_collection (client, "db", "collection");
+   wc = mongoc_write_concern_new ();
+   mongoc_write_concern_set_w (wc, 0);
+
+   /* no future: the call must return without the server replying */
+   ASSERT_OR_PRINT (mongoc_collection_insert (collection,
+                                              MONGOC_INSERT_NONE,
+                                              tmp_bson ("{'_id': 1}"),
+                                              wc,
+                                              &error),
+                    error);
+
+   request = mock_server_receives_msg (server,
+                                       MONGOC_OP_MSG_FLAG_MORE_TO_COME,
+                                       "{'insert': 'collection',"
+                                       " '$db': 'db',"
+                                       " 'writeConcern': {'w': 0},"
+                                       " 'documents': [{'_id': 1}]}");
+   ASSERT (request);
+   request_destroy (request);
+
+   /* unlike legacy opcodes, OP_MSG can bypass document validation */
+   bulk = mongoc_collection_create_bulk_operation (collection, true, wc);
+   mongoc_bulk_operation_set_bypass_document_validation (bulk, true);
+   mongoc_bulk_operation_remove (bulk, tmp_bson ("{'_id': 1}"));
+   r = mongoc_bulk_operation_execute (bulk, &reply, &error);
+   ASSERT_OR_PRINT (r, error);
+
+   request = mock_server_receives_msg (server,
+                                       MONGOC_OP_MSG_FLAG_MORE_TO_COME,
+                                       "{'delete': 'collection',"
+                                       " '$db': 'db',"
+                                       " 'bypassDocumentValidation': true,"
+                                       " 'deletes': [{'q': {'_id': 1}}]}");
+   ASSERT (request);
+   request_destroy (request);
+
+   bson_destroy (&reply);
+   mongoc_bulk_operation_destroy (bulk);
+   mongoc_write_concern_destroy (wc);
+   mongoc_collection_destroy (collection);
+   mongoc_client_destroy (client);
+   mock_server_destroy (server);
+}
+
+
+static void
+test_merge_results (void)
+{
+   mongoc_bulk_write_flags_t write_flags = MONGOC_BULK_WRITE_FLAGS_INIT;
+   mongoc_write_command_t command;
+   mongoc_write_result_t result;
+   mongoc_write_concern_t *write_concern;
+   bson_t reply;
+   bson_error_t error;
+   bool r;
+
+   write_concern = mongoc_write_concern_new ();
+   _mongoc_write_command_init_update (&command,
+                                      tmp_bson ("{}"),
+                                      tmp_bson ("{'$set': {'x': 1}}"),
+                                      NULL,
+                                      write_flags,
+                                      1);
+
+   /* nobody reads the details: nothing is allocated for them */
+   _mongoc_write_result_init (&result);
+   _mongoc_write_result_merge (
+      &result, &command, tmp_bson ("{'ok': 1, 'n': 2, 'nModified': 2}"), 0);
+   ASSERT (_mongoc_write_result_complete (&result,
+                                          2,
+                                          write_concern,
+                                          (mongoc_error_domain_t) 0,
+                                          NULL,
+                                          &error));
+   ASSERT_CMPSIZE_T (result.upserted.len, ==, (size_t) 0);
+   ASSERT (!result.upserted.data);
+   ASSERT (!result.writeErrors.data);
+   _mongoc_write_result_destroy (&result);
+
+   /* upserts and errors from two batches, the second starting at index 10 */
+   _mongoc_write_result_init (&result);
+   _mongoc_write_result_merge (
+      &result,
+      &command,
+      tmp_bson ("{'ok': 1, 'n': 2, 'nModified': 0,"
+                " 'upserted': [{'index': 0, '_id': 'a'},"
+                "              {'index': 1, '_id': 'b'}]}"),
+      0);
+   _mongoc_write_result_merge (
+      &result,
+      &command,
+      tmp_bson ("{'ok': 1, 'n': 1, 'nModified': 0,"
+                " 'upserted': [{'index': 0, '_id': 'c'}],"
+                " 'writeErrors': [{'index': 1, 'code': 11000,"
+                "                  'errmsg': 'dupe', 'errInfo': {'x': 1}}]}"),
+      10);
+
+   bson_init (&reply);
+   r = _mongoc_write_result_complete (&result,
+                                      2,
+                                      write_concern,
+                                      (mongoc_error_domain_t) 0,
+                                      &reply,
+                                      &error);
+   ASSERT (!r);
+   ASSERT_ERROR_CONTAINS (error, MONGOC_ERROR_SERVER, 11000, "dupe");
+   ASSERT_MATCH (&reply,
+                 "{'nUpserted': 3,"
+                 " 'upserted': [{'index': 0, '_id': 'a'},"
+                 "              {'index': 1, '_id': 'b'},"
+                 "              {'index': 10, '_id': 'c'}],"
+                 " 'writeErrors': [{'index': 11, 'code': 11000,"
+                 "                  'errmsg': 'dupe', 'errInfo': {'x': 1}}]}");
+
+   bson_destroy (&reply);
+   _mongoc_write_result_destroy (&result);
+   _mongoc_write_command_destroy (&command);
+   mongoc_write_concern_destroy (write_concern);
+}
+
+
 void
 test_write_command_install (TestSuite *suite)
 {
    TestSuite_AddLive (suite, "/WriteCommand/split_insert", test_split_insert);
+   TestSuite_Add (suite, "/WriteCommand/merge_results", test_merge_results);
+   TestSuite_Add (
+      suite, "/WriteCommand/unacknowledged_op_msg", test_unacknowledged_op_msg);
    TestSuite_AddLive (
       suite, "/WriteCommand/invalid_write_concern", test_invalid_write_concern);
    TestSuite_AddFull (suite,